@@ -0,0 +1,172 @@
+// Microbenchmark: per-call cost of the hook layer on a dummy target.
+//
+//   direct        plain call to the target
+//   hooked        jmp -> relay -> detour -> CallOriginal -> trampoline
+//   hooked+stats  same, with a Hook::Call timing the invocation
+//   toggle        HookDisable + HookEnableAll while another thread keeps
+//                 calling the target; every result is checked
+//
+// Before the timings, a detour disables its own hook and then calls the
+// original, which must still go through the kept trampoline.
+//
+// Build with -DSSF_BUILD_BENCH=ON; run from any directory (the log and INI
+// are looked up next to the executable).
+
+#include "hookreg.h"
+#include "log.h"
+#include <windows.h>
+#include <cstdio>
+#include <cstdlib>
+
+char g_modDir[MAX_PATH] = ".";
+
+static volatile int g_sink = 0;
+
+extern "C" __attribute__((noinline, ms_abi)) int Dummy(int x) {
+    // Real prologue so the hook has whole instructions to steal
+    int acc = x;
+    for (int i = 0; i < 2; ++i) acc = acc * 31 + g_sink;
+    return acc;
+}
+
+using DummyHook = Hook<int(int)>;
+static DummyHook g_plainHook("Dummy(plain)");
+static DummyHook g_statsHook("Dummy(stats)");
+
+static int __attribute__((ms_abi)) Detour_Plain(int x) {
+    return g_plainHook.CallOriginal(x);
+}
+
+static int __attribute__((ms_abi)) Detour_Stats(int x) {
+    DummyHook::Call call(g_statsHook);
+    return call.Original(x);
+}
+
+// Disables its own hook before calling the original when g_disableNext
+// is set; counts every entry
+static DummyHook     g_toggleHook("Dummy(toggle)");
+static volatile bool g_disableNext = false;
+static volatile long g_toggleEntries = 0;
+
+static int __attribute__((ms_abi)) Detour_Toggle(int x) {
+    DummyHook::Call call(g_toggleHook);
+    InterlockedIncrement(&g_toggleEntries);
+    if (g_disableNext) {
+        g_disableNext = false;
+        HookDisable(HookFind("Dummy(toggle)"));
+    }
+    return call.Original(x);
+}
+
+static int Expected(int x) {
+    int acc = x;
+    for (int i = 0; i < 2; ++i) acc = acc * 31 + g_sink;
+    return acc;
+}
+
+// The detour's Call outlives the removal of its hook
+static bool DisableMidCall(int (__attribute__((ms_abi)) *fn)(int)) {
+    if (!g_toggleHook.Install((uintptr_t)Dummy, Detour_Toggle)) return false;
+
+    g_disableNext = true;
+    long entries = g_toggleEntries;
+    bool ok = fn(7) == Expected(7) && g_toggleEntries == entries + 1 &&
+              !g_toggleHook.Installed();
+
+    // Not hooked any more, then hooked again in the same slot
+    ok = ok && fn(8) == Expected(8) && g_toggleEntries == entries + 1;
+    ok = ok && HookEnableAll() && fn(9) == Expected(9) && g_toggleEntries == entries + 2;
+    return ok;
+}
+
+struct Caller {
+    int (__attribute__((ms_abi)) *fn)(int);
+    volatile bool stop;
+    long          calls;
+    long          mismatches;
+};
+
+static DWORD WINAPI CallerThread(LPVOID param) {
+    Caller& c = *(Caller*)param;
+    while (!c.stop) {
+        int x = (int)(c.calls & 0xFFFF);
+        if (c.fn(x) != Expected(x)) c.mismatches++;
+        c.calls++;
+    }
+    return 0;
+}
+
+// Microseconds per HookDisable + HookEnableAll with a caller running
+static double Toggle(int (__attribute__((ms_abi)) *fn)(int), int rounds, Caller& c) {
+    int index = HookFind("Dummy(toggle)");
+    c = { fn, false, 0, 0 };
+    HANDLE thread = CreateThread(nullptr, 0, CallerThread, &c, 0, nullptr);
+
+    LARGE_INTEGER t0, t1, freq;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t0);
+    for (int i = 0; i < rounds; ++i) {
+        HookDisable(index);
+        HookEnableAll();
+    }
+    QueryPerformanceCounter(&t1);
+
+    c.stop = true;
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+    return (double)(t1.QuadPart - t0.QuadPart) * 1e6 / (double)freq.QuadPart / rounds;
+}
+
+static double NsPerCall(int (__attribute__((ms_abi)) *fn)(int), int iters) {
+    LARGE_INTEGER t0, t1, freq;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&t0);
+    int acc = 0;
+    for (int i = 0; i < iters; ++i)
+        acc += fn(i);
+    QueryPerformanceCounter(&t1);
+    g_sink = acc & 1;
+    return (double)(t1.QuadPart - t0.QuadPart) * 1e9 / (double)freq.QuadPart / iters;
+}
+
+int main(int argc, char** argv) {
+    int iters = (argc > 1) ? atoi(argv[1]) : 10000000;
+
+    LogOpen("hook_overhead.log");
+    HookStatsInit();
+
+    // Function pointer through a volatile so the calls are not inlined
+    int (__attribute__((ms_abi)) * volatile target)(int) = Dummy;
+
+    NsPerCall(target, iters / 10);                       // warm up
+    double direct = NsPerCall(target, iters);
+
+    if (!g_plainHook.Install((uintptr_t)Dummy, Detour_Plain)) return 1;
+    double hooked = NsPerCall(target, iters);
+    HookRemoveAll();
+
+    if (!g_statsHook.Install((uintptr_t)Dummy, Detour_Stats)) return 1;
+    double stats = NsPerCall(target, iters);
+    HookDumpAllStats();
+    HookRemoveAll();
+
+    if (!DisableMidCall(target)) {
+        printf("disable mid-call FAILED\n");
+        return 1;
+    }
+    Caller caller;
+    double toggle = Toggle(target, 200, caller);
+    HookRemoveAll();
+
+    printf("iterations      %d\n", iters);
+    printf("direct          %6.2f ns/call\n", direct);
+    printf("hooked          %6.2f ns/call  (+%.2f)\n", hooked, hooked - direct);
+    printf("hooked+stats    %6.2f ns/call  (+%.2f)\n", stats, stats - direct);
+    printf("toggle          %6.1f us/round  (%ld calls checked, %ld wrong)\n",
+           toggle, caller.calls, caller.mismatches);
+
+    if (caller.mismatches) return 1;
+
+    LogShutdown(false);
+    return 0;
+}
@@ -0,0 +1,298 @@
+// Benchmark: the OnPostSaveLoaded detour body (RebuildSockets) against a
+// simulated Mass entity store, at several save sizes.
+//
+//   subsystem lookup   loading world's subsystems (cached after the first
+//                      load), or the first MassEntitySubsystem found
+//   entity array       FindEntityArray probe
+//   extraction         entity slot scan (archetype set, or every handle
+//                      when the verifier falls back)
+//   filtering          socket verifier chunk walk and neighbour matching
+//   signalling         SignalEntity loop (recording stub, so this is the
+//                      loop overhead, not the engine's work per signal)
+//   rail graph         CSR build, link classification and union-find;
+//                      deferred past the detour when entities were
+//                      signalled, so run after each load and not part of
+//                      its total
+//
+// Phase times are read off the TRACE_SPANs already in the code.  Each size
+// runs in a forked child so peak RSS is per size.  Results go to stdout (or
+// --out) as JSON; a human summary goes to stderr.
+//
+//   postload_signal [--sizes 10000,100000,1000000] [--objects N]
+//                   [--plain-arch N] [--socket-arch N] [--socket-pct P]
+//                   [--junction-pct P] [--broken-pct P] [--retro-pct P] [--repeat N]
+//                   [--seed S] [--out FILE]
+//
+// Build with -DSSF_BUILD_BENCH=ON (host build).
+
+#include "sim_runtime.h"
+#include "sim_world.h"
+#include "discovery.h"
+#include "log.h"
+#include "platform.h"
+#include "rebuild.h"
+#include "trace.h"
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef SSF_BUILD_ID
+#define SSF_BUILD_ID "unknown"
+#endif
+
+static constexpr int MAX_SIZES = 16;
+
+struct BenchArgs {
+    SimConfig cfg;
+    int32_t   sizes[MAX_SIZES];
+    int       numSizes;
+    int       repeat;
+    const char* out;
+};
+
+// Span names as they appear in rebuild.cpp / discovery.cpp / sockets.cpp
+struct Phase {
+    const char* key;
+    const char* spans[3];
+};
+
+static const Phase g_phases[] = {
+    { "subsystem_lookup", { "ResolveWorldSubsystems", "FindObjectByClassName(MassEntitySubsystem)",
+                            "FindSignalSubsystem" } },
+    { "entity_array",     { "FindEntityArray", nullptr } },
+    { "extraction",       { "VerifySockets: slots", "ReadEntityHandles" } },
+    { "filtering",        { "VerifySockets: chunks", "ReconnectSockets: match" } },
+    { "signalling",       { "SignalEntity loop", nullptr } },
+    { "rail_graph",       { "BuildRailGraph", nullptr } },
+};
+static constexpr int NUM_PHASES = (int)(sizeof(g_phases) / sizeof(g_phases[0]));
+
+static double TicksToMs(int64_t ticks) {
+    return (double)ticks * 1000.0 / (double)PlatTicksPerSecond();
+}
+
+static long PeakRssKb() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+static int CompareDouble(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// ===================================================================
+// One size (runs in the child)
+// ===================================================================
+
+static int RunSize(const BenchArgs& args, int32_t entities, FILE* out) {
+    SimConfig cfg = args.cfg;
+    cfg.numEntities = entities;
+
+    SimWorld w = {};
+    int64_t t0 = PlatTicks();
+    if (!SimCreate(cfg, w)) return 1;
+    double buildMs = TicksToMs(PlatTicks() - t0);
+    long rssWorld = PeakRssKb();
+
+    RebuildEnv env = { w.objArrayBase, w.nameToString, w.signalEntity,
+                       "CrLogisticsSocketsSignal", true, true, nullptr, nullptr,
+                       w.saveSubsystem };
+    SignalState sig = {};
+    TargetStructs targets = {};
+
+    // Init-time work the detour relies on (not part of the measurement)
+    FindTargets(w.objArrayBase, w.nameToString, targets);
+    ResolveSignal(env, sig);
+
+    g_traceEnabled = true;
+
+    // First load: class cache cold for MassEntitySubsystem
+    SimResetSignals();
+    t0 = PlatTicks();
+    int signalled = RebuildSockets(env, sig, targets);
+    double firstMs = TicksToMs(PlatTicks() - t0);
+
+    double* totals = (double*)calloc((size_t)args.repeat, sizeof(double));
+    double phaseMs[NUM_PHASES] = {};
+    SimSpansReset();
+    for (int r = 0; r < args.repeat; ++r) {
+        SimResetSignals();
+        t0 = PlatTicks();
+        RebuildSockets(env, sig, targets);
+        totals[r] = TicksToMs(PlatTicks() - t0);
+
+        RailGraphStats graph;
+        RunDeferredRailGraph(env, targets, graph);
+    }
+    for (int p = 0; p < NUM_PHASES; ++p) {
+        for (const char* span : g_phases[p].spans)
+            if (span) phaseMs[p] += TicksToMs(SimSpanTicks(span));
+        phaseMs[p] /= args.repeat;
+    }
+    g_traceEnabled = false;
+
+    qsort(totals, (size_t)args.repeat, sizeof(double), CompareDouble);
+    double minMs = totals[0];
+    double medianMs = totals[args.repeat / 2];
+    free(totals);
+
+    long rssPeak = PeakRssKb();
+    bool correct = signalled == w.brokenEntities;
+
+    double seconds = medianMs / 1000.0;
+    double handlesPerSec = seconds > 0 ? (double)w.liveEntities / seconds : 0.0;
+
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"entities\": %d,\n", w.liveEntities);
+    fprintf(out, "      \"objects\": %d,\n", ReadAt<int32_t>(w.objArrayBase, TObjOff::NumElements));
+    fprintf(out, "      \"socket_entities\": %d,\n", w.socketEntities);
+    fprintf(out, "      \"junctions\": %d,\n", w.junctions);
+    fprintf(out, "      \"broken\": %d,\n", w.brokenEntities);
+    fprintf(out, "      \"signalled\": %d,\n", signalled);
+    fprintf(out, "      \"correct\": %s,\n", correct ? "true" : "false");
+    fprintf(out, "      \"build_ms\": %.3f,\n", buildMs);
+    fprintf(out, "      \"first_load_ms\": %.3f,\n", firstMs);
+    fprintf(out, "      \"total_ms\": { \"min\": %.3f, \"median\": %.3f },\n", minMs, medianMs);
+    fprintf(out, "      \"phases_ms\": {");
+    for (int p = 0; p < NUM_PHASES; ++p)
+        fprintf(out, "%s \"%s\": %.3f", p ? "," : "", g_phases[p].key, phaseMs[p]);
+    fprintf(out, " },\n");
+    fprintf(out, "      \"handles_per_sec\": %.0f,\n", handlesPerSec);
+    fprintf(out, "      \"world_mb\": %.1f,\n", (double)w.bytesReserved / (1024.0 * 1024.0));
+    fprintf(out, "      \"peak_rss_kb\": %ld,\n", rssPeak);
+    fprintf(out, "      \"postload_rss_growth_kb\": %ld\n", rssPeak - rssWorld);
+    fprintf(out, "    }");
+    fflush(out);
+
+    fprintf(stderr, "%8d entities  first %9.3f ms  median %9.3f ms  "
+                    "(lookup %.3f, array %.3f, extract %.3f, filter %.3f, signal %.3f, "
+                    "graph %.3f)  %.2fM handles/s  %s\n",
+            w.liveEntities, firstMs, medianMs,
+            phaseMs[0], phaseMs[1], phaseMs[2], phaseMs[3], phaseMs[4], phaseMs[5],
+            handlesPerSec / 1e6, correct ? "ok" : "MISMATCH");
+
+    SimDestroy(w);
+    return correct ? 0 : 1;
+}
+
+// ===================================================================
+// Arguments
+// ===================================================================
+
+static bool ParseSizes(const char* s, BenchArgs& args) {
+    args.numSizes = 0;
+    while (*s && args.numSizes < MAX_SIZES) {
+        char* end;
+        long v = strtol(s, &end, 0);
+        if (end == s || v < SIM_MIN_ENTITIES || v > SIM_MAX_ENTITIES) return false;
+        args.sizes[args.numSizes++] = (int32_t)v;
+        s = (*end == ',') ? end + 1 : end;
+    }
+    return args.numSizes > 0;
+}
+
+static bool ParseArgs(int argc, char** argv, BenchArgs& args) {
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (i + 1 >= argc) return false;
+        const char* val = argv[++i];
+        long v = strtol(val, nullptr, 0);
+
+        if      (strcmp(a, "--sizes") == 0)        { if (!ParseSizes(val, args)) return false; }
+        else if (strcmp(a, "--out") == 0)          args.out = val;
+        else if (strcmp(a, "--repeat") == 0)       args.repeat = (int)v;
+        else if (strcmp(a, "--objects") == 0)      args.cfg.numObjects = (int32_t)v;
+        else if (strcmp(a, "--plain-arch") == 0)   args.cfg.plainArchetypes = (int32_t)v;
+        else if (strcmp(a, "--socket-arch") == 0)  args.cfg.socketArchetypes = (int32_t)v;
+        else if (strcmp(a, "--socket-pct") == 0)   args.cfg.socketPct = (int32_t)v;
+        else if (strcmp(a, "--junction-pct") == 0) args.cfg.junctionPct = (int32_t)v;
+        else if (strcmp(a, "--broken-pct") == 0)   args.cfg.brokenPct = (int32_t)v;
+        else if (strcmp(a, "--retro-pct") == 0)    args.cfg.retroPct = (int32_t)v;
+        else if (strcmp(a, "--seed") == 0)         args.cfg.seed = (uint32_t)v;
+        else return false;
+    }
+    return args.repeat > 0;
+}
+
+int main(int argc, char** argv) {
+    BenchArgs args = {};
+    SimDefaultConfig(args.cfg);
+    args.sizes[0] = 10000;
+    args.sizes[1] = 100000;
+    args.sizes[2] = 1000000;
+    args.numSizes = 3;
+    args.repeat = 5;
+
+    if (!ParseArgs(argc, argv, args)) {
+        fprintf(stderr, "usage: postload_signal [--sizes N,N,...] [--objects N] "
+                        "[--plain-arch N] [--socket-arch N] [--socket-pct P] "
+                        "[--junction-pct P] [--broken-pct P] [--retro-pct P] [--repeat N] "
+                        "[--seed S] [--out FILE]\n");
+        return 2;
+    }
+
+    FILE* out = args.out ? fopen(args.out, "w") : stdout;
+    if (!out) {
+        perror(args.out);
+        return 2;
+    }
+
+    const SimConfig& c = args.cfg;
+    fprintf(out, "{\n");
+    fprintf(out, "  \"benchmark\": \"postload_signal\",\n");
+    fprintf(out, "  \"schema\": 1,\n");
+    fprintf(out, "  \"build\": \"%s\",\n", SSF_BUILD_ID);
+    fprintf(out, "  \"config\": { \"objects\": %d, \"plain_archetypes\": %d, "
+                 "\"socket_archetypes\": %d, \"socket_pct\": %d, \"junction_pct\": %d, "
+                 "\"broken_pct\": %d, \"retro_pct\": %d, \"repeat\": %d, \"seed\": %u },\n",
+            c.numObjects, c.plainArchetypes, c.socketArchetypes, c.socketPct,
+            c.junctionPct, c.brokenPct, c.retroPct, args.repeat, c.seed);
+    fprintf(out, "  \"runs\": [\n");
+    fflush(out);
+
+    // Each child writes its run object into a pipe; a child that dies
+    // leaves no partial object behind
+    int failures = 0, written = 0;
+    for (int i = 0; i < args.numSizes; ++i) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            perror("pipe");
+            return 2;
+        }
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 2;
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            FILE* f = fdopen(fds[1], "w");
+            int rc = RunSize(args, args.sizes[i], f);
+            fclose(f);
+            _exit(rc);
+        }
+        close(fds[1]);
+
+        char buf[4096];
+        size_t len = 0;
+        ssize_t n;
+        while ((n = read(fds[0], buf + len, sizeof(buf) - 1 - len)) > 0) len += (size_t)n;
+        buf[len] = '\0';
+        close(fds[0]);
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failures++;
+        if (len > 0) fprintf(out, "%s%s", written++ ? ",\n" : "", buf);
+        fflush(out);
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout) fclose(out);
+    return failures ? 1 : 0;
+}
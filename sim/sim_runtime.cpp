@@ -0,0 +1,83 @@
+#include "sim_runtime.h"
+#include "log.h"
+#include "platform.h"
+#include "trace.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+// ===================================================================
+// Host stand-ins for the DLL's Windows-only runtime (log.cpp, trace.cpp,
+// main.cpp globals) so the portable modules link into the simulator.
+// Log lines go to stderr up to g_logLevel; spans are summed by name.
+// ===================================================================
+
+char g_modDir[260] = ".";
+int  g_logLevel    = LOG_LEVEL_ERROR;
+bool g_traceEnabled = false;
+
+static void Emit(int level, const char* fmt, va_list ap) {
+    if (level > g_logLevel) return;
+    vfprintf(stderr, fmt, ap);
+    fputc('\n', stderr);
+}
+
+void LogMsg(const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    Emit(LOG_LEVEL_INFO, fmt, ap);
+    va_end(ap);
+}
+
+void LogMsgLevel(int level, const char* fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    Emit(level, fmt, ap);
+    va_end(ap);
+}
+
+bool LogOpen(const char*)  { return true; }
+void LogShutdown(bool)     {}
+
+void    TraceInit()   {}
+void    TraceExport() {}
+int64_t TraceNow()    { return PlatTicks(); }
+
+// ===================================================================
+// Span totals
+// ===================================================================
+
+static constexpr int MAX_SPAN_NAMES = 64;
+
+static SimSpanTotal g_spans[MAX_SPAN_NAMES];
+static int          g_spanCount = 0;
+
+static SimSpanTotal* FindSpan(const char* name) {
+    for (int i = 0; i < g_spanCount; ++i)
+        if (g_spans[i].name == name || strcmp(g_spans[i].name, name) == 0) return &g_spans[i];
+    return nullptr;
+}
+
+void TraceRecord(const char* name, int64_t start, int64_t end) {
+    SimSpanTotal* t = FindSpan(name);
+    if (!t) {
+        if (g_spanCount >= MAX_SPAN_NAMES) return;
+        t = &g_spans[g_spanCount++];
+        t->name = name;
+    }
+    t->ticks += end - start;
+    t->calls++;
+}
+
+void SimSpansReset() {
+    memset(g_spans, 0, sizeof(g_spans));
+    g_spanCount = 0;
+}
+
+int64_t SimSpanTicks(const char* name) {
+    const SimSpanTotal* t = FindSpan(name);
+    return t ? t->ticks : 0;
+}
+
+int                 SimSpanCount() { return g_spanCount; }
+const SimSpanTotal* SimSpans()     { return g_spans; }
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Span totals — with g_traceEnabled set, the simulator's TraceRecord adds
+// every TRACE_SPAN in the portable modules to a per-name total instead of
+// buffering events, so a benchmark can read phase times straight off the
+// spans the mod already has.  Ticks are PlatTicks() units.
+// ---------------------------------------------------------------------------
+
+struct SimSpanTotal {
+    const char* name;
+    int64_t     ticks;
+    int         calls;
+};
+
+void SimSpansReset();
+
+// Total ticks recorded under 'name' (0 if never seen)
+int64_t SimSpanTicks(const char* name);
+
+int                 SimSpanCount();
+const SimSpanTotal* SimSpans();
@@ -0,0 +1,773 @@
+#include "sim_world.h"
+#include "discovery.h"
+#include "platform.h"
+#include "props.h"
+#include "worlds.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// ===================================================================
+// Arena  (64 MB blocks; large requests get a block of their own)
+// ===================================================================
+
+static constexpr size_t ARENA_BLOCK = 64u << 20;
+static constexpr int    MAX_BLOCKS  = 4096;
+
+struct ArenaBlock {
+    uint8_t* base;
+    size_t   size;
+    size_t   used;
+};
+
+static ArenaBlock g_blocks[MAX_BLOCKS];
+static int        g_blockCount = 0;
+static int        g_current = -1;      // block small requests are carved from
+static size_t     g_reserved = 0;
+
+static ArenaBlock* NewBlock(size_t size) {
+    if (g_blockCount >= MAX_BLOCKS) return nullptr;
+    uint8_t* p = (uint8_t*)PlatAlloc(size);
+    if (!p) return nullptr;
+    ArenaBlock& b = g_blocks[g_blockCount++];
+    b.base = p;
+    b.size = size;
+    b.used = 0;
+    g_reserved += size;
+    return &b;
+}
+
+// Zeroed, 16-byte aligned.  Aborts on exhaustion: a half-built world is
+// of no use to anyone.
+static void* Alloc(size_t size) {
+    size = (size + 15) & ~(size_t)15;
+
+    if (size > ARENA_BLOCK / 4) {
+        ArenaBlock* b = NewBlock((size + 0xFFFF) & ~(size_t)0xFFFF);
+        if (!b) { fprintf(stderr, "sim: out of memory (%zu bytes)\n", size); abort(); }
+        b->used = size;
+        return b->base;
+    }
+
+    if (g_current < 0 || g_blocks[g_current].used + size > g_blocks[g_current].size) {
+        if (!NewBlock(ARENA_BLOCK)) { fprintf(stderr, "sim: out of memory\n"); abort(); }
+        g_current = g_blockCount - 1;
+    }
+    ArenaBlock& b = g_blocks[g_current];
+    void* p = b.base + b.used;
+    b.used += size;
+    return p;
+}
+
+static void ArenaRelease() {
+    for (int i = 0; i < g_blockCount; ++i)
+        PlatFree(g_blocks[i].base, g_blocks[i].size);
+    g_blockCount = 0;
+    g_current = -1;
+    g_reserved = 0;
+}
+
+// ===================================================================
+// Deterministic RNG  (xorshift32)
+// ===================================================================
+
+static uint32_t g_rng = 1;
+
+static uint32_t Rand() {
+    uint32_t x = g_rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return g_rng = x;
+}
+
+static bool Chance(int pct) {
+    return (int)(Rand() % 100) < pct;
+}
+
+// ===================================================================
+// FName table + fake FName::ToString
+//
+// Index 0 is "None", as in the engine.  Number > 0 renders as
+// "<name>_<Number-1>".  The output FString grows like a TArray.
+// ===================================================================
+
+static constexpr uint32_t MAX_NAMES = 1u << 16;
+
+static const char* g_names[MAX_NAMES];
+static uint16_t    g_nameLen[MAX_NAMES];
+static uint32_t    g_nameCount = 0;
+
+static FName AddName(const char* s) {
+    if (g_nameCount >= MAX_NAMES) { fprintf(stderr, "sim: name table full\n"); abort(); }
+    size_t len = strlen(s);
+    char* copy = (char*)Alloc(len + 1);
+    memcpy(copy, s, len + 1);
+    g_names[g_nameCount] = copy;
+    g_nameLen[g_nameCount] = (uint16_t)len;
+    return { g_nameCount++, 0 };
+}
+
+static void SimNameToString(const void* namePtr, FString* out) {
+    const FName* n = (const FName*)namePtr;
+    uint32_t idx = (n->ComparisonIndex < g_nameCount) ? n->ComparisonIndex : 0;
+
+    char suffix[16];
+    int slen = n->Number ? snprintf(suffix, sizeof(suffix), "_%u", n->Number - 1) : 0;
+    int len  = g_nameLen[idx];
+    int need = len + slen + 1;
+
+    if (out->Max < need) {
+        int newMax = need < 64 ? 64 : need;
+        out->Data = (wchar_t*)realloc(out->Data, (size_t)newMax * sizeof(wchar_t));
+        out->Max  = newMax;
+    }
+
+    const char* s = g_names[idx];
+    for (int i = 0; i < len; ++i)  out->Data[i] = (wchar_t)(unsigned char)s[i];
+    for (int i = 0; i < slen; ++i) out->Data[len + i] = (wchar_t)suffix[i];
+    out->Data[len + slen] = L'\0';
+    out->Num = need;
+}
+
+// ===================================================================
+// Recording SignalEntity
+// ===================================================================
+
+static SimSignal* g_signals = nullptr;
+static int        g_signalCap = 0;
+static int        g_signalCount = 0;
+
+static void SimSignalEntity(void* subsystem, FName name, FMassEntityHandle handle) {
+    if (g_signalCount < g_signalCap)
+        g_signals[g_signalCount] = { subsystem, name, handle };
+    g_signalCount++;
+}
+
+int              SimSignalCount()  { return g_signalCount; }
+const SimSignal* SimSignals()      { return g_signals; }
+void             SimResetSignals() { g_signalCount = 0; }
+
+// ===================================================================
+// Objects and structs
+// ===================================================================
+
+static constexpr size_t OBJECT_SIZE    = 0x30;     // UObjectBase, rounded
+static constexpr size_t STRUCT_SIZE    = 0xC0;     // UScriptStruct
+static constexpr size_t SUBSYSTEM_SIZE = 0x400;
+static constexpr size_t CDO_SIZE       = 0x2A0;
+static constexpr size_t PROPERTY_SIZE  = 0x78;     // FProperty
+
+// Not where the mod's fallback guess (+0x288) has it, so only the
+// property resolver finds the signal name
+static constexpr size_t  SIGNAL_PROCESSOR_SIGNAL_OFFSET = 0x298;
+static constexpr size_t  ENTITY_ARRAY_OFFSET            = 0x1B0;   // in UMassEntitySubsystem
+
+static constexpr int FILLER_CLASSES = 256;
+static constexpr int FILLER_NAMES   = 4096;
+
+static uintptr_t NewObject(size_t size, uintptr_t cls, FName name, uintptr_t outer) {
+    uintptr_t obj = (uintptr_t)Alloc(size);
+    WriteAt<uintptr_t>(obj, UObjOff::ClassPrivate, cls);
+    WriteAt<FName>(obj, UObjOff::NamePrivate, name);
+    WriteAt<uintptr_t>(obj, UObjOff::OuterPrivate, outer);
+    return obj;
+}
+
+// UStruct (UClass or UScriptStruct) with its InheritanceChain
+static uintptr_t NewStruct(uintptr_t cls, FName name, uintptr_t super, int32_t propsSize) {
+    uintptr_t s = NewObject(STRUCT_SIZE, cls, name, 0);
+
+    int32_t depth = super ? ReadAt<int32_t>(super, UStructOff::HierarchyDepth) + 1 : 0;
+    uintptr_t* chain = (uintptr_t*)Alloc((size_t)(depth + 1) * sizeof(uintptr_t));
+    if (super)
+        memcpy(chain, ReadAt<uintptr_t*>(super, UStructOff::InheritanceChain),
+               (size_t)depth * sizeof(uintptr_t));
+    chain[depth] = s + UStructOff::InheritanceChain;
+
+    WriteAt<uintptr_t*>(s, UStructOff::InheritanceChain, chain);
+    WriteAt<int32_t>(s, UStructOff::HierarchyDepth, depth);
+    WriteAt<uintptr_t>(s, UStructOff::SuperStruct, super);
+    WriteAt<int32_t>(s, UStructOff::PropertiesSize, propsSize);
+    return s;
+}
+
+// FFieldClass: only its name is read
+static uintptr_t NewFieldClass(FName name) {
+    uintptr_t fc = (uintptr_t)Alloc(0x10);
+    WriteAt<FName>(fc, FFieldClassOff::Name, name);
+    return fc;
+}
+
+// Append an FProperty to the struct's ChildProperties list
+static uintptr_t AddProperty(uintptr_t s, FName name, uint64_t flags, uintptr_t fieldClass,
+                             size_t offset, int32_t size) {
+    uintptr_t prop = (uintptr_t)Alloc(PROPERTY_SIZE);
+    WriteAt<uintptr_t>(prop, FFieldOff::ClassPrivate, fieldClass);
+    WriteAt<FName>(prop, FFieldOff::NamePrivate, name);
+    WriteAt<int32_t>(prop, FPropertyOff::ArrayDim, 1);
+    WriteAt<int32_t>(prop, FPropertyOff::ElementSize, size);
+    WriteAt<uint64_t>(prop, FPropertyOff::PropertyFlags, flags);
+    WriteAt<int32_t>(prop, FPropertyOff::OffsetInternal, (int32_t)offset);
+
+    uintptr_t link = s + UStructOff::ChildProperties;
+    while (ReadAt<uintptr_t>(link, 0)) link = ReadAt<uintptr_t>(link, 0) + FFieldOff::Next;
+    WriteAt<uintptr_t>(link, 0, prop);
+    return prop;
+}
+
+bool SimIsChildOf(uintptr_t s, uintptr_t parent) {
+    uintptr_t* chain = ReadAt<uintptr_t*>(s, UStructOff::InheritanceChain);
+    int32_t depth    = ReadAt<int32_t>(s, UStructOff::HierarchyDepth);
+    int32_t pDepth   = ReadAt<int32_t>(parent, UStructOff::HierarchyDepth);
+    return chain && pDepth <= depth && chain[pDepth] == parent + UStructOff::InheritanceChain;
+}
+
+// ===================================================================
+// Chunked GUObjectArray
+// ===================================================================
+
+static uintptr_t** g_chunks = nullptr;
+
+static void PlaceObject(int32_t index, uintptr_t obj) {
+    uintptr_t item = (uintptr_t)g_chunks[index / TObjOff::ChunkSize] +
+                     (uintptr_t)(index % TObjOff::ChunkSize) * ItemOff::Size;
+    WriteAt<uintptr_t>(item, ItemOff::Object, obj);
+    WriteAt<int32_t>(obj, UObjOff::InternalIndex, index);
+}
+
+static uintptr_t NewObjectArray(int32_t numElements) {
+    int32_t numChunks = (numElements + TObjOff::ChunkSize - 1) / TObjOff::ChunkSize;
+    g_chunks = (uintptr_t**)Alloc((size_t)numChunks * sizeof(uintptr_t*));
+    for (int32_t c = 0; c < numChunks; ++c)
+        g_chunks[c] = (uintptr_t*)Alloc((size_t)TObjOff::ChunkSize * ItemOff::Size);
+
+    uintptr_t guObjectArray = (uintptr_t)Alloc(GUObjOff::ObjObjects + 0x20);
+    uintptr_t objArray = guObjectArray + GUObjOff::ObjObjects;
+    WriteAt<uintptr_t**>(objArray, TObjOff::Objects, g_chunks);
+    WriteAt<int32_t>(objArray, TObjOff::NumElements, numElements);
+    WriteAt<int32_t>(objArray, TObjOff::NumChunks, numChunks);
+    return guObjectArray;
+}
+
+// ===================================================================
+// Mass entity store
+// ===================================================================
+
+static constexpr int MAX_SIM_FRAGMENTS = 8;
+static constexpr int EXTRA_FRAGMENTS   = 3;
+
+struct SimArchetype {
+    uintptr_t mem;                          // FMassArchetypeData
+    int32_t   numFragments;
+    uintptr_t types[MAX_SIM_FRAGMENTS];
+    int32_t   sizes[MAX_SIM_FRAGMENTS];
+    int32_t   offsets[MAX_SIM_FRAGMENTS];   // ArrayOffsetWithinChunk
+    int32_t   perChunk;
+    uintptr_t chunks;                       // FMassArchetypeChunk[]
+    int32_t   filled;
+};
+
+static void ArchetypeAddFragment(SimArchetype& a, uintptr_t type) {
+    a.types[a.numFragments] = type;
+    a.sizes[a.numFragments] = ReadAt<int32_t>(type, UStructOff::PropertiesSize);
+    a.numFragments++;
+}
+
+// Lay out chunks for 'count' entities: entity handle list first, then one
+// array per fragment.
+static void ArchetypeBuild(SimArchetype& a, int32_t count, int32_t perChunk) {
+    a.mem = (uintptr_t)Alloc(MassArchetypeOff::EntityListOffset + 8);
+    a.perChunk = perChunk;
+
+    size_t off = (size_t)perChunk * sizeof(FMassEntityHandle);
+    for (int f = 0; f < a.numFragments; ++f) {
+        off = (off + 15) & ~(size_t)15;
+        a.offsets[f] = (int32_t)off;
+        off += (size_t)perChunk * a.sizes[f];
+
+        uintptr_t cfg = a.mem + MassArchetypeOff::FragmentConfigs +
+                        (uintptr_t)f * MassArchetypeOff::FragmentConfigSize;
+        WriteAt<uintptr_t>(cfg, FragmentConfigOff::FragmentType, a.types[f]);
+        WriteAt<int32_t>(cfg, FragmentConfigOff::ArrayOffset, a.offsets[f]);
+    }
+    const size_t chunkBytes = off;
+
+    int32_t numChunks = (count + perChunk - 1) / perChunk;
+    a.chunks = (uintptr_t)Alloc((size_t)(numChunks ? numChunks : 1) * MassChunkOff::Size);
+    for (int32_t c = 0; c < numChunks; ++c)
+        WriteAt<uintptr_t>(a.chunks + (uintptr_t)c * MassChunkOff::Size, MassChunkOff::RawMemory,
+                           (uintptr_t)Alloc(chunkBytes));
+
+    WriteAt<uintptr_t>(a.mem, MassArchetypeOff::FragmentConfigsHeap, 0);
+    WriteAt<int32_t>(a.mem, MassArchetypeOff::FragmentConfigsNum, a.numFragments);
+    WriteAt<uintptr_t>(a.mem, MassArchetypeOff::Chunks + TArrayOff::Data, a.chunks);
+    WriteAt<int32_t>(a.mem, MassArchetypeOff::Chunks + TArrayOff::Num, numChunks);
+    WriteAt<int32_t>(a.mem, MassArchetypeOff::Chunks + TArrayOff::Max, numChunks);
+    WriteAt<int32_t>(a.mem, MassArchetypeOff::NumEntitiesPerChunk, perChunk);
+    WriteAt<int32_t>(a.mem, MassArchetypeOff::EntityListOffset, 0);
+}
+
+// Append an entity; returns its chunk memory and index within the chunk
+static uintptr_t ArchetypeAdd(SimArchetype& a, FMassEntityHandle h, int32_t& s) {
+    uintptr_t chunk = a.chunks + (uintptr_t)(a.filled / a.perChunk) * MassChunkOff::Size;
+    uintptr_t raw   = ReadAt<uintptr_t>(chunk, MassChunkOff::RawMemory);
+    s = a.filled % a.perChunk;
+
+    WriteAt<FMassEntityHandle>(raw, (size_t)s * sizeof(FMassEntityHandle), h);
+    WriteAt<int32_t>(chunk, MassChunkOff::NumInstances, s + 1);
+    a.filled++;
+    return raw;
+}
+
+static void WriteTArray(uintptr_t at, uintptr_t data, int32_t num) {
+    WriteAt<uintptr_t>(at, TArrayOff::Data, data);
+    WriteAt<int32_t>(at, TArrayOff::Num, num);
+    WriteAt<int32_t>(at, TArrayOff::Max, num);
+}
+
+static uint8_t* g_broken = nullptr;
+static int32_t  g_numEntities = 0;
+
+bool SimEntityBroken(int32_t index) {
+    return index >= 0 && index < g_numEntities && g_broken[index];
+}
+
+// Socket entities as generated, for breaking links after the fact and
+// checking what was restored
+struct SimSocketEntity {
+    FMassEntityHandle  handle;
+    uintptr_t          sockFrag;
+    uintptr_t          connFrag;
+    uintptr_t          sockArr;
+    uintptr_t          connArr;
+    FMassEntityHandle* original;    // link of each socket before breaking
+    int32_t            numSockets;
+    int32_t            numConns;
+    bool               wiped;       // Sockets array emptied
+};
+
+static SimSocketEntity* g_socketEntities = nullptr;
+static int32_t          g_numSocketEntities = 0;
+
+// Sockets not linked yet; a new entity may attach to one
+struct SimOpenSocket {
+    uintptr_t sock;
+    int32_t   entity;               // index into g_socketEntities
+};
+
+static void AddConnection(SimSocketEntity& e, int32_t socketIdx, FMassEntityHandle target) {
+    uintptr_t conn = e.connArr + (uintptr_t)e.numConns * ConnOff::Size;
+    WriteAt<int32_t>(conn, ConnOff::SocketIndex, socketIdx);
+    WriteAt<FMassEntityHandle>(conn, ConnOff::Target, target);
+    WriteAt<int32_t>(conn, ConnOff::TargetSocketIndex, (int32_t)(Rand() % 2));
+    e.numConns++;
+}
+
+static void ClearLinks(SimSocketEntity& e) {
+    for (int32_t k = 0; k < e.numSockets; ++k)
+        WriteAt<FMassEntityHandle>(e.sockArr + (uintptr_t)k * SocketOff::Size,
+                                   SocketOff::ConnectedEntity, FMassEntityHandle{ 0, 0 });
+}
+
+// Lost links, decided once every link exists:
+//   brokenPct  the Sockets array was wiped or came back unconnected, the
+//              saved connection list survived
+//   retroPct   broken before the mod: links and saved connections are
+//              gone, only the neighbours still point back.  Chosen only
+//              where no neighbour was wiped, so they can be traced.
+//   compact    the save left socket locations out: every socket entity
+//              needs the rebuild, and none can be traced by position, so
+//              there are no pre-mod breaks.
+static void BreakLinks(const SimConfig& cfg, SimWorld& w, const int32_t* entityOfSlot) {
+    for (int32_t e = 0; e < g_numSocketEntities; ++e) {
+        SimSocketEntity& se = g_socketEntities[e];
+        if (se.numConns == 0 || !Chance(cfg.brokenPct)) continue;
+
+        g_broken[se.handle.Index] = 1;
+        w.brokenEntities++;
+        if (Rand() & 1) {
+            se.wiped = true;
+            w.wipedEntities++;
+        } else {
+            ClearLinks(se);
+        }
+    }
+
+    for (int32_t e = 0; e < g_numSocketEntities && cfg.compact; ++e) {
+        SimSocketEntity& se = g_socketEntities[e];
+        for (int32_t k = 0; k < se.numSockets; ++k)
+            for (size_t c = 0; c < 3; ++c)
+                WriteAt<double>(se.sockArr + (uintptr_t)k * SocketOff::Size,
+                                SocketOff::Location + c * 8, 0.0);
+        if (g_broken[se.handle.Index]) continue;
+        g_broken[se.handle.Index] = 1;
+        w.brokenEntities++;
+    }
+
+    for (int32_t e = 0; e < g_numSocketEntities && !cfg.compact; ++e) {
+        SimSocketEntity& se = g_socketEntities[e];
+        if (se.numConns == 0 || g_broken[se.handle.Index] || !Chance(cfg.retroPct)) continue;
+
+        bool traceable = true;
+        for (int32_t k = 0; k < se.numSockets; ++k) {
+            FMassEntityHandle t = se.original[k];
+            if (t.Index != 0 && g_socketEntities[entityOfSlot[t.Index]].wiped) traceable = false;
+        }
+        if (!traceable) continue;
+
+        g_broken[se.handle.Index] = 1;
+        w.brokenEntities++;
+        w.retroBroken++;
+        ClearLinks(se);
+        se.numConns = 0;
+    }
+
+    for (int32_t e = 0; e < g_numSocketEntities; ++e) {
+        SimSocketEntity& se = g_socketEntities[e];
+        WriteTArray(se.sockFrag + SocketsFragOff::Sockets, se.sockArr, se.wiped ? 0 : se.numSockets);
+        WriteTArray(se.connFrag + ConnDataOff::Connections, se.connArr, se.numConns);
+    }
+}
+
+int SimLinkMismatches() {
+    int mismatches = 0;
+    for (int32_t e = 0; e < g_numSocketEntities; ++e) {
+        const SimSocketEntity& se = g_socketEntities[e];
+        if (se.wiped) continue;
+        for (int32_t k = 0; k < se.numSockets; ++k) {
+            FMassEntityHandle live = ReadAt<FMassEntityHandle>(
+                se.sockArr + (uintptr_t)k * SocketOff::Size, SocketOff::ConnectedEntity);
+            if (live.Index != se.original[k].Index ||
+                live.SerialNumber != se.original[k].SerialNumber)
+                mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static SimArchetype g_archetypes[SIM_MAX_ARCHETYPES];
+
+// Archetypes [0, socketArchetypes) carry transform + sockets + connection
+// fragments, the rest just transform; each also gets 0..3 extras.
+static void BuildEntityStore(const SimConfig& cfg, SimWorld& w, uintptr_t plainFragment,
+                             const uintptr_t* extraFragments) {
+    const int32_t n = cfg.numEntities;
+    const int32_t slotSize = cfg.entitySlotSize;
+    const int32_t numSocketArch = cfg.socketArchetypes;
+    const int32_t numArch = cfg.socketArchetypes + cfg.plainArchetypes;
+    g_numEntities = n;
+    g_broken = (uint8_t*)Alloc((size_t)n);
+
+    // Pass 1: decide each slot's archetype so chunk arrays can be sized
+    uint16_t* arch = (uint16_t*)Alloc((size_t)n * sizeof(uint16_t));
+    int32_t* counts = (int32_t*)Alloc((size_t)numArch * sizeof(int32_t));
+    int32_t socketCount = 0;
+    for (int32_t i = 1; i < n; ++i) {          // slot 0 stays free, as in Mass
+        bool socket = numSocketArch > 0 && (cfg.plainArchetypes == 0 || Chance(cfg.socketPct));
+        arch[i] = (uint16_t)(socket ? Rand() % numSocketArch
+                                    : numSocketArch + Rand() % cfg.plainArchetypes);
+        counts[arch[i]]++;
+        if (socket) socketCount++;
+    }
+
+    for (int32_t a = 0; a < numArch; ++a) {
+        SimArchetype& at = g_archetypes[a];
+        memset(&at, 0, sizeof(at));
+        ArchetypeAddFragment(at, plainFragment);
+        if (a < numSocketArch) {
+            ArchetypeAddFragment(at, w.socketsFragment);
+            ArchetypeAddFragment(at, w.connectionData);
+        }
+        for (int e = 0; e < a % (EXTRA_FRAGMENTS + 1); ++e)
+            ArchetypeAddFragment(at, extraFragments[(a + e) % EXTRA_FRAGMENTS]);
+        ArchetypeBuild(at, counts[a], cfg.entitiesPerChunk);
+    }
+
+    uintptr_t slots = (uintptr_t)Alloc((size_t)n * slotSize);
+    g_socketEntities = (SimSocketEntity*)Alloc(
+        (size_t)(socketCount ? socketCount : 1) * sizeof(SimSocketEntity));
+    g_numSocketEntities = 0;
+    int32_t* entityOfSlot = (int32_t*)Alloc((size_t)n * sizeof(int32_t));
+    SimOpenSocket* open = (SimOpenSocket*)Alloc(
+        (size_t)(socketCount ? socketCount : 1) * 5 * sizeof(SimOpenSocket));
+    int32_t numOpen = 0;
+
+    // Pass 2: slots, chunk entries and fragment data
+    for (int32_t i = 1; i < n; ++i) {
+        FMassEntityHandle h = { i, (int32_t)(1 + Rand() % 4) };
+        SimArchetype& a = g_archetypes[arch[i]];
+
+        uintptr_t slot = slots + (uintptr_t)i * slotSize;
+        WriteAt<int32_t>(slot, EntitySlotOff::SerialNumber, h.SerialNumber);
+        WriteAt<uintptr_t>(slot, EntitySlotOff::Archetype, a.mem);
+        w.liveEntities++;
+
+        int32_t s;
+        uintptr_t raw = ArchetypeAdd(a, h, s);
+        if (arch[i] >= numSocketArch) continue;
+
+        // Sockets: rails have 1-2, junctions 3 or 5.  Most attach to an
+        // open socket of an earlier entity — same position, linked both
+        // ways, recorded in both connection lists; the rest stay open.
+        bool junction = Chance(cfg.junctionPct);
+        int32_t numSockets = junction ? ((Rand() & 1) ? 3 : 5) : 1 + (int32_t)(Rand() & 1);
+
+        int32_t self = g_numSocketEntities++;
+        entityOfSlot[i] = self;
+        SimSocketEntity& se = g_socketEntities[self];
+        se.handle     = h;
+        se.sockFrag   = raw + a.offsets[1] + (uintptr_t)s * a.sizes[1];
+        se.connFrag   = raw + a.offsets[2] + (uintptr_t)s * a.sizes[2];
+        se.sockArr    = (uintptr_t)Alloc((size_t)numSockets * SocketOff::Size);
+        se.connArr    = (uintptr_t)Alloc((size_t)numSockets * ConnOff::Size);
+        se.original   = (FMassEntityHandle*)Alloc((size_t)numSockets * sizeof(FMassEntityHandle));
+        se.numSockets = numSockets;
+
+        int32_t firstOwn = numOpen;
+        double x = (double)(Rand() % 100000000) * 0.1;
+        double y = (double)(Rand() % 100000000) * 0.1;
+        for (int32_t k = 0; k < numSockets; ++k) {
+            uintptr_t sock = se.sockArr + (uintptr_t)k * SocketOff::Size;
+
+            // Open sockets of this entity are appended after 'firstOwn'
+            if (firstOwn > 0 && Chance(75)) {
+                int32_t pick = (int32_t)(Rand() % (uint32_t)firstOwn);
+                SimOpenSocket other = open[pick];
+                open[pick] = open[--firstOwn];
+                open[firstOwn] = open[--numOpen];
+
+                SimSocketEntity& oe = g_socketEntities[other.entity];
+                int32_t otherIdx = (int32_t)((other.sock - oe.sockArr) / SocketOff::Size);
+                for (size_t c = 0; c < 3; ++c)
+                    WriteAt<double>(sock, SocketOff::Location + c * 8,
+                                    ReadAt<double>(other.sock, SocketOff::Location + c * 8));
+
+                WriteAt<FMassEntityHandle>(sock, SocketOff::ConnectedEntity, oe.handle);
+                WriteAt<FMassEntityHandle>(other.sock, SocketOff::ConnectedEntity, h);
+                se.original[k] = oe.handle;
+                oe.original[otherIdx] = h;
+                AddConnection(se, k, oe.handle);
+                AddConnection(oe, otherIdx, h);
+                w.links++;
+                continue;
+            }
+
+            WriteAt<double>(sock, SocketOff::Location + 0,  x + 50.0 * k);
+            WriteAt<double>(sock, SocketOff::Location + 8,  y);
+            WriteAt<double>(sock, SocketOff::Location + 16, 0.0);
+            open[numOpen++] = SimOpenSocket{ sock, self };
+        }
+
+        w.socketEntities++;
+        w.sockets += numSockets;
+        if (numSockets >= 3) w.junctions++;
+    }
+
+    BreakLinks(cfg, w, entityOfSlot);
+
+    WriteTArray(w.entitySubsystem + ENTITY_ARRAY_OFFSET, slots, n);
+
+    g_signalCap = n;
+    g_signals = (SimSignal*)Alloc((size_t)n * sizeof(SimSignal));
+    g_signalCount = 0;
+}
+
+// ===================================================================
+// SimCreate / SimDestroy
+// ===================================================================
+
+void SimDefaultConfig(SimConfig& cfg) {
+    cfg.numObjects       = 500000;
+    cfg.numStructs       = 8000;
+    cfg.numEntities      = 50000;
+    cfg.entitySlotSize   = 16;
+    cfg.entitiesPerChunk = 128;
+    cfg.plainArchetypes  = 24;
+    cfg.socketArchetypes = 4;
+    cfg.socketPct        = 20;
+    cfg.junctionPct      = 10;
+    cfg.brokenPct        = 5;
+    cfg.retroPct         = 3;
+    cfg.compact          = 0;
+    cfg.seed             = 1;
+}
+
+bool SimCreate(const SimConfig& cfg, SimWorld& w) {
+    if (cfg.numEntities < SIM_MIN_ENTITIES || cfg.numEntities > SIM_MAX_ENTITIES ||
+        (cfg.entitySlotSize != 16 && cfg.entitySlotSize != 24 && cfg.entitySlotSize != 32) ||
+        cfg.entitiesPerChunk <= 0 || cfg.numStructs < 0 ||
+        cfg.plainArchetypes < 0 || cfg.socketArchetypes < 0 ||
+        cfg.plainArchetypes + cfg.socketArchetypes < 1 ||
+        cfg.plainArchetypes + cfg.socketArchetypes > SIM_MAX_ARCHETYPES) {
+        fprintf(stderr, "sim: invalid configuration\n");
+        return false;
+    }
+
+    SimDestroy(w);
+    g_rng = cfg.seed ? cfg.seed : 1;
+    DiscoveryResetCache();
+    WorldCacheReset();
+    PropCacheReset(0);
+
+    AddName("None");
+
+    // ---- Classes ----
+    uintptr_t classClass = NewStruct(0, AddName("Class"), 0, 0);
+    WriteAt<uintptr_t>(classClass, UObjOff::ClassPrivate, classClass);
+
+    auto newClass = [&](const char* name) { return NewStruct(classClass, AddName(name), 0, 0); };
+    uintptr_t scriptStructClass = newClass("ScriptStruct");
+    uintptr_t packageClass      = newClass("Package");
+    uintptr_t signalSubClass    = newClass("MassSignalSubsystem");
+    uintptr_t entitySubClass    = newClass("MassEntitySubsystem");
+    uintptr_t worldClass        = newClass("World");
+    uintptr_t saveSubClass      = newClass("CrMassSaveSubsystem");
+    uintptr_t processorClass    = newClass("CrLogisticsSocketsSignalProcessor");
+
+    // ---- Script structs the patch looks for ----
+    auto newStruct = [&](const char* name, uintptr_t super, int32_t size) {
+        return NewStruct(scriptStructClass, AddName(name), super, size);
+    };
+    w.scriptStructClass = scriptStructClass;
+    w.massFragment      = newStruct("MassFragment", 0, 0x1);
+    w.savableFragment   = newStruct("CrMassSavableFragment", w.massFragment, 0x1);
+    w.socketsFragment   = newStruct("CrLogisticsSocketsFragment", w.massFragment, 0x10);
+    w.junctionFragment  = newStruct("CrLogisticsJunctionSocketsFragment", w.socketsFragment, 0x18);
+    w.connectionData    = newStruct("CrCustomConnectionData", 0, 0x10);
+    w.socketStruct      = newStruct("CrLogisticsSocket", 0, (int32_t)SocketOff::Size);
+    uintptr_t structProperty = NewFieldClass(AddName("StructProperty"));
+    uintptr_t nameProperty   = NewFieldClass(AddName("NameProperty"));
+    uintptr_t intProperty    = NewFieldClass(AddName("IntProperty"));
+    AddProperty(w.socketStruct, AddName("ConnectedEntity"), 0, structProperty,
+                SocketOff::ConnectedEntity, (int32_t)sizeof(FMassEntityHandle));
+    w.socketLocationProp = AddProperty(w.socketStruct, AddName("Location"), 0, structProperty,
+                                       SocketOff::Location, 3 * (int32_t)sizeof(double));
+    AddProperty(processorClass, AddName("ExecutionPriority"), 0, intProperty, 0x280, 4);
+    AddProperty(processorClass, AddName("SocketsSignal"), 0, nameProperty,
+                SIGNAL_PROCESSOR_SIGNAL_OFFSET, (int32_t)sizeof(FName));
+    uintptr_t transformFragment = newStruct("TransformFragment", w.massFragment, 0x60);
+    const uintptr_t extraFragments[EXTRA_FRAGMENTS] = {
+        newStruct("MassVelocityFragment", w.massFragment, 0x18),
+        newStruct("CrBuildingStateFragment", w.massFragment, 0x40),
+        newStruct("CrPowerConsumerFragment", w.massFragment, 0x8),
+    };
+
+    const uintptr_t fixedStructs[] = {
+        w.massFragment, w.savableFragment, w.socketsFragment,
+        w.junctionFragment, w.connectionData, w.socketStruct, transformFragment,
+        extraFragments[0], extraFragments[1], extraFragments[2],
+    };
+    const int numFixedStructs = (int)(sizeof(fixedStructs) / sizeof(fixedStructs[0]));
+
+    // ---- Package, CDO, subsystems ----
+    uintptr_t package = NewObject(OBJECT_SIZE, packageClass, AddName("/Script/StarRupture"), 0);
+    w.processorCDO = NewObject(CDO_SIZE, processorClass,
+                               AddName("Default__CrLogisticsSocketsSignalProcessor"), package);
+    w.socketSignal = AddName("CrLogisticsSocketsSignal");
+    WriteAt<FName>(w.processorCDO, SIGNAL_PROCESSOR_SIGNAL_OFFSET, w.socketSignal);
+
+    w.world           = NewObject(OBJECT_SIZE, worldClass, AddName("SimWorld"), 0);
+    w.saveSubsystem   = NewObject(SUBSYSTEM_SIZE, saveSubClass, AddName("CrMassSaveSubsystem_0"), w.world);
+    w.signalSubsystem = NewObject(SUBSYSTEM_SIZE, signalSubClass, AddName("MassSignalSubsystem_0"), w.world);
+    w.entitySubsystem = NewObject(SUBSYSTEM_SIZE, entitySubClass, AddName("MassEntitySubsystem_0"), w.world);
+
+    w.otherWorld           = NewObject(OBJECT_SIZE, worldClass, AddName("SimOtherWorld"), 0);
+    w.otherSaveSubsystem   = NewObject(SUBSYSTEM_SIZE, saveSubClass,
+                                       AddName("CrMassSaveSubsystem_1"), w.otherWorld);
+    w.otherSignalSubsystem = NewObject(SUBSYSTEM_SIZE, signalSubClass,
+                                       AddName("MassSignalSubsystem_1"), w.otherWorld);
+    w.otherEntitySubsystem = NewObject(SUBSYSTEM_SIZE, entitySubClass,
+                                       AddName("MassEntitySubsystem_1"), w.otherWorld);
+
+    // ---- Filler classes and names ----
+    uintptr_t fillerClasses[FILLER_CLASSES];
+    char buf[64];
+    for (int i = 0; i < FILLER_CLASSES; ++i) {
+        snprintf(buf, sizeof(buf), "SimClass_%d", i);
+        fillerClasses[i] = newClass(buf);
+    }
+    FName fillerNames[FILLER_NAMES];
+    for (int i = 0; i < FILLER_NAMES; ++i) {
+        snprintf(buf, sizeof(buf), "SimObject_%d", i);
+        fillerNames[i] = AddName(buf);
+    }
+
+    // ---- Objects that get their own array slots, in registration order:
+    // classes, package and CDO early, structs spread through, worlds and
+    // their subsystems last.  Everything else is filler.
+    const uintptr_t early[] = {
+        classClass, scriptStructClass, packageClass, signalSubClass,
+        entitySubClass, worldClass, saveSubClass, processorClass, package, w.processorCDO,
+    };
+    const uintptr_t late[] = {
+        w.world, w.saveSubsystem, w.signalSubsystem, w.entitySubsystem,
+        w.otherWorld, w.otherSaveSubsystem, w.otherSignalSubsystem, w.otherEntitySubsystem,
+    };
+    const int numEarly = (int)(sizeof(early) / sizeof(early[0]));
+    const int numLate  = (int)(sizeof(late) / sizeof(late[0]));
+    const int numSpecial = numEarly + FILLER_CLASSES + cfg.numStructs + numFixedStructs + numLate;
+
+    uintptr_t* special = (uintptr_t*)Alloc((size_t)numSpecial * sizeof(uintptr_t));
+    int k = 0;
+    for (int i = 0; i < numEarly; ++i)       special[k++] = early[i];
+    for (int i = 0; i < FILLER_CLASSES; ++i) special[k++] = fillerClasses[i];
+
+    uintptr_t prev = 0;
+    int nextFixed = 0;
+    for (int i = 0; i < cfg.numStructs; ++i) {
+        while (nextFixed < numFixedStructs &&
+               i >= (int)((int64_t)cfg.numStructs * (nextFixed + 1) / (numFixedStructs + 1)))
+            special[k++] = fixedStructs[nextFixed++];
+
+        // A mix of roots, Mass fragments and short derivation chains
+        uintptr_t super = 0;
+        switch (i % 4) {
+            case 0: super = w.massFragment; break;
+            case 1: if (prev && ReadAt<int32_t>(prev, UStructOff::HierarchyDepth) < 4) super = prev; break;
+        }
+        FName name = fillerNames[i % FILLER_NAMES];
+        name.Number = (uint32_t)(i / FILLER_NAMES) + 1;
+        prev = NewStruct(scriptStructClass, name, super, 0x10);
+        special[k++] = prev;
+    }
+    while (nextFixed < numFixedStructs) special[k++] = fixedStructs[nextFixed++];
+    for (int i = 0; i < numLate; ++i)        special[k++] = late[i];
+
+    int32_t numObjects = cfg.numObjects > numSpecial ? cfg.numObjects : numSpecial;
+    w.guObjectArray = NewObjectArray(numObjects);
+    w.objArrayBase  = w.guObjectArray + GUObjOff::ObjObjects;
+
+    // Special object j goes to slot j * N / S, spread evenly and in order
+    int next = 0;
+    for (int32_t i = 0; i < numObjects; ++i) {
+        if (next < numSpecial && i == (int32_t)((int64_t)next * numObjects / numSpecial)) {
+            PlaceObject(i, special[next++]);
+            continue;
+        }
+        FName name = fillerNames[Rand() % FILLER_NAMES];
+        name.Number = Rand() % 8;
+        PlaceObject(i, NewObject(OBJECT_SIZE, fillerClasses[Rand() % FILLER_CLASSES], name, 0));
+    }
+
+    BuildEntityStore(cfg, w, transformFragment, extraFragments);
+
+    w.nameToString  = SimNameToString;
+    w.signalEntity  = SimSignalEntity;
+    w.bytesReserved = g_reserved;
+    return true;
+}
+
+void SimDestroy(SimWorld& w) {
+    ArenaRelease();
+    g_nameCount = 0;
+    g_chunks = nullptr;
+    g_signals = nullptr;
+    g_signalCap = 0;
+    g_signalCount = 0;
+    g_broken = nullptr;
+    g_numEntities = 0;
+    g_socketEntities = nullptr;
+    g_numSocketEntities = 0;
+    memset(&w, 0, sizeof(w));
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "ue_types.h"
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Synthetic UE object world for host-side runs of the patch logic.
+//
+// Builds, in plain process memory, the structures the mod reads through
+// ue_types.h: a chunked FUObjectArray, UClass / UScriptStruct objects with
+// InheritanceChain / HierarchyDepth, an FName table behind a fake
+// FName::ToString, the signal processor CDO, the Mass signal / entity
+// subsystems and a Mass entity store (slots, archetypes, chunks, socket and
+// connection fragments, and the FCrLogisticsSocket property list).
+// SignalEntity is replaced by a recorder.
+//
+// Only one world exists at a time.  Everything is carved from large
+// page allocations, so N = several million objects is fine.
+// ---------------------------------------------------------------------------
+
+// Entity slot counts FindEntityArray accepts
+constexpr int32_t SIM_MIN_ENTITIES = 100;
+constexpr int32_t SIM_MAX_ENTITIES = 1 << 21;
+
+// Archetypes get 0..3 extra filler fragments each, so the mix also varies
+// FragmentConfigs length
+constexpr int32_t SIM_MAX_ARCHETYPES = 512;
+
+struct SimConfig {
+    int32_t  numObjects;        // GUObjectArray entries, well-known objects included
+    int32_t  numStructs;        // filler UScriptStructs among them
+    int32_t  numEntities;       // Mass entity slots (SIM_MIN_ENTITIES..SIM_MAX_ENTITIES)
+    int32_t  entitySlotSize;    // bytes per entity slot: 16, 24 or 32
+    int32_t  entitiesPerChunk;
+    int32_t  plainArchetypes;   // archetypes without sockets
+    int32_t  socketArchetypes;  // archetypes carrying the sockets fragment
+    int32_t  socketPct;         // % of entities carrying the sockets fragment
+    int32_t  junctionPct;       // % of socket entities with 3 or 5 sockets
+    int32_t  brokenPct;         // % of connected socket entities that lost their links
+    int32_t  retroPct;          // % that lost links and saved connections (pre-mod saves)
+    int32_t  compact;           // 1 = loaded from a compact save: no socket locations
+    uint32_t seed;
+};
+
+struct SimWorld {
+    uintptr_t       guObjectArray;      // FUObjectArray
+    uintptr_t       objArrayBase;       // guObjectArray + ObjObjects
+    FNameToStringFn nameToString;       // fake FName::ToString
+    SignalEntityFn  signalEntity;       // recorder
+
+    // Well-known objects
+    uintptr_t scriptStructClass;
+    uintptr_t massFragment;
+    uintptr_t savableFragment;
+    uintptr_t socketsFragment;
+    uintptr_t junctionFragment;         // derived from socketsFragment
+    uintptr_t connectionData;
+    uintptr_t socketStruct;             // FCrLogisticsSocket
+    uintptr_t socketLocationProp;       // its Location FProperty
+    uintptr_t processorCDO;
+    uintptr_t world;                    // UWorld the subsystems below belong to
+    uintptr_t saveSubsystem;            // OnPostSaveLoaded 'this'
+    uintptr_t signalSubsystem;
+    uintptr_t entitySubsystem;
+    FName     socketSignal;
+
+    // A second world registered after the first (a transition or menu
+    // world), with subsystems of its own and no entities
+    uintptr_t otherWorld;
+    uintptr_t otherSaveSubsystem;
+    uintptr_t otherSignalSubsystem;
+    uintptr_t otherEntitySubsystem;
+
+    // Ground truth for the entity store
+    int32_t   liveEntities;
+    int32_t   socketEntities;
+    int32_t   junctions;
+    int32_t   sockets;
+    int32_t   links;              // socket pairs linked both ways, as generated
+    int32_t   brokenEntities;     // includes retroBroken
+    int32_t   retroBroken;
+    int32_t   wipedEntities;      // broken with an emptied Sockets array
+    size_t    bytesReserved;
+};
+
+void SimDefaultConfig(SimConfig& cfg);
+
+bool SimCreate(const SimConfig& cfg, SimWorld& w);
+void SimDestroy(SimWorld& w);
+
+// IsChildOf(parent) as the engine evaluates it
+bool SimIsChildOf(uintptr_t s, uintptr_t parent);
+
+// Whether the entity at 'index' was generated with lost socket links
+bool SimEntityBroken(int32_t index);
+
+// Sockets whose live link differs from the one generated, over every
+// socket entity whose Sockets array was not wiped
+int SimLinkMismatches();
+
+// SignalEntity calls recorded since the last reset.  The count keeps
+// going past the record buffer (one record per entity slot).
+struct SimSignal {
+    void*             subsystem;
+    FName             name;
+    FMassEntityHandle handle;
+};
+
+int              SimSignalCount();
+const SimSignal* SimSignals();
+void             SimResetSignals();
@@ -0,0 +1,850 @@
+#include "sim_world.h"
+#include "discovery.h"
+#include "compact.h"
+#include "hierarchy.h"
+#include "log.h"
+#include "mem.h"
+#include "metrics.h"
+#include "platform.h"
+#include "probe.h"
+#include "props.h"
+#include "railgraph.h"
+#include "uobject.h"
+#include "rebuild.h"
+#include "savestats.h"
+#include "sidecar.h"
+#include "worlds.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// ---------------------------------------------------------------------------
+// ssf_sim — build a synthetic object world and run the mod's init and
+// post-load logic against it: target discovery, the hierarchy patch and
+// restore (also repeated under concurrent IsChildOf readers), the
+// compact-save property patch and restore, signal
+// resolution, the property offset cache, the per-world subsystem cache,
+// the socket rebuild, a repeated load of the same world and a world
+// whose signal subsystem is not there yet,
+// the save-side sockets fragment count and async slot writes,
+// the memory probe against bad guesses, the live metrics block (written
+// through a file-backed mapping, read back as an external reader would),
+// the sidecar round trip (captured from an intact world, applied to the
+// same world built with its breaks), the rail graph of the intact world,
+// the offline repair tool on generated saves of both tag layouts and the
+// mod's own allocations.  Each phase is timed and
+// checked against the world's ground truth; exit code 0 = all passed.
+//
+//   ssf_sim [--objects N] [--structs N] [--entities N] [--slot-size 16|24|32]
+//           [--per-chunk N] [--plain-arch N] [--socket-arch N]
+//           [--socket-pct P] [--junction-pct P] [--broken-pct P]
+//           [--retro-pct P] [--compact 0|1] [--seed S] [-v]
+// ---------------------------------------------------------------------------
+
+static const HierarchyPatch g_hierarchyPatches[] = {
+    { "CrLogisticsSocketsFragment", "CrMassSavableFragment" },
+};
+
+static const CompactPatch g_compactPatches[] = {
+    { "CrLogisticsSocket", "Location" },
+};
+
+static int g_failures = 0;
+
+static double Ms(int64_t t0, int64_t t1) {
+    return (double)(t1 - t0) * 1000.0 / (double)PlatTicksPerSecond();
+}
+
+static void Report(const char* phase, int64_t t0, int64_t t1, bool ok, const char* detail) {
+    printf("  %-18s %10.3f ms  %s  %s\n", phase, Ms(t0, t1), ok ? "ok  " : "FAIL", detail);
+    if (!ok) g_failures++;
+}
+
+// ---------------------------------------------------------------------------
+// Concurrent readers for the hierarchy phase: each thread evaluates
+// IsChildOf on the patched structs the way the engine does (chain, then
+// depth) while the main thread applies and restores the patch.  A torn
+// read is a chain/depth pair whose entries are not all ancestors the
+// struct can have in either hierarchy — e.g. an old chain indexed with a
+// new, larger depth.  A transient "false" for the patched ancestor is
+// allowed; losing an unpatched ancestor is not.  The publication order
+// only covers readers that finish within HIER_GRACE_MS, so a read the
+// scheduler stretched past that (likely with more readers than cores)
+// is counted as stalled rather than checked.
+// ---------------------------------------------------------------------------
+
+static constexpr int HIER_READERS = 4;
+static constexpr int HIER_CYCLES  = 20;
+static constexpr int MAX_KNOWN    = 64;
+
+struct HierarchyReaders {
+    uintptr_t             structs[2];       // sockets fragment, junction fragment
+    uintptr_t             keptAncestor;     // ancestor of both, patched or not
+    uintptr_t             known[MAX_KNOWN]; // every chain entry either hierarchy allows
+    int                   knownCount;
+    std::atomic<bool>     stop{false};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> stalled{0};
+    std::atomic<uint64_t> torn{0};
+};
+
+static void AddKnownChain(HierarchyReaders& h, uintptr_t s) {
+    uintptr_t* chain = ReadAt<uintptr_t*>(s, UStructOff::InheritanceChain);
+    int32_t depth    = ReadAt<int32_t>(s, UStructOff::HierarchyDepth);
+    for (int32_t i = 0; i <= depth && h.knownCount < MAX_KNOWN; ++i)
+        h.known[h.knownCount++] = chain[i];
+}
+
+static bool IsKnown(const HierarchyReaders& h, uintptr_t id) {
+    for (int i = 0; i < h.knownCount; ++i)
+        if (h.known[i] == id) return true;
+    return false;
+}
+
+static void HierarchyReader(HierarchyReaders* h) {
+    const int64_t graceTicks = PlatTicksPerSecond() * HIER_GRACE_MS / 1000;
+    uint64_t reads = 0, stalled = 0, torn = 0;
+    while (!h->stop.load(std::memory_order_relaxed)) {
+        for (uintptr_t s : h->structs) {
+            int64_t t0 = PlatTicks();
+            uintptr_t* chain = ReadAt<uintptr_t*>(s, UStructOff::InheritanceChain);
+            int32_t depth    = ReadAt<int32_t>(s, UStructOff::HierarchyDepth);
+            bool ok = chain && depth >= 0 && depth < 32;
+            for (int32_t i = 0; ok && i <= depth; ++i)
+                ok = IsKnown(*h, chain[i]);
+            ok = ok && SimIsChildOf(s, h->keptAncestor);
+            if (PlatTicks() - t0 > graceTicks) stalled++;
+            else if (!ok)                      torn++;
+            reads++;
+        }
+    }
+    h->reads.fetch_add(reads, std::memory_order_relaxed);
+    h->stalled.fetch_add(stalled, std::memory_order_relaxed);
+    h->torn.fetch_add(torn, std::memory_order_relaxed);
+}
+
+static bool ParseArgs(int argc, char** argv, SimConfig& cfg) {
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strcmp(a, "-v") == 0) { g_logLevel = LOG_LEVEL_DEBUG; continue; }
+        if (i + 1 >= argc) return false;
+        long v = strtol(argv[++i], nullptr, 0);
+
+        if      (strcmp(a, "--objects") == 0)      cfg.numObjects = (int32_t)v;
+        else if (strcmp(a, "--structs") == 0)      cfg.numStructs = (int32_t)v;
+        else if (strcmp(a, "--entities") == 0)     cfg.numEntities = (int32_t)v;
+        else if (strcmp(a, "--slot-size") == 0)    cfg.entitySlotSize = (int32_t)v;
+        else if (strcmp(a, "--per-chunk") == 0)    cfg.entitiesPerChunk = (int32_t)v;
+        else if (strcmp(a, "--plain-arch") == 0)   cfg.plainArchetypes = (int32_t)v;
+        else if (strcmp(a, "--socket-arch") == 0)  cfg.socketArchetypes = (int32_t)v;
+        else if (strcmp(a, "--socket-pct") == 0)   cfg.socketPct = (int32_t)v;
+        else if (strcmp(a, "--junction-pct") == 0) cfg.junctionPct = (int32_t)v;
+        else if (strcmp(a, "--broken-pct") == 0)   cfg.brokenPct = (int32_t)v;
+        else if (strcmp(a, "--retro-pct") == 0)    cfg.retroPct = (int32_t)v;
+        else if (strcmp(a, "--compact") == 0)      cfg.compact = (int32_t)v;
+        else if (strcmp(a, "--seed") == 0)         cfg.seed = (uint32_t)v;
+        else return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Offline repair: ssf_gensave writes a save with known breaks and
+// ssf_savefix is run on it the way a player would, report only, with -o
+// and --in-place.  Its counts are checked against the generator's truth
+// line, a report must leave the file as it was, and a repaired copy must
+// keep its size and have nothing left to repair.
+// ---------------------------------------------------------------------------
+
+static const char* const SAVE_PATH  = "ssf_sim.sav";
+static const char* const FIXED_PATH = "ssf_sim_fixed.sav";
+static constexpr int     SAVE_ENTITIES = 10000;
+static constexpr size_t  TOOL_OUTPUT   = 4096;
+
+struct SaveCounts {
+    long long entities, junctions, repairable, links, unrepairable, brokenOther;
+};
+
+// Run 'cmd', keep the start of its output; returns the exit code
+static int RunTool(const char* cmd, char* out) {
+    out[0] = '\0';
+    FILE* p = popen(cmd, "r");
+    if (!p) return -1;
+    size_t n = fread(out, 1, TOOL_OUTPUT - 1, p);
+    out[n] = '\0';
+    char rest[256];
+    while (fread(rest, 1, sizeof(rest), p) > 0) {}
+    int status = pclose(p);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// Number following 'label' in a savefix report
+static long long ReportValue(const char* out, const char* label) {
+    const char* at = strstr(out, label);
+    return at ? strtoll(at + strlen(label), nullptr, 10) : -1;
+}
+
+static bool ParseReport(const char* out, bool written, SaveCounts& c) {
+    const char* verb = strstr(out, written ? "    repaired " : "would repair ");
+    const char* links = verb ? strchr(verb, '(') : nullptr;
+    c.entities     = ReportValue(out, "socket entities");
+    c.junctions    = ReportValue(out, "  junctions");
+    c.repairable   = verb ? strtoll(verb + 13, nullptr, 10) : -1;
+    c.links        = links ? strtoll(links + 1, nullptr, 10) : -1;
+    c.unrepairable = ReportValue(out, "unrepairable");
+    c.brokenOther  = ReportValue(out, "broken, not junctions");
+    return c.entities >= 0 && c.repairable >= 0 && c.links >= 0;
+}
+
+static bool SameCounts(const SaveCounts& a, const SaveCounts& b) {
+    return memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+// FNV-1a of the whole file; false if it cannot be read
+static bool FileDigest(const char* path, size_t& size, uint64_t& digest) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    uint8_t buf[64 * 1024];
+    size = 0;
+    digest = 1469598103934665603ull;
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        for (size_t i = 0; i < n; ++i) digest = (digest ^ buf[i]) * 1099511628211ull;
+        size += n;
+    }
+    fclose(f);
+    return true;
+}
+
+static bool GenerateSave(int32_t ue5, const char* layout, const char* extra,
+                         const SimConfig& cfg, SaveCounts& truth) {
+    char cmd[512], out[TOOL_OUTPUT];
+    snprintf(cmd, sizeof(cmd), "'%s' --ue5 %d --layout %s --entities %d --seed %u%s%s '%s' 2>&1",
+             SSF_GENSAVE_PATH, ue5, layout, SAVE_ENTITIES, cfg.seed,
+             cfg.compact ? " --compact" : "", extra, SAVE_PATH);
+    if (RunTool(cmd, out) != 0) return false;
+    const char* line = strstr(out, "truth:");
+    return line && sscanf(line, "truth: entities %lld junctions %lld repairable %lld links %lld "
+                                "unrepairable %lld broken-other %lld",
+                          &truth.entities, &truth.junctions, &truth.repairable, &truth.links,
+                          &truth.unrepairable, &truth.brokenOther) == 6;
+}
+
+// 'mode' is "" (report only), "-o" (to FIXED_PATH) or "--in-place"
+static int RunSaveFix(const char* mode, const char* save, char* out) {
+    char cmd[512];
+    bool copy = strcmp(mode, "-o") == 0;
+    snprintf(cmd, sizeof(cmd), "'%s' --threads 2 %s%s%s%s '%s' 2>&1", SSF_SAVEFIX_PATH, mode,
+             copy ? " '" : "", copy ? FIXED_PATH : "", copy ? "'" : "", save);
+    return RunTool(cmd, out);
+}
+
+// Cut the save off three fifths of the way into its property stream
+static bool TruncateSave() {
+    size_t size = 0;
+    uint64_t digest = 0;
+    return FileDigest(SAVE_PATH, size, digest) && truncate(SAVE_PATH, (off_t)(size * 3 / 5)) == 0;
+}
+
+// One save through all three modes
+static bool SaveFixRound(int32_t ue5, const char* layout, const SimConfig& cfg, SaveCounts& truth) {
+    char out[TOOL_OUTPUT];
+    SaveCounts c, after;
+    size_t size = 0, sizeAfter = 0, fixedSize = 0;
+    uint64_t digest = 0, digestAfter = 0, fixedDigest = 0;
+
+    if (!GenerateSave(ue5, layout, "", cfg, truth) || !FileDigest(SAVE_PATH, size, digest))
+        return false;
+
+    // Report only: right counts, nothing written
+    bool ok = RunSaveFix("", SAVE_PATH, out) == 0 && ParseReport(out, false, c) &&
+              SameCounts(c, truth) && FileDigest(SAVE_PATH, sizeAfter, digestAfter) &&
+              sizeAfter == size && digestAfter == digest;
+
+    // -o: the source stays as it was, the copy has nothing left to repair
+    ok = ok && RunSaveFix("-o", SAVE_PATH, out) == 0 &&
+         ParseReport(out, true, c) && SameCounts(c, truth) && strstr(out, "written to") &&
+         FileDigest(SAVE_PATH, sizeAfter, digestAfter) && digestAfter == digest &&
+         FileDigest(FIXED_PATH, fixedSize, fixedDigest) && fixedSize == size &&
+         fixedDigest != digest;
+    ok = ok && RunSaveFix("", FIXED_PATH, out) == 0 && ParseReport(out, false, after) &&
+         after.repairable == 0 && after.links == 0 && after.junctions == truth.junctions &&
+         after.unrepairable == truth.unrepairable && after.brokenOther == truth.brokenOther;
+
+    // --in-place: the same bytes as the copy
+    ok = ok && RunSaveFix("--in-place", SAVE_PATH, out) == 0 &&
+         ParseReport(out, true, c) && SameCounts(c, truth) &&
+         FileDigest(SAVE_PATH, sizeAfter, digestAfter) &&
+         sizeAfter == size && digestAfter == fixedDigest;
+
+    remove(SAVE_PATH);
+    remove(FIXED_PATH);
+    return ok;
+}
+
+// A save ssf_savefix must refuse: exit 1 with 'message', the save left as
+// it was and no -o copy left behind
+static bool SaveFixRejects(const char* message) {
+    char out[TOOL_OUTPUT];
+    size_t size = 0, sizeAfter = 0;
+    uint64_t digest = 0, digestAfter = 0;
+    if (!FileDigest(SAVE_PATH, size, digest)) return false;
+
+    bool ok = RunSaveFix("", SAVE_PATH, out) == 1 && strstr(out, message);
+    ok = ok && RunSaveFix("-o", SAVE_PATH, out) == 1 && strstr(out, message);
+    ok = ok && !FileDigest(FIXED_PATH, sizeAfter, digestAfter);
+    ok = ok && RunSaveFix("--in-place", SAVE_PATH, out) == 1 && strstr(out, message) &&
+         FileDigest(SAVE_PATH, sizeAfter, digestAfter) &&
+         sizeAfter == size && digestAfter == digest;
+    remove(FIXED_PATH);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    SimConfig cfg;
+    SimDefaultConfig(cfg);
+    if (!ParseArgs(argc, argv, cfg)) {
+        fprintf(stderr, "usage: ssf_sim [--objects N] [--structs N] [--entities N] "
+                        "[--slot-size 16|24|32] [--per-chunk N] [--plain-arch N] "
+                        "[--socket-arch N] [--socket-pct P] "
+                        "[--junction-pct P] [--broken-pct P] [--retro-pct P] "
+                        "[--compact 0|1] [--seed S] [-v]\n");
+        return 2;
+    }
+
+    SimWorld w = {};
+    char detail[256];
+
+    int64_t t0 = PlatTicks();
+    if (!SimCreate(cfg, w)) return 2;
+    int64_t t1 = PlatTicks();
+    printf("world: %d objects, %d entities (%d with sockets, %d junctions, %d broken, "
+           "%d of them pre-mod), %.1f MB\n",
+           ReadAt<int32_t>(w.objArrayBase, TObjOff::NumElements), w.liveEntities,
+           w.socketEntities, w.junctions, w.brokenEntities, w.retroBroken,
+           (double)w.bytesReserved / (1024.0 * 1024.0));
+    Report("build", t0, t1, true, "");
+
+    // ---- Probe: region map, then heuristics fed unmapped pointers ----
+    t0 = PlatTicks();
+    int regions = ProbeRefresh();
+    t1 = PlatTicks();
+    snprintf(detail, sizeof(detail), "%d readable regions", regions);
+    Report("probe-refresh", t0, t1, regions > 0, detail);
+
+    // Allocated before 'gone' is released, so it cannot land there
+    const size_t page = 4096;
+    uintptr_t fakeSubsystem = (uintptr_t)PlatAlloc(page);
+    uintptr_t gone = (uintptr_t)PlatAlloc(page);
+    PlatFree((void*)gone, page);
+    ProbeRefresh();
+
+    const int probes = 1000000;
+    int readable = 0;
+    t0 = PlatTicks();
+    for (int i = 0; i < probes; ++i)
+        readable += ProbeReadable(w.objArrayBase + (uintptr_t)(i & 0xFF) * 8, 8);
+    t1 = PlatTicks();
+    int32_t probed = 0;
+    bool ok = readable == probes && ObjectArrayReadable(w.objArrayBase) &&
+         !ProbeReadable(gone, 8) && !TryRead(gone, 0, probed) && !ProbeReadable(0x1000, 8);
+    snprintf(detail, sizeof(detail), "%.1f ns per probe", Ms(t0, t1) * 1e6 / probes);
+    Report("probe-lookup", t0, t1, ok, detail);
+
+    // A subsystem whose first plausible TArray points at nothing
+    WriteAt<uintptr_t>(fakeSubsystem, 0x40, gone);
+    WriteAt<int32_t>(fakeSubsystem, 0x48, 1000);
+    WriteAt<int32_t>(fakeSubsystem, 0x4C, 1000);
+    EntityArray bogus = {};
+    t0 = PlatTicks();
+    ok = !FindEntityArray(fakeSubsystem, bogus) &&
+         ReadEntityHandles({ gone, 1000, 16 }, nullptr, 0) == 0;
+    t1 = PlatTicks();
+    Report("probe-bad-guess", t0, t1, ok, "(unmapped entity array skipped)");
+    PlatFree((void*)fakeSubsystem, page);
+
+    // ---- Init: target structs ----
+    TargetStructs targets = {};
+    t0 = PlatTicks();
+    bool found = FindTargets(w.objArrayBase, w.nameToString, targets);
+    t1 = PlatTicks();
+    ok = found && targets.scriptStructClass == w.scriptStructClass &&
+              targets.socketsFragment == w.socketsFragment &&
+              targets.savableFragment == w.savableFragment &&
+              targets.massFragment == w.massFragment &&
+              targets.connectionData == w.connectionData;
+    Report("find-targets", t0, t1, ok, "");
+
+    // ---- Init: hierarchy patch, then restore ----
+    t0 = PlatTicks();
+    bool applied = HierarchyApply(w.objArrayBase, targets.scriptStructClass, w.nameToString,
+                                  g_hierarchyPatches,
+                                  (int)(sizeof(g_hierarchyPatches) / sizeof(g_hierarchyPatches[0])));
+    t1 = PlatTicks();
+    ok = applied && SimIsChildOf(w.socketsFragment, w.savableFragment) &&
+         SimIsChildOf(w.junctionFragment, w.savableFragment) &&
+         SimIsChildOf(w.junctionFragment, w.socketsFragment) &&
+         SimIsChildOf(w.socketsFragment, w.massFragment) &&
+         ReadAt<uintptr_t>(w.socketsFragment, UStructOff::SuperStruct) == w.savableFragment;
+    Report("hierarchy-apply", t0, t1, ok, "(includes grace periods)");
+
+    t0 = PlatTicks();
+    HierarchyRestore();
+    t1 = PlatTicks();
+    ok = !SimIsChildOf(w.socketsFragment, w.savableFragment) &&
+         !SimIsChildOf(w.junctionFragment, w.savableFragment) &&
+         SimIsChildOf(w.junctionFragment, w.socketsFragment) &&
+         ReadAt<uintptr_t>(w.socketsFragment, UStructOff::SuperStruct) == w.massFragment;
+    Report("hierarchy-restore", t0, t1, ok, "(includes grace periods)");
+
+    // ---- Hierarchy apply/restore cycles under concurrent readers ----
+    HierarchyReaders readers;
+    readers.structs[0]   = w.socketsFragment;
+    readers.structs[1]   = w.junctionFragment;
+    readers.keptAncestor = w.massFragment;
+    readers.knownCount   = 0;
+    AddKnownChain(readers, w.junctionFragment);
+    AddKnownChain(readers, w.savableFragment);
+
+    std::thread readerThreads[HIER_READERS];
+    for (std::thread& t : readerThreads) t = std::thread(HierarchyReader, &readers);
+    int cycles = 0;
+    t0 = PlatTicks();
+    for (int c = 0; c < HIER_CYCLES; ++c) {
+        if (!HierarchyApply(w.objArrayBase, targets.scriptStructClass, w.nameToString,
+                            g_hierarchyPatches,
+                            (int)(sizeof(g_hierarchyPatches) / sizeof(g_hierarchyPatches[0]))))
+            break;
+        HierarchyRestore();
+        cycles++;
+    }
+    t1 = PlatTicks();
+    readers.stop.store(true, std::memory_order_relaxed);
+    for (std::thread& t : readerThreads) t.join();
+
+    uint64_t tornReads = readers.torn.load();
+    ok = cycles == HIER_CYCLES && tornReads == 0 &&
+         !SimIsChildOf(w.socketsFragment, w.savableFragment);
+    snprintf(detail, sizeof(detail), "%d cycles, %llu reads on %d threads, %llu stalled, %llu torn",
+             cycles, (unsigned long long)readers.reads.load(), HIER_READERS,
+             (unsigned long long)readers.stalled.load(), (unsigned long long)tornReads);
+    Report("hierarchy-readers", t0, t1, ok, detail);
+
+    // ---- Init: compact saves, then restore ----
+    uint64_t flagsBefore = ReadAt<uint64_t>(w.socketLocationProp, FPropertyOff::PropertyFlags);
+    t0 = PlatTicks();
+    bool compacted = CompactApply(w.objArrayBase, targets.scriptStructClass, w.nameToString,
+                                  g_compactPatches,
+                                  (int)(sizeof(g_compactPatches) / sizeof(g_compactPatches[0])));
+    t1 = PlatTicks();
+    ok = compacted && ReadAt<uint64_t>(w.socketLocationProp, FPropertyOff::PropertyFlags) ==
+                      (flagsBefore | CPF_SkipSerialization);
+    Report("compact-apply", t0, t1, ok, "");
+
+    t0 = PlatTicks();
+    CompactRestore();
+    t1 = PlatTicks();
+    ok = ReadAt<uint64_t>(w.socketLocationProp, FPropertyOff::PropertyFlags) == flagsBefore;
+    Report("compact-restore", t0, t1, ok, "");
+
+    // ---- Init: signal name + subsystem ----
+    SignalLedger ledger = {};
+    RebuildEnv env = { w.objArrayBase, w.nameToString, w.signalEntity,
+                       "CrLogisticsSocketsSignal", true, true, nullptr, &ledger,
+                       w.saveSubsystem };
+    SignalState sig = {};
+    t0 = PlatTicks();
+    ResolveSignal(env, sig);
+    t1 = PlatTicks();
+    ok = sig.nameReady && sig.subsystem == (void*)w.signalSubsystem &&
+         sig.name.ComparisonIndex == w.socketSignal.ComparisonIndex;
+    Report("resolve-signal", t0, t1, ok, "");
+
+    // ---- Property cache: written after init, read back on the next launch ----
+    const char* propCachePath = "ssf_sim.props";
+    const uint64_t buildId    = 0x5F3759DF00E00000ULL;
+    PropertyInfo location = {}, signalProp = {};
+    PropCacheStats pstats;
+    PropCacheGetStats(pstats);
+    int walkedAtInit = pstats.walks;
+    bool reflected = ResolveProperty(w.nameToString, w.socketStruct, "CrLogisticsSocket",
+                                     "Location", nullptr, location);
+    PropCacheReset(buildId);
+    ResolveProperty(w.nameToString, ReadAt<uintptr_t>(w.processorCDO, UObjOff::ClassPrivate),
+                    "CrLogisticsSocketsSignalProcessor", nullptr, "NameProperty", signalProp);
+    ResolveProperty(w.nameToString, w.socketStruct, "CrLogisticsSocket",
+                    "Location", nullptr, location);
+    bool saved = PropCacheSave(propCachePath);
+
+    t0 = PlatTicks();
+    bool loaded = PropCacheLoad(propCachePath, buildId);
+    PropertyInfo cachedSignal = {}, cachedLocation = {};
+    bool hit = ResolveProperty(w.nameToString, 0, "CrLogisticsSocketsSignalProcessor",
+                               nullptr, "NameProperty", cachedSignal) &&
+               ResolveProperty(w.nameToString, 0, "CrLogisticsSocket", "Location", nullptr,
+                               cachedLocation);
+    t1 = PlatTicks();
+    PropCacheGetStats(pstats);
+    ok = walkedAtInit == 1 && reflected && location.offset == (int32_t)SocketOff::Location &&
+         location.size == 0x18 && signalProp.size == (int32_t)sizeof(FName) &&
+         ReadAt<FName>(w.processorCDO, (size_t)signalProp.offset).ComparisonIndex ==
+             w.socketSignal.ComparisonIndex &&
+         saved && loaded && hit && pstats.loaded == 2 && pstats.hits == 2 && pstats.walks == 0 &&
+         cachedSignal.offset == signalProp.offset && cachedLocation.offset == location.offset;
+    snprintf(detail, sizeof(detail), "signal at +0x%X, %d offsets read back",
+             cachedSignal.offset, pstats.loaded);
+    Report("property-cache", t0, t1, ok, detail);
+
+    // A game update (other build id) starts over
+    ok = !PropCacheLoad(propCachePath, buildId + 1);
+    PropCacheGetStats(pstats);
+    ok = ok && pstats.entries == 0;
+    Report("property-rebuild", 0, 0, ok, "(other build rejected)");
+    remove(propCachePath);
+
+    // ---- Load: subsystems of the loading world, then a cached lookup ----
+    WorldSubsystems ws, wsAgain, wsOther;
+    WorldCacheStats wstats;
+    t0 = PlatTicks();
+    bool resolved = ResolveWorldSubsystems(w.objArrayBase, w.nameToString, w.saveSubsystem, ws);
+    int64_t tScan = PlatTicks();
+    bool again = ResolveWorldSubsystems(w.objArrayBase, w.nameToString, w.saveSubsystem, wsAgain);
+    t1 = PlatTicks();
+    bool other = ResolveWorldSubsystems(w.objArrayBase, w.nameToString, w.otherSaveSubsystem, wsOther);
+    WorldCacheGetStats(wstats);
+    ok = resolved && again && other && ws.world == w.world &&
+         ws.signalSubsystem == w.signalSubsystem && ws.entitySubsystem == w.entitySubsystem &&
+         wsAgain.entitySubsystem == w.entitySubsystem &&
+         wsOther.signalSubsystem == w.otherSignalSubsystem &&
+         wsOther.entitySubsystem == w.otherEntitySubsystem &&
+         wstats.worlds == 2 && wstats.scans == 2 && wstats.hits == 1;
+    snprintf(detail, sizeof(detail), "scan %.3f ms, cached %.3f ms, %d worlds",
+             Ms(t0, tScan), Ms(tScan, t1), wstats.worlds);
+    Report("world-subsystems", t0, t1, ok, detail);
+
+    // The other world is torn down: its entry goes, this world's stays
+    WriteAt<uint32_t>(w.otherWorld, UObjOff::ObjectFlags, RF_BeginDestroyed);
+    other = ResolveWorldSubsystems(w.objArrayBase, w.nameToString, w.otherSaveSubsystem, wsOther);
+    again = ResolveWorldSubsystems(w.objArrayBase, w.nameToString, w.saveSubsystem, wsAgain);
+    WorldCacheGetStats(wstats);
+    ok = !other && again && wsAgain.signalSubsystem == w.signalSubsystem &&
+         wstats.worlds == 1 && wstats.evictions == 1 && wstats.scans == 2;
+    snprintf(detail, sizeof(detail), "%d evicted, %d worlds left", wstats.evictions, wstats.worlds);
+    Report("world-teardown", 0, 0, ok, detail);
+
+    // ---- Load: socket rebuild ----
+    SimResetSignals();
+    t0 = PlatTicks();
+    RebuildStats rebuildStats;
+    int signalled = RebuildSockets(env, sig, targets, &rebuildStats);
+    t1 = PlatTicks();
+
+    int wrong = 0;
+    int stored = SimSignalCount() < w.liveEntities ? SimSignalCount() : w.liveEntities;
+    for (int i = 0; i < stored; ++i) {
+        const SimSignal& s = SimSignals()[i];
+        if (s.subsystem != (void*)w.signalSubsystem ||
+            s.name.ComparisonIndex != w.socketSignal.ComparisonIndex ||
+            !SimEntityBroken(s.handle.Index))
+            wrong++;
+    }
+    int mismatches = SimLinkMismatches();
+    ok = signalled == w.brokenEntities && SimSignalCount() == signalled && wrong == 0 &&
+         mismatches == 0 && rebuildStats.graphDeferred == (signalled > 0) &&
+         rebuildStats.graphBuilt == (signalled == 0);
+    snprintf(detail, sizeof(detail), "%d signalled, %d expected, %d unexpected, "
+             "%d links not restored", signalled, w.brokenEntities, wrong, mismatches);
+    Report("rebuild-sockets", t0, t1, ok, detail);
+
+    // ---- Later game-thread point: the rail graph left by the load ----
+    if (rebuildStats.graphDeferred) {
+        RailGraphStats deferred;
+        t0 = PlatTicks();
+        bool ran = RunDeferredRailGraph(env, targets, deferred);
+        t1 = PlatTicks();
+        bool again = RunDeferredRailGraph(env, targets, deferred);
+        ok = ran && !again && deferred.entities == w.socketEntities;
+        snprintf(detail, sizeof(detail), "%d socket entities, %d networks",
+                 deferred.entities, deferred.networks);
+        Report("graph-deferred", t0, t1, ok, detail);
+    }
+
+    // ---- Load again: the ledger skips what this world already had signalled ----
+    RebuildStats repeatStats;
+    SimResetSignals();
+    t0 = PlatTicks();
+    int resignalled = RebuildSockets(env, sig, targets, &repeatStats);
+    t1 = PlatTicks();
+    int stillBroken = repeatStats.skipped;
+    ok = resignalled == 0 && SimSignalCount() == 0 && (stillBroken > 0 || w.wipedEntities == 0) &&
+         repeatStats.graphBuilt && repeatStats.graph.entities == w.socketEntities;
+    snprintf(detail, sizeof(detail), "%d still flagged, all skipped", stillBroken);
+    Report("rebuild-repeat", t0, t1, ok, detail);
+
+    SignalLedgerReset(ledger);
+    SimResetSignals();
+    t0 = PlatTicks();
+    resignalled = RebuildSockets(env, sig, targets, &repeatStats);
+    t1 = PlatTicks();
+    ok = resignalled == stillBroken && repeatStats.skipped == 0;
+    snprintf(detail, sizeof(detail), "%d signalled again, %d expected", resignalled, stillBroken);
+    Report("ledger-reset", t0, t1, ok, detail);
+
+    // A world rebuilt in the same slot (new serial number) starts afresh
+    uintptr_t worldItem = GetObjectItem(w.objArrayBase,
+                                        ReadAt<int32_t>(w.world, UObjOff::InternalIndex));
+    WriteAt<int32_t>(worldItem, ItemOff::SerialNumber,
+                     ReadAt<int32_t>(worldItem, ItemOff::SerialNumber) + 1);
+    SimResetSignals();
+    t0 = PlatTicks();
+    resignalled = RebuildSockets(env, sig, targets, &repeatStats);
+    t1 = PlatTicks();
+    ok = resignalled == stillBroken && repeatStats.skipped == 0;
+    snprintf(detail, sizeof(detail), "%d signalled again, %d expected", resignalled, stillBroken);
+    Report("ledger-new-world", t0, t1, ok, detail);
+
+    // A world without a signal subsystem yet is not signalled through the
+    // one kept from an earlier world
+    uintptr_t signalOuter = ReadAt<uintptr_t>(w.signalSubsystem, UObjOff::OuterPrivate);
+    WriteAt<uintptr_t>(w.signalSubsystem, UObjOff::OuterPrivate, 0);
+    WorldCacheReset();
+    SimResetSignals();
+    sig.subsystem = (void*)w.otherSignalSubsystem;
+    int staleSignalled = RebuildSockets(env, sig, targets, nullptr);
+    ok = staleSignalled < 0 && sig.subsystem == nullptr && SimSignalCount() == 0;
+    WriteAt<uintptr_t>(w.signalSubsystem, UObjOff::OuterPrivate, signalOuter);
+    WorldCacheReset();
+    RebuildSockets(env, sig, targets, nullptr);
+    ok = ok && sig.subsystem == (void*)w.signalSubsystem;
+    Report("signal-stale", 0, 0, ok, "(previous world's subsystem dropped)");
+    SignalLedgerFree(ledger);
+
+    // ---- Save: sockets fragment share ----
+    SocketShare share;
+    SaveStatsBegin();
+    t0 = PlatTicks();
+    bool measured = MeasureSocketShare(w.objArrayBase, w.nameToString, targets, share);
+    t1 = PlatTicks();
+    SaveStatsEnd(measured ? &share : nullptr, t1 - t0);
+    ok = measured && share.entities == w.socketEntities && SaveStatsCount() == 1 &&
+         SaveStatsGet(0)->shareValid;
+    snprintf(detail, sizeof(detail), "%d socket entities, %d expected, %lld sockets, %.1f MB",
+             share.entities, w.socketEntities, (long long)share.sockets,
+             (double)share.bytes / (1024.0 * 1024.0));
+    Report("save-share", t0, t1, ok, detail);
+
+    // Slot writes from another thread (async saves) while saves keep
+    // starting and ending on this one: every byte lands in a record, and
+    // bytes written after a save ended go to that save
+    const int64_t lateBytes = 3 << 20, stressBytes = 200000;
+    std::thread late([&] { SaveStatsAddBytes(lateBytes); });
+    late.join();
+    t0 = PlatTicks();
+    std::thread writer([&] { for (int64_t i = 0; i < stressBytes; ++i) SaveStatsAddBytes(1); });
+    for (int i = 0; i < 20; ++i) {
+        SaveStatsBegin();
+        SaveStatsEnd(nullptr, 0);
+    }
+    writer.join();
+    SaveStatsBegin();
+    SaveStatsEnd(nullptr, 0);
+    t1 = PlatTicks();
+    int64_t credited = 0;
+    for (int i = 1; i < SaveStatsCount(); ++i) credited += SaveStatsGet(i)->bytesWritten;
+    ok = SaveStatsCount() == 22 && SaveStatsGet(0)->bytesWritten == lateBytes &&
+         credited == stressBytes;
+    snprintf(detail, sizeof(detail), "%lld of %lld bytes credited across %d saves",
+             (long long)credited, (long long)stressBytes, SaveStatsCount() - 1);
+    Report("save-async-bytes", t0, t1, ok, detail);
+
+    // ---- Metrics: publish the load and save, read back through a second mapping ----
+    const char* metricsPath = "./ssf_sim.metrics";
+    void* metricsHandle = nullptr;
+    const MetricsBlock* reader = nullptr;
+    MetricsBlock snap;
+    t0 = PlatTicks();
+    ok = MetricsOpen(metricsPath);
+    if (MetricsData* m = MetricsBeginWrite()) {
+        m->symbols           = METRICS_SYMBOLS_INI;
+        m->init              = METRICS_INIT_DONE;
+        m->loads++;
+        m->lastLoadEntities  = rebuildStats.entitySlots;
+        m->lastLoadSignalled = signalled;
+        m->lastSignalMicros  = (uint64_t)(rebuildStats.signalTicks * 1000000 /
+                                          PlatTicksPerSecond());
+        m->saves++;
+        m->hookCount = 1;
+        strcpy(m->hooks[0].name, "OnPostSaveLoaded");
+        m->hooks[0].calls = 1;
+        MetricsEndWrite();
+    }
+    reader = ok ? MetricsAttach(metricsPath, metricsHandle) : nullptr;
+    ok = reader && MetricsSnapshot(reader, snap) && snap.pid == PlatProcessId() &&
+         snap.seq == 2 && snap.data.loads == 1 && snap.data.saves == 1 &&
+         snap.data.lastLoadEntities >= w.liveEntities &&
+         snap.data.lastLoadSignalled == w.brokenEntities && snap.data.hookCount == 1 &&
+         strcmp(snap.data.hooks[0].name, "OnPostSaveLoaded") == 0;
+
+    // A reader never takes a block that is being written
+    if (ok) {
+        MetricsBeginWrite()->errors++;
+        bool torn = MetricsSnapshot(reader, snap, 3);
+        MetricsEndWrite();
+        ok = !torn && MetricsSnapshot(reader, snap) && snap.seq == 4 && snap.data.errors == 1;
+    }
+    t1 = PlatTicks();
+    snprintf(detail, sizeof(detail), "%d slots, %lld signalled read back",
+             rebuildStats.entitySlots, reader ? (long long)snap.data.lastLoadSignalled : -1LL);
+    Report("metrics", t0, t1, ok, detail);
+    if (reader) MetricsDetach(reader, metricsHandle);
+    MetricsClose();
+    remove(metricsPath);
+
+    SimDestroy(w);
+
+    // ---- Sidecar: capture from the intact world, restore into the broken one ----
+    const char* sidecarPath = "ssf_sim.ssfs";
+    const int64_t saveBytes  = 0x5AFE;
+    const uint32_t saveSample = cfg.seed;
+
+    SimConfig intact = cfg;
+    intact.brokenPct = 0;
+    intact.retroPct  = 0;
+    intact.compact   = 0;
+    if (!SimCreate(intact, w)) return 2;
+
+    TargetStructs sideTargets = {};
+    EntityArray entities = {};
+    t0 = PlatTicks();
+    bool haveStore = FindSocketEntityStore(w.objArrayBase, w.nameToString, sideTargets, entities);
+    int captured = haveStore ? SidecarCapture(1, entities, sideTargets.socketsFragment,
+                                              sideTargets.connectionData)
+                             : -1;
+
+    // Only the save it was captured for takes it, from whichever thread
+    // writes the slot; a capture nobody takes is freed by the next one
+    bool otherTook = SidecarTake(2) != nullptr;
+    bool written = false;
+    std::thread slotWriter([&] {
+        written = SidecarWrite(SidecarTake(1), sidecarPath, saveBytes, saveSample);
+    });
+    slotWriter.join();
+    t1 = PlatTicks();
+    bool stillPending = SidecarTake(1) != nullptr;
+    if (haveStore) {
+        SidecarCapture(3, entities, sideTargets.socketsFragment, sideTargets.connectionData);
+        SidecarCapture(4, entities, sideTargets.socketsFragment, sideTargets.connectionData);
+    }
+    SidecarDiscard();
+    ok = captured == w.socketEntities && written && !otherTook && !stillPending;
+    snprintf(detail, sizeof(detail), "%d socket entities, %d expected", captured, w.socketEntities);
+    Report("sidecar-write", t0, t1, ok, detail);
+
+    // ---- Rail graph: the intact network has no broken links ----
+    RailGraphStats graph;
+    t0 = PlatTicks();
+    ok = BuildRailGraph(entities, sideTargets.socketsFragment, sideTargets.connectionData, graph);
+    t1 = PlatTicks();
+    int graphJunctions = graph.threeWay.junctions + graph.fiveWay.junctions +
+                         graph.otherJunctions.junctions;
+    ok = ok && graph.entities == w.socketEntities && graph.sockets == w.sockets &&
+         graph.linked == 2 * w.links && graph.open == w.sockets - 2 * w.links &&
+         graph.dangling == 0 && graph.oneWay == 0 && graphJunctions == w.junctions &&
+         graph.threeWay.withBrokenArms == 0 && graph.fiveWay.withBrokenArms == 0;
+    snprintf(detail, sizeof(detail), "%d sockets, %d linked, %d networks (largest %d), "
+             "%d junctions, %d broken links", graph.sockets, graph.linked, graph.networks,
+             graph.largestNetwork, graphJunctions, graph.dangling + graph.oneWay);
+    Report("rail-graph", t0, t1, ok, detail);
+    SimDestroy(w);
+
+    if (!SimCreate(cfg, w)) return 2;
+
+    Sidecar stale;
+    ok = !SidecarOpen(sidecarPath, saveBytes, saveSample + 1, stale) &&
+         !SidecarOpen(sidecarPath, saveBytes + 1, saveSample, stale);
+    Report("sidecar-stale", 0, 0, ok, "(other save rejected)");
+
+    Sidecar sidecar;
+    t0 = PlatTicks();
+    bool opened = SidecarOpen(sidecarPath, saveBytes, saveSample, sidecar);
+    t1 = PlatTicks();
+    Report("sidecar-open", t0, t1, opened, "");
+
+    RebuildEnv sideEnv = { w.objArrayBase, w.nameToString, w.signalEntity,
+                           "CrLogisticsSocketsSignal", true, false,
+                           opened ? &sidecar : nullptr, nullptr, w.saveSubsystem };
+    SignalState sideSig = {};
+    ResolveSignal(sideEnv, sideSig);
+    sideTargets = {};
+    SimResetSignals();
+    t0 = PlatTicks();
+    signalled = RebuildSockets(sideEnv, sideSig, sideTargets);
+    t1 = PlatTicks();
+    mismatches = SimLinkMismatches();
+    ok = opened && signalled == w.wipedEntities && mismatches == 0;
+    snprintf(detail, sizeof(detail), "%d signalled, %d expected (wiped), %d links not restored",
+             signalled, w.wipedEntities, mismatches);
+    Report("sidecar-rebuild", t0, t1, ok, detail);
+
+    if (opened) SidecarClose(sidecar);
+    remove(sidecarPath);
+    SimDestroy(w);
+
+    // ---- Offline repair: generated saves through ssf_savefix ----
+    SaveCounts truth = {};
+    t0 = PlatTicks();
+    ok = SaveFixRound(1009, "direct", cfg, truth);
+    SaveCounts wrapped = {};
+    ok = ok && SaveFixRound(1011, "wrapped", cfg, wrapped);
+    t1 = PlatTicks();
+    snprintf(detail, sizeof(detail), "%lld junctions, %lld repaired (%lld links), "
+             "%lld unrepairable", truth.junctions, truth.repairable, truth.links,
+             truth.unrepairable);
+    Report("savefix-classic", t0, t1, ok, detail);
+
+    t0 = PlatTicks();
+    ok = SaveFixRound(1012, "direct", cfg, truth) && SaveFixRound(1012, "wrapped", cfg, wrapped);
+    t1 = PlatTicks();
+    snprintf(detail, sizeof(detail), "%lld junctions, %lld repaired (%lld links), "
+             "%lld unrepairable", truth.junctions, truth.repairable, truth.links,
+             truth.unrepairable);
+    Report("savefix-5.4", t0, t1, ok, detail);
+
+    // Cut off mid-stream, then framed as a compressed save
+    t0 = PlatTicks();
+    ok = GenerateSave(1012, "direct", "", cfg, truth) &&
+         TruncateSave() &&
+         SaveFixRejects("malformed property stream");
+    ok = ok && GenerateSave(1009, "direct", "", cfg, truth) &&
+         TruncateSave() &&
+         SaveFixRejects("malformed property stream");
+    ok = ok && GenerateSave(1012, "direct", " --compressed", cfg, truth) &&
+         SaveFixRejects("not an uncompressed UE save");
+    t1 = PlatTicks();
+    remove(SAVE_PATH);
+    Report("savefix-reject", t0, t1, ok, "(truncated and compressed saves, nothing written)");
+
+    // ---- Memory: every phase returned what it allocated ----
+    ProbeShutdown();
+    MemStats mem;
+    MemGetStats(mem);
+    int live = 0;
+    size_t peak = 0;
+    for (int t = 0; t < MEM_TAG_COUNT; ++t) {
+        live += mem.tags[t].live;
+        peak += mem.tags[t].peak;
+    }
+    MemReport();
+    snprintf(detail, sizeof(detail), "%d allocations live, arena %.0f KB committed, "
+             "sum of tag peaks %.0f KB", live, (double)mem.arenaCommitted / 1024.0,
+             (double)peak / 1024.0);
+    Report("memory", 0, 0, live == 0, detail);
+    MemReleaseAll(0);
+
+    printf("%s\n", g_failures ? "FAILED" : "PASSED");
+    return g_failures ? 1 : 0;
+}
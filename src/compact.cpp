@@ -0,0 +1,88 @@
+#include "compact.h"
+#include "log.h"
+#include "platform.h"
+#include "props.h"
+#include "trace.h"
+#include "uobject.h"
+
+static constexpr int COMPACT_MAX_PATCHES = 16;
+
+// ===================================================================
+// Restore records
+// ===================================================================
+
+struct CompactRecord {
+    uintptr_t property;     // FProperty
+    uint64_t  origFlags;
+};
+
+static CompactRecord g_records[COMPACT_MAX_PATCHES] = {};
+static int           g_recordCount = 0;
+
+static uint64_t ReadFlags(uintptr_t prop) {
+    return ReadAt<uint64_t>(prop, FPropertyOff::PropertyFlags);
+}
+
+static void StoreFlags(uintptr_t prop, uint64_t flags) {
+    PlatStore64((void*)(prop + FPropertyOff::PropertyFlags), flags);
+}
+
+// ===================================================================
+// CompactApply / CompactRestore
+// ===================================================================
+
+bool CompactApply(uintptr_t objArrayBase, uintptr_t scriptStructClass,
+                  FNameToStringFn fn, const CompactPatch* table, int count)
+{
+    TRACE_SPAN("CompactApply");
+
+    if (count > COMPACT_MAX_PATCHES) count = COMPACT_MAX_PATCHES;
+
+    int32_t numElements = ReadAt<int32_t>(objArrayBase, TObjOff::NumElements);
+    if (numElements <= 0 || !scriptStructClass) return false;
+
+    // One pass: the owning struct of every entry
+    uintptr_t owners[COMPACT_MAX_PATCHES] = {};
+    int resolved = 0;
+    for (int32_t i = 0; i < numElements && resolved < count; ++i) {
+        uintptr_t obj = GetObject(objArrayBase, i);
+        if (!obj || ReadAt<uintptr_t>(obj, UObjOff::ClassPrivate) != scriptStructClass) continue;
+
+        for (int p = 0; p < count; ++p) {
+            if (owners[p] || !NameEqualsA(fn, obj + UObjOff::NamePrivate, table[p].structName))
+                continue;
+            owners[p] = obj;
+            resolved++;
+        }
+    }
+
+    bool allOK = true;
+    for (int p = 0; p < count; ++p) {
+        const CompactPatch& e = table[p];
+        uintptr_t prop = owners[p] ? FindPropertyField(fn, owners[p], e.property) : 0;
+        if (!prop) {
+            LogMsg("ERROR: Compact: %s.%s not found", e.structName, e.property);
+            allOK = false;
+            continue;
+        }
+
+        uint64_t flags = ReadFlags(prop);
+        if (flags & CPF_SkipSerialization) {
+            LogMsg("  Compact: %s.%s already skipped", e.structName, e.property);
+            continue;
+        }
+        if (g_recordCount >= COMPACT_MAX_PATCHES) break;
+
+        g_records[g_recordCount++] = { prop, flags };
+        StoreFlags(prop, flags | CPF_SkipSerialization);
+        LogMsg("  Compact: %s.%s left out of saves (flags 0x%016llX)",
+               e.structName, e.property, (unsigned long long)(flags | CPF_SkipSerialization));
+    }
+    return allOK;
+}
+
+void CompactRestore() {
+    for (int i = g_recordCount - 1; i >= 0; --i)
+        StoreFlags(g_records[i].property, g_records[i].origFlags);
+    g_recordCount = 0;
+}
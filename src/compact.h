@@ -0,0 +1,31 @@
+#pragma once
+#include "ue_types.h"
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Compact socket saves — leave out of the save what the post-load rebuild
+// recomputes anyway.
+//
+// Each table entry marks one property of a UScriptStruct
+// CPF_SkipSerialization, so tagged serialization writes every other
+// property of the struct and skips this one; on load it keeps its default
+// (zero).  For FCrLogisticsSocket that leaves ConnectedEntity — the link
+// the junction needs — and drops Location, which the signal processor
+// rebuilds from FCrLogisticsSocketsParams.  The socket verifier treats a
+// socket without a location as needing that rebuild, so compact saves
+// load correctly whether or not the mode is still on.
+// ---------------------------------------------------------------------------
+
+struct CompactPatch {
+    const char* structName;     // UScriptStruct owning the property
+    const char* property;       // FProperty left out of saves
+};
+
+// Resolve every entry in one object-array pass and set the flag.  Entries
+// whose flag is already set are skipped.  Returns false if any entry could
+// not be resolved (the others still apply).
+bool CompactApply(uintptr_t objArrayBase, uintptr_t scriptStructClass,
+                  FNameToStringFn fn, const CompactPatch* table, int count);
+
+// Put back the original flags of every patched property.
+void CompactRestore();
@@ -0,0 +1,354 @@
+#include "discovery.h"
+#include "log.h"
+#include "probe.h"
+#include "props.h"
+#include "trace.h"
+#include "uobject.h"
+#include <cstring>
+
+// ===================================================================
+// Target UScriptStructs (one pass)
+// ===================================================================
+
+bool FindTargets(uintptr_t objArrayBase, FNameToStringFn fn, TargetStructs& t) {
+    TRACE_SPAN("FindTargets");
+
+    int32_t numElements = ReadAt<int32_t>(objArrayBase, TObjOff::NumElements);
+    if (numElements <= 0) return false;
+
+    // Phase 1: Find UScriptStruct class if not yet known
+    if (!t.scriptStructClass) {
+        constexpr int MAX_CLASSES = 512;
+        uintptr_t checkedClasses[MAX_CLASSES];
+        int numChecked = 0;
+
+        for (int32_t i = 0; i < numElements; ++i) {
+            uintptr_t obj = GetObject(objArrayBase, i);
+            if (!obj) continue;
+
+            uintptr_t cls = ReadAt<uintptr_t>(obj, UObjOff::ClassPrivate);
+            if (!cls) continue;
+
+            bool already = false;
+            for (int c = 0; c < numChecked; ++c) {
+                if (checkedClasses[c] == cls) { already = true; break; }
+            }
+            if (already) continue;
+            if (numChecked < MAX_CLASSES) checkedClasses[numChecked++] = cls;
+
+            if (NameEqualsA(fn, cls + UObjOff::NamePrivate, "ScriptStruct")) {
+                t.scriptStructClass = cls;
+                break;
+            }
+        }
+        if (!t.scriptStructClass) return false;
+    }
+
+    // Phase 2: Find target structs by name
+    int found = (t.socketsFragment ? 1 : 0) +
+                (t.savableFragment ? 1 : 0) +
+                (t.massFragment ? 1 : 0) +
+                (t.connectionData ? 1 : 0);
+
+    for (int32_t i = 0; i < numElements && found < 4; ++i) {
+        uintptr_t obj = GetObject(objArrayBase, i);
+        if (!obj) continue;
+
+        uintptr_t cls = ReadAt<uintptr_t>(obj, UObjOff::ClassPrivate);
+        if (cls != t.scriptStructClass) continue;
+
+        uintptr_t namePtr = obj + UObjOff::NamePrivate;
+
+        if (!t.socketsFragment && NameEqualsA(fn, namePtr, "CrLogisticsSocketsFragment")) {
+            t.socketsFragment = obj;
+            found++;
+        }
+        else if (!t.savableFragment && NameEqualsA(fn, namePtr, "CrMassSavableFragment")) {
+            t.savableFragment = obj;
+            found++;
+        }
+        else if (!t.massFragment && NameEqualsA(fn, namePtr, "MassFragment")) {
+            t.massFragment = obj;
+            found++;
+        }
+        else if (!t.connectionData && NameEqualsA(fn, namePtr, "CrCustomConnectionData")) {
+            t.connectionData = obj;
+            found++;
+        }
+    }
+
+    // FCrCustomConnectionData is only needed by the socket verifier, which
+    // falls back to signalling every entity without it
+    return t.socketsFragment && t.savableFragment && t.massFragment;
+}
+
+// ===================================================================
+// Find UObject by class name (with class pointer cache)
+// ===================================================================
+
+struct ClassCacheEntry {
+    const char* name;
+    uintptr_t   classPtr;
+};
+static ClassCacheEntry g_classCache[8] = {};
+static int             g_classCacheCount = 0;
+
+uintptr_t FindObjectByClassName(uintptr_t objArrayBase, FNameToStringFn fn,
+                                const char* className, bool skipCDO) {
+    int32_t numElements = ReadAt<int32_t>(objArrayBase, TObjOff::NumElements);
+
+    uintptr_t cachedClass = 0;
+    for (int c = 0; c < g_classCacheCount; ++c) {
+        if (strcmp(g_classCache[c].name, className) == 0) {
+            cachedClass = g_classCache[c].classPtr;
+            break;
+        }
+    }
+
+    for (int32_t i = 0; i < numElements; ++i) {
+        uintptr_t obj = GetObject(objArrayBase, i);
+        if (!obj) continue;
+
+        uintptr_t cls = ReadAt<uintptr_t>(obj, UObjOff::ClassPrivate);
+        if (!cls) continue;
+
+        if (cachedClass) {
+            if (cls != cachedClass) continue;
+        } else {
+            if (!NameEqualsA(fn, cls + UObjOff::NamePrivate, className))
+                continue;
+            if (g_classCacheCount < 8) {
+                g_classCache[g_classCacheCount].name = className;
+                g_classCache[g_classCacheCount].classPtr = cls;
+                g_classCacheCount++;
+            }
+        }
+
+        if (skipCDO) {
+            uintptr_t outer = ReadAt<uintptr_t>(obj, UObjOff::OuterPrivate);
+            if (outer) {
+                uintptr_t outerClass = ReadAt<uintptr_t>(outer, UObjOff::ClassPrivate);
+                if (outerClass && NameEqualsA(fn, outerClass + UObjOff::NamePrivate, "Package"))
+                    continue;
+            }
+        }
+
+        return obj;
+    }
+    return 0;
+}
+
+void DiscoveryResetCache() {
+    g_classCacheCount = 0;
+}
+
+// ===================================================================
+// Find an FName ComparisonIndex by string
+// ===================================================================
+
+FName FindFNameByString(uintptr_t objArrayBase, FNameToStringFn fn, const char* target) {
+    int32_t numElements = ReadAt<int32_t>(objArrayBase, TObjOff::NumElements);
+
+    for (int32_t i = 0; i < numElements; ++i) {
+        uintptr_t obj = GetObject(objArrayBase, i);
+        if (!obj) continue;
+
+        uintptr_t namePtr = obj + UObjOff::NamePrivate;
+        if (NameEqualsA(fn, namePtr, target)) {
+            FName result;
+            result.ComparisonIndex = ReadAt<uint32_t>(namePtr, 0);
+            result.Number = ReadAt<uint32_t>(namePtr, 4);
+            return result;
+        }
+    }
+
+    return { 0, 0 };
+}
+
+// ===================================================================
+// Discover signal name from CrLogisticsSocketsSignalProcessor CDO
+// ===================================================================
+
+// Where one game build keeps it; used only if reflection does not find
+// the FName property on the processor class
+static constexpr size_t SIGNAL_PROCESSOR_SIGNAL_OFFSET = 0x288;
+
+static size_t SignalOffset(FNameToStringFn fn, uintptr_t processorCDO) {
+    uintptr_t cls = ReadAt<uintptr_t>(processorCDO, UObjOff::ClassPrivate);
+    PropertyInfo info;
+    if (ResolveProperty(fn, cls, "CrLogisticsSocketsSignalProcessor", nullptr, "NameProperty",
+                        info) && info.size == (int32_t)sizeof(FName)) {
+        LogMsg("Signal FName property at +0x%X", info.offset);
+        return (size_t)info.offset;
+    }
+    LogMsg("WARNING: No FName property on CrLogisticsSocketsSignalProcessor — assuming +0x%zX",
+           SIGNAL_PROCESSOR_SIGNAL_OFFSET);
+    return SIGNAL_PROCESSOR_SIGNAL_OFFSET;
+}
+
+bool DiscoverSignalName(uintptr_t objArrayBase, FNameToStringFn fn, FName& out) {
+    TRACE_SPAN("DiscoverSignalName");
+
+    if (!ObjectArrayReadable(objArrayBase)) {
+        LogMsg("WARNING: GUObjectArray not readable — signal name not discovered");
+        return false;
+    }
+
+    int32_t numElements = ReadAt<int32_t>(objArrayBase, TObjOff::NumElements);
+    uintptr_t processorCDO = 0;
+
+    for (int32_t i = 0; i < numElements; ++i) {
+        uintptr_t obj = GetObject(objArrayBase, i);
+        if (!obj) continue;
+
+        uintptr_t cls = ReadAt<uintptr_t>(obj, UObjOff::ClassPrivate);
+        if (!cls) continue;
+
+        if (NameEqualsA(fn, cls + UObjOff::NamePrivate,
+                        "CrLogisticsSocketsSignalProcessor")) {
+            uintptr_t outer = ReadAt<uintptr_t>(obj, UObjOff::OuterPrivate);
+            if (outer) {
+                uintptr_t outerClass = ReadAt<uintptr_t>(outer, UObjOff::ClassPrivate);
+                if (outerClass && NameEqualsA(fn, outerClass + UObjOff::NamePrivate, "Package")) {
+                    processorCDO = obj;
+                    LogMsg("Found CrLogisticsSocketsSignalProcessor CDO at 0x%llX",
+                           (unsigned long long)obj);
+                    break;
+                }
+            }
+            if (!processorCDO) {
+                processorCDO = obj;
+                LogMsg("Found CrLogisticsSocketsSignalProcessor instance at 0x%llX (may not be CDO)",
+                       (unsigned long long)obj);
+            }
+        }
+    }
+
+    if (!processorCDO) {
+        LogMsg("WARNING: CrLogisticsSocketsSignalProcessor not found in GUObjectArray");
+        return false;
+    }
+
+    // A guessed offset may lie past the end of the CDO on another build
+    size_t offset = SignalOffset(fn, processorCDO);
+    FName signalFName;
+    if (!TryRead(processorCDO, offset, signalFName)) {
+        LogMsg("WARNING: CDO+0x%zX not readable", offset);
+        return false;
+    }
+
+    const wchar_t* ws = NameToString(fn, processorCDO + offset);
+    if (ws && ws[0] != L'\0') {
+        char nameBuf[256];
+        WideToNarrow(ws, nameBuf, sizeof(nameBuf));
+        LogMsg("Signal name from CDO+0x%zX: \"%s\" (CompIdx=0x%X, Num=%d)",
+               offset, nameBuf, signalFName.ComparisonIndex, signalFName.Number);
+
+        out = signalFName;
+        return true;
+    }
+
+    LogMsg("WARNING: FName at CDO+0x%zX resolved to empty/null", offset);
+    return false;
+}
+
+// ===================================================================
+// Mass entity slot array
+// ===================================================================
+
+// Upper bound for a plausible entity array — large multiplayer bases run
+// to about a million entities
+static constexpr int MAX_ENTITY_INDEX = 1 << 21;
+
+// Locate the entity slot array inside UMassEntitySubsystem by probing for a
+// TArray whose elements look like {SerialNumber, Archetype*} pairs.
+bool FindEntityArray(uintptr_t entitySubsystem, EntityArray& out) {
+    TRACE_SPAN("FindEntityArray");
+
+    LogMsg("  Scanning UMassEntitySubsystem (0x%llX) for entity array...",
+           (unsigned long long)entitySubsystem);
+
+    for (size_t off = 0x30; off < 0x400; off += 8) {
+        uintptr_t arrayPtr = ReadAt<uintptr_t>(entitySubsystem, off);
+        if (arrayPtr == 0 || arrayPtr < 0x10000) continue;
+
+        int32_t num = ReadAt<int32_t>(entitySubsystem, off + 0x08);
+        int32_t max = ReadAt<int32_t>(entitySubsystem, off + 0x0C);
+
+        if (num < 100 || num > MAX_ENTITY_INDEX || max < num || max > MAX_ENTITY_INDEX * 2)
+            continue;
+
+        // Any 8 bytes followed by two plausible ints gets here; only
+        // dereference it if the whole array would be readable
+        if (!ProbeReadable(arrayPtr, (size_t)num * 16)) continue;
+
+        for (int elemSize = 16; elemSize <= 32; elemSize += 8) {
+            if (elemSize > 16 && !ProbeReadable(arrayPtr, (size_t)num * elemSize)) break;
+
+            int validCount = 0;
+            int sampleSize = (num < 20) ? num : 20;
+
+            for (int i = 0; i < sampleSize; ++i) {
+                uintptr_t elemAddr = arrayPtr + (uintptr_t)i * elemSize;
+                int32_t serial = ReadAt<int32_t>(elemAddr, EntitySlotOff::SerialNumber);
+                uintptr_t archetype = ReadAt<uintptr_t>(elemAddr, EntitySlotOff::Archetype);
+
+                if (serial > 0 && serial < 10000 &&
+                    archetype > 0x10000 && archetype < 0x7FFFFFFFFFFF) {
+                    validCount++;
+                }
+            }
+
+            if (validCount >= sampleSize / 2) {
+                LogMsg("  Found candidate entity array at subsys+0x%zX: "
+                       "ptr=0x%llX, num=%d, max=%d, elemSize=%d (%d/%d valid samples)",
+                       off, (unsigned long long)arrayPtr, num, max,
+                       elemSize, validCount, sampleSize);
+
+                out.data     = arrayPtr;
+                out.num      = num;
+                out.elemSize = elemSize;
+                return true;
+            }
+        }
+    }
+
+    LogMsg("  WARNING: Could not find entity array in UMassEntitySubsystem");
+    return false;
+}
+
+bool FindSocketEntityStore(uintptr_t objArrayBase, FNameToStringFn fn,
+                           TargetStructs& t, EntityArray& out)
+{
+    if (!t.socketsFragment || !t.connectionData) FindTargets(objArrayBase, fn, t);
+    if (!t.socketsFragment) return false;
+
+    uintptr_t entitySubsystem = FindObjectByClassName(objArrayBase, fn, "MassEntitySubsystem");
+    return entitySubsystem && FindEntityArray(entitySubsystem, out);
+}
+
+int ReadEntityHandles(const EntityArray& entities,
+                      FMassEntityHandle* outHandles, int maxHandles)
+{
+    TRACE_SPAN("ReadEntityHandles");
+
+    if (!ProbeReadable(entities.data, (size_t)entities.num * entities.elemSize)) {
+        LogMsg("  WARNING: Entity slot array not readable — no handles extracted");
+        return 0;
+    }
+
+    int count = 0;
+    for (int i = 0; i < entities.num && count < maxHandles; ++i) {
+        uintptr_t elemAddr = entities.data + (uintptr_t)i * entities.elemSize;
+        int32_t serial = ReadAt<int32_t>(elemAddr, EntitySlotOff::SerialNumber);
+
+        if (serial > 0) {
+            outHandles[count].Index = i;
+            outHandles[count].SerialNumber = serial;
+            count++;
+        }
+    }
+
+    LogMsg("  Extracted %d valid entity handles from %d slots", count, entities.num);
+    return count;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "sockets.h"
+#include "ue_types.h"
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Object discovery — linear GUObjectArray walks that locate what the patch
+// works on: the target UScriptStructs, subsystem instances, the signal
+// name on the signal processor CDO and the Mass entity slot array.
+// No OS calls, so the host simulator runs exactly this code.
+// ---------------------------------------------------------------------------
+
+struct TargetStructs {
+    uintptr_t socketsFragment;   // FCrLogisticsSocketsFragment
+    uintptr_t savableFragment;   // FCrMassSavableFragment
+    uintptr_t massFragment;      // FMassFragment
+    uintptr_t connectionData;    // FCrCustomConnectionData (optional — verifier only)
+    uintptr_t scriptStructClass; // UScriptStruct class pointer (cached)
+};
+
+// Fill in whatever is still zero in 't'.  Returns true once the three
+// structs the hierarchy patch needs are known.
+bool FindTargets(uintptr_t objArrayBase, FNameToStringFn fn, TargetStructs& t);
+
+// First object whose class is named className; skipCDO skips objects
+// whose outer is a Package (class default objects).  Class pointers are
+// cached by name.
+uintptr_t FindObjectByClassName(uintptr_t objArrayBase, FNameToStringFn fn,
+                                const char* className, bool skipCDO = false);
+
+// Forget cached class pointers (the object array was rebuilt).
+void DiscoveryResetCache();
+
+// FName of the first object named 'target', or {0,0}.
+FName FindFNameByString(uintptr_t objArrayBase, FNameToStringFn fn, const char* target);
+
+// Socket signal name stored on the CrLogisticsSocketsSignalProcessor CDO.
+bool DiscoverSignalName(uintptr_t objArrayBase, FNameToStringFn fn, FName& out);
+
+// Locate the entity slot array inside UMassEntitySubsystem.
+bool FindEntityArray(uintptr_t entitySubsystem, EntityArray& out);
+
+// Targets plus the entity slot array, for walks outside the post-load
+// path (save hooks).  Returns false if either cannot be found.
+bool FindSocketEntityStore(uintptr_t objArrayBase, FNameToStringFn fn,
+                           TargetStructs& t, EntityArray& out);
+
+// Handles of every live entity slot.
+int ReadEntityHandles(const EntityArray& entities, FMassEntityHandle* outHandles, int maxHandles);
@@ -0,0 +1,490 @@
+#include "hierarchy.h"
+#include "log.h"
+#include "mem.h"
+#include "trace.h"
+#include "platform.h"
+#include "uobject.h"
+#include <cstring>
+
+// ===================================================================
+// Restore records  (one per rewritten struct)
+// ===================================================================
+
+static constexpr int HIER_MAX_DEPTH   = 32;    // chain slots per record in the pool
+static constexpr int HIER_MAX_RECORDS = 256;
+static constexpr int HIER_MAX_PATCHES = 16;
+
+struct HierarchyRecord {
+    uintptr_t  structPtr;
+    uintptr_t* origChain;
+    int32_t    origDepth;
+    uintptr_t  origSuper;
+    uintptr_t* newChain;        // slot in g_pool
+    int32_t    newDepth;
+    uintptr_t  newSuper;
+    uint32_t   oldProtect;      // while unlocked for publication
+    bool       changed;         // differs from the original
+    bool       written;         // new values are live
+};
+
+static HierarchyRecord g_records[HIER_MAX_RECORDS] = {};
+static int             g_recordCount = 0;
+static uintptr_t*      g_pool = nullptr;
+static size_t          g_poolBytes = 0;
+
+static uintptr_t Identity(uintptr_t s) {
+    return s + UStructOff::InheritanceChain;
+}
+
+static bool ReadHierarchy(uintptr_t s, uintptr_t*& chain, int32_t& depth) {
+    chain = ReadAt<uintptr_t*>(s, UStructOff::InheritanceChain);
+    depth = ReadAt<int32_t>(s, UStructOff::HierarchyDepth);
+    return chain && depth >= 0 && depth < HIER_MAX_DEPTH - 1 && chain[depth] == Identity(s);
+}
+
+static HierarchyRecord* FindRecord(uintptr_t s) {
+    for (int i = 0; i < g_recordCount; ++i)
+        if (g_records[i].structPtr == s) return &g_records[i];
+    return nullptr;
+}
+
+static bool AddRecord(uintptr_t s) {
+    if (FindRecord(s)) return true;
+    if (g_recordCount >= HIER_MAX_RECORDS) {
+        LogMsg("ERROR: Hierarchy: more than %d structs to rewrite", HIER_MAX_RECORDS);
+        return false;
+    }
+    HierarchyRecord& r = g_records[g_recordCount];
+    memset(&r, 0, sizeof(r));
+    if (!ReadHierarchy(s, r.origChain, r.origDepth)) return false;
+    r.structPtr = s;
+    r.origSuper = ReadAt<uintptr_t>(s, UStructOff::SuperStruct);
+    r.newSuper  = r.origSuper;
+    g_recordCount++;
+    return true;
+}
+
+// Working view of a struct's chain: the pooled copy if it is being
+// rewritten, otherwise the live one.
+static bool CurrentHierarchy(uintptr_t s, const uintptr_t*& chain, int32_t& depth) {
+    if (HierarchyRecord* r = FindRecord(s)) {
+        chain = r->newChain;
+        depth = r->newDepth;
+        return true;
+    }
+    uintptr_t* live;
+    if (!ReadHierarchy(s, live, depth)) return false;
+    chain = live;
+    return true;
+}
+
+// ===================================================================
+// Resolution — one pass over GUObjectArray
+// ===================================================================
+
+struct ResolvedPatch {
+    const HierarchyPatch* entry;
+    uintptr_t child;
+    uintptr_t ancestor;
+};
+
+// Every UScriptStruct seen in the pass (descendant candidates).
+struct StructList {
+    uintptr_t* items;
+    int32_t    count;
+    int32_t    capacity;        // entries allocated in items
+};
+
+static void ResolvePass(uintptr_t objArrayBase, uintptr_t scriptStructClass, FNameToStringFn fn,
+                        ResolvedPatch* patches, int count, StructList& structs) {
+    TRACE_SPAN("HierarchyResolvePass");
+
+    // The list was sized from an earlier read; objects added since then
+    // are past its end and are left out of this pass
+    int32_t numElements = ReadAt<int32_t>(objArrayBase, TObjOff::NumElements);
+    if (numElements > structs.capacity) {
+        LogMsg("WARNING: Hierarchy: object array grew to %d during the pass — "
+               "scanning the first %d", numElements, structs.capacity);
+        numElements = structs.capacity;
+    }
+    structs.count = 0;
+
+    for (int32_t i = 0; i < numElements; ++i) {
+        uintptr_t obj = GetObject(objArrayBase, i);
+        if (!obj) continue;
+        if (ReadAt<uintptr_t>(obj, UObjOff::ClassPrivate) != scriptStructClass) continue;
+
+        structs.items[structs.count++] = obj;
+
+        // Resolve the name once and match it against every table entry
+        const wchar_t* ws = NameToString(fn, obj + UObjOff::NamePrivate);
+        if (!ws) continue;
+        char name[256];
+        WideToNarrow(ws, name, sizeof(name));
+
+        for (int p = 0; p < count; ++p) {
+            if (!patches[p].child && strcmp(name, patches[p].entry->child) == 0)
+                patches[p].child = obj;
+            if (!patches[p].ancestor && strcmp(name, patches[p].entry->ancestor) == 0)
+                patches[p].ancestor = obj;
+        }
+    }
+}
+
+// ===================================================================
+// Chain rewrite (on the pooled working copies)
+// ===================================================================
+
+static bool ApplyOne(const ResolvedPatch& p, const StructList& structs) {
+    const char* childName = p.entry->child;
+    const char* ancName   = p.entry->ancestor;
+
+    const uintptr_t* chainC; int32_t dC;
+    const uintptr_t* chainA; int32_t dA;
+    if (!CurrentHierarchy(p.child, chainC, dC) || !CurrentHierarchy(p.ancestor, chainA, dA)) {
+        LogMsg("ERROR: Hierarchy: invalid chain data for %s / %s", childName, ancName);
+        return false;
+    }
+    const uintptr_t idC = Identity(p.child);
+    const uintptr_t idA = Identity(p.ancestor);
+
+    if (dA < dC && chainC[dA] == idA) {
+        LogMsg("Hierarchy: %s already derives from %s", childName, ancName);
+        return true;
+    }
+    if (dA > dC && chainA[dC] == idC) {
+        LogMsg("ERROR: Hierarchy: %s derives from %s — would create a cycle", ancName, childName);
+        return false;
+    }
+    if (dC > 0 && (dA < dC - 1 || chainA[dC - 1] != chainC[dC - 1])) {
+        LogMsg("ERROR: Hierarchy: %s does not derive from %s's current parent", ancName, childName);
+        return false;
+    }
+
+    int32_t newDepthC = dA + 1;
+    int32_t shift     = newDepthC - dC;
+
+    // Descendants by the working chains — includes structs already
+    // rewritten by an earlier entry.
+    int descendants = 0;
+    for (int i = 0; i < structs.count; ++i) {
+        uintptr_t s = structs.items[i];
+        const uintptr_t* chainD; int32_t dD;
+        if (s == p.child || !CurrentHierarchy(s, chainD, dD)) continue;
+        if (dD <= dC || chainD[dC] != idC) continue;
+        if (dD + shift >= HIER_MAX_DEPTH) {
+            LogMsg("ERROR: Hierarchy: descendant chain too deep (%d)", dD + shift);
+            return false;
+        }
+        if (!FindRecord(s)) {
+            LogMsg("ERROR: Hierarchy: descendant 0x%llX has no restore record",
+                   (unsigned long long)s);
+            return false;
+        }
+        descendants++;
+    }
+
+    // Child: ancestor's chain followed by the child itself
+    uintptr_t prefix[HIER_MAX_DEPTH];
+    memcpy(prefix, chainA, (dA + 1) * sizeof(uintptr_t));
+    prefix[newDepthC] = idC;
+
+    for (int i = 0; i < structs.count; ++i) {
+        uintptr_t s = structs.items[i];
+        if (s == p.child) continue;
+        const uintptr_t* chainD; int32_t dD;
+        if (!CurrentHierarchy(s, chainD, dD)) continue;
+        if (dD <= dC || chainD[dC] != idC) continue;
+
+        HierarchyRecord* r = FindRecord(s);
+        uintptr_t tail[HIER_MAX_DEPTH];
+        int tailLen = dD - dC;
+        memcpy(tail, chainD + dC + 1, tailLen * sizeof(uintptr_t));
+        memcpy(r->newChain, prefix, (newDepthC + 1) * sizeof(uintptr_t));
+        memcpy(r->newChain + newDepthC + 1, tail, tailLen * sizeof(uintptr_t));
+        r->newDepth = dD + shift;
+    }
+
+    HierarchyRecord* rc = FindRecord(p.child);
+    memcpy(rc->newChain, prefix, (newDepthC + 1) * sizeof(uintptr_t));
+    rc->newDepth = newDepthC;
+    rc->newSuper = p.ancestor;
+
+    LogMsg("Hierarchy: %s under %s — depth %d -> %d, %d descendant(s)",
+           childName, ancName, dC, newDepthC, descendants);
+    return true;
+}
+
+// ===================================================================
+// Write / verify
+// ===================================================================
+
+// Publication
+//
+// Mass worker threads may be running IsChildOf on these structs while the
+// patch thread rewrites them.  IsChildOf(T) reads this->InheritanceChain,
+// then T->HierarchyDepth, then chain[depth] — three independent loads, so
+// the fields are published in an order where every mix a reader can see
+// indexes inside the chain it loaded:
+//
+//   apply    new chains fully built (pool slots are HIER_MAX_DEPTH wide,
+//            zero past the end, so any depth < 32 is a valid index)
+//            -> chain pointers -> grace -> depths -> SuperStruct
+//   restore  SuperStruct -> depths -> grace -> chain pointers -> grace
+//            -> free pool
+//
+// Depths only grow under a patch, so a new chain read with an old depth
+// stays in bounds.  The grace period (process-wide barrier + a short
+// sleep) lets a reader that loaded an old chain pointer before it was
+// replaced finish before any depth it could pair it with grows.  Readers
+// in the window may get a transient "false" for the patched subtree;
+// they never read out of bounds.  Each store is an aligned atomic
+// (sequentially consistent) store.
+// ===================================================================
+
+static void GracePeriod() {
+    PlatFlushWriteBuffers();
+    PlatSleep(HIER_GRACE_MS);
+}
+
+static bool Unlock(HierarchyRecord& r) {
+    return PlatUnlock((void*)(r.structPtr + UStructOff::InheritanceChain), 0x18,
+                      r.oldProtect);
+}
+
+static void Relock(HierarchyRecord& r) {
+    PlatRelock((void*)(r.structPtr + UStructOff::InheritanceChain), 0x18, r.oldProtect);
+}
+
+static void StoreChain(HierarchyRecord& r, uintptr_t* chain) {
+    PlatStorePtr((void*)(r.structPtr + UStructOff::InheritanceChain), (uintptr_t)chain);
+}
+
+static void StoreDepth(HierarchyRecord& r, int32_t depth) {
+    PlatStore32((void*)(r.structPtr + UStructOff::HierarchyDepth), depth);
+}
+
+static void StoreSuper(HierarchyRecord& r, uintptr_t super) {
+    PlatStorePtr((void*)(r.structPtr + UStructOff::SuperStruct), super);
+}
+
+// Make every changed record writable up front so publication itself
+// cannot fail half-way.  Returns the number unlocked.
+static int UnlockChanged() {
+    int n = 0;
+    for (int i = 0; i < g_recordCount; ++i) {
+        HierarchyRecord& r = g_records[i];
+        if (!r.changed) continue;
+        if (!Unlock(r)) {
+            LogMsg("ERROR: Hierarchy: could not unlock 0x%llX",
+                   (unsigned long long)r.structPtr);
+            while (--i >= 0)
+                if (g_records[i].changed) Relock(g_records[i]);
+            return -1;
+        }
+        n++;
+    }
+    return n;
+}
+
+static void RelockChanged() {
+    for (int i = 0; i < g_recordCount; ++i)
+        if (g_records[i].changed) Relock(g_records[i]);
+}
+
+static int PublishNew() {
+    int n = UnlockChanged();
+    if (n <= 0) return n;
+
+    for (int i = 0; i < g_recordCount; ++i)
+        if (g_records[i].changed) StoreChain(g_records[i], g_records[i].newChain);
+    GracePeriod();
+    for (int i = 0; i < g_recordCount; ++i)
+        if (g_records[i].changed) StoreDepth(g_records[i], g_records[i].newDepth);
+    for (int i = 0; i < g_recordCount; ++i)
+        if (g_records[i].changed) StoreSuper(g_records[i], g_records[i].newSuper);
+
+    RelockChanged();
+    for (int i = 0; i < g_recordCount; ++i)
+        if (g_records[i].changed) g_records[i].written = true;
+    return n;
+}
+
+// Returns false if written chains could not be unlocked and are still
+// live (they point into the pool).
+static bool PublishOriginal() {
+    bool anyWritten = false;
+    for (int i = 0; i < g_recordCount; ++i)
+        anyWritten = anyWritten || g_records[i].written;
+    if (!anyWritten) return true;
+
+    if (UnlockChanged() <= 0) return false;
+
+    for (int i = g_recordCount - 1; i >= 0; --i)
+        if (g_records[i].written) StoreSuper(g_records[i], g_records[i].origSuper);
+    for (int i = g_recordCount - 1; i >= 0; --i)
+        if (g_records[i].written) StoreDepth(g_records[i], g_records[i].origDepth);
+    GracePeriod();
+    for (int i = g_recordCount - 1; i >= 0; --i)
+        if (g_records[i].written) StoreChain(g_records[i], g_records[i].origChain);
+
+    RelockChanged();
+    for (int i = 0; i < g_recordCount; ++i)
+        g_records[i].written = false;
+
+    GracePeriod();   // before the pool holding the new chains is freed
+    return true;
+}
+
+// IsChildOf(target) as the engine evaluates it
+static bool IsChildOf(uintptr_t s, uintptr_t target) {
+    uintptr_t* chain; int32_t depth;
+    uintptr_t* tChain; int32_t tDepth;
+    if (!ReadHierarchy(s, chain, depth) || !ReadHierarchy(target, tChain, tDepth)) return false;
+    return tDepth <= depth && chain[tDepth] == Identity(target);
+}
+
+// ===================================================================
+// HierarchyApply / HierarchyRestore
+// ===================================================================
+
+bool HierarchyApply(uintptr_t objArrayBase, uintptr_t scriptStructClass,
+                    FNameToStringFn fn, const HierarchyPatch* table, int count) {
+    TRACE_SPAN("HierarchyApply");
+
+    if (g_pool) {
+        LogMsg("WARNING: Hierarchy patches already applied");
+        return true;
+    }
+    if (count > HIER_MAX_PATCHES) count = HIER_MAX_PATCHES;
+
+    ResolvedPatch patches[HIER_MAX_PATCHES] = {};
+    for (int p = 0; p < count; ++p) patches[p].entry = &table[p];
+
+    int32_t numElements = ReadAt<int32_t>(objArrayBase, TObjOff::NumElements);
+    if (numElements <= 0) return false;
+
+    StructList structs;
+    const size_t listBytes = (size_t)numElements * sizeof(uintptr_t);
+    structs.capacity = numElements;
+    structs.items = (uintptr_t*)MemAlloc(MEM_HIERARCHY, listBytes);
+    if (!structs.items) {
+        LogMsg("ERROR: Hierarchy: allocation failed for struct list");
+        return false;
+    }
+    ResolvePass(objArrayBase, scriptStructClass, fn, patches, count, structs);
+    LogMsg("Hierarchy: %d patch(es), %d UScriptStructs scanned", count, structs.count);
+
+    bool allOK = true;
+
+    // Restore records: every child and every current descendant of it.
+    // Re-parenting only adds ancestors, so this set does not change as
+    // entries are applied.
+    g_recordCount = 0;
+    for (int p = 0; p < count; ++p) {
+        ResolvedPatch& rp = patches[p];
+        if (!rp.child || !rp.ancestor) {
+            LogMsg("ERROR: Hierarchy: %s%s%s not found",
+                   rp.child ? "" : rp.entry->child,
+                   (!rp.child && !rp.ancestor) ? " / " : "",
+                   rp.ancestor ? "" : rp.entry->ancestor);
+            allOK = false;
+            continue;
+        }
+        uintptr_t* chainC; int32_t dC;
+        if (!ReadHierarchy(rp.child, chainC, dC) || !AddRecord(rp.child)) {
+            LogMsg("ERROR: Hierarchy: invalid chain data for %s", rp.entry->child);
+            rp.child = 0;
+            allOK = false;
+            continue;
+        }
+        for (int i = 0; i < structs.count; ++i) {
+            uintptr_t* chainD; int32_t dD;
+            uintptr_t s = structs.items[i];
+            if (!ReadHierarchy(s, chainD, dD)) continue;
+            if (dD > dC && chainD[dC] == Identity(rp.child) && !AddRecord(s)) {
+                allOK = false;
+                break;
+            }
+        }
+    }
+
+    if (g_recordCount == 0) {
+        MemFree(MEM_HIERARCHY, structs.items, listBytes);
+        return false;
+    }
+
+    // One pooled allocation holds every rewritten chain
+    g_poolBytes = (size_t)g_recordCount * HIER_MAX_DEPTH * sizeof(uintptr_t);
+    g_pool = (uintptr_t*)MemAlloc(MEM_HIERARCHY, g_poolBytes);
+    if (!g_pool) {
+        LogMsg("ERROR: Hierarchy: allocation failed for chain pool");
+        MemFree(MEM_HIERARCHY, structs.items, listBytes);
+        g_recordCount = 0;
+        return false;
+    }
+    for (int i = 0; i < g_recordCount; ++i) {
+        HierarchyRecord& r = g_records[i];
+        r.newChain = g_pool + (size_t)i * HIER_MAX_DEPTH;
+        r.newDepth = r.origDepth;
+        memcpy(r.newChain, r.origChain, (r.origDepth + 1) * sizeof(uintptr_t));
+    }
+
+    for (int p = 0; p < count; ++p) {
+        if (patches[p].child && !ApplyOne(patches[p], structs))
+            allOK = false;
+    }
+    MemFree(MEM_HIERARCHY, structs.items, listBytes);
+
+    // Publish every struct whose chain actually changed
+    for (int i = 0; i < g_recordCount; ++i) {
+        HierarchyRecord& r = g_records[i];
+        r.changed = (r.newDepth != r.origDepth || r.newSuper != r.origSuper);
+        if (!r.changed) continue;
+
+        for (int d = 0; d <= r.newDepth; ++d)
+            LogDebug("  0x%llX chain[%d] = 0x%llX%s", (unsigned long long)r.structPtr, d,
+                     (unsigned long long)r.newChain[d], (d == r.newDepth) ? " [SELF]" : "");
+    }
+    int written = PublishNew();
+    if (written < 0) {
+        allOK = false;
+        written = 0;
+    }
+
+    // Verify IsChildOf(ancestor) for each child and its whole subtree
+    for (int p = 0; p < count; ++p) {
+        const ResolvedPatch& rp = patches[p];
+        if (!rp.child) continue;
+
+        int checked = 0, failed = 0;
+        for (int i = 0; i < g_recordCount; ++i) {
+            uintptr_t s = g_records[i].structPtr;
+            if (s != rp.child && !IsChildOf(s, rp.child)) continue;
+            checked++;
+            if (!IsChildOf(s, rp.ancestor)) failed++;
+        }
+        LogMsg("  IsChildOf(%s) = %s for %s + %d descendant(s)",
+               rp.entry->ancestor, failed ? "FALSE" : "TRUE", rp.entry->child, checked - 1);
+        if (failed) allOK = false;
+    }
+
+    LogMsg("Hierarchy: %d struct(s) rewritten", written);
+    return allOK;
+}
+
+void HierarchyRestore() {
+    if (!PublishOriginal()) {
+        // Live chains still point into the pool: keep it, and the records,
+        // so readers stay valid and a later restore can try again
+        LogMsg("ERROR: Hierarchy: could not restore original chains — "
+               "leaving %zu bytes of rewritten chains allocated", g_poolBytes);
+        return;
+    }
+    g_recordCount = 0;
+
+    if (g_pool) {
+        MemFree(MEM_HIERARCHY, g_pool, g_poolBytes);
+        g_pool = nullptr;
+    }
+}
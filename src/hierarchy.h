@@ -0,0 +1,38 @@
+#pragma once
+#include "ue_types.h"
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Declarative UStruct hierarchy patches.
+//
+// UE5 answers IsChildOf from a flat ancestor array (InheritanceChain) and
+// HierarchyDepth on every UStruct, not by walking SuperStruct.  Each table
+// entry re-parents 'child' under 'ancestor': the child's chain becomes the
+// ancestor's chain plus the child, and the chain of every struct derived
+// from the child is rebuilt the same way so IsChildOf(ancestor) holds for
+// the whole subtree.
+//
+// The ancestor must already derive from the child's current parent, so no
+// existing IsChildOf relationship is lost.
+// ---------------------------------------------------------------------------
+
+// How long a concurrent IsChildOf may take and still be guaranteed to
+// read inside the chain it loaded (see Publication in hierarchy.cpp).
+constexpr uint32_t HIER_GRACE_MS = 10;
+
+struct HierarchyPatch {
+    const char* child;          // struct to re-parent
+    const char* ancestor;       // inserted as its new direct parent
+};
+
+// Resolve every entry and collect all UScriptStructs in a single
+// object-array pass, then rewrite the affected chains from one pooled
+// allocation.  Entries already in effect are skipped.  Returns false if any
+// entry could not be resolved or applied (the others still are).
+bool HierarchyApply(uintptr_t objArrayBase, uintptr_t scriptStructClass,
+                    FNameToStringFn fn, const HierarchyPatch* table, int count);
+
+// Restore every rewritten struct (reverse order) and free the pool.  If
+// the originals cannot be written back, the pool the live chains point
+// into is kept (and logged) rather than freed.
+void HierarchyRestore();
@@ -1,184 +1,868 @@
 #include "hook.h"
+#include "log.h"
+#include "mem.h"
+#include "nearalloc.h"
 #include <windows.h>
+#include <tlhelp32.h>
 #include <cstring>
 
-extern void LogMsg(const char* fmt, ...);
-
 // ---------------------------------------------------------------------------
-// Trampoline layout (variable size):
+// Hook slot layout (one NearAlloc slot per hook):
 //
-//   [stolen bytes, with E8 fixups]     stealSize bytes
-//   FF 25 00 00 00 00                  6 bytes  (jmp [rip+0])
-//   <absolute 8-byte address>          8 bytes  (target + stealSize)
+//   relay        FF 25 00 00 00 00 <detour>           14 bytes (padded to 16)
+//   trampoline   [relocated stolen instructions]      grows when rel8
+//                                                     branches become rel32
+//                FF 25 00 00 00 00 <target+steal>     14 bytes
 //
-// Total = stealSize + 14
+// The target itself gets a 5-byte E9 rel32 to the relay, plus NOPs up to
+// the end of the last stolen instruction.
 // ---------------------------------------------------------------------------
 
 // 14-byte absolute jmp sequence for x64:
 //   FF 25 00 00 00 00   jmp [rip+0]
 //   <8-byte address>
-static constexpr size_t ABS_JMP_SIZE = 14;
+static constexpr size_t ABS_JMP_SIZE    = 14;
+static constexpr size_t REL_JMP_SIZE    = 5;
+static constexpr size_t RELAY_SIZE      = 16;
+static constexpr size_t TRAMPOLINE_MAX  = 112;
+static constexpr size_t HOOK_BLOCK_SIZE = RELAY_SIZE + TRAMPOLINE_MAX;
+static_assert(HOOK_BLOCK_SIZE <= NEAR_SLOT_SIZE, "hook block must fit one near slot");
+static constexpr size_t MAX_STEAL       = REL_JMP_SIZE + 15 - 1;   // < sizeof(origBytes)
+
+// ===================================================================
+// Length disassembler (x64 long mode)
+//
+// Only needs to find instruction boundaries and the fields that must be
+// rewritten when an instruction moves: RIP-relative disp32 operands and
+// relative branch displacements.  Covers the legacy one-byte map, 0F,
+// 0F 38, 0F 3A, VEX (C4/C5) and EVEX (62).
+// ===================================================================
+
+enum BranchKind : uint8_t {
+    BR_NONE,
+    BR_JMP,         // EB rel8, E9 rel32
+    BR_JCC,         // 7x rel8, 0F 8x rel32
+    BR_CALL,        // E8 rel32
+    BR_LOOP,        // E0-E3 rel8 (loop/jrcxz) — no rel32 form, not relocatable
+};
+
+struct Instr {
+    uint8_t    len;
+    int8_t     ripDisp;     // offset of a RIP-relative disp32, or -1
+    int8_t     rel;         // offset of the branch displacement, or -1
+    uint8_t    relSize;     // 1 or 4
+    BranchKind branch;
+    uint8_t    cond;        // Jcc condition code (low nibble of the opcode)
+    bool       terminator;  // ret / jmp / int3 — control does not fall through
+};
+
+enum : uint8_t {
+    OP_MODRM = 0x01,
+    OP_I8    = 0x02,
+    OP_I16   = 0x04,
+    OP_IZ    = 0x08,        // imm16 with 66 prefix, else imm32
+    OP_IV    = 0x10,        // mov r, imm64 with REX.W
+    OP_MOFFS = 0x20,        // 8-byte absolute address (4 with 67 prefix)
+    OP_GRP3  = 0x40,        // F6/F7: immediate only for /0 and /1 (test)
+    OP_BAD   = 0x80,
+};
+
+static uint8_t OneByteFlags(uint8_t op) {
+    if (op < 0x40) {
+        switch (op & 7) {
+            case 4:  return OP_I8;
+            case 5:  return OP_IZ;
+            case 6:
+            case 7:  return OP_BAD;     // push/pop seg, daa/das/aaa/aas
+            default: return OP_MODRM;
+        }
+    }
+    if (op < 0x60) return 0;                        // push/pop r64
+    if (op == 0x63) return OP_MODRM;                // movsxd
+    if (op < 0x68) return OP_BAD;
+    switch (op) {
+        case 0x68: return OP_IZ;
+        case 0x69: return OP_MODRM | OP_IZ;
+        case 0x6A: return OP_I8;
+        case 0x6B: return OP_MODRM | OP_I8;
+    }
+    if (op < 0x70) return 0;                        // ins/outs
+    if (op < 0x80) return OP_I8;                    // jcc rel8
+    switch (op) {
+        case 0x80: return OP_MODRM | OP_I8;
+        case 0x81: return OP_MODRM | OP_IZ;
+        case 0x82: return OP_BAD;
+        case 0x83: return OP_MODRM | OP_I8;
+    }
+    if (op < 0x90) return OP_MODRM;
+    if (op == 0x9A) return OP_BAD;
+    if (op < 0xA0) return 0;
+    if (op < 0xA4) return OP_MOFFS;
+    if (op == 0xA8) return OP_I8;
+    if (op == 0xA9) return OP_IZ;
+    if (op < 0xB0) return 0;                        // movs/cmps/stos/lods/scas
+    if (op < 0xB8) return OP_I8;
+    if (op < 0xC0) return OP_IV;
+    switch (op) {
+        case 0xC0: case 0xC1: case 0xC6: return OP_MODRM | OP_I8;
+        case 0xC7: return OP_MODRM | OP_IZ;
+        case 0xC2: case 0xCA: return OP_I16;
+        case 0xC8: return OP_I16 | OP_I8;           // enter
+        case 0xCD: return OP_I8;
+        case 0xCE: case 0xD4: case 0xD5: case 0xD6: case 0xEA: return OP_BAD;
+    }
+    if (op >= 0xD0 && op <= 0xD3) return OP_MODRM;
+    if (op >= 0xD8 && op <= 0xDF) return OP_MODRM; // x87
+    if (op >= 0xE0 && op <= 0xE7) return OP_I8;   // loop/jrcxz, in/out imm8
+    if (op == 0xE8 || op == 0xE9) return OP_IZ;
+    if (op == 0xEB) return OP_I8;
+    if (op == 0xF6 || op == 0xF7) return OP_MODRM | OP_GRP3;
+    if (op == 0xFE || op == 0xFF) return OP_MODRM;
+    return 0;
+}
 
-// Allocate executable memory within ±2GB of 'nearAddr' so that E8 (call rel32)
-// fixups in the trampoline can reach the original call targets.
-static void* AllocateNear(uintptr_t nearAddr, size_t size) {
-    // Search in 64KB-aligned steps within ±0x7FFF0000 (~2GB) of nearAddr
-    const uintptr_t RANGE = 0x7FFF0000ULL;
-    const uintptr_t ALIGN = 0x10000ULL;  // 64KB allocation granularity
+static bool TwoByteHasModrm(uint8_t op) {
+    switch (op) {
+        case 0x05: case 0x06: case 0x07: case 0x08: case 0x09:
+        case 0x0B: case 0x0E: case 0x77:
+        case 0xA0: case 0xA1: case 0xA2: case 0xA8: case 0xA9: case 0xAA:
+            return false;
+    }
+    if (op >= 0x30 && op <= 0x37) return false;     // wrmsr/rdtsc/sysenter...
+    if (op >= 0x80 && op <= 0x8F) return false;     // jcc rel32
+    if (op >= 0xC8 && op <= 0xCF) return false;     // bswap
+    return true;
+}
 
-    uintptr_t lo = (nearAddr > RANGE) ? (nearAddr - RANGE) : 0x10000;
-    uintptr_t hi = nearAddr + RANGE;
+static bool TwoByteHasImm8(uint8_t op) {
+    return (op >= 0x70 && op <= 0x73) || op == 0x0F || op == 0xA4 || op == 0xAC ||
+           op == 0xBA || op == 0xC2 || op == 0xC4 || op == 0xC5 || op == 0xC6;
+}
 
-    // Round lo up to alignment
-    lo = (lo + ALIGN - 1) & ~(ALIGN - 1);
+static bool DecodeInstr(const uint8_t* code, Instr& in) {
+    memset(&in, 0, sizeof(in));
+    in.ripDisp = -1;
+    in.rel     = -1;
+
+    const uint8_t* p = code;
+    bool opsize16 = false, addr32 = false, rexW = false;
+
+    // ---- Legacy prefixes ----
+    for (;;) {
+        uint8_t b = *p;
+        if (b == 0x66)      opsize16 = true;
+        else if (b == 0x67) addr32 = true;
+        else if (b != 0xF0 && b != 0xF2 && b != 0xF3 && b != 0x2E && b != 0x36 &&
+                 b != 0x3E && b != 0x26 && b != 0x64 && b != 0x65) break;
+        if (++p - code > 14) return false;
+    }
 
-    // Search upward from the target first (more likely to find space above .text)
-    for (uintptr_t addr = nearAddr & ~(ALIGN - 1); addr < hi; addr += ALIGN) {
-        MEMORY_BASIC_INFORMATION mbi;
-        if (VirtualQuery((void*)addr, &mbi, sizeof(mbi)) == 0)
-            continue;
+    // ---- REX ----
+    if ((*p & 0xF0) == 0x40) {
+        rexW = (*p & 0x08) != 0;
+        ++p;
+    }
 
-        if (mbi.State == MEM_FREE && mbi.RegionSize >= size) {
-            void* p = VirtualAlloc((void*)addr, size,
-                                   MEM_COMMIT | MEM_RESERVE,
-                                   PAGE_EXECUTE_READWRITE);
-            if (p) return p;
+    uint8_t op = *p++;
+    bool   hasModrm = false;
+    bool   grp3     = false;
+    size_t imm      = 0;
+
+    if (op == 0x0F) {
+        uint8_t op2 = *p++;
+        if (op2 == 0x38) {
+            ++p;
+            hasModrm = true;
+        } else if (op2 == 0x3A) {
+            ++p;
+            hasModrm = true;
+            imm = 1;
+        } else if (op2 >= 0x80 && op2 <= 0x8F) {
+            in.branch  = BR_JCC;
+            in.cond    = op2 & 0x0F;
+            in.rel     = (int8_t)(p - code);
+            in.relSize = 4;
+            imm = 4;
+        } else {
+            hasModrm = TwoByteHasModrm(op2);
+            if (TwoByteHasImm8(op2)) imm = 1;
         }
+    } else if (op == 0xC4 || op == 0xC5 || op == 0x62) {
+        // VEX / EVEX — LES/LDS/BOUND do not exist in long mode
+        int map;
+        uint8_t vop;
+        if (op == 0xC5)      { map = 1;         vop = p[1]; p += 2; }
+        else if (op == 0xC4) { map = p[0] & 0x1F; vop = p[2]; p += 3; }
+        else                 { map = p[0] & 0x07; vop = p[3]; p += 4; }
+        hasModrm = !(map == 1 && vop == 0x77);      // vzeroupper/vzeroall
+        if (map == 3 || (map == 1 && ((vop >= 0x70 && vop <= 0x73) ||
+                                      vop == 0xC2 || (vop >= 0xC4 && vop <= 0xC6))))
+            imm = 1;
+    } else {
+        uint8_t f = OneByteFlags(op);
+        if (f & OP_BAD) return false;
+        hasModrm = (f & OP_MODRM) != 0;
+        grp3     = (f & OP_GRP3) != 0;
+        if (f & OP_I8)    imm += 1;
+        if (f & OP_I16)   imm += 2;
+        if (f & OP_IZ)    imm += (opsize16 && op != 0xE8 && op != 0xE9) ? 2 : 4;
+        if (f & OP_IV)    imm += rexW ? 8 : (opsize16 ? 2 : 4);
+        if (f & OP_MOFFS) imm += addr32 ? 4 : 8;
+
+        if (op >= 0x70 && op <= 0x7F) { in.branch = BR_JCC; in.cond = op & 0x0F; }
+        else if (op >= 0xE0 && op <= 0xE3) in.branch = BR_LOOP;
+        else if (op == 0xE8) in.branch = BR_CALL;
+        else if (op == 0xE9 || op == 0xEB) in.branch = BR_JMP;
+
+        if (in.branch != BR_NONE) {
+            in.rel     = (int8_t)(p - code);
+            in.relSize = (uint8_t)imm;
+        }
+        if (op == 0xC3 || op == 0xC2 || op == 0xCB || op == 0xCA || op == 0xCC ||
+            op == 0xE9 || op == 0xEB)
+            in.terminator = true;
     }
 
-    // Search downward
-    for (uintptr_t addr = (nearAddr & ~(ALIGN - 1)) - ALIGN; addr >= lo; addr -= ALIGN) {
-        MEMORY_BASIC_INFORMATION mbi;
-        if (VirtualQuery((void*)addr, &mbi, sizeof(mbi)) == 0)
-            continue;
+    // ---- ModRM / SIB / displacement ----
+    if (hasModrm) {
+        uint8_t modrm = *p++;
+        uint8_t mod = modrm >> 6;
+        uint8_t reg = (modrm >> 3) & 7;
+        uint8_t rm  = modrm & 7;
+
+        if (grp3 && reg <= 1) imm += (op == 0xF6) ? 1 : (opsize16 ? 2 : 4);
+        if (op == 0xFF && (reg == 4 || reg == 5)) in.terminator = true;  // jmp r/m
+
+        if (mod != 3) {
+            size_t disp = 0;
+            if (rm == 4) {
+                uint8_t sib = *p++;
+                if (mod == 0 && (sib & 7) == 5) disp = 4;
+            } else if (mod == 0 && rm == 5) {
+                in.ripDisp = (int8_t)(p - code);
+                disp = 4;
+            }
+            if (mod == 1) disp = 1;
+            if (mod == 2) disp = 4;
+            p += disp;
+        }
+    }
+
+    size_t len = (size_t)(p - code) + imm;
+    if (len > 15) return false;
+    in.len = (uint8_t)len;
+    return true;
+}
+
+// ===================================================================
+// Relocator
+// ===================================================================
+
+static bool FitsRel32(int64_t v) {
+    return v >= INT32_MIN && v <= INT32_MAX;
+}
 
-        if (mbi.State == MEM_FREE && mbi.RegionSize >= size) {
-            void* p = VirtualAlloc((void*)addr, size,
-                                   MEM_COMMIT | MEM_RESERVE,
-                                   PAGE_EXECUTE_READWRITE);
-            if (p) return p;
+static void WriteAbsJmp(uint8_t* dst, uintptr_t to) {
+    dst[0] = 0xFF;
+    dst[1] = 0x25;
+    memset(dst + 2, 0, 4);
+    memcpy(dst + 6, &to, 8);
+}
+
+// Copy one stolen instruction from 'src' to 'dst', re-targeting anything
+// relative to its address.  [stealBegin, stealEnd) is the stolen range —
+// branches into it cannot be relocated.  Returns bytes written, 0 on failure.
+static size_t RelocateInstr(const Instr& in, uintptr_t src, uint8_t* dst,
+                            uintptr_t stealBegin, uintptr_t stealEnd)
+{
+    uintptr_t dstAddr = (uintptr_t)dst;
+    uintptr_t next    = src + in.len;
+
+    if (in.branch != BR_NONE) {
+        int64_t rel = (in.relSize == 1)
+            ? (int64_t)*(const int8_t*)(src + in.rel)
+            : (int64_t)*(const int32_t*)(src + in.rel);
+        uintptr_t dest = next + rel;
+
+        if (in.branch == BR_LOOP) {
+            LogMsg("ERROR: loop/jrcxz at 0x%llX cannot be relocated", (unsigned long long)src);
+            return 0;
+        }
+        if (dest >= stealBegin && dest < stealEnd) {
+            LogMsg("ERROR: branch at 0x%llX targets the stolen bytes (0x%llX)",
+                   (unsigned long long)src, (unsigned long long)dest);
+            return 0;
+        }
+
+        if (in.branch == BR_JMP) {
+            int64_t d = (int64_t)dest - (int64_t)(dstAddr + 5);
+            if (FitsRel32(d)) {
+                int32_t d32 = (int32_t)d;
+                dst[0] = 0xE9;
+                memcpy(dst + 1, &d32, 4);
+                return 5;
+            }
+            WriteAbsJmp(dst, dest);
+            return ABS_JMP_SIZE;
+        }
+        if (in.branch == BR_JCC) {
+            int64_t d = (int64_t)dest - (int64_t)(dstAddr + 6);
+            if (FitsRel32(d)) {
+                int32_t d32 = (int32_t)d;
+                dst[0] = 0x0F;
+                dst[1] = (uint8_t)(0x80 | in.cond);
+                memcpy(dst + 2, &d32, 4);
+                return 6;
+            }
+            // j!cc over an absolute jmp
+            dst[0] = (uint8_t)(0x70 | (in.cond ^ 1));
+            dst[1] = (uint8_t)ABS_JMP_SIZE;
+            WriteAbsJmp(dst + 2, dest);
+            return 2 + ABS_JMP_SIZE;
+        }
+        // BR_CALL
+        int64_t d = (int64_t)dest - (int64_t)(dstAddr + 5);
+        if (FitsRel32(d)) {
+            int32_t d32 = (int32_t)d;
+            dst[0] = 0xE8;
+            memcpy(dst + 1, &d32, 4);
+            return 5;
         }
+        // call [rip+2]; jmp +8; <abs>
+        static const uint8_t farCall[] = { 0xFF, 0x15, 0x02, 0x00, 0x00, 0x00, 0xEB, 0x08 };
+        memcpy(dst, farCall, sizeof(farCall));
+        memcpy(dst + sizeof(farCall), &dest, 8);
+        return sizeof(farCall) + 8;
     }
 
-    return nullptr;
+    memcpy(dst, (const void*)src, in.len);
+
+    if (in.ripDisp >= 0) {
+        int32_t oldDisp;
+        memcpy(&oldDisp, (const void*)(src + in.ripDisp), 4);
+        uintptr_t ref = next + (int64_t)oldDisp;
+        int64_t newDisp = (int64_t)ref - (int64_t)(dstAddr + in.len);
+        if (!FitsRel32(newDisp)) {
+            LogMsg("ERROR: RIP-relative operand at 0x%llX (-> 0x%llX) out of reach of trampoline",
+                   (unsigned long long)src, (unsigned long long)ref);
+            return 0;
+        }
+        int32_t d32 = (int32_t)newDisp;
+        memcpy(dst + in.ripDisp, &d32, 4);
+        LogDebug("  RIP fixup at 0x%llX: disp 0x%08X -> 0x%08X (ref 0x%llX)",
+                 (unsigned long long)src, (uint32_t)oldDisp, (uint32_t)d32,
+                 (unsigned long long)ref);
+    }
+    return in.len;
 }
 
-bool InstallHook(InlineHook& hook, uintptr_t target, void* detour, size_t stealSize) {
-    if (stealSize < ABS_JMP_SIZE) {
-        LogMsg("ERROR: stealSize %zu < %zu minimum", stealSize, ABS_JMP_SIZE);
+// ===================================================================
+// Thread suspension
+//
+// Every other thread in the process is suspended for the duration of a
+// commit so nothing executes a prologue while it is half-written.  The
+// handle array is allocated before the first SuspendThread — a suspended
+// thread may own the heap lock.
+// ===================================================================
+
+struct SuspendedThreads {
+    HANDLE* handles;
+    int     count;
+    int     capacity;
+};
+
+static bool SuspendOtherThreads(SuspendedThreads& st) {
+    st.handles  = nullptr;
+    st.count    = 0;
+    st.capacity = 0;
+
+    HANDLE snap = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snap == INVALID_HANDLE_VALUE) {
+        LogMsg("ERROR: CreateToolhelp32Snapshot failed (err=%lu)", GetLastError());
         return false;
     }
 
-    hook.target    = target;
-    hook.detour    = detour;
-    hook.stealSize = stealSize;
-    hook.installed = false;
+    const DWORD pid = GetCurrentProcessId();
+    const DWORD tid = GetCurrentThreadId();
+    THREADENTRY32 te;
 
-    // --- Allocate trampoline (RWX) near the target for E8 rel32 reach ---
-    size_t trampolineSize = stealSize + ABS_JMP_SIZE;
-    hook.trampoline = AllocateNear(target, trampolineSize);
-    if (!hook.trampoline) {
-        LogMsg("ERROR: AllocateNear failed — no free memory within ±2GB of 0x%llX",
-               (unsigned long long)target);
+    int total = 0;
+    te.dwSize = sizeof(te);
+    for (BOOL ok = Thread32First(snap, &te); ok; ok = Thread32Next(snap, &te))
+        if (te.th32OwnerProcessID == pid && te.th32ThreadID != tid) total++;
+
+    st.capacity = total + 64;   // slack for threads started since the count
+    st.handles = (HANDLE*)MemAlloc(MEM_HOOKS, st.capacity * sizeof(HANDLE));
+    if (!st.handles) {
+        CloseHandle(snap);
         return false;
     }
 
-    // --- Copy stolen bytes to trampoline ---
-    memcpy(hook.origBytes, (void*)target, stealSize);
-    memcpy(hook.trampoline, (void*)target, stealSize);
-
-    // --- Fix up E8 (call rel32) instructions in the stolen region ---
-    // E8 is 5 bytes: opcode + 4-byte signed displacement
-    uint8_t* tramp = (uint8_t*)hook.trampoline;
-    for (size_t i = 0; i + 5 <= stealSize; ) {
-        if (tramp[i] == 0xE8) {
-            // Original absolute target = target + i + 5 + old_disp
-            int32_t oldDisp;
-            memcpy(&oldDisp, tramp + i + 1, 4);
-            uintptr_t callTarget = target + i + 5 + (int64_t)oldDisp;
-
-            // New displacement from trampoline location
-            uintptr_t newCallSite = (uintptr_t)(tramp + i);
-            int64_t newDisp64 = (int64_t)callTarget - (int64_t)(newCallSite + 5);
-
-            // Check if it fits in int32
-            if (newDisp64 < INT32_MIN || newDisp64 > INT32_MAX) {
-                LogMsg("WARNING: E8 fixup at offset %zu: displacement 0x%llX out of int32 range",
-                       i, (unsigned long long)newDisp64);
-                // This can happen if trampoline is allocated far from the original code.
-                // Fall through — the call will crash, but we log it.
+    te.dwSize = sizeof(te);
+    for (BOOL ok = Thread32First(snap, &te); ok && st.count < st.capacity;
+         ok = Thread32Next(snap, &te)) {
+        if (te.th32OwnerProcessID != pid || te.th32ThreadID == tid) continue;
+
+        HANDLE h = OpenThread(THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT |
+                              THREAD_SET_CONTEXT | THREAD_QUERY_INFORMATION,
+                              FALSE, te.th32ThreadID);
+        if (!h) continue;                       // thread already exited
+        if (SuspendThread(h) == (DWORD)-1) {
+            CloseHandle(h);
+            continue;
+        }
+        st.handles[st.count++] = h;
+    }
+    CloseHandle(snap);
+    return true;
+}
+
+static void ResumeThreads(SuspendedThreads& st) {
+    for (int i = 0; i < st.count; ++i) {
+        ResumeThread(st.handles[i]);
+        CloseHandle(st.handles[i]);
+    }
+    MemFree(MEM_HOOKS, st.handles, st.capacity * sizeof(HANDLE));
+    st.handles = nullptr;
+    st.count   = 0;
+}
+
+// ===================================================================
+// Retired slots
+//
+// A detour still running when its hook is removed calls the original
+// through hook.trampoline, so a removed hook keeps its relay/trampoline
+// slot and pointers.  The slot is listed here and freed by
+// HookReleaseRetired (unload), or taken back if the same hook is
+// installed again.  Slots holding a relocated call are never freed.
+// ===================================================================
+
+struct RetiredSlot {
+    InlineHook* owner;
+    void*       block;
+};
+
+static constexpr int RETIRED_MAX = 32;
+static RetiredSlot   g_retired[RETIRED_MAX];
+static int           g_retiredCount = 0;
+
+static void RetireSlot(InlineHook& hook) {
+    if (!hook.relay) return;
+    if (hook.keepSlot) {
+        LogDebug("  trampoline 0x%llX holds a relocated call — slot kept",
+                 (unsigned long long)(uintptr_t)hook.trampoline);
+        return;
+    }
+    for (int i = 0; i < g_retiredCount; ++i)
+        if (g_retired[i].block == hook.relay) return;
+    if (g_retiredCount == RETIRED_MAX) {
+        LogDebug("  retired-slot list full — slot 0x%llX kept",
+                 (unsigned long long)(uintptr_t)hook.relay);
+        return;
+    }
+    g_retired[g_retiredCount++] = { &hook, hook.relay };
+}
+
+static void UnretireSlot(const InlineHook& hook) {
+    for (int i = 0; i < g_retiredCount; ++i) {
+        if (g_retired[i].block == hook.relay) {
+            g_retired[i] = g_retired[--g_retiredCount];
+            return;
+        }
+    }
+}
+
+void HookReleaseRetired() {
+    for (int i = 0; i < g_retiredCount; ++i) {
+        InlineHook& hook = *g_retired[i].owner;
+        NearFree(g_retired[i].block);
+        if (hook.relay == g_retired[i].block)
+            hook.relay = hook.trampoline = nullptr;
+    }
+    g_retiredCount = 0;
+}
+
+// ===================================================================
+// Prepare — decode, relocate and build the relay/trampoline slot.
+// Touches nothing at the target; the patch itself is written by commit.
+// hook.relay/trampoline change only once the new slot is complete, so a
+// call still running through a removed hook's trampoline keeps working.
+// ===================================================================
+
+// A removed hook installed again at the same target with the same detour
+// takes its slot back: the relay and trampoline are still correct
+static bool ReuseSlot(InlineHook& hook, uintptr_t target, void* detour) {
+    if (!hook.relay || hook.installed || hook.target != target || hook.detour != detour)
+        return false;
+    if (memcmp((const void*)target, hook.origBytes, hook.stealSize) != 0)
+        return false;
+    UnretireSlot(hook);
+    LogDebug("Hook prepared: target=0x%llX reuses slot 0x%llX",
+             (unsigned long long)target, (unsigned long long)(uintptr_t)hook.relay);
+    return true;
+}
+
+static bool PrepareHook(InlineHook& hook, uintptr_t target, void* detour) {
+    if (ReuseSlot(hook, target, detour)) return true;
+
+    hook.installed = false;
+    bool keepSlot  = false;
+
+    // --- Decode whole instructions until a rel32 jmp fits ---
+    Instr instrs[REL_JMP_SIZE];
+    int numInstrs = 0;
+    size_t steal = 0;
+    while (steal < REL_JMP_SIZE) {
+        Instr& in = instrs[numInstrs];
+        if (!DecodeInstr((const uint8_t*)(target + steal), in)) {
+            LogMsg("ERROR: Cannot decode instruction at 0x%llX (+%zu)",
+                   (unsigned long long)(target + steal), steal);
+            return false;
+        }
+        LogDebug("  stolen+%zu: len=%u rip=%d branch=%d",
+                 steal, in.len, in.ripDisp, (int)in.branch);
+        steal += in.len;
+        numInstrs++;
+
+        // A function shorter than the patch is only safe to hook if what
+        // follows is int3 padding rather than another function.
+        if (in.terminator && steal < REL_JMP_SIZE) {
+            for (size_t i = steal; i < REL_JMP_SIZE; ++i) {
+                if (*(const uint8_t*)(target + i) != 0xCC) {
+                    LogMsg("ERROR: Function at 0x%llX ends after %zu bytes — too short to hook",
+                           (unsigned long long)target, steal);
+                    return false;
+                }
             }
+            steal = REL_JMP_SIZE;
+            break;
+        }
+    }
+    if (steal > MAX_STEAL) {
+        LogMsg("ERROR: stolen region of %zu bytes exceeds %zu", steal, MAX_STEAL);
+        return false;
+    }
+
+    // --- Allocate relay + trampoline slot near the target ---
+    uint8_t* block = (uint8_t*)NearAlloc(target, HOOK_BLOCK_SIZE);
+    if (!block) {
+        LogMsg("ERROR: NearAlloc failed — no free memory within ±2GB of 0x%llX",
+               (unsigned long long)target);
+        return false;
+    }
 
-            int32_t newDisp = (int32_t)newDisp64;
-            memcpy(tramp + i + 1, &newDisp, 4);
+    int64_t relayDisp = (int64_t)(uintptr_t)block - (int64_t)(target + REL_JMP_SIZE);
+    if (!FitsRel32(relayDisp)) {
+        LogMsg("ERROR: relay at 0x%llX out of rel32 reach of 0x%llX",
+               (unsigned long long)(uintptr_t)block, (unsigned long long)target);
+        NearFree(block);
+        return false;
+    }
 
-            LogMsg("  E8 fixup at stolen+%zu: old_disp=0x%08X new_disp=0x%08X target=0x%llX",
-                   i, (uint32_t)oldDisp, (uint32_t)newDisp,
-                   (unsigned long long)callTarget);
+    if (!NearWriteBegin(block, HOOK_BLOCK_SIZE)) {
+        LogMsg("ERROR: Cannot make hook slot writable (err=%lu)", GetLastError());
+        NearFree(block);
+        return false;
+    }
 
-            i += 5;
+    WriteAbsJmp(block, (uintptr_t)detour);
+
+    // --- Relocate stolen instructions into the trampoline ---
+    uint8_t* tramp = block + RELAY_SIZE;
+    uint8_t srcOffsets[sizeof(hook.srcOffsets)];
+    uint8_t trampOffsets[sizeof(hook.trampOffsets)];
+    size_t out = 0;
+    size_t srcOff = 0;
+    for (int i = 0; i < numInstrs; ++i) {
+        size_t n = 0;
+        if (out + 2 + ABS_JMP_SIZE + ABS_JMP_SIZE > TRAMPOLINE_MAX) {
+            LogMsg("ERROR: trampoline overflow relocating 0x%llX", (unsigned long long)target);
         } else {
-            i++;
+            n = RelocateInstr(instrs[i], target + srcOff, tramp + out,
+                              target, target + steal);
+        }
+        if (!n) {
+            NearWriteEnd(block, HOOK_BLOCK_SIZE);
+            NearFree(block);
+            return false;
         }
+        if (instrs[i].branch == BR_CALL) keepSlot = true;
+        srcOffsets[i]   = (uint8_t)srcOff;
+        trampOffsets[i] = (uint8_t)out;
+        srcOff += instrs[i].len;
+        out += n;
     }
 
     // --- Append absolute jmp back to (target + stealSize) ---
-    uint8_t* jmpBack = tramp + stealSize;
-    jmpBack[0] = 0xFF;
-    jmpBack[1] = 0x25;
-    jmpBack[2] = 0x00;
-    jmpBack[3] = 0x00;
-    jmpBack[4] = 0x00;
-    jmpBack[5] = 0x00;
-    uintptr_t returnAddr = target + stealSize;
-    memcpy(jmpBack + 6, &returnAddr, 8);
-
-    // --- Write absolute jmp to detour at the original target ---
-    DWORD oldProtect;
-    if (!VirtualProtect((void*)target, stealSize, PAGE_EXECUTE_READWRITE, &oldProtect)) {
-        LogMsg("ERROR: VirtualProtect failed (err=%lu)", GetLastError());
-        VirtualFree(hook.trampoline, 0, MEM_RELEASE);
-        hook.trampoline = nullptr;
+    // Recorded as one more map entry so a thread parked on it maps back
+    // to the first byte after the stolen range.
+    srcOffsets[numInstrs]   = (uint8_t)steal;
+    trampOffsets[numInstrs] = (uint8_t)out;
+    WriteAbsJmp(tramp + out, target + steal);
+    NearWriteEnd(block, HOOK_BLOCK_SIZE);
+
+    // The previous slot, if any, is already retired (or kept)
+    hook.target     = target;
+    hook.detour     = detour;
+    hook.stealSize  = steal;
+    hook.numInstrs  = (uint8_t)numInstrs;
+    memcpy(hook.origBytes, (void*)target, steal);
+    memcpy(hook.srcOffsets, srcOffsets, (size_t)numInstrs + 1);
+    memcpy(hook.trampOffsets, trampOffsets, (size_t)numInstrs + 1);
+    hook.relay      = block;
+    hook.trampoline = tramp;
+    hook.keepSlot   = keepSlot;
+
+    LogDebug("Hook prepared: target=0x%llX relay=0x%llX trampoline=0x%llX "
+             "steal=%zu (%d instrs, %zu relocated bytes)",
+             (unsigned long long)target,
+             (unsigned long long)(uintptr_t)hook.relay,
+             (unsigned long long)(uintptr_t)hook.trampoline,
+             steal, numInstrs, out);
+    return true;
+}
+
+// ===================================================================
+// Commit helpers
+// ===================================================================
+
+// Move a suspended thread whose RIP lies inside a range being rewritten.
+// Installing: stolen bytes -> matching trampoline instruction.
+// Removing:   trampoline -> matching original instruction, relay -> detour.
+// Returns false if RIP sits mid-way through an expanded branch sequence
+// that has no original counterpart.
+static bool RelocateThreadRip(const InlineHook& hook, bool removing, DWORD64& rip) {
+    const uintptr_t tramp = (uintptr_t)hook.trampoline;
+    const uintptr_t relay = (uintptr_t)hook.relay;
+
+    if (!removing) {
+        // rip == target is left alone: it will execute the new jmp.
+        if (rip <= hook.target || rip >= hook.target + hook.stealSize) return true;
+        for (int i = 1; i < hook.numInstrs; ++i) {
+            if (rip == hook.target + hook.srcOffsets[i]) {
+                rip = tramp + hook.trampOffsets[i];
+                return true;
+            }
+        }
         return false;
     }
 
-    uint8_t* dst = (uint8_t*)target;
-    dst[0] = 0xFF;
-    dst[1] = 0x25;
-    dst[2] = 0x00;
-    dst[3] = 0x00;
-    dst[4] = 0x00;
-    dst[5] = 0x00;
-    uintptr_t detourAddr = (uintptr_t)detour;
-    memcpy(dst + 6, &detourAddr, 8);
+    if (rip >= relay && rip < relay + RELAY_SIZE) {
+        rip = (uintptr_t)hook.detour;
+        return true;
+    }
+    if (rip < tramp || rip >= tramp + TRAMPOLINE_MAX) return true;
+    for (int i = 0; i <= hook.numInstrs; ++i) {
+        if (rip == tramp + hook.trampOffsets[i]) {
+            rip = hook.target + hook.srcOffsets[i];
+            return true;
+        }
+    }
+    return false;
+}
+
+// Store 'len' bytes of code.  If they sit within one aligned qword the
+// store is a single atomic exchange, so even a thread that escaped
+// suspension sees either the old or the new bytes, never a mix.
+static void StoreCode(uintptr_t dst, const uint8_t* bytes, size_t len) {
+    uintptr_t q = dst & ~(uintptr_t)7;
+    if (dst + len <= q + 8) {
+        uint64_t v = *(volatile uint64_t*)q;
+        memcpy((uint8_t*)&v + (dst - q), bytes, len);
+        InterlockedExchange64((volatile LONG64*)q, (LONG64)v);
+    } else {
+        memcpy((void*)dst, bytes, len);
+    }
+}
+
+// Write the jmp (installing) or the original bytes (removing).  The 5-byte
+// head is the only part a thread entering the function can reach, so it is
+// written last on removal and first on install.
+static void WritePatch(const InlineHook& hook, bool removing) {
+    uint8_t code[sizeof(hook.origBytes)];
+    if (removing) {
+        memcpy(code, hook.origBytes, hook.stealSize);
+    } else {
+        int32_t rel32 = (int32_t)((int64_t)(uintptr_t)hook.relay -
+                                  (int64_t)(hook.target + REL_JMP_SIZE));
+        code[0] = 0xE9;
+        memcpy(code + 1, &rel32, 4);
+        for (size_t i = REL_JMP_SIZE; i < hook.stealSize; ++i)
+            code[i] = 0x90;     // NOP the rest of the stolen bytes
+    }
+
+    size_t tail = hook.stealSize - REL_JMP_SIZE;
+    if (removing && tail)
+        StoreCode(hook.target + REL_JMP_SIZE, code + REL_JMP_SIZE, tail);
+    StoreCode(hook.target, code, REL_JMP_SIZE);
+    if (!removing && tail)
+        StoreCode(hook.target + REL_JMP_SIZE, code + REL_JMP_SIZE, tail);
+}
+
+// ===================================================================
+// Transactions
+// ===================================================================
+
+void HookTxBegin(HookTransaction& tx) {
+    tx.count  = 0;
+    tx.failed = false;
+}
+
+static bool TxAppend(HookTransaction& tx, InlineHook& hook, bool removing) {
+    if (tx.count >= HOOK_TX_MAX) {
+        LogMsg("ERROR: hook transaction full (%d entries)", HOOK_TX_MAX);
+        tx.failed = true;
+        return false;
+    }
+    tx.hooks[tx.count]  = &hook;
+    tx.remove[tx.count] = removing;
+    tx.count++;
+    return true;
+}
+
+bool HookTxInstall(HookTransaction& tx, InlineHook& hook, uintptr_t target, void* detour) {
+    if (tx.failed) return false;
+    if (!PrepareHook(hook, target, detour)) {
+        tx.failed = true;
+        return false;
+    }
+    if (!TxAppend(tx, hook, false)) {
+        RetireSlot(hook);
+        return false;
+    }
+    return true;
+}
+
+bool HookTxRemove(HookTransaction& tx, InlineHook& hook) {
+    if (tx.failed) return false;
+    if (!hook.installed) return true;
+    return TxAppend(tx, hook, true);
+}
+
+void HookTxAbort(HookTransaction& tx) {
+    // Only installs own resources before commit; queued removals are
+    // simply forgotten.  A prepared slot is published in hook.trampoline,
+    // so it is retired rather than freed.
+    for (int i = 0; i < tx.count; ++i) {
+        if (!tx.remove[i]) RetireSlot(*tx.hooks[i]);
+    }
+    tx.count  = 0;
+    tx.failed = false;
+}
+
+bool HookTxCommit(HookTransaction& tx) {
+    if (tx.failed) {
+        HookTxAbort(tx);
+        return false;
+    }
+    if (tx.count == 0) return true;
 
-    // NOP any remaining stolen bytes beyond the 14-byte jmp
-    for (size_t i = ABS_JMP_SIZE; i < stealSize; ++i)
-        dst[i] = 0x90;
+    SuspendedThreads st;
+    if (!SuspendOtherThreads(st)) {
+        HookTxAbort(tx);
+        return false;
+    }
 
-    VirtualProtect((void*)target, stealSize, oldProtect, &oldProtect);
-    FlushInstructionCache(GetCurrentProcess(), (void*)target, stealSize);
+    // --- Relocate threads parked inside any range being rewritten ---
+    // All contexts are checked before any is changed, so a failure leaves
+    // every thread exactly where it was.
+    alignas(16) CONTEXT ctx;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int t = 0; t < st.count; ++t) {
+            memset(&ctx, 0, sizeof(ctx));
+            ctx.ContextFlags = CONTEXT_CONTROL;
+            if (!GetThreadContext(st.handles[t], &ctx)) continue;
+
+            DWORD64 rip = ctx.Rip;
+            for (int i = 0; i < tx.count; ++i) {
+                if (!RelocateThreadRip(*tx.hooks[i], tx.remove[i], rip)) {
+                    LogMsg("ERROR: thread parked mid-trampoline at 0x%llX — hook commit aborted",
+                           (unsigned long long)ctx.Rip);
+                    ResumeThreads(st);
+                    HookTxAbort(tx);
+                    return false;
+                }
+            }
+            if (pass == 1 && rip != ctx.Rip) {
+                LogDebug("  thread RIP 0x%llX -> 0x%llX",
+                         (unsigned long long)ctx.Rip, (unsigned long long)rip);
+                ctx.Rip = rip;
+                SetThreadContext(st.handles[t], &ctx);
+            }
+        }
+    }
 
-    hook.installed = true;
+    // --- Make every target writable before touching any of them ---
+    DWORD oldProtect[HOOK_TX_MAX];
+    for (int i = 0; i < tx.count; ++i) {
+        InlineHook& hook = *tx.hooks[i];
+        if (!VirtualProtect((void*)hook.target, hook.stealSize,
+                            PAGE_EXECUTE_READWRITE, &oldProtect[i])) {
+            LogMsg("ERROR: VirtualProtect failed at 0x%llX (err=%lu)",
+                   (unsigned long long)hook.target, GetLastError());
+            DWORD tmp;
+            while (--i >= 0)
+                VirtualProtect((void*)tx.hooks[i]->target, tx.hooks[i]->stealSize,
+                               oldProtect[i], &tmp);
+            ResumeThreads(st);
+            HookTxAbort(tx);
+            return false;
+        }
+    }
 
-    LogMsg("Hook installed: target=0x%llX -> detour=0x%llX, trampoline=0x%llX, steal=%zu",
-           (unsigned long long)target,
-           (unsigned long long)(uintptr_t)detour,
-           (unsigned long long)(uintptr_t)hook.trampoline,
-           stealSize);
+    // --- Write — nothing below can fail ---
+    for (int i = 0; i < tx.count; ++i) {
+        InlineHook& hook = *tx.hooks[i];
+        DWORD tmp;
+        WritePatch(hook, tx.remove[i]);
+        VirtualProtect((void*)hook.target, hook.stealSize, oldProtect[i], &tmp);
+        FlushInstructionCache(GetCurrentProcess(), (void*)hook.target, hook.stealSize);
+    }
 
+    int suspended = st.count;
+    ResumeThreads(st);
+
+    for (int i = 0; i < tx.count; ++i) {
+        InlineHook& hook = *tx.hooks[i];
+        if (tx.remove[i]) {
+            hook.installed = false;
+            // A detour still running may call the original through the
+            // trampoline: the slot and pointers stay until unload
+            RetireSlot(hook);
+            LogMsg("Hook removed: target=0x%llX", (unsigned long long)hook.target);
+        } else {
+            hook.installed = true;
+            LogMsg("Hook installed: target=0x%llX -> relay=0x%llX -> detour=0x%llX, "
+                   "trampoline=0x%llX, steal=%zu (%d instrs)",
+                   (unsigned long long)hook.target,
+                   (unsigned long long)(uintptr_t)hook.relay,
+                   (unsigned long long)(uintptr_t)hook.detour,
+                   (unsigned long long)(uintptr_t)hook.trampoline,
+                   hook.stealSize, hook.numInstrs);
+        }
+    }
+    LogMsg("Hook transaction committed: %d hook(s), %d thread(s) suspended",
+           tx.count, suspended);
+    tx.count = 0;
     return true;
 }
 
+// ===================================================================
+// InstallHook / RemoveHook — single-hook transactions
+// ===================================================================
+
+bool InstallHook(InlineHook& hook, uintptr_t target, void* detour) {
+    HookTransaction tx;
+    HookTxBegin(tx);
+    HookTxInstall(tx, hook, target, detour);
+    return HookTxCommit(tx);
+}
+
 void RemoveHook(InlineHook& hook) {
     if (!hook.installed) return;
 
-    DWORD oldProtect;
-    VirtualProtect((void*)hook.target, hook.stealSize, PAGE_EXECUTE_READWRITE, &oldProtect);
-    memcpy((void*)hook.target, hook.origBytes, hook.stealSize);
-    VirtualProtect((void*)hook.target, hook.stealSize, oldProtect, &oldProtect);
-    FlushInstructionCache(GetCurrentProcess(), (void*)hook.target, hook.stealSize);
-
-    hook.installed = false;
-    LogMsg("Hook removed: target=0x%llX", (unsigned long long)hook.target);
+    HookTransaction tx;
+    HookTxBegin(tx);
+    HookTxRemove(tx, hook);
+    HookTxCommit(tx);
 }
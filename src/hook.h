@@ -3,24 +3,81 @@
 #include <cstddef>
 
 // ---------------------------------------------------------------------------
-// x64 inline hook — steals bytes from a function prologue, replaces with
-// an absolute jmp to the detour.  A trampoline preserves the stolen bytes
-// so the original function can still be called.
+// x64 inline hook — overwrites the first whole instructions of a function
+// with a 5-byte jmp rel32 to a relay stub, which jumps on to the detour.
+// The stolen instructions are decoded and relocated into a trampoline
+// (RIP-relative operands, calls and branches re-targeted) followed by a
+// jmp back, so the original function can still be called.
 // ---------------------------------------------------------------------------
 
 struct InlineHook {
     uintptr_t target;           // address of the function to hook
     void*     detour;           // address of the detour function
-    void*     trampoline;       // allocated executable memory: stolen bytes + jmp back
+    void*     trampoline;       // relocated stolen instructions + jmp back
+    void*     relay;            // jmp [rip+0] -> detour, within rel32 reach of target
     uint8_t   origBytes[32];    // backup of stolen bytes (for unhook)
-    size_t    stealSize;        // number of bytes stolen (>= 14)
+    size_t    stealSize;        // bytes overwritten at target (whole instructions, >= 5)
+    uint8_t   numInstrs;        // stolen instruction count
+    uint8_t   srcOffsets[8];    // per instruction: offset in the stolen bytes
+    uint8_t   trampOffsets[8];  //   ... and in the trampoline ([numInstrs] = jmp back)
+    bool      keepSlot;         // trampoline holds a relocated call: never freed
+                                // (other slots outlive removal until
+                                // HookReleaseRetired)
     bool      installed;
 };
 
-// Install an inline hook.  stealSize must be >= 14 and must land on an
-// instruction boundary.  If the stolen region contains an E8 (call rel32)
-// instruction, its displacement is automatically fixed up in the trampoline.
-bool InstallHook(InlineHook& hook, uintptr_t target, void* detour, size_t stealSize);
+// ---------------------------------------------------------------------------
+// Hook transactions — queue several installs/removals and apply them in one
+// step.  Commit suspends every other thread once, moves any thread whose
+// RIP is inside a range being rewritten (stolen bytes <-> trampoline), and
+// writes each patch with an aligned atomic store where it fits.  Either
+// every queued change is applied or none is.
+//
+//   HookTransaction tx;
+//   HookTxBegin(tx);
+//   HookTxInstall(tx, hookA, addrA, DetourA);
+//   HookTxInstall(tx, hookB, addrB, DetourB);
+//   if (!HookTxCommit(tx)) ...   // neither hook installed
+// ---------------------------------------------------------------------------
+
+constexpr int HOOK_TX_MAX = 16;
+
+struct HookTransaction {
+    InlineHook* hooks[HOOK_TX_MAX];
+    bool        remove[HOOK_TX_MAX];
+    int         count;
+    bool        failed;         // an entry failed to prepare; commit will abort
+};
+
+void HookTxBegin(HookTransaction& tx);
 
-// Remove the hook by restoring original bytes.
+// Decode/relocate the target and build its trampoline now; the target is
+// not touched until commit.  Fails (and poisons the transaction) if the
+// prologue contains an instruction that cannot be relocated, e.g. a
+// loop/jrcxz or a branch back into the stolen bytes.
+bool HookTxInstall(HookTransaction& tx, InlineHook& hook, uintptr_t target, void* detour);
+
+// Queue restoring an installed hook's original bytes.
+bool HookTxRemove(HookTransaction& tx, InlineHook& hook);
+
+// Apply everything queued.  Returns false (with nothing applied) on failure.
+bool HookTxCommit(HookTransaction& tx);
+
+// Drop everything queued and free prepared trampolines.
+void HookTxAbort(HookTransaction& tx);
+
+// Single-hook transaction.  Fails (and leaves the target untouched) under
+// the same conditions as HookTxInstall.
+bool InstallHook(InlineHook& hook, uintptr_t target, void* detour);
+
+// Remove the hook by restoring original bytes (single-hook transaction).
+// The relay/trampoline slot and hook.trampoline stay valid, so a detour
+// still running can call the original; installing the same hook again
+// reuses the slot.  A trampoline containing a relocated call keeps its
+// slot until process exit, since a caller of the original may still
+// return into it.
 void RemoveHook(InlineHook& hook);
+
+// Free the slots kept by removed hooks.  Only once no detour of theirs
+// can still be running (unload).
+void HookReleaseRetired();
@@ -0,0 +1,102 @@
+#include "hookreg.h"
+#include "log.h"
+#include <atomic>
+#include <cstring>
+
+// ===================================================================
+// Registry storage
+// ===================================================================
+
+static HookEntry        g_hooks[HOOK_TX_MAX] = {};
+static std::atomic<int> g_hookCount{0};     // also read by the writer's stats dump
+
+int HookRegister(const char* name, InlineHook& hook, uintptr_t target, void* detour,
+                 HookStats* stats) {
+    for (int i = 0; i < g_hookCount; ++i) {
+        if (g_hooks[i].hook == &hook) {
+            g_hooks[i].name   = name;
+            g_hooks[i].target = target;
+            g_hooks[i].detour = detour;
+            g_hooks[i].stats  = stats;
+            return i;
+        }
+    }
+    if (g_hookCount >= HOOK_TX_MAX) {
+        LogMsg("ERROR: hook registry full (%d) — cannot register %s", HOOK_TX_MAX, name);
+        return -1;
+    }
+    g_hooks[g_hookCount] = { name, &hook, target, detour, stats };
+    return g_hookCount++;
+}
+
+int HookCount() {
+    return g_hookCount;
+}
+
+const HookEntry* HookGet(int index) {
+    return (index >= 0 && index < g_hookCount) ? &g_hooks[index] : nullptr;
+}
+
+int HookFind(const char* name) {
+    for (int i = 0; i < g_hookCount; ++i)
+        if (strcmp(g_hooks[i].name, name) == 0) return i;
+    return -1;
+}
+
+// ===================================================================
+// Enable / disable
+// ===================================================================
+
+bool HookEnable(int index) {
+    if (index < 0 || index >= g_hookCount) return false;
+    HookEntry& e = g_hooks[index];
+    if (e.hook->installed) return true;
+
+    if (!InstallHook(*e.hook, e.target, e.detour)) {
+        LogMsg("ERROR: Failed to enable hook %s at 0x%llX",
+               e.name, (unsigned long long)e.target);
+        return false;
+    }
+    LogMsg("Hook enabled: %s", e.name);
+    return true;
+}
+
+bool HookDisable(int index) {
+    if (index < 0 || index >= g_hookCount) return false;
+    HookEntry& e = g_hooks[index];
+    if (!e.hook->installed) return true;
+
+    RemoveHook(*e.hook);
+    LogMsg("Hook disabled: %s", e.name);
+    return !e.hook->installed;
+}
+
+bool HookEnableAll() {
+    HookTransaction tx;
+    HookTxBegin(tx);
+    for (int i = 0; i < g_hookCount; ++i) {
+        HookEntry& e = g_hooks[i];
+        if (!e.hook->installed)
+            HookTxInstall(tx, *e.hook, e.target, e.detour);
+    }
+    return HookTxCommit(tx);
+}
+
+void HookRemoveAll() {
+    HookTransaction tx;
+    HookTxBegin(tx);
+    for (int i = g_hookCount - 1; i >= 0; --i)
+        HookTxRemove(tx, *g_hooks[i].hook);
+    if (!HookTxCommit(tx)) {
+        LogMsg("ERROR: Failed to remove hooks — leaving them installed");
+        return;
+    }
+    HookReleaseRetired();
+    g_hookCount = 0;
+}
+
+void HookDumpAllStats() {
+    for (int i = 0; i < g_hookCount; ++i)
+        if (g_hooks[i].stats)
+            HookStatsDump(g_hooks[i].name, *g_hooks[i].stats);
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include "hook.h"
+#include "hookstats.h"
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Hook registry — every hook the mod installs, by name, so they can be
+// listed, toggled at runtime and torn down together.
+// ---------------------------------------------------------------------------
+
+struct HookEntry {
+    const char* name;
+    InlineHook* hook;           // hook->installed == enabled
+    uintptr_t   target;
+    void*       detour;
+    HookStats*  stats;          // nullptr for hooks registered without stats
+};
+
+// Record a hook without installing it.  Re-registering the same InlineHook
+// updates its target/detour.  Returns the entry index, or -1 if full.
+int  HookRegister(const char* name, InlineHook& hook, uintptr_t target, void* detour,
+                  HookStats* stats = nullptr);
+
+int              HookCount();
+const HookEntry* HookGet(int index);
+int              HookFind(const char* name);       // -1 if not registered
+
+// Install / remove one registered hook.  A detour still running when its
+// hook is disabled can call the original; see RemoveHook.
+bool HookEnable(int index);
+bool HookDisable(int index);
+
+// Install every registered-but-disabled hook in one transaction.
+bool HookEnableAll();
+
+// Remove every installed hook in one transaction (reverse registration
+// order), free the slots of every removed hook and clear the registry.
+// For unload: no detour may still be running.
+void HookRemoveAll();
+
+// Log HookStats for every registered hook that keeps them.
+void HookDumpAllStats();
+
+// ---------------------------------------------------------------------------
+// Hook<R(Args...)> — typed wrapper over an InlineHook.
+//
+//   static Hook<void(void*)> g_fooHook("Foo");
+//   static void __attribute__((ms_abi)) Detour_Foo(void* self) {
+//       Hook<void(void*)>::Call call(g_fooHook);   // timed invocation
+//       call.Original(self);
+//   }
+//   g_fooHook.Install(addr, Detour_Foo);
+//
+// The detour must match the signature exactly (checked at compile time).
+// CallOriginal is a load of the trampoline pointer and an indirect call —
+// the same code as a hand-cast function pointer.  Call adds four rdtsc
+// reads plus one HookStatsRecord per invocation.
+// ---------------------------------------------------------------------------
+
+template <typename Sig> class Hook;
+
+template <typename R, typename... Args>
+class Hook<R(Args...)> {
+public:
+    using Fn = R (__attribute__((ms_abi)) *)(Args...);
+
+    constexpr explicit Hook(const char* name) : m_name(name), m_hook{}, m_stats{} {}
+
+    Hook(const Hook&) = delete;
+    Hook& operator=(const Hook&) = delete;
+
+    // Register and install in one step.
+    bool Install(uintptr_t target, Fn detour) {
+        int index = HookRegister(m_name, m_hook, target, (void*)detour, &m_stats);
+        return index >= 0 && HookEnable(index);
+    }
+
+    // Register only — install later with HookEnableAll() alongside others.
+    bool Register(uintptr_t target, Fn detour) {
+        return HookRegister(m_name, m_hook, target, (void*)detour, &m_stats) >= 0;
+    }
+
+    R CallOriginal(Args... args) const {
+        return reinterpret_cast<Fn>(m_hook.trampoline)(args...);
+    }
+
+    bool             Installed() const { return m_hook.installed; }
+    const char*      Name()      const { return m_name; }
+    const HookStats& Stats()     const { return m_stats; }
+
+    // One detour invocation.  Construct on entry; Original() times the
+    // call through to the original; the destructor records the total.
+    class Call {
+    public:
+        explicit Call(Hook& hook) : m_hook(hook), m_start(Now()), m_orig(0) {}
+        ~Call() {
+#if SSF_HOOK_STATS
+            HookStatsRecord(m_hook.m_stats, m_start, Now(), m_orig);
+#endif
+        }
+
+        Call(const Call&) = delete;
+        Call& operator=(const Call&) = delete;
+
+        R Original(Args... args) {
+            OrigTimer timer(m_orig);
+            return m_hook.CallOriginal(args...);
+        }
+
+    private:
+        struct OrigTimer {
+            uint64_t& acc;
+            uint64_t  start;
+            explicit OrigTimer(uint64_t& a) : acc(a), start(Now()) {}
+            ~OrigTimer() { acc += Now() - start; }
+        };
+
+        static uint64_t Now() {
+#if SSF_HOOK_STATS
+            return HookStatsNow();
+#else
+            return 0;
+#endif
+        }
+
+        Hook&    m_hook;
+        uint64_t m_start;
+        uint64_t m_orig;
+    };
+
+private:
+    const char* m_name;
+    InlineHook  m_hook;
+    HookStats   m_stats;
+};
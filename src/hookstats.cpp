@@ -0,0 +1,151 @@
+#include "hookstats.h"
+#include "hookreg.h"
+#include "ini.h"
+#include "log.h"
+#include <windows.h>
+#include <intrin.h>
+#include <cstdio>
+
+extern char g_modDir[];
+
+// ===================================================================
+// Clock — raw TSC, calibrated against QPC at dump time
+// ===================================================================
+
+static uint64_t              g_tscStart = 0;
+static int64_t               g_qpcStart = 0;
+static uint64_t              g_intervalSec = 300;
+static uint64_t              g_nextDumpTsc = 0;  // writer thread only
+
+uint64_t HookStatsNow() {
+    return __rdtsc();
+}
+
+static double TicksPerMicrosecond() {
+    LARGE_INTEGER now, freq;
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    uint64_t tsc = __rdtsc();
+
+    double us = (double)(now.QuadPart - g_qpcStart) * 1e6 / (double)freq.QuadPart;
+    if (us < 1000.0 || g_tscStart == 0) return 0.0;
+    return (double)(tsc - g_tscStart) / us;
+}
+
+// ===================================================================
+// HookStatsInit
+// ===================================================================
+
+// Log writer task — hooked calls never pay for the summary
+static void PeriodicDump() {
+    uint64_t now = __rdtsc();
+    if (now < g_nextDumpTsc) return;
+
+    double tpu = TicksPerMicrosecond();
+    g_nextDumpTsc = now + (uint64_t)(tpu > 0.0 ? tpu * 1e6 : 1e9) * g_intervalSec;
+    HookDumpAllStats();
+}
+
+void HookStatsInit() {
+    char path[MAX_PATH];
+    snprintf(path, MAX_PATH, "%s\\socket_save_fix.ini", g_modDir);
+
+    int val = IniReadInt(path, "HookStatsIntervalSec", (int)g_intervalSec);
+    if (val >= 0) g_intervalSec = (uint64_t)val;
+
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    g_qpcStart = t.QuadPart;
+    g_tscStart = __rdtsc();
+
+    // The first periodic dump needs a calibrated rate; assume >= 1 GHz TSC
+    // until then (the interval is a lower bound, not a deadline).
+    if (g_intervalSec) {
+        g_nextDumpTsc = g_tscStart + g_intervalSec * 1000000000ull;
+        LogAddTask(PeriodicDump);
+    }
+}
+
+// ===================================================================
+// Recording
+// ===================================================================
+
+static int Bucket(uint64_t ticks) {
+    if (ticks == 0) return 0;
+    int b = 63 - __builtin_clzll(ticks);
+    return (b < HOOK_STAT_BUCKETS) ? b : HOOK_STAT_BUCKETS - 1;
+}
+
+template <typename T>
+static inline void Bump(std::atomic<T>& c, T v) {
+    c.fetch_add(v, std::memory_order_relaxed);
+}
+
+void HookStatsRecord(HookStats& stats, uint64_t startTicks, uint64_t endTicks,
+                     uint64_t origTicks) {
+    uint64_t totalTicks  = endTicks - startTicks;
+    uint64_t detourTicks = (totalTicks > origTicks) ? totalTicks - origTicks : 0;
+
+    // Thread ids are multiples of 4 on Windows
+    HookStatStripe& s = stats.stripes[(GetCurrentThreadId() >> 2) & (HOOK_STAT_STRIPES - 1)];
+    Bump(s.calls, (uint64_t)1);
+    Bump(s.origTicks, origTicks);
+    Bump(s.detourTicks, detourTicks);
+    Bump(s.origHist[Bucket(origTicks)], (uint32_t)1);
+    Bump(s.detourHist[Bucket(detourTicks)], (uint32_t)1);
+}
+
+// ===================================================================
+// Dump
+// ===================================================================
+
+// Upper edge of the bucket holding the given quantile.
+static uint64_t Quantile(const uint64_t* hist, uint64_t total, double q) {
+    uint64_t want = (uint64_t)(q * (double)total);
+    uint64_t seen = 0;
+    for (int b = 0; b < HOOK_STAT_BUCKETS; ++b) {
+        seen += hist[b];
+        if (seen > want) return 2ull << b;
+    }
+    return 2ull << (HOOK_STAT_BUCKETS - 1);
+}
+
+uint64_t HookStatsCalls(const HookStats& stats) {
+    uint64_t calls = 0;
+    for (const HookStatStripe& s : stats.stripes)
+        calls += s.calls.load(std::memory_order_relaxed);
+    return calls;
+}
+
+void HookStatsDump(const char* name, const HookStats& stats) {
+    uint64_t calls = 0, origTicks = 0, detourTicks = 0;
+    uint64_t origHist[HOOK_STAT_BUCKETS] = {};
+    uint64_t detourHist[HOOK_STAT_BUCKETS] = {};
+
+    for (const HookStatStripe& s : stats.stripes) {
+        calls       += s.calls.load(std::memory_order_relaxed);
+        origTicks   += s.origTicks.load(std::memory_order_relaxed);
+        detourTicks += s.detourTicks.load(std::memory_order_relaxed);
+        for (int b = 0; b < HOOK_STAT_BUCKETS; ++b) {
+            origHist[b]   += s.origHist[b].load(std::memory_order_relaxed);
+            detourHist[b] += s.detourHist[b].load(std::memory_order_relaxed);
+        }
+    }
+
+    if (calls == 0) {
+        LogMsg("HookStats %s: no calls", name);
+        return;
+    }
+
+    double tpu = TicksPerMicrosecond();
+    if (tpu <= 0.0) tpu = 1000.0;   // uncalibrated: assume 1 GHz
+    auto us = [tpu](uint64_t ticks) { return (double)ticks / tpu; };
+
+    LogMsg("HookStats %s: calls=%llu", name, (unsigned long long)calls);
+    LogMsg("  original: mean=%.1fus p50<=%.1fus p99<=%.1fus",
+           us(origTicks / calls),
+           us(Quantile(origHist, calls, 0.50)), us(Quantile(origHist, calls, 0.99)));
+    LogMsg("  detour:   mean=%.1fus p50<=%.1fus p99<=%.1fus (excl. original)",
+           us(detourTicks / calls),
+           us(Quantile(detourHist, calls, 0.50)), us(Quantile(detourHist, calls, 0.99)));
+}
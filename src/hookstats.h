@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Per-hook call statistics — call counts and log2-bucketed latency
+// histograms (TSC ticks) for the original function and for the detour's
+// own overhead (total time minus time spent in the original).
+//
+// Counters are striped by thread id across cache-line-sized stripes and
+// bumped with relaxed fetch_add, so no increment is lost and threads on
+// different stripes do not share a cache line.  The log writer thread
+// logs a summary every HookStatsIntervalSec (socket_save_fix.ini,
+// default 300, 0 = off); another is logged on unload.
+//
+// SSF_HOOK_STATS=0 compiles the recording out entirely.
+// ---------------------------------------------------------------------------
+
+#ifndef SSF_HOOK_STATS
+#define SSF_HOOK_STATS 1
+#endif
+
+constexpr int HOOK_STAT_STRIPES = 16;
+constexpr int HOOK_STAT_BUCKETS = 40;   // bucket b: [2^b, 2^(b+1)) ticks
+
+struct alignas(64) HookStatStripe {
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> origTicks;
+    std::atomic<uint64_t> detourTicks;
+    std::atomic<uint32_t> origHist[HOOK_STAT_BUCKETS];
+    std::atomic<uint32_t> detourHist[HOOK_STAT_BUCKETS];
+};
+
+struct HookStats {
+    HookStatStripe stripes[HOOK_STAT_STRIPES];
+};
+
+// Read HookStatsIntervalSec= from the INI and calibrate the TSC.
+void HookStatsInit();
+
+uint64_t HookStatsNow();
+
+// Record one detour invocation running from startTicks to endTicks, of
+// which origTicks were spent inside the original function.
+void HookStatsRecord(HookStats& stats, uint64_t startTicks, uint64_t endTicks,
+                     uint64_t origTicks);
+
+// Calls recorded so far, summed over the stripes.
+uint64_t HookStatsCalls(const HookStats& stats);
+
+// Log a one-line summary for one hook.
+void HookStatsDump(const char* name, const HookStats& stats);
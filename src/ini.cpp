@@ -0,0 +1,39 @@
+#include "ini.h"
+#include <cstdio>
+#include <cstring>
+
+// Value text of the last "key=" line, copied into 'value'
+static bool FindValue(const char* path, const char* key, char (&value)[256]) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+
+    size_t keyLen = strlen(key);
+    bool found = false;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == ';' || line[0] == '\n' || line[0] == '\r')
+            continue;
+        if (strncmp(line, key, keyLen) != 0 || line[keyLen] != '=')
+            continue;
+        snprintf(value, sizeof(value), "%s", line + keyLen + 1);
+        found = true;
+    }
+    fclose(f);
+    return found;
+}
+
+int IniReadInt(const char* path, const char* key, int def) {
+    char value[256];
+    int v;
+    if (FindValue(path, key, value) && sscanf(value, "%d", &v) == 1)
+        return v;
+    return def;
+}
+
+bool IniReadString(const char* path, const char* key, char* out, size_t size) {
+    char value[256], token[256];
+    if (!FindValue(path, key, value) || sscanf(value, "%255s", token) != 1)
+        return false;
+    snprintf(out, size, "%s", token);
+    return true;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+
+// ---------------------------------------------------------------------------
+// socket_save_fix.ini lookups — "Key=value" lines; lines starting with
+// '#' or ';' are comments.  When a key appears more than once the last
+// line wins.  The file is reopened on every call; these are read once
+// per setting at startup.
+// ---------------------------------------------------------------------------
+
+// Integer value of 'key', or 'def' if the file or the key is missing.
+int IniReadInt(const char* path, const char* key, int def);
+
+// String value of 'key' (up to the first whitespace) copied into 'out'.
+// Returns false, leaving 'out' untouched, if the file or key is missing.
+bool IniReadString(const char* path, const char* key, char* out, size_t size);
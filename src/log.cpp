@@ -0,0 +1,337 @@
+#include "log.h"
+#include "ini.h"
+#include "mem.h"
+#include <windows.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdarg>
+#include <cstring>
+
+extern char g_modDir[];
+
+int g_logLevel = LOG_LEVEL_INFO;
+
+// ===================================================================
+// Ring buffer  (bounded MPSC, Vyukov sequence-numbered cells)
+//
+// A producer claims a cell by CAS on g_enqueuePos, formats its line
+// straight into the cell, then publishes it by storing seq = pos + 1.
+// The single consumer (writer thread) reads cells in order and recycles
+// them by storing seq = pos + RING_SIZE.
+// ===================================================================
+
+static constexpr size_t RING_SIZE   = 2048;     // power of two
+static constexpr size_t RECORD_TEXT = 480;
+
+struct alignas(64) LogRecord {
+    std::atomic<size_t> seq;
+    FILETIME            time;
+    uint16_t            len;
+    uint8_t             level;
+    char                text[RECORD_TEXT];
+};
+
+static LogRecord*          g_ring = nullptr;
+static std::atomic<size_t> g_enqueuePos{0};
+static size_t              g_dequeuePos = 0;
+static std::atomic<uint32_t> g_dropped{0};
+
+// ===================================================================
+// Writer state
+// ===================================================================
+
+static HANDLE            g_file        = INVALID_HANDLE_VALUE;
+static char              g_path[MAX_PATH] = {};
+static uint64_t          g_fileBytes   = 0;
+static uint64_t          g_maxBytes    = 4ull * 1024 * 1024;
+static constexpr int     MAX_BACKUPS   = 3;
+
+static HANDLE            g_writerThread = nullptr;
+static HANDLE            g_writerDone   = nullptr;
+static HANDLE            g_writerPark   = nullptr;     // never signalled; the writer
+                                                        // leaves it through an APC
+static std::atomic<bool> g_stop{false};
+
+// Whether the writer got past its first instruction before shutdown.  A
+// writer still waiting for the loader lock cannot be waited for from
+// DLL_PROCESS_DETACH, which holds it.
+enum WriterState { WRITER_PENDING, WRITER_RUNNING, WRITER_CANCELLED };
+static std::atomic<int>  g_writerState{WRITER_PENDING};
+
+static LogTaskFn         g_tasks[LOG_MAX_TASKS] = {};
+static std::atomic<int>  g_taskCount{0};
+
+static constexpr size_t  BATCH_SIZE = 64 * 1024;
+static char              g_batch[BATCH_SIZE];
+static size_t            g_batchLen = 0;
+
+// ===================================================================
+// Producers
+// ===================================================================
+
+static void Enqueue(int level, const char* fmt, va_list ap) {
+    if (!g_ring) return;
+
+    LogRecord* cell;
+    size_t pos = g_enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        cell = &g_ring[pos & (RING_SIZE - 1)];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0) {
+            if (g_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            g_dropped.fetch_add(1, std::memory_order_relaxed);   // ring full
+            return;
+        } else {
+            pos = g_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    GetSystemTimeAsFileTime(&cell->time);
+    int n = vsnprintf(cell->text, RECORD_TEXT, fmt, ap);
+    if (n < 0) n = 0;
+    if (n >= (int)RECORD_TEXT) n = RECORD_TEXT - 1;
+    cell->len   = (uint16_t)n;
+    cell->level = (uint8_t)level;
+
+    cell->seq.store(pos + 1, std::memory_order_release);
+}
+
+// Existing call sites all use LogMsg; classify them by their prefix so
+// LogLevel=0/1 still lets errors and warnings through.
+static int ClassifyMessage(const char* fmt) {
+    while (*fmt == ' ') ++fmt;
+    if (strncmp(fmt, "ERROR", 5) == 0)   return LOG_LEVEL_ERROR;
+    if (strncmp(fmt, "WARNING", 7) == 0) return LOG_LEVEL_WARN;
+    return LOG_LEVEL_INFO;
+}
+
+void LogMsg(const char* fmt, ...) {
+    int level = ClassifyMessage(fmt);
+    if (level > g_logLevel) return;
+
+    va_list ap;
+    va_start(ap, fmt);
+    Enqueue(level, fmt, ap);
+    va_end(ap);
+}
+
+void LogMsgLevel(int level, const char* fmt, ...) {
+    if (level > g_logLevel || level > SSF_LOG_MAX_LEVEL) return;
+
+    va_list ap;
+    va_start(ap, fmt);
+    Enqueue(level, fmt, ap);
+    va_end(ap);
+}
+
+// ===================================================================
+// Consumer
+// ===================================================================
+
+static void FlushBatch() {
+    if (!g_batchLen || g_file == INVALID_HANDLE_VALUE) {
+        g_batchLen = 0;
+        return;
+    }
+    DWORD written = 0;
+    WriteFile(g_file, g_batch, (DWORD)g_batchLen, &written, nullptr);
+    g_fileBytes += written;
+    g_batchLen = 0;
+}
+
+// socket_save_fix.log -> .log.1 -> .log.2 ... (oldest dropped)
+static void Rotate() {
+    HANDLE old = g_file;
+    g_file = INVALID_HANDLE_VALUE;
+    CloseHandle(old);
+
+    char from[MAX_PATH + 8], to[MAX_PATH + 8];
+    for (int i = MAX_BACKUPS - 1; i >= 1; --i) {
+        snprintf(from, sizeof(from), "%s.%d", g_path, i);
+        snprintf(to,   sizeof(to),   "%s.%d", g_path, i + 1);
+        MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING);
+    }
+    snprintf(to, sizeof(to), "%s.1", g_path);
+    MoveFileExA(g_path, to, MOVEFILE_REPLACE_EXISTING);
+
+    g_file = CreateFileA(g_path, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                         nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    g_fileBytes = 0;
+}
+
+static void AppendLine(const char* text, size_t len) {
+    if (g_batchLen + len > BATCH_SIZE)
+        FlushBatch();
+    memcpy(g_batch + g_batchLen, text, len);
+    g_batchLen += len;
+}
+
+// Drain published records, at most one ring's worth, so a drain never
+// chases producers that keep logging.  Returns the number of lines
+// written.
+static int Drain() {
+    int lines = 0;
+    while (lines < (int)RING_SIZE) {
+        LogRecord* cell = &g_ring[g_dequeuePos & (RING_SIZE - 1)];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+        if (seq != g_dequeuePos + 1) break;
+
+        FILETIME local;
+        SYSTEMTIME st;
+        FileTimeToLocalFileTime(&cell->time, &local);
+        FileTimeToSystemTime(&local, &st);
+
+        char prefix[32];
+        int plen = snprintf(prefix, sizeof(prefix), "[%02d:%02d:%02d.%03d] ",
+                            st.wHour, st.wMinute, st.wSecond, st.wMilliseconds);
+        AppendLine(prefix, (size_t)plen);
+        AppendLine(cell->text, cell->len);
+        AppendLine("\n", 1);
+
+        cell->seq.store(g_dequeuePos + RING_SIZE, std::memory_order_release);
+        g_dequeuePos++;
+        lines++;
+    }
+
+    uint32_t dropped = g_dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped) {
+        char msg[64];
+        int n = snprintf(msg, sizeof(msg), "[log] %u lines dropped (ring full)\n", dropped);
+        AppendLine(msg, (size_t)n);
+    }
+
+    if (lines || dropped) {
+        FlushBatch();
+        if (g_fileBytes >= g_maxBytes)
+            Rotate();
+    }
+    return lines;
+}
+
+// The writer may have been terminated inside Drain at process exit: a
+// record recycled before g_dequeuePos was advanced is skipped, and the
+// batch keeps only whole appends (AppendLine bumps g_batchLen after the
+// copy).  A line cut between its prefix and text, or a batch written
+// twice by an interrupted FlushBatch, is the most that can go wrong.
+static void RecoverTornDrain() {
+    LogRecord* cell = &g_ring[g_dequeuePos & (RING_SIZE - 1)];
+    if (cell->seq.load(std::memory_order_acquire) == g_dequeuePos + RING_SIZE)
+        g_dequeuePos++;
+}
+
+bool LogAddTask(LogTaskFn fn) {
+    int n = g_taskCount.load(std::memory_order_relaxed);
+    if (n >= LOG_MAX_TASKS) return false;
+    g_tasks[n] = fn;
+    g_taskCount.store(n + 1, std::memory_order_release);
+    return true;
+}
+
+static void RunTasks() {
+    int n = g_taskCount.load(std::memory_order_acquire);
+    for (int i = 0; i < n; ++i) g_tasks[i]();
+}
+
+static DWORD WINAPI WriterThread(LPVOID) {
+    int expected = WRITER_PENDING;
+    if (!g_writerState.compare_exchange_strong(expected, WRITER_RUNNING))
+        return 0;       // shutting down; LogShutdown terminates this thread
+
+    while (!g_stop.load(std::memory_order_acquire)) {
+        RunTasks();
+        if (Drain() == 0)
+            Sleep(10);
+    }
+    RunTasks();
+    Drain();
+
+    // LogShutdown runs in DLL_PROCESS_DETACH and the DLL is unmapped as
+    // soon as it returns, so the writer must not execute another
+    // instruction of ours after signalling.  The queued ExitThread runs as
+    // soon as the alertable wait starts, and the thread ends inside
+    // kernel32 without returning here.
+    QueueUserAPC((PAPCFUNC)ExitThread, GetCurrentThread(), 0);
+    SignalObjectAndWait(g_writerDone, g_writerPark, INFINITE, TRUE);
+    return 0;
+}
+
+// ===================================================================
+// LogOpen / LogShutdown
+// ===================================================================
+
+static void ReadLogSettingsFromINI() {
+    char path[MAX_PATH];
+    snprintf(path, MAX_PATH, "%s\\socket_save_fix.ini", g_modDir);
+
+    int val = IniReadInt(path, "LogLevel", g_logLevel);
+    g_logLevel = (val < LOG_LEVEL_ERROR) ? LOG_LEVEL_ERROR :
+                 (val > LOG_LEVEL_DEBUG) ? LOG_LEVEL_DEBUG : val;
+
+    val = IniReadInt(path, "LogMaxKB", 0);
+    if (val > 0) g_maxBytes = (uint64_t)val * 1024;
+}
+
+bool LogOpen(const char* path) {
+    strncpy(g_path, path, sizeof(g_path) - 1);
+    ReadLogSettingsFromINI();
+
+    g_file = CreateFileA(g_path, GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                         nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (g_file == INVALID_HANDLE_VALUE) return false;
+
+    g_ring = (LogRecord*)MemAlloc(MEM_LOG, RING_SIZE * sizeof(LogRecord));
+    if (!g_ring) {
+        CloseHandle(g_file);
+        g_file = INVALID_HANDLE_VALUE;
+        return false;
+    }
+    for (size_t i = 0; i < RING_SIZE; ++i)
+        g_ring[i].seq.store(i, std::memory_order_relaxed);
+
+    g_writerDone   = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    g_writerPark   = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+    g_writerThread = CreateThread(nullptr, 0, WriterThread, nullptr, 0, nullptr);
+    return true;
+}
+
+void LogShutdown(bool processExit) {
+    if (!g_ring) return;
+
+    // During process exit the writer has already been terminated,
+    // possibly mid-drain, so drain from here.  On explicit unload let it
+    // finish: what it has left is bounded (the pass in progress, then one
+    // pass of tasks and a drain of at most one ring), so the wait needs no
+    // timeout and returns only once the writer is leaving through
+    // ExitThread.  A writer that never started is terminated instead.
+    g_stop.store(true, std::memory_order_release);
+    if (processExit) {
+        RecoverTornDrain();
+    } else if (g_writerThread) {
+        int expected = WRITER_PENDING;
+        if (g_writerState.compare_exchange_strong(expected, WRITER_CANCELLED)) {
+            TerminateThread(g_writerThread, 0);
+            WaitForSingleObject(g_writerThread, INFINITE);
+        } else {
+            WaitForSingleObject(g_writerDone, INFINITE);
+        }
+
+        // g_writerPark stays open: the writer may still be waiting on it,
+        // and its exit cannot be awaited here
+        CloseHandle(g_writerThread);
+        CloseHandle(g_writerDone);
+        g_writerThread = g_writerDone = nullptr;
+    }
+
+    // Lines queued after the writer's last pass
+    Drain();
+
+    if (g_file != INVALID_HANDLE_VALUE) {
+        FlushFileBuffers(g_file);
+        CloseHandle(g_file);
+        g_file = INVALID_HANDLE_VALUE;
+    }
+}
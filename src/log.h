@@ -0,0 +1,54 @@
+#pragma once
+
+// ---------------------------------------------------------------------------
+// Asynchronous logger — callers format into a slot of a lock-free MPSC ring
+// and return immediately; a background writer thread drains the ring in
+// batches to socket_save_fix.log and rotates it by size.  No caller ever
+// blocks on disk I/O.  If the ring is full the line is dropped and counted.
+//
+// Verbosity:
+//   compile time  SSF_LOG_MAX_LEVEL   levels above it compile to nothing
+//   runtime       LogLevel=N in socket_save_fix.ini (default 2 = info)
+// ---------------------------------------------------------------------------
+
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_WARN  1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_DEBUG 3
+
+#ifndef SSF_LOG_MAX_LEVEL
+#define SSF_LOG_MAX_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+extern int g_logLevel;
+
+// Open the log file, read LogLevel=/LogMaxKB= from the INI and start the
+// writer thread.  Requires g_modDir to be set.
+bool LogOpen(const char* path);
+
+// Stop the writer thread, drain what is still queued and close the file.
+// processExit = true when called during process termination (the writer
+// thread is already gone, possibly mid-batch, so the calling thread
+// drains directly).  On explicit unload the writer finishes its last
+// bounded pass and exits without returning into the DLL; one that has not
+// started yet is terminated.
+void LogShutdown(bool processExit);
+
+// Info-level line (the level every existing call site logs at).
+void LogMsg(const char* fmt, ...);
+
+void LogMsgLevel(int level, const char* fmt, ...);
+
+// Work run by the writer thread between drains (about every 10 ms, and
+// once more before it stops), so file output other than the log stays
+// off the game thread.  Tasks must not block.  Register before LogOpen
+// returns to the caller's first hook, up to LOG_MAX_TASKS.
+constexpr int LOG_MAX_TASKS = 4;
+using LogTaskFn = void (*)();
+bool LogAddTask(LogTaskFn fn);
+
+#define LogDebug(...)                                                       \
+    do {                                                                    \
+        if (SSF_LOG_MAX_LEVEL >= LOG_LEVEL_DEBUG && g_logLevel >= LOG_LEVEL_DEBUG) \
+            LogMsgLevel(LOG_LEVEL_DEBUG, __VA_ARGS__);                      \
+    } while (0)
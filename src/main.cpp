@@ -1,47 +1,41 @@
+#include "log.h"
+#include "trace.h"
+#include "hookstats.h"
 #include <windows.h>
-#include <cstdio>
-#include <cstdarg>
+#include <atomic>
 #include <cstring>
 
-extern bool ApplyPatch();
+extern bool ApplyPatch(void* cancelEvent);
 extern void CleanupPatch();
 
 // ===================================================================
 // Globals shared with other modules
 // ===================================================================
 
-static FILE* g_log    = nullptr;
 char         g_modDir[MAX_PATH] = {};
+static char  g_logPath[MAX_PATH] = {};
 
-// ===================================================================
-// Logging
-// ===================================================================
-
-void LogMsg(const char* fmt, ...) {
-    if (!g_log) return;
+// Init pipeline control: cancel is set on unload, done once ApplyPatch
+// has returned; park is never set (all manual-reset)
+static HANDLE g_initCancel  = nullptr;
+static HANDLE g_initDone    = nullptr;
+static HANDLE g_initPark    = nullptr;
+static HANDLE g_patchThread = nullptr;
 
-    SYSTEMTIME st;
-    GetLocalTime(&st);
-    fprintf(g_log, "[%02d:%02d:%02d.%03d] ",
-            st.wHour, st.wMinute, st.wSecond, st.wMilliseconds);
-
-    va_list ap;
-    va_start(ap, fmt);
-    vfprintf(g_log, fmt, ap);
-    va_end(ap);
-
-    fprintf(g_log, "\n");
-    fflush(g_log);
-}
+// Whether the patch thread got past its first instruction before an
+// unload.  A thread still waiting for the loader lock cannot be waited
+// for from DLL_PROCESS_DETACH, which holds it.
+enum PatchState { PATCH_PENDING, PATCH_RUNNING, PATCH_CANCELLED };
+static std::atomic<int> g_patchState{PATCH_PENDING};
 
 // ===================================================================
-// Background patch thread
+// Paths relative to our DLL location (DllMain: GetModuleFileName takes
+// the loader lock, which the patch thread must never need)
 // ===================================================================
 
-static DWORD WINAPI PatchThread(LPVOID param) {
-    // Build paths relative to our DLL location
-    char dllPath[MAX_PATH];
-    GetModuleFileNameA((HMODULE)param, dllPath, MAX_PATH);
+static void BuildPaths(HMODULE self) {
+    char* dllPath = g_logPath;
+    GetModuleFileNameA(self, dllPath, MAX_PATH);
 
     // Extract directory
     char* lastSep = nullptr;
@@ -57,26 +51,55 @@ static DWORD WINAPI PatchThread(LPVOID param) {
         strcpy(g_modDir, ".");
         strcpy(dllPath, "socket_save_fix.log");
     }
+}
+
+// ===================================================================
+// Background patch thread
+// ===================================================================
 
-    g_log = fopen(dllPath, "w");
-    if (!g_log) return 1;
+static DWORD PatchThreadBody() {
+    if (!LogOpen(g_logPath)) return 1;
 
     LogMsg("=== SocketSaveFix v2.0 ===");
     LogMsg("DLL dir: %s", g_modDir);
-    LogMsg("Log:     %s", dllPath);
+    LogMsg("Log:     %s", g_logPath);
+
+    TraceInit();
+    HookStatsInit();
 
     // Wait for the exe module to be fully mapped, then install hooks.
     // The UObject system needs to be populated before we can resolve symbols.
     LogMsg("Starting initialization...");
 
-    bool ok = ApplyPatch();
+    bool ok;
+    {
+        TRACE_SPAN("ApplyPatch");
+        ok = ApplyPatch(g_initCancel);
+    }
+    TraceExport();
 
+    // The log stays open so post-load activity from the hook is captured;
+    // it is drained and closed on DLL_PROCESS_DETACH.
     LogMsg("=== %s ===", ok ? "SUCCESS" : "FAILED");
-    fclose(g_log);
-    g_log = nullptr;
     return ok ? 0 : 1;
 }
 
+static DWORD WINAPI PatchThread(LPVOID) {
+    int expected = PATCH_PENDING;
+    if (!g_patchState.compare_exchange_strong(expected, PATCH_RUNNING))
+        return 0;       // unloading; DETACH terminates this thread
+
+    DWORD code = PatchThreadBody();
+
+    // DETACH may be waiting on g_initDone and unmaps the DLL as soon as
+    // it returns, so nothing of ours may run after signalling.  The
+    // queued ExitThread runs as soon as the alertable wait starts, and
+    // the thread ends inside kernel32.
+    QueueUserAPC((PAPCFUNC)ExitThread, GetCurrentThread(), code);
+    SignalObjectAndWait(g_initDone, g_initPark, INFINITE, TRUE);
+    return code;
+}
+
 // ===================================================================
 // DLL entry point
 // ===================================================================
@@ -84,12 +107,34 @@ static DWORD WINAPI PatchThread(LPVOID param) {
 extern "C" BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpReserved) {
     if (fdwReason == DLL_PROCESS_ATTACH) {
         DisableThreadLibraryCalls(hinstDLL);
-        CreateThread(nullptr, 0, PatchThread, (LPVOID)hinstDLL, 0, nullptr);
+        BuildPaths(hinstDLL);
+        g_initCancel  = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        g_initDone    = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        g_initPark    = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+        g_patchThread = CreateThread(nullptr, 0, PatchThread, nullptr, 0, nullptr);
     }
-    else if (fdwReason == DLL_PROCESS_DETACH && lpReserved == nullptr) {
-        // Explicit unload (FreeLibrary) — restore hooks to prevent crashes
-        // during engine teardown.  Skip if lpReserved != nullptr (process exit).
-        CleanupPatch();
+    else if (fdwReason == DLL_PROCESS_DETACH) {
+        // Explicit unload (FreeLibrary) — stop the init pipeline, then
+        // restore hooks to prevent crashes during engine teardown.
+        // Skip if lpReserved != nullptr (process exit).
+        if (lpReserved == nullptr && g_patchThread) {
+            int expected = PATCH_PENDING;
+            if (g_patchState.compare_exchange_strong(expected, PATCH_CANCELLED)) {
+                // Never ran any of our code: it holds nothing of ours
+                TerminateThread(g_patchThread, 1);
+                WaitForSingleObject(g_patchThread, INFINITE);
+            } else {
+                // The pipeline checks the event between attempts, which
+                // are short, so this waits for one attempt at most
+                SetEvent(g_initCancel);
+                WaitForSingleObject(g_initDone, INFINITE);
+            }
+            CloseHandle(g_patchThread);
+            g_patchThread = nullptr;
+        }
+        if (lpReserved == nullptr)
+            CleanupPatch();
+        LogShutdown(lpReserved != nullptr);
     }
     return TRUE;
 }
@@ -0,0 +1,266 @@
+#include "mem.h"
+#include "log.h"
+#include "platform.h"
+#include <atomic>
+#include <cstring>
+
+static constexpr size_t MEM_MIN_CLASS     = 32;
+static constexpr int    MEM_CLASS_COUNT   = 11;            // 32 B .. 32 KB
+static constexpr size_t MEM_COMMIT_STEP   = 64 * 1024;
+static constexpr size_t MEM_PAGE          = 4096;
+static constexpr int    MAX_ARENA_BLOCKS  = 16;
+static constexpr int    MAX_LARGE         = 64;
+
+static_assert((MEM_MIN_CLASS << (MEM_CLASS_COUNT - 1)) == MEM_SMALL_MAX, "size classes");
+
+// ===================================================================
+// State (all under g_lock)
+// ===================================================================
+
+struct ArenaBlock {
+    uint8_t* base;
+    size_t   committed;
+    size_t   used;              // bump offset
+};
+
+struct LargeAlloc {
+    void*  p;
+    size_t size;
+    MemTag tag;
+};
+
+static ArenaBlock       g_blocks[MAX_ARENA_BLOCKS] = {};
+static int              g_blockCount = 0;
+static void*            g_freeLists[MEM_CLASS_COUNT] = {};
+static LargeAlloc       g_large[MAX_LARGE] = {};
+static MemTagStats      g_tags[MEM_TAG_COUNT] = {};
+static int              g_smallLive[MEM_TAG_COUNT] = {};
+static size_t           g_smallBytes[MEM_TAG_COUNT] = {};
+static size_t           g_arenaInUse = 0;
+static std::atomic_flag g_lock = ATOMIC_FLAG_INIT;
+
+struct MemLock {
+    MemLock()  { while (g_lock.test_and_set(std::memory_order_acquire)) PlatSleep(0); }
+    ~MemLock() { g_lock.clear(std::memory_order_release); }
+};
+
+static const char* const g_tagNames[MEM_TAG_COUNT] = {
+    "hierarchy", "rebuild", "reconnect", "sidecar", "graph", "probe", "hooks", "log", "trace",
+};
+
+const char* MemTagName(MemTag tag) {
+    return (tag >= 0 && tag < MEM_TAG_COUNT) ? g_tagNames[tag] : "?";
+}
+
+static int SizeClass(size_t size) {
+    int c = 0;
+    while ((MEM_MIN_CLASS << c) < size) ++c;
+    return c;
+}
+
+static void Account(MemTag tag, size_t bytes) {
+    MemTagStats& t = g_tags[tag];
+    t.inUse += bytes;
+    if (t.inUse > t.peak) t.peak = t.inUse;
+    t.live++;
+    t.allocs++;
+}
+
+static void Unaccount(MemTag tag, size_t bytes) {
+    MemTagStats& t = g_tags[tag];
+    t.inUse -= bytes;
+    t.live--;
+}
+
+// ===================================================================
+// Small: size classes carved from arena blocks
+// ===================================================================
+
+static void* Carve(size_t bytes) {
+    ArenaBlock* b = g_blockCount ? &g_blocks[g_blockCount - 1] : nullptr;
+
+    if (!b || b->used + bytes > MEM_ARENA_BLOCK) {
+        if (g_blockCount == MAX_ARENA_BLOCKS) return nullptr;
+        uint8_t* base = (uint8_t*)PlatReserve(MEM_ARENA_BLOCK);
+        if (!base) return nullptr;
+        b = &g_blocks[g_blockCount++];
+        *b = { base, 0, 0 };
+    }
+
+    if (b->used + bytes > b->committed) {
+        size_t want = (b->used + bytes + MEM_COMMIT_STEP - 1) & ~(MEM_COMMIT_STEP - 1);
+        if (!PlatCommit(b->base + b->committed, want - b->committed)) return nullptr;
+        b->committed = want;
+    }
+
+    void* p = b->base + b->used;
+    b->used += bytes;
+    return p;
+}
+
+static void* AllocSmall(MemTag tag, size_t size) {
+    int c = SizeClass(size);
+    size_t bytes = MEM_MIN_CLASS << c;
+
+    void* p = g_freeLists[c];
+    if (p) {
+        g_freeLists[c] = *(void**)p;
+        memset(p, 0, bytes);
+    } else {
+        p = Carve(bytes);           // fresh commits are zero
+        if (!p) return nullptr;
+    }
+
+    Account(tag, bytes);
+    g_smallLive[tag]++;
+    g_smallBytes[tag] += bytes;
+    g_arenaInUse += bytes;
+    return p;
+}
+
+static void FreeSmall(MemTag tag, void* p, size_t size) {
+    int c = SizeClass(size);
+    size_t bytes = MEM_MIN_CLASS << c;
+
+    *(void**)p = g_freeLists[c];
+    g_freeLists[c] = p;
+
+    Unaccount(tag, bytes);
+    g_smallLive[tag]--;
+    g_smallBytes[tag] -= bytes;
+    g_arenaInUse -= bytes;
+}
+
+// ===================================================================
+// Large: own pages, tracked for bulk release
+// ===================================================================
+
+static size_t PageRound(size_t size) {
+    return (size + MEM_PAGE - 1) & ~(MEM_PAGE - 1);
+}
+
+static void* AllocLarge(MemTag tag, size_t size) {
+    void* p = PlatAlloc(size);
+    if (!p) return nullptr;
+
+    // Past MAX_LARGE allocations are still accounted, only not bulk-released
+    for (LargeAlloc& l : g_large) {
+        if (l.p) continue;
+        l = { p, size, tag };
+        break;
+    }
+    Account(tag, PageRound(size));
+    return p;
+}
+
+static void FreeLarge(MemTag tag, void* p, size_t size) {
+    for (LargeAlloc& l : g_large) {
+        if (l.p != p) continue;
+        l.p = nullptr;
+        break;
+    }
+    Unaccount(tag, PageRound(size));
+    PlatFree(p, size);
+}
+
+// ===================================================================
+// MemAlloc / MemFree
+// ===================================================================
+
+void* MemAlloc(MemTag tag, size_t size) {
+    if (size == 0) return nullptr;
+
+    MemLock lock;
+    return size <= MEM_SMALL_MAX ? AllocSmall(tag, size) : AllocLarge(tag, size);
+}
+
+void MemFree(MemTag tag, void* p, size_t size) {
+    if (!p) return;
+
+    MemLock lock;
+    if (size <= MEM_SMALL_MAX) FreeSmall(tag, p, size);
+    else                       FreeLarge(tag, p, size);
+}
+
+// ===================================================================
+// Stats / report
+// ===================================================================
+
+void MemGetStats(MemStats& out) {
+    memset(&out, 0, sizeof(out));
+
+    MemLock lock;
+    memcpy(out.tags, g_tags, sizeof(g_tags));
+    for (int i = 0; i < g_blockCount; ++i) {
+        out.arenaReserved  += MEM_ARENA_BLOCK;
+        out.arenaCommitted += g_blocks[i].committed;
+    }
+    out.arenaInUse = g_arenaInUse;
+    for (const LargeAlloc& l : g_large) {
+        if (!l.p) continue;
+        out.largeBytes += PageRound(l.size);
+        out.largeCount++;
+    }
+}
+
+static double KB(size_t bytes) {
+    return (double)bytes / 1024.0;
+}
+
+void MemReport() {
+    MemStats s;
+    MemGetStats(s);
+
+    LogMsg("Memory: arena %.0f KB reserved, %.0f KB committed, %.1f KB in use; "
+           "%d large allocations, %.0f KB",
+           KB(s.arenaReserved), KB(s.arenaCommitted), KB(s.arenaInUse),
+           s.largeCount, KB(s.largeBytes));
+    for (int t = 0; t < MEM_TAG_COUNT; ++t) {
+        const MemTagStats& m = s.tags[t];
+        if (m.allocs == 0) continue;
+        LogMsg("  %-10s %9.1f KB in use (%d live), peak %9.1f KB, %d allocations",
+               g_tagNames[t], KB(m.inUse), m.live, KB(m.peak), m.allocs);
+    }
+}
+
+// ===================================================================
+// Bulk release
+// ===================================================================
+
+void MemReleaseAll(uint32_t keepTags) {
+    MemLock lock;
+
+    for (int t = 0; t < MEM_TAG_COUNT; ++t) {
+        if ((keepTags & MemTagBit((MemTag)t)) || g_tags[t].live == 0) continue;
+        LogMsg("Memory: %s still holds %d allocations (%.1f KB) at unload — released",
+               g_tagNames[t], g_tags[t].live, KB(g_tags[t].inUse));
+    }
+
+    for (LargeAlloc& l : g_large) {
+        if (!l.p || (keepTags & MemTagBit(l.tag))) continue;
+        PlatFree(l.p, l.size);
+        l.p = nullptr;
+    }
+
+    bool keepArena = false;
+    for (int t = 0; t < MEM_TAG_COUNT; ++t)
+        if ((keepTags & MemTagBit((MemTag)t)) && g_smallLive[t] > 0) keepArena = true;
+
+    if (!keepArena) {
+        for (int i = 0; i < g_blockCount; ++i) PlatFree(g_blocks[i].base, MEM_ARENA_BLOCK);
+        g_blockCount = 0;
+        memset(g_freeLists, 0, sizeof(g_freeLists));
+        g_arenaInUse = 0;
+    }
+
+    // What a released tag still holds is only its share of a kept arena
+    for (int t = 0; t < MEM_TAG_COUNT; ++t) {
+        if (keepTags & MemTagBit((MemTag)t)) continue;
+        if (!keepArena) {
+            g_smallLive[t]  = 0;
+            g_smallBytes[t] = 0;
+        }
+        g_tags[t].inUse = g_smallBytes[t];
+        g_tags[t].live  = g_smallLive[t];
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Mod memory — every read/write allocation the mod makes goes through
+// here, tagged with the subsystem it belongs to, so the footprint inside
+// the game process is small and can be reported.
+//
+// Requests up to MEM_SMALL_MAX bytes are rounded to a power-of-two size
+// class and carved from shared arena blocks (MEM_ARENA_BLOCK reserved,
+// committed 64 KB at a time); freed chunks go to a per-class free list.
+// Larger requests get their own pages.  Either way memory comes back
+// zeroed, as from PlatAlloc.  Executable memory stays in the near-code
+// slab allocator (nearalloc.h).
+// ---------------------------------------------------------------------------
+
+enum MemTag {
+    MEM_HIERARCHY,      // struct lists, chain pool
+    MEM_REBUILD,        // post-load handle buffer, signal ledger
+    MEM_RECONNECT,      // socket records, buckets, marks
+    MEM_SIDECAR,        // capture buffer, record index
+    MEM_GRAPH,          // rail graph nodes, edges, union-find
+    MEM_PROBE,          // readable region maps
+    MEM_HOOKS,          // suspended thread lists
+    MEM_LOG,            // log ring
+    MEM_TRACE,          // trace event buffer
+    MEM_TAG_COUNT
+};
+
+constexpr uint32_t MemTagBit(MemTag t) { return 1u << t; }
+
+constexpr size_t MEM_SMALL_MAX   = 32 * 1024;
+constexpr size_t MEM_ARENA_BLOCK = 4 * 1024 * 1024;
+
+// Pass the same tag and size back to MemFree.
+void* MemAlloc(MemTag tag, size_t size);
+void  MemFree(MemTag tag, void* p, size_t size);
+
+struct MemTagStats {
+    size_t inUse;           // bytes, rounded to the size class / page
+    size_t peak;
+    int    live;            // allocations not freed yet
+    int    allocs;          // allocations made
+};
+
+struct MemStats {
+    MemTagStats tags[MEM_TAG_COUNT];
+    size_t arenaReserved;
+    size_t arenaCommitted;
+    size_t arenaInUse;      // small allocations live
+    size_t largeBytes;      // large allocations live
+    int    largeCount;
+};
+
+void MemGetStats(MemStats& out);
+const char* MemTagName(MemTag tag);
+
+// Log bytes reserved, committed and in use, per subsystem and in total
+void MemReport();
+
+// Unload: free every large allocation and, if no small allocation of a
+// kept tag is live, every arena block.  Allocations of tags outside
+// keepTags that are still live are logged as leaks.
+void MemReleaseAll(uint32_t keepTags);
@@ -0,0 +1,101 @@
+#include "metrics.h"
+#include "platform.h"
+#include <cstdio>
+#include <cstring>
+
+static MetricsBlock* g_block  = nullptr;
+static void*         g_handle = nullptr;
+
+void MetricsName(uint32_t pid, char* out, size_t outSize) {
+    snprintf(out, outSize, "SocketSaveFix.Metrics.%u", pid);
+}
+
+// ===================================================================
+// Writer
+// ===================================================================
+
+bool MetricsOpen(const char* name) {
+    if (g_block) return true;
+
+    void* handle = nullptr;
+    MetricsBlock* b = (MetricsBlock*)PlatCreateShared(name, sizeof(MetricsBlock), handle);
+    if (!b) return false;
+
+    b->version     = METRICS_VERSION;
+    b->headerBytes = (uint16_t)offsetof(MetricsBlock, data);
+    b->blockBytes  = (uint32_t)sizeof(MetricsBlock);
+    b->pid         = PlatProcessId();
+    b->data.lastLoadSignalled = -1;
+    __atomic_store_n(&b->magic, METRICS_MAGIC, __ATOMIC_RELEASE);
+
+    g_block  = b;
+    g_handle = handle;
+    return true;
+}
+
+void MetricsClose() {
+    if (!g_block) return;
+    PlatCloseShared(g_block, sizeof(MetricsBlock), g_handle);
+    g_block  = nullptr;
+    g_handle = nullptr;
+}
+
+MetricsData* MetricsBeginWrite() {
+    if (!g_block) return nullptr;
+
+    // Take the odd state; another writer holding it finishes in a few stores
+    uint64_t seq = __atomic_load_n(&g_block->seq, __ATOMIC_RELAXED);
+    for (;;) {
+        if ((seq & 1) == 0 &&
+            __atomic_compare_exchange_n(&g_block->seq, &seq, seq + 1, true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            break;
+        PlatSleep(0);
+        seq = __atomic_load_n(&g_block->seq, __ATOMIC_RELAXED);
+    }
+
+    // Field stores must not become visible before the odd seq
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return &g_block->data;
+}
+
+void MetricsEndWrite() {
+    if (!g_block) return;
+    __atomic_fetch_add(&g_block->seq, 1, __ATOMIC_RELEASE);
+}
+
+// ===================================================================
+// Reader
+// ===================================================================
+
+bool MetricsSnapshot(const MetricsBlock* shared, MetricsBlock& out, int tries) {
+    if (__atomic_load_n(&shared->magic, __ATOMIC_ACQUIRE) != METRICS_MAGIC) return false;
+    if (shared->version != METRICS_VERSION || shared->blockBytes < sizeof(MetricsBlock))
+        return false;
+
+    for (int i = 0; i < tries; ++i) {
+        uint64_t before = __atomic_load_n(&shared->seq, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            PlatSleep(0);
+            continue;
+        }
+
+        memcpy(&out, shared, sizeof(out));
+
+        // The copy's loads must complete before seq is read again
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shared->seq, __ATOMIC_RELAXED) == before) {
+            out.seq = before;
+            return true;
+        }
+    }
+    return false;
+}
+
+const MetricsBlock* MetricsAttach(const char* name, void*& handle) {
+    return (const MetricsBlock*)PlatOpenShared(name, sizeof(MetricsBlock), handle);
+}
+
+void MetricsDetach(const MetricsBlock* block, void* handle) {
+    PlatCloseShared(block, sizeof(MetricsBlock), handle);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Live metrics — a fixed-layout block in named shared memory that an
+// external monitor can read while the game runs, without the log: where
+// the engine symbols came from, how long init took, what the last load
+// signalled and how often each hook ran.
+//
+// Writers update the block under a seqlock: 'seq' is odd while a write is
+// in progress, and a reader copies the block and keeps the copy only if
+// 'seq' was even and unchanged across the copy.  Writers never wait on a
+// reader; concurrent writers take turns on the odd/even transition.
+//
+// The layout is versioned: fields are only appended (blockBytes grows),
+// METRICS_VERSION changes when one is moved or its meaning changes.
+// tools/ssf_metrics reads the block by process id.
+// ---------------------------------------------------------------------------
+
+constexpr uint32_t METRICS_MAGIC     = 0x4D465353;     // "SSFM"
+constexpr uint16_t METRICS_VERSION   = 1;
+constexpr int      METRICS_MAX_HOOKS = 16;
+
+enum MetricsSymbols : uint32_t {
+    METRICS_SYMBOLS_NONE,           // not resolved (yet)
+    METRICS_SYMBOLS_INI,            // socket_save_fix.ini RVAs
+    METRICS_SYMBOLS_AOB,            // pattern scan
+};
+
+enum MetricsInit : uint32_t {
+    METRICS_INIT_RUNNING,
+    METRICS_INIT_DONE,
+    METRICS_INIT_FAILED,
+    METRICS_INIT_UNLOADED,
+};
+
+struct MetricsHook {
+    char     name[24];
+    uint64_t calls;
+};
+
+struct MetricsData {
+    uint32_t    symbols;            // MetricsSymbols
+    uint32_t    init;               // MetricsInit
+    uint64_t    setupMicros;        // init pipeline, start to finish
+    uint64_t    errors;             // failed init stages and post-load rebuilds
+    uint64_t    loads;              // post-load rebuilds run
+    int64_t     lastLoadEntities;   // entity slots of the last load
+    int64_t     lastLoadSignalled;  // entities signalled, -1 = rebuild failed
+    uint64_t    lastSignalMicros;   // SignalEntity loop of the last load
+    uint64_t    lastLoadMicros;     // whole post-load rebuild of the last load
+    uint64_t    saves;
+    uint64_t    lastSaveMicros;
+    uint32_t    hookCount;
+    uint32_t    reserved;
+    MetricsHook hooks[METRICS_MAX_HOOKS];
+};
+
+struct MetricsBlock {
+    uint32_t    magic;              // set last, once the block is initialised
+    uint16_t    version;
+    uint16_t    headerBytes;        // offset of 'data'
+    uint32_t    blockBytes;
+    uint32_t    pid;
+    uint64_t    seq;                // seqlock, odd while a write is in progress
+    MetricsData data;
+};
+
+static_assert(sizeof(MetricsBlock) == 624, "MetricsBlock layout is shared with readers");
+
+// "SocketSaveFix.Metrics.<pid>"
+void MetricsName(uint32_t pid, char* out, size_t outSize);
+
+// Writer side (the mod).  MetricsOpen creates the block under 'name' for
+// this process; without it Begin returns null and nothing is published.
+bool MetricsOpen(const char* name);
+void MetricsClose();
+
+// Bracket every update: fields written between the two are seen by a
+// reader together or not at all.  Keep the bracketed code short.
+MetricsData* MetricsBeginWrite();
+void         MetricsEndWrite();
+
+// Reader side.  Copies a consistent snapshot of 'shared' into 'out';
+// false if the block is not initialised, of another version, or was
+// being written on every one of 'tries' attempts.
+bool MetricsSnapshot(const MetricsBlock* shared, MetricsBlock& out, int tries = 100);
+
+// Open another process's block read-only by name
+const MetricsBlock* MetricsAttach(const char* name, void*& handle);
+void                MetricsDetach(const MetricsBlock* block, void* handle);
@@ -0,0 +1,195 @@
+#include "nearalloc.h"
+#include "log.h"
+#include <windows.h>
+#include <atomic>
+#include <cstring>
+
+// ===================================================================
+// Blocks
+// ===================================================================
+
+static constexpr size_t    BLOCK_SIZE      = 64 * 1024;
+static constexpr size_t    SLOTS_PER_BLOCK = BLOCK_SIZE / NEAR_SLOT_SIZE;
+static constexpr int       MAX_BLOCKS      = 16;
+static constexpr uintptr_t REACH           = 0x7FFF0000ULL;   // keep clear of INT32 limits
+
+struct NearBlock {
+    uintptr_t base;                             // 0 = unused entry
+    uint64_t  used[SLOTS_PER_BLOCK / 64];       // slot bitmap
+    int       inUse;
+};
+
+static NearBlock         g_blocks[MAX_BLOCKS] = {};
+static std::atomic_flag  g_lock = ATOMIC_FLAG_INIT;
+
+struct NearLock {
+    NearLock()  { while (g_lock.test_and_set(std::memory_order_acquire)) Sleep(0); }
+    ~NearLock() { g_lock.clear(std::memory_order_release); }
+};
+
+static bool InReach(uintptr_t blockBase, uintptr_t nearAddr) {
+    uintptr_t lo = blockBase;
+    uintptr_t hi = blockBase + BLOCK_SIZE;
+    return (lo >= nearAddr) ? (hi - nearAddr <= REACH) : (nearAddr - lo <= REACH);
+}
+
+// ===================================================================
+// Region search — VirtualQuery once per region, not per 64 KB step
+// ===================================================================
+
+static uintptr_t TryReserve(uintptr_t addr) {
+    void* p = VirtualAlloc((void*)addr, BLOCK_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READ);
+    return (uintptr_t)p;
+}
+
+static uintptr_t ReserveBlockNear(uintptr_t nearAddr) {
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    const uintptr_t gran = si.dwAllocationGranularity;
+    const uintptr_t minAddr = (uintptr_t)si.lpMinimumApplicationAddress;
+    const uintptr_t maxAddr = (uintptr_t)si.lpMaximumApplicationAddress;
+
+    uintptr_t lo = (nearAddr > REACH + minAddr) ? nearAddr - REACH : minAddr;
+    uintptr_t hi = (nearAddr + REACH < maxAddr) ? nearAddr + REACH : maxAddr;
+    int queries = 0;
+
+    // Upward: skip each occupied region by its RegionSize
+    uintptr_t addr = (nearAddr + gran - 1) & ~(gran - 1);
+    while (addr + BLOCK_SIZE <= hi) {
+        MEMORY_BASIC_INFORMATION mbi;
+        queries++;
+        if (VirtualQuery((void*)addr, &mbi, sizeof(mbi)) == 0) break;
+
+        uintptr_t regionEnd = (uintptr_t)mbi.BaseAddress + mbi.RegionSize;
+        if (mbi.State == MEM_FREE && regionEnd - addr >= BLOCK_SIZE) {
+            if (uintptr_t p = TryReserve(addr)) {
+                LogDebug("NearAlloc: block at 0x%llX after %d queries (above)",
+                         (unsigned long long)p, queries);
+                return p;
+            }
+        }
+        addr = (regionEnd + gran - 1) & ~(gran - 1);
+    }
+
+    // Downward: jump below each occupied allocation
+    addr = ((nearAddr & ~(gran - 1)) > BLOCK_SIZE) ? (nearAddr & ~(gran - 1)) - BLOCK_SIZE : 0;
+    while (addr >= lo && addr != 0) {
+        MEMORY_BASIC_INFORMATION mbi;
+        queries++;
+        if (VirtualQuery((void*)addr, &mbi, sizeof(mbi)) == 0) break;
+
+        uintptr_t regionEnd = (uintptr_t)mbi.BaseAddress + mbi.RegionSize;
+        uintptr_t next;
+        if (mbi.State == MEM_FREE) {
+            if (regionEnd - addr >= BLOCK_SIZE) {
+                if (uintptr_t p = TryReserve(addr)) {
+                    LogDebug("NearAlloc: block at 0x%llX after %d queries (below)",
+                             (unsigned long long)p, queries);
+                    return p;
+                }
+            }
+            next = addr;
+        } else {
+            next = (uintptr_t)mbi.AllocationBase;
+        }
+        next &= ~(gran - 1);
+        if (next < lo + BLOCK_SIZE) break;
+        addr = next - BLOCK_SIZE;
+    }
+
+    LogMsg("WARNING: NearAlloc found no free block within ±2GB of 0x%llX (%d queries)",
+           (unsigned long long)nearAddr, queries);
+    return 0;
+}
+
+// ===================================================================
+// Slots
+// ===================================================================
+
+static void* TakeSlot(NearBlock& b) {
+    for (size_t w = 0; w < SLOTS_PER_BLOCK / 64; ++w) {
+        if (b.used[w] == ~0ULL) continue;
+        for (int bit = 0; bit < 64; ++bit) {
+            if (b.used[w] & (1ULL << bit)) continue;
+            b.used[w] |= (1ULL << bit);
+            b.inUse++;
+            return (void*)(b.base + (w * 64 + bit) * NEAR_SLOT_SIZE);
+        }
+    }
+    return nullptr;
+}
+
+void* NearAlloc(uintptr_t nearAddr, size_t size) {
+    if (size > NEAR_SLOT_SIZE) {
+        LogMsg("ERROR: NearAlloc request of %zu bytes exceeds slot size %zu", size, NEAR_SLOT_SIZE);
+        return nullptr;
+    }
+
+    NearLock lock;
+
+    for (NearBlock& b : g_blocks) {
+        if (b.base && b.inUse < (int)SLOTS_PER_BLOCK && InReach(b.base, nearAddr))
+            return TakeSlot(b);
+    }
+
+    for (NearBlock& b : g_blocks) {
+        if (b.base) continue;
+        uintptr_t base = ReserveBlockNear(nearAddr);
+        if (!base) return nullptr;
+        memset(&b, 0, sizeof(b));
+        b.base = base;
+        return TakeSlot(b);
+    }
+
+    LogMsg("ERROR: NearAlloc out of block entries (%d)", MAX_BLOCKS);
+    return nullptr;
+}
+
+void NearFree(void* slot) {
+    if (!slot) return;
+    uintptr_t p = (uintptr_t)slot;
+
+    NearLock lock;
+    for (NearBlock& b : g_blocks) {
+        if (!b.base || p < b.base || p >= b.base + BLOCK_SIZE) continue;
+        size_t idx = (p - b.base) / NEAR_SLOT_SIZE;
+        uint64_t mask = 1ULL << (idx % 64);
+        if (b.used[idx / 64] & mask) {
+            b.used[idx / 64] &= ~mask;
+            b.inUse--;
+        }
+        return;
+    }
+}
+
+bool NearWriteBegin(void* p, size_t size) {
+    DWORD oldProtect;
+    return VirtualProtect(p, size, PAGE_EXECUTE_READWRITE, &oldProtect) != 0;
+}
+
+void NearWriteEnd(void* p, size_t size) {
+    DWORD oldProtect;
+    VirtualProtect(p, size, PAGE_EXECUTE_READ, &oldProtect);
+    FlushInstructionCache(GetCurrentProcess(), p, size);
+}
+
+void NearGetStats(size_t& reserved, size_t& inUse) {
+    reserved = inUse = 0;
+
+    NearLock lock;
+    for (const NearBlock& b : g_blocks) {
+        if (!b.base) continue;
+        reserved += BLOCK_SIZE;
+        inUse    += (size_t)b.inUse * NEAR_SLOT_SIZE;
+    }
+}
+
+void NearReleaseUnused() {
+    NearLock lock;
+    for (NearBlock& b : g_blocks) {
+        if (b.base && b.inUse == 0) {
+            VirtualFree((void*)b.base, 0, MEM_RELEASE);
+            b.base = 0;
+        }
+    }
+}
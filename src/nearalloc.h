@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// ---------------------------------------------------------------------------
+// Near-code slab allocator — hands out small executable slots (trampolines,
+// relay stubs) within rel32 reach (±2GB) of a given code address.
+//
+// One 64 KB block is reserved per ±2GB window and carved into fixed-size
+// slots, so a dozen hooks cost one allocation instead of a dozen 64 KB RWX
+// granules.  Blocks are PAGE_EXECUTE_READ; wrap writes in NearWriteBegin /
+// NearWriteEnd, which make the affected pages writable only for the
+// duration of the write.
+// ---------------------------------------------------------------------------
+
+constexpr size_t NEAR_SLOT_SIZE = 128;
+
+// Allocate one slot (size <= NEAR_SLOT_SIZE) within rel32 reach of nearAddr.
+// Returns nullptr if no block could be placed in range.
+void* NearAlloc(uintptr_t nearAddr, size_t size);
+
+// Return a slot to its block.
+void NearFree(void* slot);
+
+// Make [p, p+size) writable (RWX — other slots on the page may be running).
+bool NearWriteBegin(void* p, size_t size);
+
+// Restore RX and flush the instruction cache for [p, p+size).
+void NearWriteEnd(void* p, size_t size);
+
+// Release every block that has no slots in use.
+void NearReleaseUnused();
+
+// Bytes reserved in blocks and handed out in slots (memory report)
+void NearGetStats(size_t& reserved, size_t& inUse);
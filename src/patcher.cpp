@@ -1,84 +1,123 @@
 #include "patcher.h"
+#include "log.h"
 #include "scanner.h"
-#include "hook.h"
+#include "discovery.h"
+#include "compact.h"
+#include "hierarchy.h"
+#include "hookreg.h"
+#include "ini.h"
+#include "mem.h"
+#include "metrics.h"
+#include "nearalloc.h"
+#include "pipeline.h"
+#include "platform.h"
+#include "probe.h"
+#include "props.h"
+#include "rebuild.h"
+#include "savestats.h"
+#include "sidecar.h"
+#include "trace.h"
 #include "ue_types.h"
+#include "uobject.h"
 #include <windows.h>
+#include <atomic>
 #include <cstdio>
 #include <cstring>
 #include <cwchar>
 
-extern void LogMsg(const char* fmt, ...);
-
 // ===================================================================
-// Helper: resolve an FName to a narrow string  (reuses one FString)
+// Globals
 // ===================================================================
 
-static FString g_fstr = { nullptr, 0, 0 };
+static ScanResults       g_scan = {};
+static uintptr_t         g_objArrayBase = 0;
+using PostSaveHook = Hook<void(void*)>;
+static PostSaveHook      g_postSaveHook("OnPostSaveLoaded");
+
+// Save side (save stats).  The save entry is forwarded as four register
+// arguments, so it must not take more than four or any in xmm registers.
+using MassSaveHook = Hook<void*(void*, void*, void*, void*)>;
+using SaveDataHook = Hook<bool(const void*, const void*, int32_t)>;
+static MassSaveHook      g_massSaveHook("MassSave");
+static SaveDataHook      g_saveDataHook("SaveDataToSlot");
+static int               g_saveDepth = 0;       // game thread only
+
+// Which MassSave a slot write belongs to, for its sidecar snapshot: the
+// one in progress, or for a write on another thread (async save) the
+// last one.  Ids count outer MassSave calls from 1.
+static uint32_t              g_saveSeq = 0;     // game thread only
+static std::atomic<uint32_t> g_saveActive{0};   // MassSave in progress, 0 = none
+static std::atomic<uint32_t> g_saveLast{0};
+static std::atomic<DWORD>    g_gameThread{0};
+
+// Load side: every save read resets the signal ledger; with the sidecar
+// it also records the slot the save came from, so the post-load rebuild
+// can find its sidecar
+using LoadDataHook = Hook<bool(void*, const void*, int32_t)>;
+static LoadDataHook      g_loadDataHook("LoadDataFromSlot");
+struct LoadedSave {
+    char     slot[128];         // sanitized slot name, "" = none since last rebuild
+    int64_t  bytes;
+    uint32_t sample;            // SidecarSaveSample of the data read
+};
+static LoadedSave        g_loadedSave = {};
 
-static const wchar_t* NameToString(FNameToStringFn fn, uintptr_t namePtr) {
-    g_fstr.Num = 0;
-    fn((const void*)namePtr, &g_fstr);
-    return g_fstr.Data;
-}
+// Set only by the sidecar stage, which needs every hook involved
+static bool              g_sidecarOn = false;
 
-static bool NameEqualsA(FNameToStringFn fn, uintptr_t namePtr, const char* target) {
-    const wchar_t* ws = NameToString(fn, namePtr);
-    if (!ws) return false;
-    size_t tlen = strlen(target);
-    for (size_t i = 0; i < tlen; ++i) {
-        if (ws[i] != (wchar_t)(unsigned char)target[i]) return false;
-    }
-    return ws[tlen] == L'\0';
+static bool SidecarActive() {
+    return g_sidecarOn;
 }
 
-static void WideToNarrow(const wchar_t* ws, char* out, size_t maxLen) {
-    if (!ws) { out[0] = '\0'; return; }
-    size_t i = 0;
-    for (; ws[i] && i + 1 < maxLen; ++i)
-        out[i] = (char)(ws[i] < 128 ? ws[i] : '?');
-    out[i] = '\0';
-}
+// Signal subsystem instance + signal name (resolved at init time,
+// completed at load time if needed)
+static SignalState       g_signal = {};
 
-// ===================================================================
-// Object iteration helpers
-// ===================================================================
+// Entities signalled in the current world, so repeated OnPostSaveLoaded
+// calls only signal new or recycled handles.  Only used while the
+// LoadDataFromSlot hook is in to reset it: a second load of the same
+// world restores the same handles.  LoadDataFromSlot may run on an async
+// load thread, so it only counts the reads; the game thread resets the
+// ledger before the rebuild that follows.
+static SignalLedger      g_ledger = {};
+static std::atomic<uint32_t> g_savesRead{0};
+static uint32_t          g_ledgerSavesRead = 0;     // game thread only
 
-static uintptr_t GetObject(uintptr_t objArrayBase, int32_t index) {
-    auto** chunks = ReadAt<uintptr_t**>(objArrayBase, TObjOff::Objects);
-    if (!chunks) return 0;
+// INI fallback signal name
+static char              g_iniSignalName[256] = "CrLogisticsSocketsSignal";
 
-    int chunkIdx = index / TObjOff::ChunkSize;
-    int itemIdx  = index % TObjOff::ChunkSize;
+// INI ReconnectSockets: restore links lost before the mod was installed
+static bool              g_iniReconnect = true;
 
-    uintptr_t chunk = (uintptr_t)chunks[chunkIdx];
-    if (!chunk) return 0;
+// INI RailGraph: check the rail network after each load (off by default:
+// a full walk of the socket entities on the game thread)
+static bool              g_iniRailGraph = false;
 
-    uintptr_t item = chunk + (uintptr_t)itemIdx * ItemOff::Size;
-    return ReadAt<uintptr_t>(item, ItemOff::Object);
-}
+// INI CompactSockets: leave what the rebuild recomputes out of saves
+static bool              g_iniCompact = false;
 
-// ===================================================================
-// Globals
-// ===================================================================
+// INI SocketSidecar: snapshot socket state next to each save, restore from it on load
+static bool              g_iniSidecar = false;
 
-static ScanResults       g_scan = {};
-static uintptr_t         g_objArrayBase = 0;
-static InlineHook        g_postSaveHook = {};
+// INI LiveMetrics: publish the shared-memory metrics block (metrics.h)
+static bool              g_iniLiveMetrics = true;
 
-// Signal subsystem instance + signal name (resolved at init time)
-static void*             g_signalSubsystem = nullptr;
-static FName             g_socketSignalName = { 0, 0 };
-static bool              g_signalReady = false;
+// INI PropertyCache: keep reflected property offsets per game build (props.h)
+static bool              g_iniPropertyCache = true;
 
-// INI fallback signal name
-static char              g_iniSignalName[256] = "CrLogisticsSocketsSignal";
+// Hierarchy patches (v1): child struct -> ancestor inserted as its parent.
+// FCrLogisticsSocketsFragment is not IsChildOf(FCrMassSavableFragment), so
+// the save system skips it; re-parenting makes its data (and that of any
+// struct derived from it) savable.
+static const HierarchyPatch g_hierarchyPatches[] = {
+    { "CrLogisticsSocketsFragment", "CrMassSavableFragment" },
+};
 
-// Hierarchy patch state (for cleanup/restore)
-static uintptr_t* g_newChain = nullptr;
-static uintptr_t  g_socketsStruct = 0;
-static uintptr_t* g_origChain = nullptr;
-static int32_t    g_origDepth = 0;
-static uintptr_t  g_origSuperStruct = 0;
+// Compact saves: socket locations come back from the rebuild signal, so
+// only the links are saved
+static const CompactPatch g_compactPatches[] = {
+    { "CrLogisticsSocket", "Location" },
+};
 
 // ===================================================================
 // Diagnostic: dump hierarchy chain and struct info
@@ -93,7 +132,8 @@ static void DumpHierarchyChain(FNameToStringFn fn, const char* label, uintptr_t
     LogMsg("  %s.HierarchyDepth   = %d", label, depth);
     LogMsg("  %s.InheritanceChain = 0x%llX", label, (unsigned long long)(uintptr_t)chain);
 
-    if (chain && depth >= 0 && depth < 32) {
+    // Per-entry dump resolves every ancestor name — only at LogLevel=3
+    if (g_logLevel >= LOG_LEVEL_DEBUG && chain && depth >= 0 && depth < 32) {
         for (int i = 0; i <= depth; ++i) {
             uintptr_t entry = chain[i];
             uintptr_t structPtr = entry - UStructOff::InheritanceChain;
@@ -102,10 +142,10 @@ static void DumpHierarchyChain(FNameToStringFn fn, const char* label, uintptr_t
             const wchar_t* ws = NameToString(fn, structPtr + UObjOff::NamePrivate);
             WideToNarrow(ws, nameBuf, sizeof(nameBuf));
 
-            LogMsg("    chain[%d] = 0x%llX -> struct 0x%llX (%s)%s",
-                   i, (unsigned long long)entry,
-                   (unsigned long long)structPtr, nameBuf,
-                   (i == depth) ? " [SELF]" : "");
+            LogDebug("    chain[%d] = 0x%llX -> struct 0x%llX (%s)%s",
+                     i, (unsigned long long)entry,
+                     (unsigned long long)structPtr, nameBuf,
+                     (i == depth) ? " [SELF]" : "");
         }
     }
 }
@@ -134,546 +174,368 @@ static void DumpStructInfo(FNameToStringFn fn, const char* label, uintptr_t scri
     LogMsg("  %s.StructFlags      = 0x%08X", label, flags);
 }
 
-// ===================================================================
-// Find all three target UScriptStructs in one pass
-// ===================================================================
-
-struct TargetStructs {
-    uintptr_t socketsFragment;   // FCrLogisticsSocketsFragment
-    uintptr_t savableFragment;   // FCrMassSavableFragment
-    uintptr_t massFragment;      // FMassFragment
-    uintptr_t scriptStructClass; // UScriptStruct class pointer (cached)
-};
-
-static bool FindTargets(uintptr_t objArrayBase, FNameToStringFn fn, TargetStructs& t) {
-    int32_t numElements = ReadAt<int32_t>(objArrayBase, TObjOff::NumElements);
-    if (numElements <= 0) return false;
-
-    // Phase 1: Find UScriptStruct class if not yet known
-    if (!t.scriptStructClass) {
-        constexpr int MAX_CLASSES = 512;
-        uintptr_t checkedClasses[MAX_CLASSES];
-        int numChecked = 0;
-
-        for (int32_t i = 0; i < numElements; ++i) {
-            uintptr_t obj = GetObject(objArrayBase, i);
-            if (!obj) continue;
-
-            uintptr_t cls = ReadAt<uintptr_t>(obj, UObjOff::ClassPrivate);
-            if (!cls) continue;
-
-            bool already = false;
-            for (int c = 0; c < numChecked; ++c) {
-                if (checkedClasses[c] == cls) { already = true; break; }
-            }
-            if (already) continue;
-            if (numChecked < MAX_CLASSES) checkedClasses[numChecked++] = cls;
-
-            if (NameEqualsA(fn, cls + UObjOff::NamePrivate, "ScriptStruct")) {
-                t.scriptStructClass = cls;
-                break;
-            }
-        }
-        if (!t.scriptStructClass) return false;
-    }
-
-    // Phase 2: Find target structs by name
-    int found = (t.socketsFragment ? 1 : 0) +
-                (t.savableFragment ? 1 : 0) +
-                (t.massFragment ? 1 : 0);
-
-    for (int32_t i = 0; i < numElements && found < 3; ++i) {
-        uintptr_t obj = GetObject(objArrayBase, i);
-        if (!obj) continue;
+// Resolved by ApplyPatch, read by the post-load socket verifier
+static TargetStructs g_targets = {};
 
-        uintptr_t cls = ReadAt<uintptr_t>(obj, UObjOff::ClassPrivate);
-        if (cls != t.scriptStructClass) continue;
-
-        uintptr_t namePtr = obj + UObjOff::NamePrivate;
-
-        if (!t.socketsFragment && NameEqualsA(fn, namePtr, "CrLogisticsSocketsFragment")) {
-            t.socketsFragment = obj;
-            found++;
-        }
-        else if (!t.savableFragment && NameEqualsA(fn, namePtr, "CrMassSavableFragment")) {
-            t.savableFragment = obj;
-            found++;
-        }
-        else if (!t.massFragment && NameEqualsA(fn, namePtr, "MassFragment")) {
-            t.massFragment = obj;
-            found++;
-        }
-    }
+// Set by the names-ready stage once objects, hierarchy, signal-name and
+// compact have finished.  The hooks go in earlier; until then the
+// detours leave g_targets, g_signal and the resolver caches to the patch
+// thread and skip whatever needs them.
+static std::atomic<bool> g_namesReady{false};
 
-    return found == 3;
+static bool NamesReady() {
+    return g_namesReady.load(std::memory_order_acquire);
 }
 
 // ===================================================================
-// PatchHierarchyChain — rebuild the precomputed IsChildOf array
-//
-// UE5 stores a flat ancestor array at UStruct+0x30 and depth at +0x38.
-// IsChildOf(target) checks: this->chain[target->depth] == (target + 0x30)
-//
-// We insert FCrMassSavableFragment into FCrLogisticsSocketsFragment's chain
-// so that the save system's IsChildOf check succeeds.
+// Read post-load options (fallback signal name, reconnect, compact,
+// sidecar) from INI
 // ===================================================================
 
-static bool PatchHierarchyChain(uintptr_t socketsStruct, uintptr_t savableStruct) {
-    int32_t sockDepth = ReadAt<int32_t>(socketsStruct, UStructOff::HierarchyDepth);
-    uintptr_t* sockChain = ReadAt<uintptr_t*>(socketsStruct, UStructOff::InheritanceChain);
-
-    int32_t savDepth = ReadAt<int32_t>(savableStruct, UStructOff::HierarchyDepth);
-    uintptr_t savIdentity = savableStruct + UStructOff::InheritanceChain;
-    uintptr_t sockIdentity = socketsStruct + UStructOff::InheritanceChain;
-
-    LogMsg("PatchHierarchyChain:");
-    LogMsg("  sockets depth=%d, chain=0x%llX, identity=0x%llX",
-           sockDepth, (unsigned long long)(uintptr_t)sockChain,
-           (unsigned long long)sockIdentity);
-    LogMsg("  savable depth=%d, identity=0x%llX",
-           savDepth, (unsigned long long)savIdentity);
-
-    if (!sockChain || sockDepth < 0 || sockDepth > 30) {
-        LogMsg("ERROR: Invalid sockets hierarchy data");
-        return false;
-    }
-
-    if (sockChain[sockDepth] != sockIdentity) {
-        LogMsg("ERROR: chain[self_depth] (0x%llX) != self identity (0x%llX)",
-               (unsigned long long)sockChain[sockDepth],
-               (unsigned long long)sockIdentity);
-        return false;
-    }
-
-    // Check if savable is already in the chain (patch already applied)
-    if (savDepth <= sockDepth && sockChain[savDepth] == savIdentity) {
-        LogMsg("Hierarchy chain already contains CrMassSavableFragment");
-        return true;
-    }
-
-    // Build new chain: insert savable at index savDepth, shift rest up by 1
-    int newSize = sockDepth + 2;
-    LogMsg("Building new chain: %d -> %d entries", sockDepth + 1, newSize);
-
-    g_newChain = (uintptr_t*)VirtualAlloc(
-        nullptr, newSize * sizeof(uintptr_t),
-        MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-    if (!g_newChain) {
-        LogMsg("ERROR: VirtualAlloc failed for new chain");
-        return false;
-    }
-
-    for (int i = 0; i < savDepth; ++i) {
-        g_newChain[i] = sockChain[i];
-    }
-
-    g_newChain[savDepth] = savIdentity;
-
-    for (int i = savDepth; i <= sockDepth; ++i) {
-        g_newChain[i + 1] = sockChain[i];
-    }
-
-    for (int i = 0; i < newSize; ++i) {
-        LogMsg("  newChain[%d] = 0x%llX%s%s",
-               i, (unsigned long long)g_newChain[i],
-               (g_newChain[i] == savIdentity) ? " [SAVABLE]" : "",
-               (g_newChain[i] == sockIdentity) ? " [SELF]" : "");
-    }
-
-    // Save originals for restoration on shutdown
-    g_socketsStruct   = socketsStruct;
-    g_origChain       = sockChain;
-    g_origDepth       = sockDepth;
-    g_origSuperStruct = ReadAt<uintptr_t>(socketsStruct, UStructOff::SuperStruct);
-
-    // Apply the patch
-    uintptr_t patchStart = socketsStruct + UStructOff::InheritanceChain;
-    DWORD oldProtect;
-    VirtualProtect((void*)patchStart, 0x18, PAGE_READWRITE, &oldProtect);
-
-    WriteAt<uintptr_t*>(socketsStruct, UStructOff::InheritanceChain, g_newChain);
-    WriteAt<int32_t>(socketsStruct, UStructOff::HierarchyDepth, sockDepth + 1);
-    WriteAt<uintptr_t>(socketsStruct, UStructOff::SuperStruct, savableStruct);
-
-    VirtualProtect((void*)patchStart, 0x18, oldProtect, &oldProtect);
-
-    // Verify
-    uintptr_t* verifyChain = ReadAt<uintptr_t*>(socketsStruct, UStructOff::InheritanceChain);
-    int32_t verifyDepth = ReadAt<int32_t>(socketsStruct, UStructOff::HierarchyDepth);
-    uintptr_t verifySuper = ReadAt<uintptr_t>(socketsStruct, UStructOff::SuperStruct);
-
-    bool ok = (verifyChain == g_newChain) &&
-              (verifyDepth == sockDepth + 1) &&
-              (verifySuper == savableStruct);
-
-    if (ok) {
-        uintptr_t testEntry = g_newChain[savDepth];
-        bool isChildOf = (savDepth <= verifyDepth) && (testEntry == savIdentity);
-        LogMsg("  IsChildOf(CrMassSavableFragment) = %s", isChildOf ? "TRUE" : "FALSE");
-    }
+extern char g_modDir[];
 
-    return ok;
+static void ReadIniFlag(const char* path, const char* key, bool& flag) {
+    flag = IniReadInt(path, key, flag) != 0;
+    LogMsg("  INI %s = %d", key, flag ? 1 : 0);
 }
 
-// ===================================================================
-// Read fallback signal name from INI
-// ===================================================================
-
-extern char g_modDir[];
+static void ReadRebuildOptionsFromINI() {
+    TRACE_SPAN("ReadRebuildOptionsFromINI");
 
-static void ReadSignalNameFromINI() {
     char path[MAX_PATH];
     snprintf(path, MAX_PATH, "%s\\socket_save_fix.ini", g_modDir);
 
-    FILE* f = fopen(path, "r");
-    if (!f) return;
-
-    char line[256];
-    while (fgets(line, sizeof(line), f)) {
-        if (line[0] == '#' || line[0] == ';' || line[0] == '\n' || line[0] == '\r')
-            continue;
+    if (IniReadString(path, "SocketSignalName", g_iniSignalName, sizeof(g_iniSignalName)))
+        LogMsg("  INI SocketSignalName = %s", g_iniSignalName);
 
-        char val[256];
-        if (sscanf(line, "SocketSignalName=%255s", val) == 1) {
-            strncpy(g_iniSignalName, val, sizeof(g_iniSignalName) - 1);
-            g_iniSignalName[sizeof(g_iniSignalName) - 1] = '\0';
-            LogMsg("  INI SocketSignalName = %s", g_iniSignalName);
-        }
-    }
-    fclose(f);
+    ReadIniFlag(path, "ReconnectSockets", g_iniReconnect);
+    ReadIniFlag(path, "RailGraph",        g_iniRailGraph);
+    ReadIniFlag(path, "CompactSockets",   g_iniCompact);
+    ReadIniFlag(path, "SocketSidecar",    g_iniSidecar);
+    ReadIniFlag(path, "PropertyCache",    g_iniPropertyCache);
 }
 
 // ===================================================================
-// Find UObject by class name in GUObjectArray (with class pointer cache)
+// Live metrics
+//
+// Published at the end of init, after every post-load rebuild and after
+// every save, so hook call counts lag by at most one such event.
 // ===================================================================
 
-struct ClassCacheEntry {
-    const char* name;
-    uintptr_t   classPtr;
-};
-static ClassCacheEntry g_classCache[8] = {};
-static int             g_classCacheCount = 0;
-
-static uintptr_t FindObjectByClassName(const char* className, bool skipCDO = false) {
-    int32_t numElements = ReadAt<int32_t>(g_objArrayBase, TObjOff::NumElements);
-
-    uintptr_t cachedClass = 0;
-    for (int c = 0; c < g_classCacheCount; ++c) {
-        if (strcmp(g_classCache[c].name, className) == 0) {
-            cachedClass = g_classCache[c].classPtr;
-            break;
-        }
-    }
+static uint64_t Micros(int64_t ticks) {
+    return (uint64_t)(ticks * 1000000 / PlatTicksPerSecond());
+}
 
-    for (int32_t i = 0; i < numElements; ++i) {
-        uintptr_t obj = GetObject(g_objArrayBase, i);
-        if (!obj) continue;
+// Read LiveMetrics= (before the symbols stage, which reads the rest of
+// the options) and create the block
+static void OpenMetrics() {
+    char path[MAX_PATH];
+    snprintf(path, MAX_PATH, "%s\\socket_save_fix.ini", g_modDir);
 
-        uintptr_t cls = ReadAt<uintptr_t>(obj, UObjOff::ClassPrivate);
-        if (!cls) continue;
+    g_iniLiveMetrics = IniReadInt(path, "LiveMetrics", g_iniLiveMetrics) != 0;
+    if (!g_iniLiveMetrics) return;
 
-        if (cachedClass) {
-            if (cls != cachedClass) continue;
-        } else {
-            if (!NameEqualsA(g_scan.fnNameToString, cls + UObjOff::NamePrivate, className))
-                continue;
-            if (g_classCacheCount < 8) {
-                g_classCache[g_classCacheCount].name = className;
-                g_classCache[g_classCacheCount].classPtr = cls;
-                g_classCacheCount++;
-            }
-        }
+    char name[64];
+    MetricsName(PlatProcessId(), name, sizeof(name));
+    if (MetricsOpen(name))
+        LogMsg("Live metrics published as Local\\%s", name);
+    else
+        LogMsg("WARNING: Could not create live metrics block %s (error %lu)",
+               name, GetLastError());
+}
 
-        if (skipCDO) {
-            uintptr_t outer = ReadAt<uintptr_t>(obj, UObjOff::OuterPrivate);
-            if (outer) {
-                uintptr_t outerClass = ReadAt<uintptr_t>(outer, UObjOff::ClassPrivate);
-                if (outerClass && NameEqualsA(g_scan.fnNameToString,
-                                               outerClass + UObjOff::NamePrivate, "Package"))
-                    continue;
-            }
-        }
+// Call counts of the registered hooks; inside a metrics write
+static void PublishHooks(MetricsData& m) {
+    int n = HookCount();
+    if (n > METRICS_MAX_HOOKS) n = METRICS_MAX_HOOKS;
+    for (int i = 0; i < n; ++i) {
+        const HookEntry* e = HookGet(i);
+        MetricsHook& h = m.hooks[i];
+        memset(h.name, 0, sizeof(h.name));
+        strncpy(h.name, e->name, sizeof(h.name) - 1);
+        h.calls = e->stats ? HookStatsCalls(*e->stats) : 0;
+    }
+    m.hookCount = (uint32_t)n;
+}
 
-        return obj;
-    }
-    return 0;
+static RebuildEnv RebuildEnvNow(const Sidecar* sidecar = nullptr, void* loadingObject = nullptr) {
+    SignalLedger* ledger = g_loadDataHook.Installed() ? &g_ledger : nullptr;
+    return { g_objArrayBase, g_scan.fnNameToString, g_scan.fnSignalEntity, g_iniSignalName,
+             g_iniReconnect, g_iniRailGraph, sidecar, ledger, (uintptr_t)loadingObject };
 }
 
 // ===================================================================
-// Find an FName ComparisonIndex by string
+// Sidecar files: <mod dir>\sidecars\<slot>.ssfs
 // ===================================================================
 
-static FName FindFNameByString(const char* target) {
-    int32_t numElements = ReadAt<int32_t>(g_objArrayBase, TObjOff::NumElements);
+// Slot names are FStrings chosen by the game; keep what is safe in a
+// file name and replace the rest
+static bool ReadSlotName(const void* slotName, char* out, size_t outSize) {
+    out[0] = '\0';
+    if (!slotName) return false;
 
-    for (int32_t i = 0; i < numElements; ++i) {
-        uintptr_t obj = GetObject(g_objArrayBase, i);
-        if (!obj) continue;
+    const wchar_t* ws = ReadAt<const wchar_t*>((uintptr_t)slotName, TArrayOff::Data);
+    if (!ws) return false;
+    WideToNarrow(ws, out, outSize);
 
-        uintptr_t namePtr = obj + UObjOff::NamePrivate;
-        if (NameEqualsA(g_scan.fnNameToString, namePtr, target)) {
-            FName result;
-            result.ComparisonIndex = ReadAt<uint32_t>(namePtr, 0);
-            result.Number = ReadAt<uint32_t>(namePtr, 4);
-            return result;
-        }
+    for (char* p = out; *p; ++p) {
+        char c = *p;
+        bool safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                    (c >= '0' && c <= '9') || c == '-' || c == '_';
+        if (!safe) *p = '_';
     }
+    return out[0] != '\0';
+}
 
-    return { 0, 0 };
+static void SidecarPath(const char* slot, char* path, size_t pathSize) {
+    snprintf(path, pathSize, "%s\\sidecars", g_modDir);
+    CreateDirectoryA(path, nullptr);    // fails harmlessly if it exists
+    snprintf(path, pathSize, "%s\\sidecars\\%s.ssfs", g_modDir, slot);
 }
 
 // ===================================================================
-// Discover signal name from CrLogisticsSocketsSignalProcessor CDO
+// Hook detour: OnPostSaveLoaded
+//
+// Called after the save subsystem finishes loading entity data.
+// We signal all entities with the logistics sockets signal to trigger
+// UCrLogisticsSocketsSignalProcessor::Execute, which properly rebuilds
+// socket data from FCrLogisticsSocketsParams + FCrCustomConnectionData.
 // ===================================================================
 
-static constexpr size_t SIGNAL_PROCESSOR_SIGNAL_OFFSET = 0x288;
-
-static bool DiscoverSignalName() {
-    int32_t numElements = ReadAt<int32_t>(g_objArrayBase, TObjOff::NumElements);
-    uintptr_t processorCDO = 0;
-
-    for (int32_t i = 0; i < numElements; ++i) {
-        uintptr_t obj = GetObject(g_objArrayBase, i);
-        if (!obj) continue;
-
-        uintptr_t cls = ReadAt<uintptr_t>(obj, UObjOff::ClassPrivate);
-        if (!cls) continue;
-
-        if (NameEqualsA(g_scan.fnNameToString, cls + UObjOff::NamePrivate,
-                        "CrLogisticsSocketsSignalProcessor")) {
-            uintptr_t outer = ReadAt<uintptr_t>(obj, UObjOff::OuterPrivate);
-            if (outer) {
-                uintptr_t outerClass = ReadAt<uintptr_t>(outer, UObjOff::ClassPrivate);
-                if (outerClass && NameEqualsA(g_scan.fnNameToString,
-                                               outerClass + UObjOff::NamePrivate, "Package")) {
-                    processorCDO = obj;
-                    LogMsg("Found CrLogisticsSocketsSignalProcessor CDO at 0x%llX",
-                           (unsigned long long)obj);
-                    break;
-                }
-            }
-            if (!processorCDO) {
-                processorCDO = obj;
-                LogMsg("Found CrLogisticsSocketsSignalProcessor instance at 0x%llX (may not be CDO)",
-                       (unsigned long long)obj);
-            }
-        }
-    }
+static void DetourBody(PostSaveHook::Call& call, void* thisPtr);
 
-    if (!processorCDO) {
-        LogMsg("WARNING: CrLogisticsSocketsSignalProcessor not found in GUObjectArray");
-        return false;
+static void __attribute__((ms_abi)) Detour_OnPostSaveLoaded(void* thisPtr) {
+    PostSaveHook::Call call(g_postSaveHook);
+    {
+        TRACE_SPAN("Detour_OnPostSaveLoaded");
+        DetourBody(call, thisPtr);
     }
+    TraceExport();
+}
 
-    FName signalFName;
-    signalFName.ComparisonIndex = ReadAt<uint32_t>(processorCDO, SIGNAL_PROCESSOR_SIGNAL_OFFSET);
-    signalFName.Number = ReadAt<uint32_t>(processorCDO, SIGNAL_PROCESSOR_SIGNAL_OFFSET + 4);
-
-    const wchar_t* ws = NameToString(g_scan.fnNameToString,
-                                      processorCDO + SIGNAL_PROCESSOR_SIGNAL_OFFSET);
-    if (ws && ws[0] != L'\0') {
-        char nameBuf[256];
-        WideToNarrow(ws, nameBuf, sizeof(nameBuf));
-        LogMsg("Signal name from CDO+0x%zX: \"%s\" (CompIdx=0x%X, Num=%d)",
-               SIGNAL_PROCESSOR_SIGNAL_OFFSET, nameBuf,
-               signalFName.ComparisonIndex, signalFName.Number);
+static void DetourBody(PostSaveHook::Call& call, void* thisPtr) {
+    LogMsg(">>> OnPostSaveLoaded hook entered (this=0x%llX)",
+           (unsigned long long)(uintptr_t)thisPtr);
 
-        g_socketSignalName = signalFName;
-        return true;
+    // Call original first — let the save system finish its work
+    {
+        TRACE_SPAN("OnPostSaveLoaded (original)");
+        call.Original(thisPtr);
     }
 
-    LogMsg("WARNING: FName at CDO+0x%zX resolved to empty/null", SIGNAL_PROCESSOR_SIGNAL_OFFSET);
-    return false;
-}
+    LogMsg("  Original OnPostSaveLoaded returned");
 
-// ===================================================================
-// Find UMassSignalSubsystem instance
-// ===================================================================
+    uint32_t savesRead = g_savesRead.load(std::memory_order_acquire);
+    if (savesRead != g_ledgerSavesRead) {
+        SignalLedgerReset(g_ledger);
+        g_ledgerSavesRead = savesRead;
+    }
 
-static bool FindSignalSubsystem() {
-    int32_t numElements = ReadAt<int32_t>(g_objArrayBase, TObjOff::NumElements);
+    if (!NamesReady()) {
+        LogMsg("  Init still resolving names — post-load rebuild skipped for this load");
+        g_loadedSave.slot[0] = '\0';
+        return;
+    }
 
-    for (int32_t i = 0; i < numElements; ++i) {
-        uintptr_t obj = GetObject(g_objArrayBase, i);
-        if (!obj) continue;
+    // Sidecar of the save just loaded, if LoadDataFromSlot saw one read
+    Sidecar sidecar = {};
+    bool haveSidecar = false;
+    if (SidecarActive() && g_loadedSave.slot[0]) {
+        char path[MAX_PATH];
+        SidecarPath(g_loadedSave.slot, path, sizeof(path));
+        haveSidecar = SidecarOpen(path, g_loadedSave.bytes, g_loadedSave.sample, sidecar);
+    }
+    g_loadedSave.slot[0] = '\0';
 
-        uintptr_t cls = ReadAt<uintptr_t>(obj, UObjOff::ClassPrivate);
-        if (!cls) continue;
+    int64_t t0 = PlatTicks();
+    RebuildStats stats;
+    int signalled = RebuildSockets(RebuildEnvNow(haveSidecar ? &sidecar : nullptr, thisPtr),
+                                   g_signal, g_targets, &stats);
+    if (haveSidecar) SidecarClose(sidecar);
 
-        if (NameEqualsA(g_scan.fnNameToString, cls + UObjOff::NamePrivate,
-                        "MassSignalSubsystem")) {
-            g_signalSubsystem = (void*)obj;
-            LogMsg("Found UMassSignalSubsystem at 0x%llX", (unsigned long long)obj);
-            return true;
-        }
+    if (MetricsData* m = MetricsBeginWrite()) {
+        m->loads++;
+        m->lastLoadEntities  = stats.entitySlots;
+        m->lastLoadSignalled = signalled;
+        m->lastSignalMicros  = Micros(stats.signalTicks);
+        m->lastLoadMicros    = Micros(PlatTicks() - t0);
+        if (signalled < 0) m->errors++;
+        PublishHooks(*m);
+        MetricsEndWrite();
     }
+    if (signalled < 0) return;
 
-    LogMsg("WARNING: UMassSignalSubsystem not found");
-    return false;
+    LogMsg("<<< OnPostSaveLoaded hook complete");
 }
 
 // ===================================================================
-// Hook detour: OnPostSaveLoaded
+// Hook detours: save side
 //
-// Called after the save subsystem finishes loading entity data.
-// We signal all entities with the logistics sockets signal to trigger
-// UCrLogisticsSocketsSignalProcessor::Execute, which properly rebuilds
-// socket data from FCrLogisticsSocketsParams + FCrCustomConnectionData.
+// MassSave brackets one UCrMassSaveSubsystem save; SaveDataToSlot sees
+// the serialized bytes on their way to the slot.  After the original
+// returns the socket entities are counted, outside the timed part, so
+// the fragment's share can be logged with the save.
+//
+// With SocketSidecar the socket state is captured before the save runs,
+// tagged with the MassSave call, and written once SaveDataToSlot has
+// stored that save's data — not a settings or other USaveGame written in
+// between, which runs on the game thread outside MassSave; LoadDataFromSlot resets the signal ledger and, with the sidecar,
+// remembers which slot and data the next load uses.
 // ===================================================================
 
-using OnPostSaveLoadedFn = void (*)(void* thisPtr);
-
-// ===================================================================
-// Entity manager scanning
-// ===================================================================
+static void* __attribute__((ms_abi)) Detour_MassSave(void* a, void* b, void* c, void* d) {
+    MassSaveHook::Call call(g_massSaveHook);
 
-static constexpr int MAX_ENTITY_INDEX = 200000;
-
-static int ReadEntityHandles(uintptr_t entitySubsystem,
-                              FMassEntityHandle* outHandles, int maxHandles)
-{
-    LogMsg("  Scanning UMassEntitySubsystem (0x%llX) for entity array...",
-           (unsigned long long)entitySubsystem);
-
-    for (size_t off = 0x30; off < 0x400; off += 8) {
-        uintptr_t arrayPtr = ReadAt<uintptr_t>(entitySubsystem, off);
-        if (arrayPtr == 0 || arrayPtr < 0x10000) continue;
-
-        int32_t num = ReadAt<int32_t>(entitySubsystem, off + 0x08);
-        int32_t max = ReadAt<int32_t>(entitySubsystem, off + 0x0C);
-
-        if (num < 100 || num > MAX_ENTITY_INDEX || max < num || max > MAX_ENTITY_INDEX * 2)
-            continue;
-
-        for (int elemSize = 16; elemSize <= 32; elemSize += 8) {
-            int validCount = 0;
-            int sampleSize = (num < 20) ? num : 20;
-
-            for (int i = 0; i < sampleSize; ++i) {
-                uintptr_t elemAddr = arrayPtr + (uintptr_t)i * elemSize;
-                int32_t serial = ReadAt<int32_t>(elemAddr, 0);
-                uintptr_t archetype = ReadAt<uintptr_t>(elemAddr, 8);
-
-                if (serial > 0 && serial < 10000 &&
-                    archetype > 0x10000 && archetype < 0x7FFFFFFFFFFF) {
-                    validCount++;
-                }
-            }
-
-            if (validCount >= sampleSize / 2) {
-                LogMsg("  Found candidate entity array at subsys+0x%zX: "
-                       "ptr=0x%llX, num=%d, max=%d, elemSize=%d (%d/%d valid samples)",
-                       off, (unsigned long long)arrayPtr, num, max,
-                       elemSize, validCount, sampleSize);
-
-                int count = 0;
-                for (int i = 0; i < num && count < maxHandles; ++i) {
-                    uintptr_t elemAddr = arrayPtr + (uintptr_t)i * elemSize;
-                    int32_t serial = ReadAt<int32_t>(elemAddr, 0);
-
-                    if (serial > 0) {
-                        outHandles[count].Index = i;
-                        outHandles[count].SerialNumber = serial;
-                        count++;
-                    }
-                }
-
-                LogMsg("  Extracted %d valid entity handles from %d slots", count, num);
-                return count;
-            }
-        }
+    // Nested saves are part of the outer one
+    if (g_saveDepth++ > 0) {
+        void* ret = call.Original(a, b, c, d);
+        g_saveDepth--;
+        return ret;
     }
 
-    LogMsg("  WARNING: Could not find entity array in UMassEntitySubsystem");
-    return 0;
-}
-
-static void __attribute__((ms_abi)) Detour_OnPostSaveLoaded(void* thisPtr) {
-    LogMsg(">>> OnPostSaveLoaded hook entered (this=0x%llX)",
-           (unsigned long long)(uintptr_t)thisPtr);
-
-    // Call original first — let the save system finish its work
-    auto origFn = (OnPostSaveLoadedFn)g_postSaveHook.trampoline;
-    origFn(thisPtr);
+    if (++g_saveSeq == 0) g_saveSeq = 1;
+    g_gameThread.store(GetCurrentThreadId(), std::memory_order_relaxed);
+    g_saveLast.store(g_saveSeq, std::memory_order_release);
+    g_saveActive.store(g_saveSeq, std::memory_order_release);
 
-    LogMsg("  Original OnPostSaveLoaded returned");
-
-    // Re-discover subsystem if needed (it may not exist at patch time)
-    if (!g_signalSubsystem) {
-        FindSignalSubsystem();
+    bool namesReady = NamesReady();
+    if (SidecarActive() && namesReady) {
+        EntityArray entities = {};
+        if (FindSocketEntityStore(g_objArrayBase, g_scan.fnNameToString, g_targets, entities))
+            SidecarCapture(g_saveSeq, entities, g_targets.socketsFragment,
+                           g_targets.connectionData);
+        else
+            LogMsg("  Sidecar: entity store not found — no sidecar for this save");
     }
 
-    // Retry signal name discovery if it failed at init
-    if (!g_signalReady) {
-        if (DiscoverSignalName()) {
-            g_signalReady = true;
-        } else {
-            g_socketSignalName = FindFNameByString(g_iniSignalName);
-            if (g_socketSignalName.ComparisonIndex != 0)
-                g_signalReady = true;
-        }
+    int64_t saveStart = PlatTicks();
+    SaveStatsBegin();
+    void* ret;
+    {
+        TRACE_SPAN("MassSave (original)");
+        ret = call.Original(a, b, c, d);
     }
+    g_saveActive.store(0, std::memory_order_release);
 
-    if (!g_signalReady || !g_signalSubsystem || !g_scan.fnSignalEntity) {
-        LogMsg("  Signal system not ready (ready=%d, subsys=%p, fn=%p) — skipping",
-               g_signalReady, g_signalSubsystem, (void*)g_scan.fnSignalEntity);
-        return;
-    }
+    SocketShare share;
+    int64_t t0 = PlatTicks();
+    bool measured = namesReady &&
+                    MeasureSocketShare(g_objArrayBase, g_scan.fnNameToString, g_targets, share);
+    int64_t t1 = PlatTicks();
+    SaveStatsEnd(measured ? &share : nullptr, t1 - t0);
 
-    // Find UMassEntitySubsystem to iterate entity handles
-    uintptr_t entitySubsystem = FindObjectByClassName("MassEntitySubsystem");
-    if (!entitySubsystem) {
-        LogMsg("  WARNING: MassEntitySubsystem not found — cannot signal entities");
-        return;
+    if (MetricsData* m = MetricsBeginWrite()) {
+        m->saves++;
+        m->lastSaveMicros = Micros(t0 - saveStart);
+        PublishHooks(*m);
+        MetricsEndWrite();
     }
 
-    // Read valid entity handles from the entity manager
-    constexpr int HANDLE_BUF_SIZE = 100000;
-    FMassEntityHandle* handles = (FMassEntityHandle*)VirtualAlloc(
-        nullptr, HANDLE_BUF_SIZE * sizeof(FMassEntityHandle),
-        MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-
-    if (!handles) {
-        LogMsg("  ERROR: Failed to allocate handle buffer");
-        return;
+    // The entities signalled at the last load have been rebuilt by now
+    if (g_iniRailGraph && namesReady) {
+        RailGraphStats graph;
+        RunDeferredRailGraph(RebuildEnvNow(), g_targets, graph);
     }
 
-    int handleCount = ReadEntityHandles(entitySubsystem, handles, HANDLE_BUF_SIZE);
-
-    if (handleCount > 0) {
-        LogMsg("  Signaling %d entities with socket signal (CompIdx=0x%X)...",
-               handleCount, g_socketSignalName.ComparisonIndex);
+    g_saveDepth--;
+    return ret;
+}
 
-        for (int i = 0; i < handleCount; ++i) {
-            g_scan.fnSignalEntity(g_signalSubsystem, g_socketSignalName, handles[i]);
+static bool __attribute__((ms_abi)) Detour_SaveDataToSlot(const void* data, const void* slotName,
+                                                           int32_t userIndex) {
+    SaveDataHook::Call call(g_saveDataHook);
+    int32_t bytes = data ? ReadAt<int32_t>((uintptr_t)data, TArrayOff::Num) : 0;
+    if (data) SaveStatsAddBytes(bytes);
+
+    // Decided before the write, which may outlast the MassSave
+    uint32_t saveId = g_saveActive.load(std::memory_order_acquire);
+    if (!saveId && GetCurrentThreadId() != g_gameThread.load(std::memory_order_relaxed))
+        saveId = g_saveLast.load(std::memory_order_acquire);
+
+    bool ok = call.Original(data, slotName, userIndex);
+
+    char slot[128];
+    if (ok && saveId && SidecarActive() && ReadSlotName(slotName, slot, sizeof(slot))) {
+        if (SidecarSnapshot* snapshot = SidecarTake(saveId)) {
+            const uint8_t* bytesData = ReadAt<const uint8_t*>((uintptr_t)data, TArrayOff::Data);
+            char path[MAX_PATH];
+            SidecarPath(slot, path, sizeof(path));
+            SidecarWrite(snapshot, path, bytes, SidecarSaveSample(bytesData, bytes));
         }
-
-        LogMsg("  Socket signal sent to %d entities", handleCount);
-    } else {
-        LogMsg("  No entity handles found — signal skipped");
     }
+    return ok;
+}
 
-    VirtualFree(handles, 0, MEM_RELEASE);
+static bool __attribute__((ms_abi)) Detour_LoadDataFromSlot(void* outData, const void* slotName,
+                                                             int32_t userIndex) {
+    LoadDataHook::Call call(g_loadDataHook);
+    bool ok = call.Original(outData, slotName, userIndex);
 
-    LogMsg("<<< OnPostSaveLoaded hook complete");
+    // A save read replaces the world's entities, whatever the subsystem address
+    if (ok) g_savesRead.fetch_add(1, std::memory_order_release);
+
+    if (ok && outData && SidecarActive() &&
+        ReadSlotName(slotName, g_loadedSave.slot, sizeof(g_loadedSave.slot))) {
+        int32_t bytes = ReadAt<int32_t>((uintptr_t)outData, TArrayOff::Num);
+        g_loadedSave.bytes  = bytes;
+        g_loadedSave.sample = SidecarSaveSample(
+            ReadAt<const uint8_t*>((uintptr_t)outData, TArrayOff::Data), bytes);
+    }
+    return ok;
 }
 
 // ===================================================================
-// ApplyPatch — main logic
+// ApplyPatch — init pipeline
+//
+// v1: patch the hierarchy chain so the save system includes socket data
+// v2: hook OnPostSaveLoaded to signal entities after load
+//
+//   symbols ──┬── objects ──┬── hierarchy ───┬── compact   (v1; compact opt-in)
+//             │             └── signal-name  │             (v2)
+//             ├── hook-install ──────────────┘             (v2)
+//             └── save-hooks ── sidecar                    (save stats, ledger reset;
+//                                                           sidecar opt-in, also
+//                                                           needs hook-install)
+//
+//   names-ready runs once objects, hierarchy, signal-name and compact have
+//   finished, whether or not they succeeded.
 //
-// Phase 1 (v1): Patch hierarchy chain so save system includes socket data
-// Phase 2 (v2): Hook OnPostSaveLoaded to signal entities after load
+// The hooks only need resolved symbols, so they go in while the object
+// array is still being polled.  The name stages keep filling g_targets,
+// g_signal and the resolver caches on the patch thread meanwhile (each
+// thread resolves names into its own FString); the detours touch those
+// only once names-ready has published g_namesReady, and re-resolve then
+// anything that was not found.
 // ===================================================================
 
-bool ApplyPatch() {
-    // ---- Step 1: Scan for engine symbols ----
+enum InitStage {
+    INIT_SYMBOLS,
+    INIT_OBJECTS,
+    INIT_HIERARCHY,
+    INIT_SIGNAL,
+    INIT_HOOK,
+    INIT_SAVE_HOOKS,
+    INIT_COMPACT,
+    INIT_NAMES_READY,
+    INIT_SIDECAR,
+    INIT_STAGE_COUNT
+};
+
+static bool g_v2Possible = false;
+
+static StageResult Stage_Symbols() {
     if (!ScanForEngineSymbols(g_scan)) {
-        return false;
+        return STAGE_FAIL;
     }
 
     g_objArrayBase = g_scan.guObjectArray + GUObjOff::ObjObjects;
 
-    // ---- Step 2: Validate v2 hook addresses ----
+    if (MetricsData* m = MetricsBeginWrite()) {
+        m->symbols = g_scan.fromIni ? METRICS_SYMBOLS_INI : METRICS_SYMBOLS_AOB;
+        MetricsEndWrite();
+    }
+
+    // Validate v2 hook addresses
     if (!g_scan.fnOnPostSaveLoaded) {
         LogMsg("WARNING: OnPostSaveLoaded_RVA not configured — v2 signal hook disabled");
         LogMsg("Add to socket_save_fix.ini:");
@@ -685,135 +547,153 @@ bool ApplyPatch() {
         LogMsg("  SignalEntity_RVA=0x65F1BB0");
     }
 
-    bool v2Possible = g_scan.fnOnPostSaveLoaded && g_scan.fnSignalEntity;
+    g_v2Possible = g_scan.fnOnPostSaveLoaded && g_scan.fnSignalEntity;
 
-    // ---- Step 3: Read INI fallback signal name ----
-    if (v2Possible) {
-        ReadSignalNameFromINI();
+    // INI fallback signal name
+    if (g_v2Possible) {
+        ReadRebuildOptionsFromINI();
     }
 
-    // ---- Step 4: Poll for target UScriptStructs (v1 hierarchy patch) ----
     LogMsg("Polling for target UScriptStructs (100ms intervals, 120s timeout)...");
+    return STAGE_OK;
+}
 
-    TargetStructs targets = {};
-    DWORD startTime = GetTickCount();
-
-    for (int attempt = 0; attempt < 1200; ++attempt) {
-        int32_t numEl = ReadAt<int32_t>(g_objArrayBase, TObjOff::NumElements);
-
-        if (numEl > 0 && g_scan.fnNameToString) {
-            uintptr_t firstObj = GetObject(g_objArrayBase, 0);
-            if (firstObj) {
-                const wchar_t* ws = NameToString(g_scan.fnNameToString,
-                                                  firstObj + UObjOff::NamePrivate);
-                if (ws && ws[0] != L'\0') {
-                    if (FindTargets(g_objArrayBase, g_scan.fnNameToString, targets)) {
-                        DWORD elapsed = GetTickCount() - startTime;
-                        LogMsg("All targets found in %lu ms (attempt %d, %d objects)",
-                               elapsed, attempt, numEl);
-                        break;
-                    }
-                }
-            }
-        }
+// One poll of the object array for the target UScriptStructs
+static StageResult Stage_Objects() {
+    int32_t numEl = ReadAt<int32_t>(g_objArrayBase, TObjOff::NumElements);
+    if (numEl <= 0 || !g_scan.fnNameToString) return STAGE_RETRY;
 
-        if (attempt == 1199) {
-            DWORD elapsed = GetTickCount() - startTime;
-            LogMsg("ERROR: Timed out after %lu ms", elapsed);
-            LogMsg("  Objects: %d, ScriptStructClass: 0x%llX",
-                   ReadAt<int32_t>(g_objArrayBase, TObjOff::NumElements),
-                   (unsigned long long)targets.scriptStructClass);
-            LogMsg("  SocketsFragment: 0x%llX, SavableFragment: 0x%llX, MassFragment: 0x%llX",
-                   (unsigned long long)targets.socketsFragment,
-                   (unsigned long long)targets.savableFragment,
-                   (unsigned long long)targets.massFragment);
-            return false;
-        }
+    uintptr_t firstObj = GetObject(g_objArrayBase, 0);
+    if (!firstObj) return STAGE_RETRY;
 
-        Sleep(100);
-    }
+    const wchar_t* ws = NameToString(g_scan.fnNameToString, firstObj + UObjOff::NamePrivate);
+    if (!ws || ws[0] == L'\0') return STAGE_RETRY;
+
+    TargetStructs& targets = g_targets;
+    if (!FindTargets(g_objArrayBase, g_scan.fnNameToString, targets)) return STAGE_RETRY;
 
+    LogMsg("All targets found (%d objects)", numEl);
     LogMsg("  CrLogisticsSocketsFragment at 0x%llX", (unsigned long long)targets.socketsFragment);
     LogMsg("  CrMassSavableFragment      at 0x%llX", (unsigned long long)targets.savableFragment);
     LogMsg("  MassFragment               at 0x%llX", (unsigned long long)targets.massFragment);
+    LogMsg("  CrCustomConnectionData     at 0x%llX%s", (unsigned long long)targets.connectionData,
+           targets.connectionData ? "" : " (not found — socket verifier will only check socket arrays)");
+    return STAGE_OK;
+}
+
+static void Stage_ObjectsTimeout() {
+    const TargetStructs& targets = g_targets;
+    LogMsg("  Objects: %d, ScriptStructClass: 0x%llX",
+           ReadAt<int32_t>(g_objArrayBase, TObjOff::NumElements),
+           (unsigned long long)targets.scriptStructClass);
+    LogMsg("  SocketsFragment: 0x%llX, SavableFragment: 0x%llX, MassFragment: 0x%llX",
+           (unsigned long long)targets.socketsFragment,
+           (unsigned long long)targets.savableFragment,
+           (unsigned long long)targets.massFragment);
+}
+
+static StageResult Stage_Hierarchy() {
+    const TargetStructs& targets = g_targets;
 
-    // ---- Step 5: Pre-patch diagnostics ----
+    // Pre-patch diagnostics
     LogMsg("=== Pre-patch diagnostics ===");
     DumpStructInfo(g_scan.fnNameToString, "CrLogisticsSocketsFragment", targets.socketsFragment);
     DumpStructInfo(g_scan.fnNameToString, "CrMassSavableFragment", targets.savableFragment);
 
-    // ---- Step 6: Check if hierarchy patch already applied ----
+    // Sanity-check the sockets fragment's current parent
     uintptr_t currentSuper = ReadAt<uintptr_t>(targets.socketsFragment, UStructOff::SuperStruct);
     char nameBuf[256];
 
-    if (currentSuper == targets.savableFragment) {
-        LogMsg("SuperStruct already points to CrMassSavableFragment — hierarchy patch already applied!");
-    } else {
-        if (currentSuper != targets.massFragment) {
-            if (currentSuper) {
-                const wchar_t* ws = NameToString(g_scan.fnNameToString,
-                                                  currentSuper + UObjOff::NamePrivate);
-                WideToNarrow(ws, nameBuf, sizeof(nameBuf));
-            } else {
-                strcpy(nameBuf, "(null)");
-            }
-            LogMsg("WARNING: Unexpected SuperStruct: 0x%llX (%s)",
-                   (unsigned long long)currentSuper, nameBuf);
+    if (currentSuper != targets.massFragment && currentSuper != targets.savableFragment) {
+        if (currentSuper) {
+            const wchar_t* ws = NameToString(g_scan.fnNameToString,
+                                              currentSuper + UObjOff::NamePrivate);
+            WideToNarrow(ws, nameBuf, sizeof(nameBuf));
+        } else {
+            strcpy(nameBuf, "(null)");
         }
+        LogMsg("WARNING: Unexpected SuperStruct: 0x%llX (%s)",
+               (unsigned long long)currentSuper, nameBuf);
+    }
 
-        // ---- Step 7: Apply hierarchy chain patch (v1) ----
-        LogMsg("=== Applying hierarchy chain patch (v1) ===");
+    // Apply hierarchy chain patches (v1).  Entries already in effect
+    // (e.g. DLL loaded twice) are skipped.
+    LogMsg("=== Applying hierarchy chain patch (v1) ===");
 
-        if (!PatchHierarchyChain(targets.socketsFragment, targets.savableFragment)) {
-            LogMsg("ERROR: Hierarchy chain patch failed");
-            return false;
-        }
+    if (!HierarchyApply(g_objArrayBase, targets.scriptStructClass, g_scan.fnNameToString,
+                        g_hierarchyPatches,
+                        (int)(sizeof(g_hierarchyPatches) / sizeof(g_hierarchyPatches[0])))) {
+        LogMsg("ERROR: Hierarchy chain patch failed");
+        return STAGE_FAIL;
+    }
 
-        // Verify
-        uintptr_t newSuper = ReadAt<uintptr_t>(targets.socketsFragment, UStructOff::SuperStruct);
-        if (newSuper != targets.savableFragment) {
-            LogMsg("ERROR: SuperStruct verification failed");
-            return false;
-        }
+    // Verify
+    uintptr_t newSuper = ReadAt<uintptr_t>(targets.socketsFragment, UStructOff::SuperStruct);
+    if (newSuper != targets.savableFragment) {
+        LogMsg("ERROR: SuperStruct verification failed");
+        return STAGE_FAIL;
+    }
 
-        const wchar_t* ws = NameToString(g_scan.fnNameToString, newSuper + UObjOff::NamePrivate);
-        WideToNarrow(ws, nameBuf, sizeof(nameBuf));
-        LogMsg("VERIFIED: SuperStruct now -> %s (0x%llX)", nameBuf, (unsigned long long)newSuper);
+    const wchar_t* ws = NameToString(g_scan.fnNameToString, newSuper + UObjOff::NamePrivate);
+    WideToNarrow(ws, nameBuf, sizeof(nameBuf));
+    LogMsg("VERIFIED: SuperStruct now -> %s (0x%llX)", nameBuf, (unsigned long long)newSuper);
 
-        LogMsg("=== Post-patch diagnostics ===");
-        DumpStructInfo(g_scan.fnNameToString, "CrLogisticsSocketsFragment", targets.socketsFragment);
-    }
+    LogMsg("=== Post-patch diagnostics ===");
+    DumpStructInfo(g_scan.fnNameToString, "CrLogisticsSocketsFragment", targets.socketsFragment);
+    return STAGE_OK;
+}
+
+static void PropertyCachePath(char* path, size_t pathSize) {
+    snprintf(path, pathSize, "%s\\property_cache.bin", g_modDir);
+}
+
+// Signal name + UMassSignalSubsystem.  Never fails: whatever is missing
+// is retried at hook time.  The signal property's offset comes from the
+// property cache of this game build when there is one.
+static StageResult Stage_Signal() {
+    if (!g_v2Possible) return STAGE_SKIP;
+
+    char path[MAX_PATH];
+    PropertyCachePath(path, sizeof(path));
+    if (g_iniPropertyCache) PropCacheLoad(path, g_scan.buildId);
+    else                    PropCacheReset(g_scan.buildId);
+
+    ResolveSignal(RebuildEnvNow(), g_signal);
+
+    if (g_iniPropertyCache) PropCacheSave(path);
+    return STAGE_OK;
+}
 
-    // ---- Step 8: Install OnPostSaveLoaded hook (v2) ----
-    if (!v2Possible) {
-        LogMsg("v2 signal hook skipped (missing RVAs). Hierarchy patch (v1) applied.");
-        DWORD totalElapsed = GetTickCount() - startTime;
-        LogMsg("Total setup time: %lu ms", totalElapsed);
-        return true;
+// Compact saves drop socket state only the post-load rebuild can restore,
+// so this runs only once the OnPostSaveLoaded hook is in.
+static StageResult Stage_Compact() {
+    if (!g_iniCompact) return STAGE_SKIP;
+
+    LogMsg("=== Enabling compact socket saves ===");
+    if (!CompactApply(g_objArrayBase, g_targets.scriptStructClass, g_scan.fnNameToString,
+                      g_compactPatches,
+                      (int)(sizeof(g_compactPatches) / sizeof(g_compactPatches[0])))) {
+        LogMsg("ERROR: Compact socket saves not (fully) enabled — saves stay complete");
+        CompactRestore();
+        return STAGE_FAIL;
     }
+    return STAGE_OK;
+}
 
-    LogMsg("=== Installing OnPostSaveLoaded hook (v2) ===");
+// Ends the window in which only the patch thread resolves names.  Runs
+// once every name stage has finished, whether or not it succeeded.
+static StageResult Stage_NamesReady() {
+    g_namesReady.store(true, std::memory_order_release);
+    return STAGE_OK;
+}
 
-    // Discover signal name from CDO
-    LogMsg("Discovering signal name from CrLogisticsSocketsSignalProcessor CDO...");
-    if (DiscoverSignalName()) {
-        g_signalReady = true;
-        LogMsg("Signal name discovered from CDO");
-    } else {
-        LogMsg("Falling back to INI signal name: %s", g_iniSignalName);
-        g_socketSignalName = FindFNameByString(g_iniSignalName);
-        if (g_socketSignalName.ComparisonIndex != 0) {
-            g_signalReady = true;
-            LogMsg("Resolved INI signal name: CompIdx=0x%X",
-                   g_socketSignalName.ComparisonIndex);
-        } else {
-            LogMsg("WARNING: Could not resolve signal name '%s' — will retry at hook time",
-                   g_iniSignalName);
-        }
+static StageResult Stage_Hook() {
+    if (!g_v2Possible) {
+        LogMsg("v2 signal hook skipped (missing RVAs)");
+        return STAGE_SKIP;
     }
 
-    // Find UMassSignalSubsystem
-    FindSignalSubsystem();  // OK if not found yet — will retry in hook
+    LogMsg("=== Installing OnPostSaveLoaded hook (v2) ===");
 
     // Verify OnPostSaveLoaded prologue
     LogMsg("Verifying OnPostSaveLoaded prologue at 0x%llX...",
@@ -834,30 +714,125 @@ bool ApplyPatch() {
         LogMsg("  Got:      %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X",
                prologue[0], prologue[1], prologue[2], prologue[3], prologue[4],
                prologue[5], prologue[6], prologue[7], prologue[8], prologue[9]);
-        LogMsg("v2 hook skipped — hierarchy patch (v1) is still active");
-        DWORD totalElapsed = GetTickCount() - startTime;
-        LogMsg("Total setup time: %lu ms", totalElapsed);
-        return true;  // v1 patch still applied, partial success
+        LogMsg("v2 hook skipped — hierarchy patch (v1) is unaffected");
+        return STAGE_FAIL;
     }
     LogMsg("  Prologue verified: push rbx; sub rsp,20h; mov rbx,rcx; call rel32");
 
-    // Install the hook (steal 14 bytes)
-    if (!InstallHook(g_postSaveHook, g_scan.fnOnPostSaveLoaded,
-                     (void*)Detour_OnPostSaveLoaded, 14)) {
+    // Install the hook (stolen length decoded by the hook layer — 6 bytes here)
+    if (!g_postSaveHook.Install(g_scan.fnOnPostSaveLoaded, Detour_OnPostSaveLoaded)) {
         LogMsg("ERROR: Failed to install OnPostSaveLoaded hook");
-        LogMsg("v2 hook failed — hierarchy patch (v1) is still active");
-        DWORD totalElapsed = GetTickCount() - startTime;
-        LogMsg("Total setup time: %lu ms", totalElapsed);
-        return true;  // v1 patch still applied, partial success
+        LogMsg("v2 hook failed — hierarchy patch (v1) is unaffected");
+        return STAGE_FAIL;
     }
 
     LogMsg("OnPostSaveLoaded hook installed successfully");
+    return STAGE_OK;
+}
+
+// Save stats and the signal ledger's reset: each hook goes in if its RVA
+// is configured.  Without LoadDataFromSlot the ledger stays off, and
+// every load signals everything it finds broken.
+static StageResult Stage_SaveHooks() {
+    if (!g_scan.fnLoadDataFromSlot)
+        LogMsg("Signal ledger off (LoadDataFromSlot_RVA not configured)");
+    if (!g_scan.fnMassSave && !g_scan.fnSaveDataToSlot && !g_scan.fnLoadDataFromSlot) {
+        LogMsg("Save stats off (MassSave_RVA / SaveDataToSlot_RVA not configured)");
+        return STAGE_SKIP;
+    }
+
+    LogMsg("=== Installing save/load hooks ===");
+    if (g_scan.fnLoadDataFromSlot &&
+        !g_loadDataHook.Install(g_scan.fnLoadDataFromSlot, Detour_LoadDataFromSlot)) {
+        LogMsg("ERROR: Failed to install LoadDataFromSlot hook — signal ledger off");
+        return STAGE_FAIL;
+    }
+    if (g_scan.fnMassSave && !g_massSaveHook.Install(g_scan.fnMassSave, Detour_MassSave)) {
+        LogMsg("ERROR: Failed to install MassSave hook");
+        return STAGE_FAIL;
+    }
+    if (g_scan.fnSaveDataToSlot &&
+        !g_saveDataHook.Install(g_scan.fnSaveDataToSlot, Detour_SaveDataToSlot)) {
+        LogMsg("ERROR: Failed to install SaveDataToSlot hook");
+        return STAGE_FAIL;
+    }
+
+    LogMsg("Save/load hooks installed (%s%s%s)",
+           g_massSaveHook.Installed() ? "MassSave " : "",
+           g_saveDataHook.Installed() ? "SaveDataToSlot " : "",
+           g_loadDataHook.Installed() ? "LoadDataFromSlot" : "");
+    return STAGE_OK;
+}
+
+// The sidecar is written from the save hooks and applied by the
+// post-load detour, so it needs both, and LoadDataFromSlot to know which
+// save a load read.
+static StageResult Stage_Sidecar() {
+    if (!g_iniSidecar) return STAGE_SKIP;
+
+    if (!g_massSaveHook.Installed() || !g_saveDataHook.Installed() ||
+        !g_loadDataHook.Installed()) {
+        LogMsg("ERROR: SocketSidecar needs MassSave_RVA, SaveDataToSlot_RVA and "
+               "LoadDataFromSlot_RVA — sidecar off");
+        return STAGE_FAIL;
+    }
+
+    g_sidecarOn = true;
+    LogMsg("Socket sidecar on (%s\\sidecars)", g_modDir);
+    return STAGE_OK;
+}
+
+static constexpr uint32_t COMPACT_DEPS = StageBit(INIT_HIERARCHY) | StageBit(INIT_HOOK);
+static constexpr uint32_t NAME_STAGES  = StageBit(INIT_OBJECTS) | StageBit(INIT_HIERARCHY) |
+                                        StageBit(INIT_SIGNAL) | StageBit(INIT_COMPACT);
+static constexpr uint32_t SIDECAR_DEPS = StageBit(INIT_SAVE_HOOKS) | StageBit(INIT_HOOK);
+
+static Stage g_initStages[INIT_STAGE_COUNT] = {
+    // name            attempt           onTimeout              deps                      after        timeout  retry  required
+    { "symbols",       Stage_Symbols,    nullptr,               0,                        0,           0,       0,     true  },
+    { "objects",       Stage_Objects,    Stage_ObjectsTimeout,  StageBit(INIT_SYMBOLS),   0,           120000,  100,   true  },
+    { "hierarchy",     Stage_Hierarchy,  nullptr,               StageBit(INIT_OBJECTS),   0,           0,       0,     true  },
+    { "signal-name",   Stage_Signal,     nullptr,               StageBit(INIT_OBJECTS),   0,           0,       0,     false },
+    { "hook-install",  Stage_Hook,       nullptr,               StageBit(INIT_SYMBOLS),   0,           0,       0,     false },
+    { "save-hooks",    Stage_SaveHooks,  nullptr,               StageBit(INIT_SYMBOLS),   0,           0,       0,     false },
+    { "compact",       Stage_Compact,    nullptr,               COMPACT_DEPS,             0,           0,       0,     false },
+    { "names-ready",   Stage_NamesReady, nullptr,               0,                        NAME_STAGES, 0,       0,     false },
+    { "sidecar",       Stage_Sidecar,    nullptr,               SIDECAR_DEPS,             0,           0,       0,     false },
+};
+
+// Mod-owned read/write memory per subsystem, then the executable slots
+// and the engine-allocated name buffer
+static void ReportMemory() {
+    MemReport();
+
+    size_t nearReserved, nearInUse;
+    NearGetStats(nearReserved, nearInUse);
+    LogMsg("  near-code  %9.1f KB reserved, %.1f KB in slots; FName buffer (engine) %zu B",
+           (double)nearReserved / 1024.0, (double)nearInUse / 1024.0, NameBufferBytes());
+}
+
+bool ApplyPatch(void* cancelEvent) {
+    int64_t start = PlatTicks();
+    OpenMetrics();
+
+    bool ok = PipelineRun(g_initStages, INIT_STAGE_COUNT, cancelEvent);
+    ReportMemory();
+
+    if (MetricsData* m = MetricsBeginWrite()) {
+        m->init        = ok ? METRICS_INIT_DONE : METRICS_INIT_FAILED;
+        m->setupMicros = Micros(PlatTicks() - start);
+        for (const Stage& st : g_initStages)
+            if (st.state == STAGE_FAILED || st.state == STAGE_TIMED_OUT) m->errors++;
+        PublishHooks(*m);
+        MetricsEndWrite();
+    }
 
-    DWORD totalElapsed = GetTickCount() - startTime;
-    LogMsg("Total setup time: %lu ms", totalElapsed);
-    LogMsg("=== v1 (hierarchy patch) + v2 (signal hook) both active ===");
+    if (ok && g_initStages[INIT_HOOK].state == STAGE_DONE)
+        LogMsg("=== v1 (hierarchy patch) + v2 (signal hook) both active ===");
+    else if (ok)
+        LogMsg("v2 signal hook not active — hierarchy patch (v1) applied");
 
-    return true;
+    return ok;
 }
 
 // ===================================================================
@@ -865,30 +840,37 @@ bool ApplyPatch() {
 // ===================================================================
 
 void CleanupPatch() {
-    // Restore inline hook
-    if (g_postSaveHook.installed) {
-        RemoveHook(g_postSaveHook);
-    }
-
-    // Restore original hierarchy chain
-    if (g_socketsStruct != 0 && g_origChain != nullptr) {
-        DWORD oldProtect;
-        uintptr_t patchStart = g_socketsStruct + UStructOff::InheritanceChain;
-        if (VirtualProtect((void*)patchStart, 0x18, PAGE_READWRITE, &oldProtect)) {
-            WriteAt<uintptr_t*>(g_socketsStruct, UStructOff::InheritanceChain, g_origChain);
-            WriteAt<int32_t>   (g_socketsStruct, UStructOff::HierarchyDepth,   g_origDepth);
-            WriteAt<uintptr_t> (g_socketsStruct, UStructOff::SuperStruct,      g_origSuperStruct);
-            VirtualProtect((void*)patchStart, 0x18, oldProtect, &oldProtect);
-        }
-
-        g_socketsStruct   = 0;
-        g_origChain       = nullptr;
-        g_origDepth       = 0;
-        g_origSuperStruct = 0;
-    }
-
-    if (g_newChain) {
-        VirtualFree(g_newChain, 0, MEM_RELEASE);
-        g_newChain = nullptr;
-    }
+    // Final save and per-hook stats, then restore inline hooks (reverse
+    // install order)
+    SaveStatsDumpSummary();
+    HookDumpAllStats();
+    if (MetricsData* m = MetricsBeginWrite()) {
+        m->init = METRICS_INIT_UNLOADED;
+        PublishHooks(*m);
+        MetricsEndWrite();
+    }
+    HookRemoveAll();
+    NearReleaseUnused();
+
+    // Restore original property flags and hierarchy chains
+    CompactRestore();
+    HierarchyRestore();
+
+    // No detour can probe, signal or capture any more
+    ProbeShutdown();
+    SignalLedgerFree(g_ledger);
+    SidecarDiscard();
+
+    // Offsets first resolved by a load-time retry
+    if (g_v2Possible && g_iniPropertyCache) {
+        char path[MAX_PATH];
+        PropertyCachePath(path, sizeof(path));
+        PropCacheSave(path);
+    }
+
+    // Final footprint, then everything but the log and trace buffers,
+    // which stay in use until LogShutdown
+    ReportMemory();
+    MemReleaseAll(MemTagBit(MEM_LOG) | MemTagBit(MEM_TRACE));
+    MetricsClose();
 }
@@ -1,10 +1,14 @@
 #pragma once
 
-// Install an inline hook on UCrMassSaveSubsystem::OnPostSaveLoaded.
-// When save data is loaded, the hook triggers socket re-initialization
-// via UMassSignalSubsystem::SignalEntity to rebuild logistics socket
-// connections that were lost during save/load.
-bool ApplyPatch();
+// Patch the hierarchy chain and install an inline hook on
+// UCrMassSaveSubsystem::OnPostSaveLoaded.  When save data is loaded, the
+// hook triggers socket re-initialization via UMassSignalSubsystem::
+// SignalEntity to rebuild logistics socket connections that were lost
+// during save/load.
+//
+// Runs as a staged pipeline; setting cancelEvent (a Win32 event handle)
+// stops it within one stage attempt.
+bool ApplyPatch(void* cancelEvent);
 
 // Remove hooks and free trampoline memory.
 // Called on DLL_PROCESS_DETACH for clean unload.
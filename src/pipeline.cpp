@@ -0,0 +1,161 @@
+#include "pipeline.h"
+#include "log.h"
+#include "trace.h"
+#include <windows.h>
+
+static const char* StateName(StageState s) {
+    switch (s) {
+        case STAGE_PENDING:   return "pending";
+        case STAGE_DONE:      return "done";
+        case STAGE_FAILED:    return "FAILED";
+        case STAGE_SKIPPED:   return "skipped";
+        case STAGE_TIMED_OUT: return "TIMED OUT";
+        case STAGE_CANCELLED: return "cancelled";
+    }
+    return "?";
+}
+
+// ===================================================================
+// Scheduler
+// ===================================================================
+
+static bool DepsFinished(const Stage* stages, int count, const Stage& s, bool& anyFailed) {
+    anyFailed = false;
+    bool all = true;
+    for (int d = 0; d < count; ++d) {
+        if (!((s.deps | s.after) & StageBit(d))) continue;
+        if (stages[d].state == STAGE_PENDING) all = false;
+        else if (stages[d].state != STAGE_DONE && (s.deps & StageBit(d))) anyFailed = true;
+    }
+    return all;
+}
+
+static void RunAttempt(Stage& s, DWORD t0) {
+    DWORD now = GetTickCount() - t0;
+    if (s.attempts == 0) s.startMs = now;
+    s.attempts++;
+
+    StageResult r;
+    {
+        TRACE_SPAN(s.name);
+        r = s.attempt();
+    }
+    now = GetTickCount() - t0;
+
+    switch (r) {
+        case STAGE_OK:   s.state = STAGE_DONE;    break;
+        case STAGE_FAIL: s.state = STAGE_FAILED;  break;
+        case STAGE_SKIP: s.state = STAGE_SKIPPED; break;
+        case STAGE_RETRY:
+            if (s.timeoutMs == 0 || now - s.startMs >= s.timeoutMs) {
+                s.state = STAGE_TIMED_OUT;
+                LogMsg("ERROR: Stage '%s' timed out after %lu ms (%d attempts)",
+                       s.name, (unsigned long)(now - s.startMs), s.attempts);
+                if (s.onTimeout) s.onTimeout();
+            } else {
+                s.nextAttemptMs = now + s.retryMs;
+            }
+            break;
+    }
+    if (s.state != STAGE_PENDING) s.endMs = now;
+}
+
+static void LogTimeline(const Stage* stages, int count, DWORD totalMs) {
+    LogMsg("=== Init timeline (%lu ms) ===", (unsigned long)totalMs);
+    for (int i = 0; i < count; ++i) {
+        const Stage& s = stages[i];
+        if (s.attempts == 0) {
+            LogMsg("  %-18s %-10s", s.name, StateName(s.state));
+            continue;
+        }
+        LogMsg("  %-18s %-10s +%5lu ms  %6lu ms  %d attempt(s)",
+               s.name, StateName(s.state), (unsigned long)s.startMs,
+               (unsigned long)(s.endMs - s.startMs), s.attempts);
+    }
+}
+
+bool PipelineRun(Stage* stages, int count, void* cancelEvent) {
+    for (int i = 0; i < count; ++i) {
+        stages[i].state         = STAGE_PENDING;
+        stages[i].startMs       = 0;
+        stages[i].endMs         = 0;
+        stages[i].attempts      = 0;
+        stages[i].nextAttemptMs = 0;
+    }
+
+    const DWORD t0 = GetTickCount();
+    bool cancelled = false;
+
+    for (;;) {
+        if (cancelEvent && WaitForSingleObject((HANDLE)cancelEvent, 0) == WAIT_OBJECT_0) {
+            cancelled = true;
+            break;
+        }
+
+        bool anyPending = false;
+        bool ranAny     = false;
+        DWORD nextWake  = INFINITE;
+
+        for (int i = 0; i < count; ++i) {
+            Stage& s = stages[i];
+            if (s.state != STAGE_PENDING) continue;
+
+            bool depFailed;
+            if (!DepsFinished(stages, count, s, depFailed)) {
+                anyPending = true;
+                continue;
+            }
+            if (depFailed) {
+                s.state = STAGE_SKIPPED;
+                LogMsg("Stage '%s' skipped — a prerequisite did not finish", s.name);
+                ranAny = true;
+                continue;
+            }
+
+            DWORD now = GetTickCount() - t0;
+            if (s.attempts > 0 && now < s.nextAttemptMs) {
+                anyPending = true;
+                if (s.nextAttemptMs - now < nextWake) nextWake = s.nextAttemptMs - now;
+                continue;
+            }
+
+            RunAttempt(s, t0);
+            ranAny = true;
+            if (s.state == STAGE_PENDING) {
+                anyPending = true;
+                now = GetTickCount() - t0;
+                DWORD wait = (s.nextAttemptMs > now) ? s.nextAttemptMs - now : 0;
+                if (wait < nextWake) nextWake = wait;
+            }
+        }
+
+        if (!anyPending) break;
+        if (ranAny) continue;       // a stage finished — its dependents may be runnable now
+
+        if (cancelEvent) {
+            if (WaitForSingleObject((HANDLE)cancelEvent, nextWake) == WAIT_OBJECT_0) {
+                cancelled = true;
+                break;
+            }
+        } else {
+            Sleep(nextWake);
+        }
+    }
+
+    if (cancelled) {
+        LogMsg("Init pipeline cancelled");
+        DWORD now = GetTickCount() - t0;
+        for (int i = 0; i < count; ++i) {
+            if (stages[i].state != STAGE_PENDING) continue;
+            stages[i].state = STAGE_CANCELLED;
+            stages[i].endMs = now;
+        }
+    }
+
+    LogTimeline(stages, count, GetTickCount() - t0);
+
+    bool ok = true;
+    for (int i = 0; i < count; ++i)
+        if (stages[i].required && stages[i].state != STAGE_DONE) ok = false;
+    return ok;
+}
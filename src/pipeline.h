@@ -0,0 +1,56 @@
+#pragma once
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Init pipeline — a small dependency graph of stages run by one thread.
+//
+// Each stage makes short, non-blocking attempts: STAGE_RETRY means "inputs
+// not there yet, ask again in retryMs".  A stage becomes runnable as soon
+// as every stage in its 'deps' mask is done and every stage in its
+// 'after' mask has finished either way, so independent stages interleave
+// instead of queueing behind a long poll.  Between attempts
+// the runner waits on the cancel event rather than sleeping, so detach
+// stops it within one attempt.
+// ---------------------------------------------------------------------------
+
+enum StageResult {
+    STAGE_OK,
+    STAGE_RETRY,
+    STAGE_FAIL,
+    STAGE_SKIP,
+};
+
+enum StageState : uint8_t {
+    STAGE_PENDING,
+    STAGE_DONE,
+    STAGE_FAILED,
+    STAGE_SKIPPED,
+    STAGE_TIMED_OUT,
+    STAGE_CANCELLED,
+};
+
+constexpr uint32_t StageBit(int index) { return 1u << index; }
+
+struct Stage {
+    const char*   name;
+    StageResult (*attempt)();
+    void        (*onTimeout)();     // optional diagnostics
+    uint32_t      deps;             // StageBit() mask of prerequisite stages
+    uint32_t      after;            // stages that must have finished, in any state
+    uint32_t      timeoutMs;        // from first attempt; 0 = one attempt only
+    uint32_t      retryMs;
+    bool          required;         // pipeline fails if this stage does not finish
+
+    // Filled in by PipelineRun
+    StageState    state         = STAGE_PENDING;
+    uint32_t      startMs       = 0;    // offset of first attempt from pipeline start
+    uint32_t      endMs         = 0;
+    int           attempts      = 0;
+    uint32_t      nextAttemptMs = 0;
+};
+
+// Run every stage to completion, failure, timeout or cancellation and log
+// a timeline.  Stages whose prerequisites did not finish are skipped.
+// cancelEvent is a Win32 event handle (may be null).  Returns true if
+// every required stage is done.
+bool PipelineRun(Stage* stages, int count, void* cancelEvent);
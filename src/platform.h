@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Platform layer — the few OS services the object-walking modules
+// (uobject, probe, discovery, hierarchy, sockets, rebuild) need.  The DLL
+// links platform_win.cpp; the host simulator links platform_posix.cpp, so
+// the same patch logic runs against a synthetic object world on Linux.
+// Hooking, symbol scanning and the logger stay Windows-only.  The offline
+// tools (tools/) use the same layer for file mappings.
+// ---------------------------------------------------------------------------
+
+// Zeroed read/write pages.  Pass the same size back to PlatFree.
+void* PlatAlloc(size_t size);
+void  PlatFree(void* p, size_t size);
+
+// Address space only; PlatCommit makes [p, p+size) zeroed read/write
+// pages.  Release the whole reservation with PlatFree.
+void* PlatReserve(size_t size);
+bool  PlatCommit(void* p, size_t size);
+
+// Make [p, p+size) writable; 'saved' receives the protection PlatRelock
+// puts back.
+bool  PlatUnlock(void* p, size_t size, uint32_t& saved);
+void  PlatRelock(void* p, size_t size, uint32_t saved);
+
+// Make stores of this thread visible to every other thread of the process
+// before returning (a process-wide memory barrier).
+void  PlatFlushWriteBuffers();
+
+void  PlatSleep(uint32_t ms);
+
+// Map a whole file.  Writable mappings are shared, so stores go to the
+// file; PlatFlushMapping writes them back before returning.  Pages are
+// faulted in on demand, so a mapping costs address space, not memory.
+void* PlatMapFile(const char* path, bool writable, size_t& size);
+void  PlatUnmapFile(void* p, size_t size);
+bool  PlatFlushMapping(void* p, size_t size);
+
+// Named shared memory another process can map.  On Windows 'name' is a
+// kernel object in the session namespace (Local\<name>) and goes away
+// with the last view; on POSIX it is a file — a path, or /tmp/<name> for
+// a bare name — that stays behind for readers after the writer exits.
+// The create side comes back zeroed; the open side is read-only and fails
+// if the mapping is smaller than 'size'.  'handle' is what PlatCloseShared
+// needs besides the view.
+void*       PlatCreateShared(const char* name, size_t size, void*& handle);
+const void* PlatOpenShared(const char* name, size_t size, void*& handle);
+void        PlatCloseShared(const void* view, size_t size, void* handle);
+
+uint32_t PlatProcessId();
+
+// Report every committed, readable address range of the process in
+// ascending order (guard pages excluded).  Ranges may touch.
+using PlatRegionFn = void (*)(void* ctx, uintptr_t base, size_t size);
+void  PlatEnumReadableRegions(PlatRegionFn fn, void* ctx);
+
+// Monotonic high-resolution clock
+int64_t PlatTicks();
+int64_t PlatTicksPerSecond();
+
+// Aligned atomic stores for fields other threads read without locking
+inline void PlatStorePtr(void* addr, uintptr_t value) {
+    __atomic_store_n((uintptr_t*)addr, value, __ATOMIC_SEQ_CST);
+}
+
+inline void PlatStore32(void* addr, int32_t value) {
+    __atomic_store_n((int32_t*)addr, value, __ATOMIC_SEQ_CST);
+}
+
+inline void PlatStore64(void* addr, uint64_t value) {
+    __atomic_store_n((uint64_t*)addr, value, __ATOMIC_SEQ_CST);
+}
@@ -0,0 +1,166 @@
+#include "platform.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+void* PlatAlloc(size_t size) {
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return (p == MAP_FAILED) ? nullptr : p;
+}
+
+void PlatFree(void* p, size_t size) {
+    if (p) munmap(p, size);
+}
+
+void* PlatReserve(size_t size) {
+    void* p = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return (p == MAP_FAILED) ? nullptr : p;
+}
+
+bool PlatCommit(void* p, size_t size) {
+    return mprotect(p, size, PROT_READ | PROT_WRITE) == 0;
+}
+
+// mprotect works on whole pages and there is no call to read the current
+// protection back; everything the simulator builds is read/write, so
+// that is what gets restored.
+static void PageSpan(void* p, size_t size, void*& base, size_t& len) {
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t lo = (uintptr_t)p & ~(page - 1);
+    uintptr_t hi = ((uintptr_t)p + size + page - 1) & ~(page - 1);
+    base = (void*)lo;
+    len  = hi - lo;
+}
+
+bool PlatUnlock(void* p, size_t size, uint32_t& saved) {
+    void* base; size_t len;
+    PageSpan(p, size, base, len);
+    if (mprotect(base, len, PROT_READ | PROT_WRITE) != 0) return false;
+    saved = PROT_READ | PROT_WRITE;
+    return true;
+}
+
+void PlatRelock(void* p, size_t size, uint32_t saved) {
+    void* base; size_t len;
+    PageSpan(p, size, base, len);
+    mprotect(base, len, (int)saved);
+}
+
+// A local fence only; the grace-period sleep that follows every call in
+// hierarchy.cpp is what readers on other threads rely on here.
+void PlatFlushWriteBuffers() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void PlatSleep(uint32_t ms) {
+    struct timespec ts = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, nullptr);
+}
+
+void* PlatMapFile(const char* path, bool writable, size_t& size) {
+    int fd = open(path, writable ? O_RDWR : O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+    size = (size_t)st.st_size;
+
+    int prot = writable ? (PROT_READ | PROT_WRITE) : PROT_READ;
+    void* p = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return nullptr;
+
+    // Whole-file readers walk front to back
+    madvise(p, size, MADV_SEQUENTIAL);
+    return p;
+}
+
+void PlatUnmapFile(void* p, size_t size) {
+    if (p) munmap(p, size);
+}
+
+bool PlatFlushMapping(void* p, size_t size) {
+    return msync(p, size, MS_SYNC) == 0;
+}
+
+static void SharedPath(const char* name, char* out, size_t outSize) {
+    if (strchr(name, '/')) snprintf(out, outSize, "%s", name);
+    else                   snprintf(out, outSize, "/tmp/%s", name);
+}
+
+void* PlatCreateShared(const char* name, size_t size, void*& handle) {
+    char path[512];
+    SharedPath(name, path, sizeof(path));
+    handle = nullptr;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return nullptr;
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return (p == MAP_FAILED) ? nullptr : p;
+}
+
+const void* PlatOpenShared(const char* name, size_t size, void*& handle) {
+    char path[512];
+    SharedPath(name, path, sizeof(path));
+    handle = nullptr;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < size) {
+        close(fd);
+        return nullptr;
+    }
+    void* p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return (p == MAP_FAILED) ? nullptr : p;
+}
+
+void PlatCloseShared(const void* view, size_t size, void* /*handle*/) {
+    if (view) munmap((void*)view, size);
+}
+
+uint32_t PlatProcessId() {
+    return (uint32_t)getpid();
+}
+
+// /proc/self/maps is sorted by address.  [vvar] is listed readable but
+// parts of it fault on access, so it is left out.
+void PlatEnumReadableRegions(PlatRegionFn fn, void* ctx) {
+    FILE* f = fopen("/proc/self/maps", "r");
+    if (!f) return;
+
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long lo, hi;
+        char perms[8];
+        if (sscanf(line, "%lx-%lx %7s", &lo, &hi, perms) != 3) continue;
+        if (perms[0] != 'r' || strstr(line, "[vvar")) continue;
+        fn(ctx, (uintptr_t)lo, (size_t)(hi - lo));
+    }
+    fclose(f);
+}
+
+int64_t PlatTicks() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int64_t PlatTicksPerSecond() {
+    return 1000000000LL;
+}
@@ -0,0 +1,151 @@
+#include "platform.h"
+#include <windows.h>
+#include <cstdio>
+#include <cstring>
+
+void* PlatAlloc(size_t size) {
+    return VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+}
+
+void PlatFree(void* p, size_t /*size*/) {
+    if (p) VirtualFree(p, 0, MEM_RELEASE);
+}
+
+void* PlatReserve(size_t size) {
+    return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+bool PlatCommit(void* p, size_t size) {
+    return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+bool PlatUnlock(void* p, size_t size, uint32_t& saved) {
+    DWORD old;
+    if (!VirtualProtect(p, size, PAGE_READWRITE, &old)) return false;
+    saved = old;
+    return true;
+}
+
+void PlatRelock(void* p, size_t size, uint32_t saved) {
+    DWORD tmp;
+    VirtualProtect(p, size, saved, &tmp);
+}
+
+void PlatFlushWriteBuffers() {
+    FlushProcessWriteBuffers();
+}
+
+void PlatSleep(uint32_t ms) {
+    Sleep(ms);
+}
+
+void* PlatMapFile(const char* path, bool writable, size_t& size) {
+    HANDLE file = CreateFileA(path, writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+                              FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+    LARGE_INTEGER len;
+    if (!GetFileSizeEx(file, &len) || len.QuadPart <= 0) {
+        CloseHandle(file);
+        return nullptr;
+    }
+    size = (size_t)len.QuadPart;
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                        0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) return nullptr;
+
+    // The view keeps the mapping (and file) alive
+    void* p = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    return p;
+}
+
+void PlatUnmapFile(void* p, size_t /*size*/) {
+    if (p) UnmapViewOfFile(p);
+}
+
+bool PlatFlushMapping(void* p, size_t size) {
+    return FlushViewOfFile(p, size) != 0;
+}
+
+// Pagefile-backed; the handle keeps the name, the view the memory
+void* PlatCreateShared(const char* name, size_t size, void*& handle) {
+    char full[256];
+    snprintf(full, sizeof(full), "Local\\%s", name);
+    handle = nullptr;
+
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                        (DWORD)((uint64_t)size >> 32), (DWORD)size, full);
+    if (!mapping) return nullptr;
+
+    // Left behind by an earlier load of the DLL in this process
+    bool existed = GetLastError() == ERROR_ALREADY_EXISTS;
+
+    void* p = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (!p) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    if (existed) memset(p, 0, size);
+    handle = mapping;
+    return p;
+}
+
+const void* PlatOpenShared(const char* name, size_t size, void*& handle) {
+    char full[256];
+    snprintf(full, sizeof(full), "Local\\%s", name);
+    handle = nullptr;
+
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, full);
+    if (!mapping) return nullptr;
+
+    const void* p = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+    if (!p) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    handle = mapping;
+    return p;
+}
+
+void PlatCloseShared(const void* view, size_t /*size*/, void* handle) {
+    if (view)   UnmapViewOfFile(view);
+    if (handle) CloseHandle((HANDLE)handle);
+}
+
+uint32_t PlatProcessId() {
+    return (uint32_t)GetCurrentProcessId();
+}
+
+void PlatEnumReadableRegions(PlatRegionFn fn, void* ctx) {
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    const DWORD readable = PAGE_READONLY | PAGE_READWRITE | PAGE_WRITECOPY |
+                           PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+
+    uintptr_t addr = (uintptr_t)si.lpMinimumApplicationAddress;
+    uintptr_t end  = (uintptr_t)si.lpMaximumApplicationAddress;
+    while (addr < end) {
+        MEMORY_BASIC_INFORMATION mbi;
+        if (VirtualQuery((void*)addr, &mbi, sizeof(mbi)) == 0) break;
+
+        if (mbi.State == MEM_COMMIT && (mbi.Protect & readable) && !(mbi.Protect & PAGE_GUARD))
+            fn(ctx, (uintptr_t)mbi.BaseAddress, mbi.RegionSize);
+        addr = (uintptr_t)mbi.BaseAddress + mbi.RegionSize;
+    }
+}
+
+int64_t PlatTicks() {
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return t.QuadPart;
+}
+
+int64_t PlatTicksPerSecond() {
+    LARGE_INTEGER f;
+    QueryPerformanceFrequency(&f);
+    return f.QuadPart;
+}
@@ -0,0 +1,150 @@
+#include "probe.h"
+#include "log.h"
+#include "mem.h"
+#include "platform.h"
+#include "trace.h"
+#include <atomic>
+
+// ===================================================================
+// Region map
+// ===================================================================
+
+struct Region {
+    uintptr_t lo;
+    uintptr_t hi;           // exclusive
+};
+
+// One allocation: header, then 'count' regions sorted by address
+struct RegionMap {
+    size_t  bytes;
+    int     count;
+    Region  items[1];
+};
+
+static std::atomic<RegionMap*> g_map{nullptr};
+static RegionMap*              g_retired = nullptr;    // previous map, freed by the next rebuild
+static std::atomic<int64_t>    g_builtAt{0};
+static std::atomic_flag        g_rebuilding = ATOMIC_FLAG_INIT;
+
+static bool Contains(const RegionMap* map, uintptr_t addr, size_t size) {
+    uintptr_t end = addr + size;
+    if (end < addr) return false;
+
+    // Last region starting at or below addr
+    int lo = 0, hi = map->count - 1, found = -1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (map->items[mid].lo <= addr) { found = mid; lo = mid + 1; }
+        else                            { hi = mid - 1; }
+    }
+    return found >= 0 && end <= map->items[found].hi;
+}
+
+// ===================================================================
+// Rebuild
+// ===================================================================
+
+struct Builder {
+    Region* items;
+    int     count;
+    int     cap;
+    bool    outOfMemory;
+};
+
+static void AddRegion(void* p, uintptr_t base, size_t size) {
+    Builder& b = *(Builder*)p;
+    if (b.outOfMemory || size == 0) return;
+
+    // Touching ranges merge, so a read spanning two allocations still probes as one
+    if (b.count > 0 && b.items[b.count - 1].hi == base) {
+        b.items[b.count - 1].hi = base + size;
+        return;
+    }
+
+    if (b.count == b.cap) {
+        int cap = b.cap ? b.cap * 2 : 4096;
+        Region* grown = (Region*)MemAlloc(MEM_PROBE, (size_t)cap * sizeof(Region));
+        if (!grown) {
+            b.outOfMemory = true;
+            return;
+        }
+        if (b.items) {
+            memcpy(grown, b.items, (size_t)b.count * sizeof(Region));
+            MemFree(MEM_PROBE, b.items, (size_t)b.cap * sizeof(Region));
+        }
+        b.items = grown;
+        b.cap   = cap;
+    }
+    b.items[b.count++] = { base, base + size };
+}
+
+int ProbeRefresh() {
+    TRACE_SPAN("ProbeRefresh");
+
+    // A caller that waited for another rebuild uses that one
+    int64_t requested = PlatTicks();
+    while (g_rebuilding.test_and_set(std::memory_order_acquire)) PlatSleep(0);
+    RegionMap* current = g_map.load(std::memory_order_acquire);
+    if (current && g_builtAt.load(std::memory_order_relaxed) >= requested) {
+        g_rebuilding.clear(std::memory_order_release);
+        return current->count;
+    }
+
+    Builder b = {};
+    PlatEnumReadableRegions(AddRegion, &b);
+
+    RegionMap* map = nullptr;
+    if (!b.outOfMemory && b.count > 0) {
+        size_t bytes = sizeof(RegionMap) + (size_t)(b.count - 1) * sizeof(Region);
+        map = (RegionMap*)MemAlloc(MEM_PROBE, bytes);
+        if (map) {
+            map->bytes = bytes;
+            map->count = b.count;
+            memcpy(map->items, b.items, (size_t)b.count * sizeof(Region));
+        }
+    }
+    MemFree(MEM_PROBE, b.items, (size_t)b.cap * sizeof(Region));
+
+    int count = -1;
+    if (map) {
+        if (g_retired) MemFree(MEM_PROBE, g_retired, g_retired->bytes);
+        g_retired = g_map.exchange(map, std::memory_order_acq_rel);
+        g_builtAt.store(PlatTicks(), std::memory_order_relaxed);
+        count = map->count;
+        LogDebug("Probe: %d readable regions mapped", count);
+    } else {
+        LogMsg("WARNING: Probe: could not map readable regions");
+    }
+
+    g_rebuilding.clear(std::memory_order_release);
+    return count;
+}
+
+void ProbeShutdown() {
+    while (g_rebuilding.test_and_set(std::memory_order_acquire)) PlatSleep(0);
+    RegionMap* map = g_map.exchange(nullptr, std::memory_order_acq_rel);
+    if (map) MemFree(MEM_PROBE, map, map->bytes);
+    if (g_retired) MemFree(MEM_PROBE, g_retired, g_retired->bytes);
+    g_retired = nullptr;
+    g_builtAt.store(0, std::memory_order_relaxed);
+    g_rebuilding.clear(std::memory_order_release);
+}
+
+// ===================================================================
+// Lookup
+// ===================================================================
+
+bool ProbeReadable(uintptr_t addr, size_t size) {
+    if (addr == 0) return false;
+
+    RegionMap* map = g_map.load(std::memory_order_acquire);
+    if (map && Contains(map, addr, size)) return true;
+
+    // Miss: the range may have been committed since the last rebuild
+    int64_t age = PlatTicks() - g_builtAt.load(std::memory_order_relaxed);
+    if (map && age < PlatTicksPerSecond() * PROBE_REFRESH_MS / 1000) return false;
+    if (ProbeRefresh() < 0) return false;
+
+    map = g_map.load(std::memory_order_acquire);
+    return map && Contains(map, addr, size);
+}
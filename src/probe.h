@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// Memory probe — reads through pointers that are only guesses (a TArray
+// found by scanning a subsystem, an object array that may not be
+// populated yet) without risking an access violation.
+//
+// The readable ranges of the process are snapshotted into a sorted,
+// merged interval list; a probe is a binary search over it.  The list is
+// built on first use and rebuilt on a miss once it is older than
+// PROBE_REFRESH_MS, since the game commits and releases memory all the
+// time.  A rebuild walks the whole address space (VirtualQuery on
+// Windows), so misses in a loop cost one rebuild per interval, not one
+// per read.
+//
+// Lookups take no lock: a rebuild publishes a new list and frees the one
+// before the previous, so a reader is only at risk if a single lookup
+// stalls across two rebuilds (at least PROBE_REFRESH_MS apart).
+// ---------------------------------------------------------------------------
+
+constexpr uint32_t PROBE_REFRESH_MS = 100;
+
+// Whether [addr, addr+size) is committed and readable
+bool ProbeReadable(uintptr_t addr, size_t size);
+
+// Rebuild the region list now (e.g. after the game finished loading).
+// Returns the number of merged regions, or -1.
+int  ProbeRefresh();
+
+// Free the region lists (DLL unload)
+void ProbeShutdown();
+
+template<typename T>
+inline bool TryRead(uintptr_t base, size_t off, T& out) {
+    if (!ProbeReadable(base + off, sizeof(T))) return false;
+    memcpy(&out, (const void*)(base + off), sizeof(T));
+    return true;
+}
+
+// Copy [addr, addr+size) if all of it is readable
+inline bool TryReadRange(uintptr_t addr, void* out, size_t size) {
+    if (!ProbeReadable(addr, size)) return false;
+    memcpy(out, (const void*)addr, size);
+    return true;
+}
@@ -0,0 +1,196 @@
+#include "props.h"
+#include "log.h"
+#include "trace.h"
+#include "uobject.h"
+#include <cstdio>
+#include <cstring>
+
+static constexpr int MAX_STRUCT_PROPERTIES = 256;
+static constexpr int MAX_SUPER_DEPTH       = 16;
+
+static PropCacheEntry g_entries[PROPCACHE_MAX_ENTRIES] = {};
+static PropCacheStats g_stats   = {};
+static uint64_t       g_buildId = 0;
+static bool           g_dirty   = false;
+
+// ===================================================================
+// FField walk
+// ===================================================================
+
+static bool FieldIsType(FNameToStringFn fn, uintptr_t field, const char* type) {
+    uintptr_t fieldClass = ReadAt<uintptr_t>(field, FFieldOff::ClassPrivate);
+    return fieldClass && NameEqualsA(fn, fieldClass + FFieldClassOff::Name, type);
+}
+
+// ChildProperties lists only the struct's own properties, not inherited ones
+static uintptr_t FindOwnProperty(FNameToStringFn fn, uintptr_t ustruct,
+                                 const char* name, const char* type) {
+    uintptr_t field = ReadAt<uintptr_t>(ustruct, UStructOff::ChildProperties);
+    for (int i = 0; field && i < MAX_STRUCT_PROPERTIES; ++i) {
+        if ((!name || NameEqualsA(fn, field + FFieldOff::NamePrivate, name)) &&
+            (!type || FieldIsType(fn, field, type)))
+            return field;
+        field = ReadAt<uintptr_t>(field, FFieldOff::Next);
+    }
+    return 0;
+}
+
+uintptr_t FindPropertyField(FNameToStringFn fn, uintptr_t ustruct,
+                            const char* name, const char* type) {
+    if (!name) return type ? FindOwnProperty(fn, ustruct, nullptr, type) : 0;
+
+    for (int depth = 0; ustruct && depth < MAX_SUPER_DEPTH; ++depth) {
+        if (uintptr_t field = FindOwnProperty(fn, ustruct, name, type)) return field;
+        ustruct = ReadAt<uintptr_t>(ustruct, UStructOff::SuperStruct);
+    }
+    return 0;
+}
+
+// ===================================================================
+// Cache
+// ===================================================================
+
+void PropCacheReset(uint64_t buildId) {
+    memset(g_entries, 0, sizeof(g_entries));
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_buildId = buildId;
+    g_dirty   = false;
+}
+
+void PropCacheGetStats(PropCacheStats& out) {
+    out = g_stats;
+}
+
+static void EntryKey(const char* ownerName, const char* name, const char* type,
+                     char (&owner)[48], char (&property)[40]) {
+    memset(owner, 0, sizeof(owner));
+    memset(property, 0, sizeof(property));
+    snprintf(owner, sizeof(owner), "%s", ownerName);
+    if (name) snprintf(property, sizeof(property), "%s", name);
+    else      snprintf(property, sizeof(property), "<%s>", type ? type : "");
+}
+
+static const PropCacheEntry* Lookup(const char (&owner)[48], const char (&property)[40]) {
+    for (int i = 0; i < g_stats.entries; ++i)
+        if (strcmp(g_entries[i].owner, owner) == 0 && strcmp(g_entries[i].property, property) == 0)
+            return &g_entries[i];
+    return nullptr;
+}
+
+bool ResolveProperty(FNameToStringFn fn, uintptr_t ustruct, const char* ownerName,
+                     const char* name, const char* type, PropertyInfo& out)
+{
+    char owner[48], property[40];
+    EntryKey(ownerName, name, type, owner, property);
+
+    if (const PropCacheEntry* e = Lookup(owner, property)) {
+        g_stats.hits++;
+        out = { e->offset, e->size };
+        return true;
+    }
+    if (!ustruct) return false;
+
+    TRACE_SPAN("ResolveProperty: walk");
+    g_stats.walks++;
+
+    uintptr_t field = FindPropertyField(fn, ustruct, name, type);
+    if (!field) return false;
+
+    int32_t offset = ReadAt<int32_t>(field, FPropertyOff::OffsetInternal);
+    int32_t size   = ReadAt<int32_t>(field, FPropertyOff::ElementSize) *
+                     ReadAt<int32_t>(field, FPropertyOff::ArrayDim);
+    if (offset < 0 || size <= 0) return false;
+
+    out = { offset, size };
+    if (g_stats.entries < PROPCACHE_MAX_ENTRIES) {
+        PropCacheEntry& e = g_entries[g_stats.entries++];
+        memcpy(e.owner, owner, sizeof(owner));
+        memcpy(e.property, property, sizeof(property));
+        e.offset = offset;
+        e.size   = size;
+        g_dirty  = true;
+    }
+    return true;
+}
+
+// ===================================================================
+// File
+// ===================================================================
+
+static uint32_t Checksum(const void* data, size_t n) {
+    const uint8_t* p = (const uint8_t*)data;
+    uint32_t h = 0x811C9DC5u;
+    while (n--) h = (h ^ *p++) * 0x01000193u;
+    return h;
+}
+
+bool PropCacheLoad(const char* path, uint64_t buildId) {
+    PropCacheReset(buildId);
+
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+
+    PropCacheHeader h;
+    bool ok = fread(&h, sizeof(h), 1, f) == 1 &&
+              h.magic == PROPCACHE_MAGIC && h.version == PROPCACHE_VERSION &&
+              h.headerSize == sizeof(h) && h.entrySize == sizeof(PropCacheEntry) &&
+              h.entries <= (uint32_t)PROPCACHE_MAX_ENTRIES && h.buildId == buildId;
+    if (ok && h.entries > 0)
+        ok = fread(g_entries, sizeof(PropCacheEntry), h.entries, f) == h.entries &&
+             Checksum(g_entries, h.entries * sizeof(PropCacheEntry)) == h.checksum;
+    fclose(f);
+
+    if (!ok) {
+        PropCacheReset(buildId);
+        LogMsg("  Property cache %s: other game build or damaged — ignored", path);
+        return false;
+    }
+
+    // Names from the file are used as strings
+    for (uint32_t i = 0; i < h.entries; ++i) {
+        g_entries[i].owner[sizeof(g_entries[i].owner) - 1] = '\0';
+        g_entries[i].property[sizeof(g_entries[i].property) - 1] = '\0';
+    }
+    g_stats.entries = g_stats.loaded = (int32_t)h.entries;
+    LogMsg("  Property cache: %u offsets for this build", h.entries);
+    return true;
+}
+
+bool PropCacheSave(const char* path) {
+    if (!g_dirty) return true;
+
+    PropCacheHeader h = {};
+    h.magic      = PROPCACHE_MAGIC;
+    h.version    = PROPCACHE_VERSION;
+    h.headerSize = (uint16_t)sizeof(h);
+    h.buildId    = g_buildId;
+    h.entries    = (uint32_t)g_stats.entries;
+    h.entrySize  = (uint32_t)sizeof(PropCacheEntry);
+    h.checksum   = Checksum(g_entries, h.entries * sizeof(PropCacheEntry));
+
+    // Temporary name and rename, as for sidecars
+    char tmp[1024];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    FILE* f = fopen(tmp, "wb");
+    bool ok = f != nullptr;
+    if (ok) {
+        ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+             (h.entries == 0 ||
+              fwrite(g_entries, sizeof(PropCacheEntry), h.entries, f) == h.entries);
+        ok = (fclose(f) == 0) && ok;
+    }
+    if (ok) {
+        remove(path);
+        ok = rename(tmp, path) == 0;
+    }
+    if (!ok) {
+        remove(tmp);
+        LogMsg("  Property cache: could not write %s", path);
+        return false;
+    }
+
+    g_dirty = false;
+    LogMsg("  Property cache: %u offsets -> %s", h.entries, path);
+    return true;
+}
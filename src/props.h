@@ -0,0 +1,81 @@
+#pragma once
+#include "ue_types.h"
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Property resolver — finds a game class's or struct's UPROPERTY through
+// reflection (the UStruct::ChildProperties FField list, then each
+// SuperStruct's) and returns its offset and size, instead of an offset
+// taken from one game build.
+//
+// Resolved offsets are cached per game build in a small binary file:
+//
+//   PropCacheHeader                    32 bytes
+//   PropCacheEntry[entries]            96 bytes each
+//
+// The header carries the build id (the main module's PE timestamp and
+// image size), so a game update discards the whole file and every
+// property is walked once more.  A lookup that hits the cache reads no
+// FField and calls no FName::ToString.
+// ---------------------------------------------------------------------------
+
+constexpr uint32_t PROPCACHE_MAGIC       = 0x50465353;     // "SSFP"
+constexpr uint16_t PROPCACHE_VERSION     = 1;
+constexpr int      PROPCACHE_MAX_ENTRIES = 32;
+
+struct PropCacheHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;        // sizeof(PropCacheHeader)
+    uint64_t buildId;
+    uint32_t entries;
+    uint32_t entrySize;         // sizeof(PropCacheEntry)
+    uint32_t checksum;          // FNV-1a of the entries
+    uint32_t reserved;
+};
+static_assert(sizeof(PropCacheHeader) == 32, "property cache header layout");
+
+struct PropCacheEntry {
+    char    owner[48];          // class or struct name
+    char    property[40];       // property name, or "<Type>" for a lookup by type
+    int32_t offset;
+    int32_t size;               // ElementSize * ArrayDim
+};
+static_assert(sizeof(PropCacheEntry) == 96, "property cache entry layout");
+
+struct PropertyInfo {
+    int32_t offset;
+    int32_t size;
+};
+
+struct PropCacheStats {
+    int32_t entries;
+    int32_t loaded;             // entries read from the file
+    int32_t hits;
+    int32_t walks;              // lookups that walked FField lists
+};
+
+// FProperty named 'name' declared on 'ustruct' or one of its supers.
+// With 'type' set (an FFieldClass name such as "NameProperty") the
+// property must be of that type, and a null 'name' takes the first
+// property of that type declared on 'ustruct' itself.  Returns 0 if
+// there is none.
+uintptr_t FindPropertyField(FNameToStringFn fn, uintptr_t ustruct,
+                            const char* name, const char* type = nullptr);
+
+// Offset and size of that property, from the cache or a walk (which
+// adds it to the cache).  'ownerName' keys the cache; 'ustruct' may be 0
+// to consult only the cache.
+bool ResolveProperty(FNameToStringFn fn, uintptr_t ustruct, const char* ownerName,
+                     const char* name, const char* type, PropertyInfo& out);
+
+// Load the cache file of this build.  A missing, damaged or other-build
+// file leaves the cache empty (and bound to 'buildId').
+bool PropCacheLoad(const char* path, uint64_t buildId);
+
+// Write the cache if anything was added since it was loaded.  Returns
+// false only if a write was needed and failed.
+bool PropCacheSave(const char* path);
+
+void PropCacheReset(uint64_t buildId);
+void PropCacheGetStats(PropCacheStats& out);
@@ -0,0 +1,207 @@
+#include "railgraph.h"
+#include "mem.h"
+#include "trace.h"
+#include <cstring>
+
+// ===================================================================
+// Build: nodes, then CSR rows
+//
+// The walk records each socket entity once, in a node array sized to the
+// slot count (only the part used is ever touched).  The edge array is
+// then allocated at its exact size and filled node by node, so nothing
+// is copied to grow.  Each edge holds the node its socket links to, so
+// the checks after it compare indices instead of handles.
+// ===================================================================
+
+static constexpr int32_t EDGE_OPEN     = -1;    // linked to nothing
+static constexpr int32_t EDGE_DANGLING = -2;    // not a live socket entity
+
+struct Node {
+    FMassEntityHandle handle;
+    uintptr_t         sockets;      // FCrLogisticsSocket array, during the build
+    int32_t           first;        // first edge of the row
+    int32_t           arms;         // row length
+};
+
+struct GraphCtx {
+    Node*              nodes;
+    int32_t            numNodes;
+    int32_t            capNodes;
+    int32_t*           nodeOfSlot;  // node index + 1, 0 = not a socket entity
+    int32_t            numSlots;
+
+    int32_t*           edges;       // target node of each socket, row-major
+    int32_t            numEdges;
+};
+
+static void AddEntity(void* p, FMassEntityHandle h, uintptr_t sockFrag, uintptr_t) {
+    GraphCtx& ctx = *(GraphCtx*)p;
+    if (ctx.numNodes == ctx.capNodes || h.Index <= 0 || h.Index >= ctx.numSlots) return;
+
+    uintptr_t sockets;
+    int32_t numSockets;
+    ReadSocketArray(sockFrag, sockets, numSockets);
+
+    ctx.nodes[ctx.numNodes++] = { h, sockets, ctx.numEdges, numSockets };
+    ctx.nodeOfSlot[h.Index] = ctx.numNodes;
+    ctx.numEdges += numSockets;
+}
+
+static int32_t ResolveLink(const GraphCtx& ctx, const FMassEntityHandle& t) {
+    if (t.Index == 0 && t.SerialNumber == 0) return EDGE_OPEN;
+    if (t.Index <= 0 || t.Index >= ctx.numSlots) return EDGE_DANGLING;
+
+    int32_t v = ctx.nodeOfSlot[t.Index] - 1;
+    return (v >= 0 && SameEntity(ctx.nodes[v].handle, t)) ? v : EDGE_DANGLING;
+}
+
+static void FillEdges(GraphCtx& ctx) {
+    for (int32_t u = 0; u < ctx.numNodes; ++u) {
+        const Node& node = ctx.nodes[u];
+        for (int32_t k = 0; k < node.arms; ++k)
+            ctx.edges[node.first + k] = ResolveLink(ctx, ReadAt<FMassEntityHandle>(
+                node.sockets + (uintptr_t)k * SocketOff::Size, SocketOff::ConnectedEntity));
+    }
+}
+
+// ===================================================================
+// Union-find: parent index, or -(set size) at a root.  Union by size,
+// path halving.
+// ===================================================================
+
+static int32_t Find(int32_t* parent, int32_t x) {
+    while (parent[x] >= 0) {
+        if (parent[parent[x]] >= 0) parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+static void Union(int32_t* parent, int32_t a, int32_t b) {
+    a = Find(parent, a);
+    b = Find(parent, b);
+    if (a == b) return;
+    if (parent[a] > parent[b]) { int32_t t = a; a = b; b = t; }
+    parent[a] += parent[b];
+    parent[b] = a;
+}
+
+// ===================================================================
+// Classify links, join networks
+// ===================================================================
+
+static bool LinksBack(const GraphCtx& ctx, int32_t from, int32_t to) {
+    const Node& node = ctx.nodes[from];
+    for (int32_t e = node.first; e < node.first + node.arms; ++e)
+        if (ctx.edges[e] == to) return true;
+    return false;
+}
+
+static void CountJunction(RailGraphStats& stats, int32_t arms, int open, int broken) {
+    if (arms < JUNCTION_MIN_ARMS) return;
+
+    JunctionArmStats& j = arms == 3 ? stats.threeWay
+                        : arms == 5 ? stats.fiveWay
+                        : stats.otherJunctions;
+    j.junctions++;
+    if (open)   j.withOpenArms++;
+    if (broken) j.withBrokenArms++;
+    j.brokenArms += broken;
+}
+
+static void Classify(const GraphCtx& ctx, int32_t* parent, RailGraphStats& stats) {
+    TRACE_SPAN("BuildRailGraph: classify");
+
+    for (int32_t u = 0; u < ctx.numNodes; ++u) {
+        const Node& node = ctx.nodes[u];
+        int open = 0, broken = 0;
+
+        for (int32_t e = node.first; e < node.first + node.arms; ++e) {
+            int32_t v = ctx.edges[e];
+            if (v == EDGE_OPEN) {
+                open++;
+                continue;
+            }
+            if (v == EDGE_DANGLING) {
+                stats.dangling++;
+                broken++;
+                continue;
+            }
+            if (!LinksBack(ctx, v, u)) {
+                stats.oneWay++;
+                broken++;
+                continue;
+            }
+
+            // A two-way link is seen from both ends; join it once
+            stats.linked++;
+            if (u < v) Union(parent, u, v);
+        }
+
+        stats.open += open;
+        CountJunction(stats, node.arms, open, broken);
+    }
+
+    for (int32_t u = 0; u < ctx.numNodes; ++u) {
+        if (parent[u] >= 0) continue;
+        int32_t size = -parent[u];
+        if (size == 1) {
+            stats.isolated++;
+            continue;
+        }
+        stats.networks++;
+        if (size > stats.largestNetwork) stats.largestNetwork = size;
+    }
+}
+
+// ===================================================================
+// BuildRailGraph
+// ===================================================================
+
+bool BuildRailGraph(const EntityArray& entities,
+                    uintptr_t socketsStruct, uintptr_t connectionStruct,
+                    RailGraphStats& stats)
+{
+    TRACE_SPAN("BuildRailGraph");
+
+    memset(&stats, 0, sizeof(stats));
+    if (entities.num <= 0) return false;
+
+    // At most one node per slot
+    GraphCtx ctx = {};
+    ctx.numSlots = entities.num;
+    ctx.capNodes = entities.num;
+    size_t nodeBytes = (size_t)entities.num * sizeof(Node);
+    size_t slotBytes = (size_t)entities.num * sizeof(int32_t);
+    ctx.nodes      = (Node*)MemAlloc(MEM_GRAPH, nodeBytes);
+    ctx.nodeOfSlot = (int32_t*)MemAlloc(MEM_GRAPH, slotBytes);
+
+    int archetypes = -1;
+    if (ctx.nodes && ctx.nodeOfSlot)
+        archetypes = WalkSocketEntities(entities, socketsStruct, connectionStruct, AddEntity, &ctx);
+
+    size_t edgeBytes   = (size_t)(ctx.numEdges ? ctx.numEdges : 1) * sizeof(int32_t);
+    size_t parentBytes = (size_t)(ctx.numNodes ? ctx.numNodes : 1) * sizeof(int32_t);
+    int32_t* parent = nullptr;
+    bool ok = archetypes >= 0;
+    if (ok) {
+        ctx.edges = (int32_t*)MemAlloc(MEM_GRAPH, edgeBytes);
+        parent    = (int32_t*)MemAlloc(MEM_GRAPH, parentBytes);
+        ok = ctx.edges && parent;
+    }
+
+    if (ok) {
+        FillEdges(ctx);
+        memset(parent, 0xFF, parentBytes);     // every node its own set of one
+
+        stats.entities = ctx.numNodes;
+        stats.sockets  = ctx.numEdges;
+        Classify(ctx, parent, stats);
+    }
+
+    MemFree(MEM_GRAPH, parent, parentBytes);
+    MemFree(MEM_GRAPH, ctx.edges, edgeBytes);
+    MemFree(MEM_GRAPH, ctx.nodeOfSlot, slotBytes);
+    MemFree(MEM_GRAPH, ctx.nodes, nodeBytes);
+    return ok;
+}
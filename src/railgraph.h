@@ -0,0 +1,42 @@
+#pragma once
+#include "sockets.h"
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Rail network graph — built after a load to tell whether any junction is
+// still broken without walking the base in game.
+//
+// One walk over the socket entities records each as a node; every
+// socket's link is then copied into a flat edge array, row by row (CSR:
+// an entity's sockets are one contiguous row).  A second pass resolves
+// each link through a slot -> node table, checks that the target links
+// back, and unions two-way links into networks.  Everything is linear in
+// sockets, and nothing reads game memory once the edges are copied.
+// ---------------------------------------------------------------------------
+
+struct JunctionArmStats {
+    int junctions;
+    int withOpenArms;       // at least one arm linked to nothing
+    int withBrokenArms;     // at least one arm dangling or one-way
+    int brokenArms;
+};
+
+struct RailGraphStats {
+    int entities;           // socket-bearing entities (nodes)
+    int sockets;
+    int linked;             // sockets whose target links back
+    int open;               // sockets linked to nothing
+    int dangling;           // linked to an entity that is not a live socket entity
+    int oneWay;             // linked to a socket entity that does not link back
+    int networks;           // sets of two or more entities joined by two-way links
+    int largestNetwork;     // entities
+    int isolated;           // entities without a two-way link
+    JunctionArmStats threeWay;
+    JunctionArmStats fiveWay;
+    JunctionArmStats otherJunctions;    // 4 or 6+ arms
+};
+
+// Returns false if an archetype layout failed validation or memory ran out.
+bool BuildRailGraph(const EntityArray& entities,
+                    uintptr_t socketsStruct, uintptr_t connectionStruct,
+                    RailGraphStats& stats);
@@ -0,0 +1,415 @@
+#include "rebuild.h"
+#include "log.h"
+#include "mem.h"
+#include "platform.h"
+#include "reconnect.h"
+#include "sockets.h"
+#include "trace.h"
+#include "uobject.h"
+#include "worlds.h"
+#include <cstring>
+
+// ===================================================================
+// Signal name + UMassSignalSubsystem
+// ===================================================================
+
+static void FindSignalSubsystem(const RebuildEnv& env, SignalState& sig) {
+    TRACE_SPAN("FindSignalSubsystem");
+
+    uintptr_t obj = FindObjectByClassName(env.objArrayBase, env.nameToString,
+                                          "MassSignalSubsystem");
+    if (obj) {
+        sig.subsystem = (void*)obj;
+        LogMsg("Found UMassSignalSubsystem at 0x%llX", (unsigned long long)obj);
+    } else {
+        LogMsg("WARNING: UMassSignalSubsystem not found");
+    }
+}
+
+static void ResolveSignalName(const RebuildEnv& env, SignalState& sig) {
+    LogMsg("Discovering signal name from CrLogisticsSocketsSignalProcessor CDO...");
+    if (DiscoverSignalName(env.objArrayBase, env.nameToString, sig.name)) {
+        sig.nameReady = true;
+        LogMsg("Signal name discovered from CDO");
+    } else {
+        LogMsg("Falling back to INI signal name: %s", env.fallbackSignalName);
+        sig.name = FindFNameByString(env.objArrayBase, env.nameToString,
+                                     env.fallbackSignalName);
+        if (sig.name.ComparisonIndex != 0) {
+            sig.nameReady = true;
+            LogMsg("Resolved INI signal name: CompIdx=0x%X", sig.name.ComparisonIndex);
+        } else {
+            LogMsg("WARNING: Could not resolve signal name '%s'", env.fallbackSignalName);
+        }
+    }
+}
+
+void ResolveSignal(const RebuildEnv& env, SignalState& sig) {
+    if (!sig.nameReady) {
+        ResolveSignalName(env, sig);
+    }
+
+    // Subsystems may not exist yet at init; the load-time call retries
+    if (!sig.subsystem) {
+        FindSignalSubsystem(env, sig);
+    }
+}
+
+// ===================================================================
+// Signal targets
+// ===================================================================
+
+// Decide which entities need the rebuild signal.  A sidecar restores the
+// entities it holds first, so they verify clean.  The socket verifier
+// narrows this down to entities whose socket links did not survive the
+// load; with ReconnectSockets it also restores links lost before the mod
+// was installed and adds those entities.  If the Mass layout cannot be
+// validated we signal everything, as v2 always did.
+static int CollectSignalTargets(const RebuildEnv& env, TargetStructs& targets,
+                                const EntityArray& entities,
+                                FMassEntityHandle* outHandles, int maxHandles)
+{
+    TRACE_SPAN("CollectSignalTargets");
+
+    if (!targets.socketsFragment || !targets.connectionData) {
+        FindTargets(env.objArrayBase, env.nameToString, targets);
+    }
+
+    if (targets.socketsFragment && env.sidecar) {
+        SidecarApplyStats ss;
+        if (SidecarApply(*env.sidecar, entities, targets.socketsFragment,
+                         targets.connectionData, ss) >= 0) {
+            LogMsg("  Sidecar: %d socket entities found, %d restored, %d left to the rebuild "
+                   "(socket count changed)", ss.entities, ss.restored, ss.shapeMismatch);
+        } else {
+            LogMsg("  Sidecar: not applied — layout validation failed");
+        }
+    }
+
+    if (targets.socketsFragment && env.reconnect) {
+        ReconnectStats rs;
+        int count = ReconnectSockets(entities, targets.socketsFragment,
+                                     targets.connectionData, rs,
+                                     outHandles, maxHandles);
+        if (count >= 0) {
+            LogMsg("  Socket reconnect: %d archetypes, %d socket entities checked "
+                   "(%d junctions), %d broken (%d junctions)",
+                   rs.verify.archetypes, rs.verify.entities, rs.verify.junctions,
+                   rs.verify.broken, rs.verify.brokenJunctions);
+            LogMsg("  Socket reconnect: %d sockets hashed, %d links restored from saved "
+                   "connections, %d from neighbours, %d ambiguous; %d entities to rebuild",
+                   rs.sockets, rs.fromConnections, rs.fromNeighbours, rs.ambiguous, count);
+            return count;
+        }
+        LogMsg("  Socket reconnect unavailable — verifying only");
+    }
+
+    if (targets.socketsFragment) {
+        SocketVerifyStats stats;
+        int broken = VerifySockets(entities, targets.socketsFragment,
+                                   targets.connectionData, stats,
+                                   outHandles, maxHandles);
+        if (broken >= 0) {
+            LogMsg("  Socket verifier: %d archetypes, %d socket entities checked "
+                   "(%d junctions), %d broken (%d junctions)",
+                   stats.archetypes, stats.entities, stats.junctions,
+                   stats.broken, stats.brokenJunctions);
+            if (!targets.connectionData)
+                LogMsg("  NOTE: CrCustomConnectionData not found — only socket arrays were checked");
+            return broken;
+        }
+        LogMsg("  Socket verifier unavailable — falling back to signalling every entity");
+    }
+
+    return ReadEntityHandles(entities, outHandles, maxHandles);
+}
+
+// ===================================================================
+// Signal ledger
+// ===================================================================
+
+static size_t LedgerBitBytes(int32_t slots) {
+    return ((size_t)slots + 63) / 64 * sizeof(uint64_t);
+}
+
+void SignalLedgerReset(SignalLedger& ledger) {
+    if (ledger.bits) memset(ledger.bits, 0, LedgerBitBytes(ledger.capSlots));
+}
+
+void SignalLedgerFree(SignalLedger& ledger) {
+    MemFree(MEM_REBUILD, ledger.bits, LedgerBitBytes(ledger.capSlots));
+    MemFree(MEM_REBUILD, ledger.serials, (size_t)ledger.capSlots * sizeof(int32_t));
+    memset(&ledger, 0, sizeof(ledger));
+}
+
+// Slot and serial number of a live object in GUObjectArray
+static void ObjectId(uintptr_t objArrayBase, uintptr_t obj, int32_t& index, int32_t& serial) {
+    index  = obj ? ReadAt<int32_t>(obj, UObjOff::InternalIndex) : -1;
+    serial = 0;
+    if (index < 0 || index >= ReadAt<int32_t>(objArrayBase, TObjOff::NumElements)) return;
+    if (uintptr_t item = GetObjectItem(objArrayBase, index))
+        serial = ReadAt<int32_t>(item, ItemOff::SerialNumber);
+}
+
+// Switch to this subsystem's world and make room for every slot
+static bool LedgerPrepare(SignalLedger& ledger, uintptr_t objArrayBase,
+                          uintptr_t entitySubsystem, int32_t slots)
+{
+    int32_t subsystemIndex, subsystemSerial, worldIndex, worldSerial;
+    ObjectId(objArrayBase, entitySubsystem, subsystemIndex, subsystemSerial);
+    ObjectId(objArrayBase, ReadAt<uintptr_t>(entitySubsystem, UObjOff::OuterPrivate),
+             worldIndex, worldSerial);
+
+    if (!ledger.bound ||
+        ledger.subsystemIndex != subsystemIndex || ledger.subsystemSerial != subsystemSerial ||
+        ledger.worldIndex != worldIndex || ledger.worldSerial != worldSerial) {
+        if (ledger.bound) LogMsg("  Signal ledger: new world — previous entities forgotten");
+        SignalLedgerReset(ledger);
+        ledger.bound           = true;
+        ledger.subsystemIndex  = subsystemIndex;
+        ledger.subsystemSerial = subsystemSerial;
+        ledger.worldIndex      = worldIndex;
+        ledger.worldSerial     = worldSerial;
+    }
+    if (slots <= ledger.capSlots) return true;
+
+    // Grow in steps of 64K slots; bits and serials carry over
+    int32_t cap = (slots + 0xFFFF) & ~0xFFFF;
+    uint64_t* bits    = (uint64_t*)MemAlloc(MEM_REBUILD, LedgerBitBytes(cap));
+    int32_t*  serials = (int32_t*)MemAlloc(MEM_REBUILD, (size_t)cap * sizeof(int32_t));
+    if (!bits || !serials) {
+        MemFree(MEM_REBUILD, bits, LedgerBitBytes(cap));
+        MemFree(MEM_REBUILD, serials, (size_t)cap * sizeof(int32_t));
+        return false;
+    }
+    if (ledger.bits) {
+        memcpy(bits, ledger.bits, LedgerBitBytes(ledger.capSlots));
+        memcpy(serials, ledger.serials, (size_t)ledger.capSlots * sizeof(int32_t));
+        MemFree(MEM_REBUILD, ledger.bits, LedgerBitBytes(ledger.capSlots));
+        MemFree(MEM_REBUILD, ledger.serials, (size_t)ledger.capSlots * sizeof(int32_t));
+    }
+    ledger.bits     = bits;
+    ledger.serials  = serials;
+    ledger.capSlots = cap;
+    return true;
+}
+
+// Drop handles already signalled in this world and record the rest.
+// Returns the number kept, compacted to the front of 'handles'.
+static int LedgerFilter(SignalLedger& ledger, FMassEntityHandle* handles, int count) {
+    int kept = 0;
+    for (int i = 0; i < count; ++i) {
+        FMassEntityHandle h = handles[i];
+        if (h.Index >= 0 && h.Index < ledger.capSlots) {
+            uint64_t bit = 1ULL << (h.Index & 63);
+            uint64_t& word = ledger.bits[h.Index >> 6];
+            if ((word & bit) && ledger.serials[h.Index] == h.SerialNumber) continue;
+            word |= bit;
+            ledger.serials[h.Index] = h.SerialNumber;
+        }
+        handles[kept++] = h;
+    }
+    return kept;
+}
+
+// ===================================================================
+// Rail graph check
+// ===================================================================
+
+static void LogJunctions(const char* label, const JunctionArmStats& j) {
+    if (j.junctions == 0) return;
+    LogMsg("  Rail graph: %-6s %d junctions, %d with open arms, %d with broken arms (%d arms)",
+           label, j.junctions, j.withOpenArms, j.withBrokenArms, j.brokenArms);
+}
+
+static bool CheckRailGraph(const TargetStructs& targets, const EntityArray& entities,
+                           RailGraphStats& g)
+{
+    int64_t t0 = PlatTicks();
+    bool built = BuildRailGraph(entities, targets.socketsFragment, targets.connectionData, g);
+    int64_t t1 = PlatTicks();
+    if (!built) {
+        LogMsg("  Rail graph: not built — layout validation failed or out of memory");
+        return false;
+    }
+
+    LogMsg("  Rail graph: %d socket entities, %d sockets: %d linked, %d open, %d dangling, "
+           "%d one-way (%.1f ms)",
+           g.entities, g.sockets, g.linked, g.open, g.dangling, g.oneWay,
+           (double)(t1 - t0) * 1000.0 / (double)PlatTicksPerSecond());
+    LogMsg("  Rail graph: %d networks, largest %d entities, %d entities unlinked",
+           g.networks, g.largestNetwork, g.isolated);
+    LogJunctions("3-way", g.threeWay);
+    LogJunctions("5-way", g.fiveWay);
+    LogJunctions("other", g.otherJunctions);
+    return true;
+}
+
+// Signalled entities are rebuilt by the signal processor on a later Mass
+// tick, so a load that signalled any leaves the check until then.  The
+// entity subsystem is kept by object slot and serial, which stay readable
+// after the world is gone.
+struct DeferredGraph {
+    bool      pending;
+    uintptr_t entitySubsystem;
+    int32_t   index;
+    int32_t   serial;
+};
+static DeferredGraph g_deferredGraph = {};
+
+static void DeferRailGraph(const RebuildEnv& env, uintptr_t entitySubsystem) {
+    g_deferredGraph.pending         = true;
+    g_deferredGraph.entitySubsystem = entitySubsystem;
+    ObjectId(env.objArrayBase, entitySubsystem, g_deferredGraph.index, g_deferredGraph.serial);
+    LogMsg("  Rail graph: deferred until the signalled entities are rebuilt (next save)");
+}
+
+bool RunDeferredRailGraph(const RebuildEnv& env, const TargetStructs& targets,
+                          RailGraphStats& graph)
+{
+    if (!g_deferredGraph.pending) return false;
+    g_deferredGraph.pending = false;
+    if (g_deferredGraph.index < 0 || !targets.socketsFragment) return false;
+
+    // Same subsystem object, still in its slot
+    uintptr_t item = GetObjectItem(env.objArrayBase, g_deferredGraph.index);
+    if (!item || ReadAt<uintptr_t>(item, ItemOff::Object) != g_deferredGraph.entitySubsystem ||
+        ReadAt<int32_t>(item, ItemOff::SerialNumber) != g_deferredGraph.serial) {
+        LogMsg("Rail graph: world of the last load is gone — check dropped");
+        return false;
+    }
+
+    EntityArray entities = {};
+    if (!FindEntityArray(g_deferredGraph.entitySubsystem, entities)) return false;
+    LogMsg("Rail graph after the last load's rebuild:");
+    return CheckRailGraph(targets, entities, graph);
+}
+
+// ===================================================================
+// RebuildSockets
+// ===================================================================
+
+int RebuildSockets(const RebuildEnv& env, SignalState& sig, TargetStructs& targets,
+                   RebuildStats* stats)
+{
+    RebuildStats local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+
+    // A check left by the previous load is about a world being replaced
+    g_deferredGraph.pending = false;
+
+    // Subsystems of the world being loaded, not the first ones in the array.
+    // The subsystem kept from the last load may belong to a world that is
+    // gone, so with a loading object it is always looked up again.
+    WorldSubsystems world = {};
+    bool worldKnown = false;
+    if (env.loadingObject) {
+        void* previous = sig.subsystem;
+        sig.subsystem = nullptr;
+        worldKnown = ResolveWorldSubsystems(env.objArrayBase, env.nameToString,
+                                            env.loadingObject, world);
+        if (!worldKnown) {
+            LogMsg("  WARNING: No world found for 0x%llX — using the first subsystems found",
+                   (unsigned long long)env.loadingObject);
+        } else if (!world.signalSubsystem) {
+            LogMsg("  WARNING: World 0x%llX has no UMassSignalSubsystem yet",
+                   (unsigned long long)world.world);
+        } else {
+            if (previous && previous != (void*)world.signalSubsystem)
+                LogMsg("  UMassSignalSubsystem of the loading world: 0x%llX",
+                       (unsigned long long)world.signalSubsystem);
+            sig.subsystem = (void*)world.signalSubsystem;
+        }
+    }
+
+    // Retry whatever was not resolvable at init.  A known world's own
+    // subsystem is the only one it may be signalled through.
+    if (!sig.nameReady) {
+        ResolveSignalName(env, sig);
+    }
+    if (!sig.subsystem && !worldKnown) {
+        FindSignalSubsystem(env, sig);
+    }
+
+    if (!sig.nameReady || !sig.subsystem || !env.signalEntity) {
+        LogMsg("  Signal system not ready (ready=%d, subsys=%p, fn=%p) — skipping",
+               sig.nameReady, sig.subsystem, (void*)env.signalEntity);
+        return -1;
+    }
+
+    // Find UMassEntitySubsystem to iterate entity handles
+    uintptr_t entitySubsystem = world.entitySubsystem;
+    if (!entitySubsystem) {
+        TRACE_SPAN("FindObjectByClassName(MassEntitySubsystem)");
+        entitySubsystem = FindObjectByClassName(env.objArrayBase, env.nameToString,
+                                                "MassEntitySubsystem");
+    }
+    if (!entitySubsystem) {
+        LogMsg("  WARNING: MassEntitySubsystem not found — cannot signal entities");
+        return -1;
+    }
+
+    EntityArray entities = {};
+    if (!FindEntityArray(entitySubsystem, entities)) {
+        LogMsg("  No entity handles found — signal skipped");
+        return -1;
+    }
+    stats->entitySlots = entities.num;
+
+    // Collect the entities that need a socket rebuild.  At most one
+    // handle per slot, so size the buffer to the slot count.
+    const size_t handleBytes = (size_t)entities.num * sizeof(FMassEntityHandle);
+    FMassEntityHandle* handles = (FMassEntityHandle*)MemAlloc(MEM_REBUILD, handleBytes);
+
+    if (!handles) {
+        LogMsg("  ERROR: Failed to allocate handle buffer");
+        return -1;
+    }
+
+    int handleCount = CollectSignalTargets(env, targets, entities, handles, entities.num);
+
+    if (handleCount > 0 && env.ledger) {
+        if (LedgerPrepare(*env.ledger, env.objArrayBase, entitySubsystem, entities.num)) {
+            int kept = LedgerFilter(*env.ledger, handles, handleCount);
+            stats->skipped = handleCount - kept;
+            if (stats->skipped > 0)
+                LogMsg("  Signal ledger: %d of %d entities already signalled in this world "
+                       "— skipped", stats->skipped, handleCount);
+            handleCount = kept;
+        } else {
+            LogMsg("  WARNING: Signal ledger allocation failed — signalling every target");
+        }
+    }
+
+    if (handleCount > 0) {
+        LogMsg("  Signaling %d entities with socket signal (CompIdx=0x%X)...",
+               handleCount, sig.name.ComparisonIndex);
+
+        TRACE_SPAN("SignalEntity loop");
+        int64_t t0 = PlatTicks();
+        for (int i = 0; i < handleCount; ++i) {
+            env.signalEntity(sig.subsystem, sig.name, handles[i]);
+        }
+        stats->signalTicks = PlatTicks() - t0;
+
+        LogMsg("  Socket signal sent to %d entities (rebuild requested)", handleCount);
+    } else if (stats->skipped > 0) {
+        LogMsg("  Every entity needing a rebuild was already signalled — signal skipped");
+    } else {
+        LogMsg("  No entities need a socket rebuild — signal skipped");
+    }
+
+    MemFree(MEM_REBUILD, handles, handleBytes);
+    stats->signalled = handleCount;
+
+    if (env.railGraph && targets.socketsFragment) {
+        if (handleCount > 0) {
+            DeferRailGraph(env, entitySubsystem);
+            stats->graphDeferred = true;
+        } else {
+            stats->graphBuilt = CheckRailGraph(targets, entities, stats->graph);
+        }
+    }
+    return handleCount;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "discovery.h"
+#include "railgraph.h"
+#include "sidecar.h"
+#include "ue_types.h"
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Post-load socket rebuild — what the OnPostSaveLoaded detour does once the
+// original has returned: finish resolving the signal path if init could
+// not, locate the Mass entity store, restore socket state from the save's
+// sidecar if there is one, pick the entities whose sockets still need
+// rebuilding and send each one the socket signal, then check the rail
+// network that results.
+// ---------------------------------------------------------------------------
+
+// Entities already signalled in the current world, kept by the caller
+// across loads so a hook that fires again (sub-level load) only signals
+// new or recycled handles: one bit per entity slot, and the serial number
+// the bit was set for.  The ledger belongs to one UMassEntitySubsystem
+// and world, identified by their GUObjectArray slots and serial numbers,
+// so an object built where a destroyed one was does not inherit it.
+//
+// A save read back into the same world restores entities at the same
+// handles, which only SignalLedgerReset can tell apart: pass a ledger
+// only when every save read is reported through it.
+struct SignalLedger {
+    bool      bound;            // the ids below are set
+    int32_t   subsystemIndex;   // UMassEntitySubsystem the bits belong to
+    int32_t   subsystemSerial;
+    int32_t   worldIndex;       // its outer
+    int32_t   worldSerial;
+    uint64_t* bits;
+    int32_t*  serials;
+    int32_t   capSlots;
+};
+
+// Forget every entity (a save is being read)
+void SignalLedgerReset(SignalLedger& ledger);
+void SignalLedgerFree(SignalLedger& ledger);
+
+struct RebuildEnv {
+    uintptr_t       objArrayBase;       // GUObjectArray + ObjObjects
+    FNameToStringFn nameToString;
+    SignalEntityFn  signalEntity;
+    const char*     fallbackSignalName; // INI SocketSignalName
+    bool            reconnect;          // INI ReconnectSockets
+    bool            railGraph;          // INI RailGraph (see RunDeferredRailGraph)
+    const Sidecar*  sidecar;            // validated sidecar of the loaded save, or null
+    SignalLedger*   ledger;             // skip entities already signalled, or null
+                                        // (null unless save reads reset it)
+    uintptr_t       loadingObject;      // object of the world being loaded (the save
+                                        // subsystem), or 0 = first subsystem found
+};
+
+// Resolved once and kept across loads; the subsystem follows the loading
+// world when RebuildEnv::loadingObject is set, and is 0 while that world
+// has none
+struct SignalState {
+    void* subsystem;            // UMassSignalSubsystem
+    FName name;                 // socket signal
+    bool  nameReady;
+};
+
+// Resolve the signal name (CDO first, then the fallback name) and the
+// signal subsystem, whichever is still missing.  Called at init and
+// again at load time if anything was not there yet.
+void ResolveSignal(const RebuildEnv& env, SignalState& sig);
+
+// What one rebuild saw, for the live metrics
+struct RebuildStats {
+    int32_t entitySlots;        // slots of the entity array, 0 if not found
+    int32_t signalled;
+    int32_t skipped;            // already signalled in this world (ledger)
+    int64_t signalTicks;        // SignalEntity loop, PlatTicks
+    bool    graphBuilt;         // nothing signalled: links are final, checked now
+    bool    graphDeferred;      // entities signalled: see RunDeferredRailGraph
+    RailGraphStats graph;
+};
+
+// Returns the number of entities signalled, or -1 if the signal path or
+// the entity store could not be found.  'targets' is completed lazily.
+int RebuildSockets(const RebuildEnv& env, SignalState& sig, TargetStructs& targets,
+                   RebuildStats* stats = nullptr);
+
+// Rail graph check of the last load, if it was left until the signal
+// processor had rebuilt the signalled entities (any later game-thread
+// point will do; the mod uses the next save).  Returns false if none was
+// pending, its world is gone or the graph could not be built.
+bool RunDeferredRailGraph(const RebuildEnv& env, const TargetStructs& targets,
+                          RailGraphStats& graph);
@@ -0,0 +1,284 @@
+#include "reconnect.h"
+#include "log.h"
+#include "mem.h"
+#include "trace.h"
+#include <cmath>
+#include <cstring>
+
+// Sockets that connect sit at the same world position (cm)
+static constexpr double  MATCH_DISTANCE = 2.0;
+static constexpr double  CELL_SIZE      = 32.0;
+static constexpr double  MAX_COORD      = 1e9;
+
+static constexpr int32_t INITIAL_RECORDS        = 64 * 1024;
+
+// ===================================================================
+// Socket records
+// ===================================================================
+
+struct SocketRec {
+    uintptr_t         sock;     // FCrLogisticsSocket
+    FMassEntityHandle owner;
+    uint32_t          cell;     // hash of the grid cell holding the socket
+    double            pos[3];   // location, as validated when the record was added
+};
+
+struct ReconnectCtx {
+    ReconnectStats*    stats;
+    FMassEntityHandle* outHandles;
+    int                maxHandles;
+    int                count;
+    int32_t            numSlots;
+
+    uint64_t*          marked;      // one bit per entity slot
+    size_t             markedBytes;
+
+    SocketRec*         recs;
+    int32_t            numRecs;
+    int32_t            capRecs;
+    bool               outOfMemory;
+};
+
+static bool IsUnconnected(const FMassEntityHandle& h) {
+    return h.Index == 0 && h.SerialNumber == 0;
+}
+
+static uint32_t CellHash(int64_t cx, int64_t cy, int64_t cz) {
+    uint64_t h = (uint64_t)cx * 0x9E3779B97F4A7C15ULL ^
+                 (uint64_t)cy * 0xC2B2AE3D27D4EB4FULL ^
+                 (uint64_t)cz * 0x165667B19E3779F9ULL;
+    return (uint32_t)(h ^ (h >> 32));
+}
+
+// Sockets without a location (compact saves) cannot be matched by position
+static bool ReadLocation(uintptr_t sock, double p[3]) {
+    if (!SocketPlaced(sock)) return false;
+    for (int i = 0; i < 3; ++i) {
+        p[i] = ReadAt<double>(sock, SocketOff::Location + (size_t)i * sizeof(double));
+        if (!(fabs(p[i]) < MAX_COORD)) return false;
+    }
+    return true;
+}
+
+static int64_t CellCoord(double v) {
+    return (int64_t)floor(v / CELL_SIZE);
+}
+
+// Queue an entity for the rebuild signal, once
+static void Mark(ReconnectCtx& ctx, FMassEntityHandle h) {
+    if (h.Index < 0 || h.Index >= ctx.numSlots) return;
+    uint64_t bit = 1ULL << (h.Index & 63);
+    uint64_t& word = ctx.marked[h.Index >> 6];
+    if (word & bit) return;
+    word |= bit;
+    if (ctx.count < ctx.maxHandles) ctx.outHandles[ctx.count++] = h;
+}
+
+static void AddRecord(ReconnectCtx& ctx, uintptr_t sock, FMassEntityHandle owner) {
+    double p[3];
+    if (!ReadLocation(sock, p)) return;
+
+    if (ctx.numRecs == ctx.capRecs) {
+        int32_t cap = ctx.capRecs ? ctx.capRecs * 2 : INITIAL_RECORDS;
+        SocketRec* grown = (SocketRec*)MemAlloc(MEM_RECONNECT, (size_t)cap * sizeof(SocketRec));
+        if (!grown) {
+            ctx.outOfMemory = true;
+            return;
+        }
+        if (ctx.recs) {
+            memcpy(grown, ctx.recs, (size_t)ctx.numRecs * sizeof(SocketRec));
+            MemFree(MEM_RECONNECT, ctx.recs, (size_t)ctx.capRecs * sizeof(SocketRec));
+        }
+        ctx.recs = grown;
+        ctx.capRecs = cap;
+    }
+
+    SocketRec& r = ctx.recs[ctx.numRecs++];
+    r.sock  = sock;
+    r.owner = owner;
+    r.cell  = CellHash(CellCoord(p[0]), CellCoord(p[1]), CellCoord(p[2]));
+    memcpy(r.pos, p, sizeof(r.pos));
+}
+
+// ===================================================================
+// Walk: verify, fill from saved connections, file sockets
+// ===================================================================
+
+static void FillFromConnections(ReconnectCtx& ctx, uintptr_t sockets, int32_t numSockets,
+                                uintptr_t connFrag)
+{
+    if (!connFrag) return;
+    uintptr_t conns  = ReadAt<uintptr_t>(connFrag, ConnDataOff::Connections + TArrayOff::Data);
+    int32_t numConns = ReadAt<int32_t>(connFrag, ConnDataOff::Connections + TArrayOff::Num);
+    if (!conns || numConns <= 0 || numConns > MAX_SOCKETS_PER_ENTITY) return;
+
+    for (int32_t c = 0; c < numConns; ++c) {
+        uintptr_t conn = conns + (uintptr_t)c * ConnOff::Size;
+        int32_t socketIdx = ReadAt<int32_t>(conn, ConnOff::SocketIndex);
+        if (socketIdx < 0 || socketIdx >= numSockets) continue;
+
+        uintptr_t sock = sockets + (uintptr_t)socketIdx * SocketOff::Size;
+        if (!IsUnconnected(ReadAt<FMassEntityHandle>(sock, SocketOff::ConnectedEntity))) continue;
+
+        WriteAt<FMassEntityHandle>(sock, SocketOff::ConnectedEntity,
+                                   ReadAt<FMassEntityHandle>(conn, ConnOff::Target));
+        ctx.stats->fromConnections++;
+    }
+}
+
+static void VisitEntity(void* p, FMassEntityHandle h, uintptr_t sockFrag, uintptr_t connFrag) {
+    ReconnectCtx& ctx = *(ReconnectCtx*)p;
+
+    bool ok = VerifySocketEntity(sockFrag, connFrag, ctx.stats->verify);
+    if (!ok) Mark(ctx, h);
+
+    uintptr_t sockets;
+    int32_t numSockets;
+    if (!ReadSocketArray(sockFrag, sockets, numSockets)) return;
+
+    if (!ok) FillFromConnections(ctx, sockets, numSockets, connFrag);
+
+    for (int32_t k = 0; k < numSockets; ++k)
+        AddRecord(ctx, sockets + (uintptr_t)k * SocketOff::Size, h);
+}
+
+// ===================================================================
+// Match: empty sockets against co-located sockets of other entities
+// ===================================================================
+
+// A partner is a socket of another entity at the same position that is
+// empty or already links back.  Returns it only if it is the only one.
+static const SocketRec* FindPartner(const SocketRec& rec, const SocketRec* sorted,
+                                    const int32_t* bucketStart, uint32_t mask, bool& ambiguous)
+{
+    const double* p = rec.pos;
+
+    // Only cells within MATCH_DISTANCE of the socket; usually just its own
+    int64_t lo[3], hi[3];
+    for (int i = 0; i < 3; ++i) {
+        lo[i] = CellCoord(p[i] - MATCH_DISTANCE);
+        hi[i] = CellCoord(p[i] + MATCH_DISTANCE);
+    }
+
+    const SocketRec* found = nullptr;
+    ambiguous = false;
+
+    for (int64_t cx = lo[0]; cx <= hi[0]; ++cx)
+    for (int64_t cy = lo[1]; cy <= hi[1]; ++cy)
+    for (int64_t cz = lo[2]; cz <= hi[2]; ++cz) {
+        uint32_t cell = CellHash(cx, cy, cz);
+        uint32_t b = cell & mask;
+        for (int32_t i = bucketStart[b]; i < bucketStart[b + 1]; ++i) {
+            const SocketRec& cand = sorted[i];
+            if (cand.cell != cell || SameEntity(cand.owner, rec.owner)) continue;
+            if (found && found->sock == cand.sock) continue;
+
+            const double* q = cand.pos;
+            double d2 = (p[0] - q[0]) * (p[0] - q[0]) + (p[1] - q[1]) * (p[1] - q[1]) +
+                        (p[2] - q[2]) * (p[2] - q[2]);
+            if (d2 > MATCH_DISTANCE * MATCH_DISTANCE) continue;
+
+            FMassEntityHandle linked = ReadAt<FMassEntityHandle>(cand.sock, SocketOff::ConnectedEntity);
+            if (!IsUnconnected(linked) && !SameEntity(linked, rec.owner)) continue;
+
+            if (found) {
+                ambiguous = true;
+                return nullptr;
+            }
+            found = &cand;
+        }
+    }
+    return found;
+}
+
+static bool MatchNeighbours(ReconnectCtx& ctx) {
+    TRACE_SPAN("ReconnectSockets: match");
+
+    int32_t n = ctx.numRecs;
+    uint32_t buckets = 1024;
+    while (buckets < (uint32_t)n * 2) buckets <<= 1;
+    uint32_t mask = buckets - 1;
+
+    size_t startBytes  = (size_t)(buckets + 1) * sizeof(int32_t);
+    size_t sortedBytes = (size_t)(n ? n : 1) * sizeof(SocketRec);
+    int32_t*   bucketStart = (int32_t*)MemAlloc(MEM_RECONNECT, startBytes);
+    SocketRec* sorted      = (SocketRec*)MemAlloc(MEM_RECONNECT, sortedBytes);
+    if (!bucketStart || !sorted) {
+        MemFree(MEM_RECONNECT, bucketStart, startBytes);
+        MemFree(MEM_RECONNECT, sorted, sortedBytes);
+        return false;
+    }
+
+    // Counting sort by bucket: each bucket's sockets end up contiguous
+    for (int32_t i = 0; i < n; ++i) bucketStart[(ctx.recs[i].cell & mask) + 1]++;
+    for (uint32_t b = 0; b < buckets; ++b) bucketStart[b + 1] += bucketStart[b];
+    for (int32_t i = 0; i < n; ++i) {
+        uint32_t b = ctx.recs[i].cell & mask;
+        sorted[bucketStart[b]++] = ctx.recs[i];
+    }
+    for (uint32_t b = buckets; b > 0; --b) bucketStart[b] = bucketStart[b - 1];
+    bucketStart[0] = 0;
+
+    for (int32_t i = 0; i < n; ++i) {
+        const SocketRec& rec = sorted[i];
+        if (!IsUnconnected(ReadAt<FMassEntityHandle>(rec.sock, SocketOff::ConnectedEntity))) continue;
+
+        bool ambiguous;
+        const SocketRec* partner = FindPartner(rec, sorted, bucketStart, mask, ambiguous);
+        if (!partner) {
+            if (ambiguous) ctx.stats->ambiguous++;
+            continue;
+        }
+
+        WriteAt<FMassEntityHandle>(rec.sock, SocketOff::ConnectedEntity, partner->owner);
+        ctx.stats->fromNeighbours++;
+        Mark(ctx, rec.owner);
+
+        if (IsUnconnected(ReadAt<FMassEntityHandle>(partner->sock, SocketOff::ConnectedEntity))) {
+            WriteAt<FMassEntityHandle>(partner->sock, SocketOff::ConnectedEntity, rec.owner);
+            ctx.stats->fromNeighbours++;
+            Mark(ctx, partner->owner);
+        }
+    }
+
+    MemFree(MEM_RECONNECT, bucketStart, startBytes);
+    MemFree(MEM_RECONNECT, sorted, sortedBytes);
+    return true;
+}
+
+// ===================================================================
+// ReconnectSockets
+// ===================================================================
+
+int ReconnectSockets(const EntityArray& entities,
+                     uintptr_t socketsStruct, uintptr_t connectionStruct,
+                     ReconnectStats& stats,
+                     FMassEntityHandle* outHandles, int maxHandles)
+{
+    TRACE_SPAN("ReconnectSockets");
+
+    memset(&stats, 0, sizeof(stats));
+
+    ReconnectCtx ctx = {};
+    ctx.stats       = &stats;
+    ctx.outHandles  = outHandles;
+    ctx.maxHandles  = maxHandles;
+    ctx.numSlots    = entities.num;
+    ctx.markedBytes = ((size_t)entities.num + 63) / 64 * sizeof(uint64_t);
+    ctx.marked      = (uint64_t*)MemAlloc(MEM_RECONNECT, ctx.markedBytes);
+    if (!ctx.marked) return -1;
+
+    int archetypes = WalkSocketEntities(entities, socketsStruct, connectionStruct,
+                                        VisitEntity, &ctx);
+    bool ok = archetypes >= 0 && !ctx.outOfMemory;
+    if (ok) {
+        stats.verify.archetypes = archetypes;
+        stats.sockets = ctx.numRecs;
+        ok = MatchNeighbours(ctx);
+    }
+    if (!ok) LogMsg("  Reconnect: %s", archetypes < 0 ? "layout validation failed" : "out of memory");
+
+    MemFree(MEM_RECONNECT, ctx.recs, (size_t)ctx.capRecs * sizeof(SocketRec));
+    MemFree(MEM_RECONNECT, ctx.marked, ctx.markedBytes);
+    return ok ? ctx.count : -1;
+}
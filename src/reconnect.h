@@ -0,0 +1,34 @@
+#pragma once
+#include "sockets.h"
+#include "ue_types.h"
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Socket reconnection — restores links that were lost before the mod was
+// installed, so old saves heal on load instead of needing a rebuild.
+//
+// One walk over every socket entity verifies it (as VerifySockets does),
+// fills empty sockets from the entity's FCrCustomConnectionData, and
+// files every socket in a spatial hash keyed by its world position.
+// Sockets still empty after that are matched against sockets of other
+// entities at the same position: a neighbour that already links back,
+// or one that is empty too, is the missing connection.  Only entities
+// that were broken or had links restored are reported for the rebuild
+// signal.
+// ---------------------------------------------------------------------------
+
+struct ReconnectStats {
+    SocketVerifyStats verify;
+    int sockets;            // sockets filed in the spatial hash
+    int fromConnections;    // links restored from saved connection data
+    int fromNeighbours;     // links restored from co-located sockets
+    int ambiguous;          // empty sockets with more than one candidate
+};
+
+// Returns the number of entity handles written to outHandles, or -1 if
+// an archetype layout failed validation or memory ran out (the caller
+// should then fall back to VerifySockets / signalling everything).
+int ReconnectSockets(const EntityArray& entities,
+                     uintptr_t socketsStruct, uintptr_t connectionStruct,
+                     ReconnectStats& stats,
+                     FMassEntityHandle* outHandles, int maxHandles);
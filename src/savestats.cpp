@@ -0,0 +1,202 @@
+#include "savestats.h"
+#include "log.h"
+#include "platform.h"
+#include "sockets.h"
+#include "trace.h"
+#include <atomic>
+#include <cstring>
+
+// ===================================================================
+// Sockets fragment share
+// ===================================================================
+
+struct ShareCtx {
+    SocketShare* out;
+    int64_t      fixedBytes;    // PropertiesSize of the sockets fragment
+};
+
+static void CountEntity(void* p, FMassEntityHandle, uintptr_t sockFrag, uintptr_t) {
+    ShareCtx& ctx = *(ShareCtx*)p;
+
+    uintptr_t sockets;
+    int32_t numSockets;
+    ReadSocketArray(sockFrag, sockets, numSockets);
+
+    ctx.out->entities++;
+    ctx.out->sockets += numSockets;
+    ctx.out->bytes   += ctx.fixedBytes + (int64_t)numSockets * (int64_t)SocketOff::Size;
+}
+
+bool MeasureSocketShare(uintptr_t objArrayBase, FNameToStringFn fn,
+                        TargetStructs& targets, SocketShare& out)
+{
+    TRACE_SPAN("MeasureSocketShare");
+
+    memset(&out, 0, sizeof(out));
+
+    EntityArray entities = {};
+    if (!FindSocketEntityStore(objArrayBase, fn, targets, entities)) return false;
+
+    ShareCtx ctx = { &out, ReadAt<int32_t>(targets.socketsFragment, UStructOff::PropertiesSize) };
+    int archetypes = WalkSocketEntities(entities, targets.socketsFragment,
+                                        targets.connectionData, CountEntity, &ctx);
+    if (archetypes < 0) return false;
+
+    out.archetypes = archetypes;
+    return true;
+}
+
+// ===================================================================
+// Save records
+// ===================================================================
+
+static SaveRecord g_saves[SAVE_STATS_WINDOW];
+static uint32_t   g_saveCount = 0;      // finished saves since load
+static int64_t    g_saveStart = 0;
+
+// Bytes handed to the slot writer, with the save they are credited to:
+// the low 16 bits of its number above BYTES_SHIFT, the byte count below.
+// The slot writer may run on an async save thread, so it only adds to
+// this word; the game thread swaps it out at the next Begin or End and
+// folds the bytes into that save's record.
+static constexpr int         BYTES_SHIFT = 48;
+static constexpr uint64_t    BYTES_MASK  = (1ULL << BYTES_SHIFT) - 1;
+static std::atomic<uint64_t> g_written{0};
+
+static uint64_t WrittenTag(uint32_t index) {
+    return (uint64_t)(index & 0xFFFF) << BYTES_SHIFT;
+}
+
+static double Ms(int64_t ticks) {
+    return (double)ticks * 1000.0 / (double)PlatTicksPerSecond();
+}
+
+static double MB(int64_t bytes) {
+    return (double)bytes / (1024.0 * 1024.0);
+}
+
+static SaveRecord* LastSave() {
+    return g_saveCount ? &g_saves[(g_saveCount - 1) % SAVE_STATS_WINDOW] : nullptr;
+}
+
+static void LogSave(const SaveRecord& r) {
+    if (!r.shareValid) {
+        LogMsg("Save #%u: %.1f ms, %.2f MB written; sockets fragment not measured",
+               r.index, Ms(r.ticks), MB(r.bytesWritten));
+        return;
+    }
+
+    const SocketShare& s = r.share;
+    double perEntity = s.entities ? (double)s.bytes / s.entities : 0.0;
+    if (r.bytesWritten > 0) {
+        LogMsg("Save #%u: %.1f ms, %.2f MB written; sockets fragment %d entities x %.0f B "
+               "= %.2f MB (%.1f%%), counted in %.1f ms",
+               r.index, Ms(r.ticks), MB(r.bytesWritten), s.entities, perEntity, MB(s.bytes),
+               100.0 * (double)s.bytes / (double)r.bytesWritten, Ms(r.walkTicks));
+    } else {
+        LogMsg("Save #%u: %.1f ms, bytes not seen; sockets fragment %d entities x %.0f B "
+               "= %.2f MB, counted in %.1f ms",
+               r.index, Ms(r.ticks), s.entities, perEntity, MB(s.bytes), Ms(r.walkTicks));
+    }
+}
+
+// Bytes reported after their save's End (async save), swapped out of
+// g_written by the next Begin
+static void FoldLateBytes(uint64_t word) {
+    int64_t bytes = (int64_t)(word & BYTES_MASK);
+    if (bytes == 0) return;
+
+    SaveRecord* r = LastSave();
+    if (!r || WrittenTag(r->index) != (word & ~BYTES_MASK)) {
+        LogMsg("Save data written outside a tracked save: %.2f MB", MB(bytes));
+        return;
+    }
+    r->bytesWritten += bytes;
+    LogMsg("Save #%u: %.2f MB written asynchronously", r->index, MB(bytes));
+    if (r->shareValid && r->bytesWritten > 0)
+        LogMsg("  sockets fragment share: %.1f%%",
+               100.0 * (double)r->share.bytes / (double)r->bytesWritten);
+}
+
+void SaveStatsBegin() {
+    FoldLateBytes(g_written.exchange(WrittenTag(g_saveCount + 1), std::memory_order_acq_rel));
+    g_saveStart = PlatTicks();
+}
+
+void SaveStatsAddBytes(int64_t bytes) {
+    if (bytes > 0) g_written.fetch_add((uint64_t)bytes & BYTES_MASK, std::memory_order_relaxed);
+}
+
+void SaveStatsEnd(const SocketShare* share, int64_t walkTicks) {
+    int64_t end = PlatTicks();
+
+    // Later bytes stay credited to this save until the next Begin
+    uint64_t word = g_written.exchange(WrittenTag(g_saveCount + 1), std::memory_order_acq_rel);
+
+    SaveRecord& r = g_saves[g_saveCount % SAVE_STATS_WINDOW];
+    memset(&r, 0, sizeof(r));
+    r.index        = ++g_saveCount;
+    r.ticks        = end - g_saveStart - walkTicks;
+    r.bytesWritten = (int64_t)(word & BYTES_MASK);
+    r.walkTicks    = walkTicks;
+    if (share) {
+        r.share      = *share;
+        r.shareValid = true;
+    }
+
+    LogSave(r);
+    SaveStatsDumpSummary();
+}
+
+int SaveStatsCount() {
+    return g_saveCount < SAVE_STATS_WINDOW ? (int)g_saveCount : SAVE_STATS_WINDOW;
+}
+
+const SaveRecord* SaveStatsGet(int i) {
+    int n = SaveStatsCount();
+    if (i < 0 || i >= n) return nullptr;
+    return &g_saves[(g_saveCount - n + i) % SAVE_STATS_WINDOW];
+}
+
+// ===================================================================
+// Rolling summary
+// ===================================================================
+
+void SaveStatsDumpSummary() {
+    int n = SaveStatsCount();
+    if (n == 0) return;
+
+    int64_t sumTicks = 0, maxTicks = 0, sumBytes = 0;
+    int     withBytes = 0;
+    double  sumShare = 0.0;
+    int     withShare = 0;
+    const SaveRecord* firstMeasured = nullptr;
+    const SaveRecord* lastMeasured  = nullptr;
+
+    for (int i = 0; i < n; ++i) {
+        const SaveRecord& r = *SaveStatsGet(i);
+        sumTicks += r.ticks;
+        if (r.ticks > maxTicks) maxTicks = r.ticks;
+        if (r.bytesWritten > 0) {
+            sumBytes += r.bytesWritten;
+            withBytes++;
+        }
+        if (r.shareValid) {
+            if (!firstMeasured) firstMeasured = &r;
+            lastMeasured = &r;
+            if (r.bytesWritten > 0) {
+                sumShare += (double)r.share.bytes / (double)r.bytesWritten;
+                withShare++;
+            }
+        }
+    }
+
+    LogMsg("Save summary (last %d): mean %.1f ms, max %.1f ms, mean %.2f MB written",
+           n, Ms(sumTicks / n), Ms(maxTicks), withBytes ? MB(sumBytes / withBytes) : 0.0);
+    if (lastMeasured) {
+        LogMsg("  sockets fragment: mean share %.1f%%, %d -> %d entities, %.2f -> %.2f MB",
+               withShare ? 100.0 * sumShare / withShare : 0.0,
+               firstMeasured->share.entities, lastMeasured->share.entities,
+               MB(firstMeasured->share.bytes), MB(lastMeasured->share.bytes));
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "discovery.h"
+#include "ue_types.h"
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Save-path instrumentation — what a save costs now that the sockets
+// fragment is savable.  The save detours bracket each UCrMassSaveSubsystem
+// save with SaveStatsBegin/End and report the bytes handed to the slot
+// writer; afterwards the socket entities are counted so the fragment's
+// share of the save can be logged next to the total.  The last
+// SAVE_STATS_WINDOW saves are kept for a rolling summary, so autosave
+// hitches can be followed as a base grows.
+//
+// Fragment bytes are the in-memory payload (fixed struct plus socket
+// array elements), an estimate of what the fragment adds to the save.
+// No OS calls, so the host simulator runs exactly this code.
+// ---------------------------------------------------------------------------
+
+constexpr int SAVE_STATS_WINDOW = 32;
+
+struct SocketShare {
+    int     archetypes;     // archetypes carrying the sockets fragment
+    int     entities;       // socket-bearing entities
+    int64_t sockets;        // socket array elements across them
+    int64_t bytes;          // fragment payload bytes
+};
+
+struct SaveRecord {
+    uint32_t    index;          // 1-based save number since load
+    int64_t     ticks;          // save duration (PlatTicks units)
+    int64_t     bytesWritten;   // handed to the slot writer, 0 if not seen
+    int64_t     walkTicks;      // time spent counting the socket entities
+    SocketShare share;
+    bool        shareValid;
+};
+
+// Count socket entities and their payload.  Returns false if the entity
+// store cannot be found or an archetype layout fails validation.
+bool MeasureSocketShare(uintptr_t objArrayBase, FNameToStringFn fn,
+                        TargetStructs& targets, SocketShare& out);
+
+// Bracket one save.  Bytes reported between Begin and End belong to it;
+// bytes reported later (asynchronous slot writes) are added to it when
+// the next save begins, and logged on their own.  End takes the share
+// counted after the original returned (nullptr if it could not be);
+// walkTicks is left out of the save duration.  Each save is logged with
+// the summary.  AddBytes may be called from any thread; everything else
+// only from the game thread.
+void SaveStatsBegin();
+void SaveStatsAddBytes(int64_t bytes);
+void SaveStatsEnd(const SocketShare* share, int64_t walkTicks);
+
+// Saves currently in the window, oldest first
+int               SaveStatsCount();
+const SaveRecord* SaveStatsGet(int i);
+
+// Log the rolling summary over the window
+void SaveStatsDumpSummary();
@@ -1,20 +1,24 @@
 #include "scanner.h"
+#include "log.h"
+#include "probe.h"
+#include "trace.h"
+#include "uobject.h"
 #include <windows.h>
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
 
-extern void LogMsg(const char* fmt, ...);
 extern char g_modDir[];
 
 // ===================================================================
 // Helpers
 // ===================================================================
 
-static uintptr_t g_moduleBase = 0;
-static size_t    g_moduleSize = 0;
+static uintptr_t g_moduleBase  = 0;
+static size_t    g_moduleSize  = 0;
+static uint32_t  g_moduleStamp = 0;
 
-static bool GetMainModule(uintptr_t& base, size_t& imageSize) {
+static bool GetMainModule(uintptr_t& base, size_t& imageSize, uint32_t& timeStamp) {
     base = (uintptr_t)GetModuleHandleA(nullptr);
     if (!base) return false;
 
@@ -25,6 +29,7 @@ static bool GetMainModule(uintptr_t& base, size_t& imageSize) {
     if (nt->Signature != IMAGE_NT_SIGNATURE) return false;
 
     imageSize = nt->OptionalHeader.SizeOfImage;
+    timeStamp = nt->FileHeader.TimeDateStamp;
     return true;
 }
 
@@ -106,18 +111,20 @@ static bool ValidateGUObjectArray(uintptr_t candidate) {
     if (candidate >= g_moduleBase + g_moduleSize + 0x20000000)
         return false;
 
-    // If the array IS populated, do a sanity check
+    // If the array IS populated, do a sanity check.  The candidate comes
+    // from a pattern match, so every read is probed.
     uintptr_t objArrayBase = candidate + GUObjOff::ObjObjects;
-    int32_t numElements  = ReadAt<int32_t>(objArrayBase, TObjOff::NumElements);
-    int32_t numChunks    = ReadAt<int32_t>(objArrayBase, TObjOff::NumChunks);
+    int32_t numElements = 0, numChunks = 0;
+    if (!TryRead(objArrayBase, TObjOff::NumElements, numElements) ||
+        !TryRead(objArrayBase, TObjOff::NumChunks, numChunks))
+        return false;
 
     if (numElements > 0) {
         // Array is populated — validate consistency
         if (numElements > 10000000 || numChunks <= 0 || numChunks > 500)
             return false;
 
-        uintptr_t objectsPtr = ReadAt<uintptr_t>(objArrayBase, TObjOff::Objects);
-        if (objectsPtr == 0) return false;
+        if (!ObjectArrayReadable(objArrayBase)) return false;
     }
     // If numElements == 0, accept the address — patcher will poll until populated
 
@@ -134,6 +141,8 @@ static bool ValidateGUObjectArray(uintptr_t candidate) {
 //   FNameToString_RVA=0x14B13A0     (added to module base)
 // ===================================================================
 static bool ReadFallbackConfig(ScanResults& out) {
+    TRACE_SPAN("ReadFallbackConfig");
+
     char path[MAX_PATH];
     snprintf(path, MAX_PATH, "%s\\socket_save_fix.ini", g_modDir);
 
@@ -183,6 +192,22 @@ static bool ReadFallbackConfig(ScanResults& out) {
             LogMsg("  SignalEntity = 0x%llX (base + RVA 0x%llX)",
                    (unsigned long long)(g_moduleBase + val), val);
         }
+        // Save-side RVAs (save stats, sidecar)
+        if (sscanf(line, "MassSave_RVA=0x%llx", &val) == 1) {
+            out.fnMassSave = g_moduleBase + (uintptr_t)val;
+            LogMsg("  MassSave = 0x%llX (base + RVA 0x%llX)",
+                   (unsigned long long)out.fnMassSave, val);
+        }
+        if (sscanf(line, "SaveDataToSlot_RVA=0x%llx", &val) == 1) {
+            out.fnSaveDataToSlot = g_moduleBase + (uintptr_t)val;
+            LogMsg("  SaveDataToSlot = 0x%llX (base + RVA 0x%llX)",
+                   (unsigned long long)out.fnSaveDataToSlot, val);
+        }
+        if (sscanf(line, "LoadDataFromSlot_RVA=0x%llx", &val) == 1) {
+            out.fnLoadDataFromSlot = g_moduleBase + (uintptr_t)val;
+            LogMsg("  LoadDataFromSlot = 0x%llX (base + RVA 0x%llX)",
+                   (unsigned long long)out.fnLoadDataFromSlot, val);
+        }
     }
     fclose(f);
     return out.guObjectArray != 0 && out.fnNameToString != nullptr;
@@ -272,8 +297,18 @@ bool ScanForEngineSymbols(ScanResults& out) {
     out.fnNameToString     = nullptr;
     out.fnOnPostSaveLoaded = 0;
     out.fnSignalEntity     = nullptr;
-
-    if (!GetMainModule(g_moduleBase, g_moduleSize)) {
+    out.fnMassSave         = 0;
+    out.fnSaveDataToSlot   = 0;
+    out.fnLoadDataFromSlot = 0;
+    out.fromIni            = false;
+    out.buildId            = 0;
+
+    bool moduleOK;
+    {
+        TRACE_SPAN("GetMainModule");
+        moduleOK = GetMainModule(g_moduleBase, g_moduleSize, g_moduleStamp);
+    }
+    if (!moduleOK) {
         LogMsg("ERROR: Cannot get main module info");
         return false;
     }
@@ -281,9 +316,11 @@ bool ScanForEngineSymbols(ScanResults& out) {
            (unsigned long long)g_moduleBase,
            (unsigned long long)g_moduleSize,
            (unsigned long long)(g_moduleSize / (1024 * 1024)));
+    out.buildId = ((uint64_t)g_moduleStamp << 32) | (uint32_t)g_moduleSize;
 
     // ---- Try INI config first (fast, safe, no memory scanning) ----
     if (ReadFallbackConfig(out)) {
+        out.fromIni = true;
         LogMsg("Loaded addresses from INI — skipping AOB scan");
     } else {
         // ---- AOB scan fallback ----
@@ -291,6 +328,8 @@ bool ScanForEngineSymbols(ScanResults& out) {
 
         LogMsg("Scanning for GUObjectArray...");
         for (const auto& pat : guaPatterns) {
+            TRACE_SPAN(pat.name);
+
             ParsedPattern pp;
             if (!ParsePattern(pat.aob, pp)) continue;
 
@@ -319,6 +358,8 @@ bool ScanForEngineSymbols(ScanResults& out) {
 
         LogMsg("Scanning for FName::ToString...");
         for (const auto& pat : fntPatterns) {
+            TRACE_SPAN(pat.name);
+
             uintptr_t match = FindPattern(g_moduleBase, g_moduleSize, pat.aob);
             if (match) {
                 out.fnNameToString = (FNameToStringFn)match;
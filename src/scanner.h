@@ -7,6 +7,11 @@ struct ScanResults {
     FNameToStringFn fnNameToString;     // FName::ToString function pointer
     uintptr_t       fnOnPostSaveLoaded; // UCrMassSaveSubsystem::OnPostSaveLoaded address
     SignalEntityFn  fnSignalEntity;     // UMassSignalSubsystem::SignalEntity function pointer
+    uintptr_t       fnMassSave;         // UCrMassSaveSubsystem save entry (optional, save stats)
+    uintptr_t       fnSaveDataToSlot;   // UGameplayStatics::SaveDataToSlot (optional, save stats)
+    uintptr_t       fnLoadDataFromSlot; // UGameplayStatics::LoadDataFromSlot (optional, ledger reset + sidecar)
+    bool            fromIni;            // addresses came from the INI, not the AOB scan
+    uint64_t        buildId;            // main module PE timestamp << 32 | image size
 };
 
 // Scan the main game module for GUObjectArray and FName::ToString.
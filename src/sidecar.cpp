@@ -0,0 +1,371 @@
+#include "sidecar.h"
+#include "log.h"
+#include "mem.h"
+#include "platform.h"
+#include "trace.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+static constexpr size_t INITIAL_CAPTURE_BYTES = 1024 * 1024;
+
+// ===================================================================
+// CRC-32 (IEEE, reflected)
+// ===================================================================
+
+static uint32_t g_crcTable[256];
+static bool     g_crcReady = false;
+
+static void CrcInit() {
+    for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        g_crcTable[i] = c;
+    }
+    g_crcReady = true;
+}
+
+static uint32_t Crc32(uint32_t crc, const uint8_t* p, size_t n) {
+    if (!g_crcReady) CrcInit();
+    crc = ~crc;
+    while (n--) crc = g_crcTable[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+uint32_t SidecarSaveSample(const uint8_t* data, int64_t size) {
+    if (!data || size <= 0) return 0;
+    size_t n = (size_t)size;
+    if (n <= 2 * SIDECAR_SAMPLE_BYTES) return Crc32(0, data, n);
+
+    uint32_t crc = Crc32(0, data, SIDECAR_SAMPLE_BYTES);
+    return Crc32(crc, data + n - SIDECAR_SAMPLE_BYTES, SIDECAR_SAMPLE_BYTES);
+}
+
+static uint32_t HeaderCrc(const SidecarHeader& h) {
+    SidecarHeader copy = h;
+    copy.headerCrc = 0;
+    return Crc32(0, (const uint8_t*)&copy, sizeof(copy));
+}
+
+// ===================================================================
+// Capture
+//
+// A snapshot is built on the game thread and published through
+// g_pending.  Whoever swaps it out of g_pending owns it: the slot writer
+// (possibly an async save thread) to write and free it, or the next
+// capture to free a snapshot nobody took.
+// ===================================================================
+
+struct SidecarSnapshot {
+    uint32_t saveId;
+    uint8_t* data;          // payload: entity records and their sockets
+    size_t   size;
+    size_t   cap;
+    int32_t  entities;
+    int64_t  sockets;
+    bool     outOfMemory;
+};
+
+static std::atomic<SidecarSnapshot*> g_pending{nullptr};
+
+static void SnapshotFree(SidecarSnapshot* s) {
+    if (!s) return;
+    MemFree(MEM_SIDECAR, s->data, s->cap);
+    MemFree(MEM_SIDECAR, s, sizeof(*s));
+}
+
+static uint8_t* CaptureReserve(SidecarSnapshot& b, size_t bytes) {
+    if (b.size + bytes > b.cap) {
+        size_t cap = b.cap ? b.cap : INITIAL_CAPTURE_BYTES;
+        while (cap < b.size + bytes) cap *= 2;
+        uint8_t* grown = (uint8_t*)MemAlloc(MEM_SIDECAR, cap);
+        if (!grown) {
+            b.outOfMemory = true;
+            return nullptr;
+        }
+        if (b.data) {
+            memcpy(grown, b.data, b.size);
+            MemFree(MEM_SIDECAR, b.data, b.cap);
+        }
+        b.data = grown;
+        b.cap  = cap;
+    }
+    uint8_t* p = b.data + b.size;
+    b.size += bytes;
+    return p;
+}
+
+static void CaptureEntity(void* ctx, FMassEntityHandle h, uintptr_t sockFrag, uintptr_t) {
+    SidecarSnapshot& snap = *(SidecarSnapshot*)ctx;
+
+    uintptr_t sockets;
+    int32_t numSockets;
+    if (!ReadSocketArray(sockFrag, sockets, numSockets)) return;
+
+    uint8_t* p = CaptureReserve(snap, sizeof(SidecarEntity) +
+                                      (size_t)numSockets * sizeof(SidecarSocket));
+    if (!p) return;
+
+    SidecarEntity e = { h, numSockets, 0 };
+    memcpy(p, &e, sizeof(e));
+
+    SidecarSocket* out = (SidecarSocket*)(p + sizeof(SidecarEntity));
+    for (int32_t k = 0; k < numSockets; ++k) {
+        uintptr_t sock = sockets + (uintptr_t)k * SocketOff::Size;
+        SidecarSocket s;
+        s.connected = ReadAt<FMassEntityHandle>(sock, SocketOff::ConnectedEntity);
+        for (int i = 0; i < 3; ++i)
+            s.location[i] = ReadAt<double>(sock, SocketOff::Location + (size_t)i * sizeof(double));
+        memcpy(&out[k], &s, sizeof(s));
+    }
+
+    snap.entities++;
+    snap.sockets += numSockets;
+}
+
+int SidecarCapture(uint32_t saveId, const EntityArray& entities,
+                   uintptr_t socketsStruct, uintptr_t connectionStruct)
+{
+    TRACE_SPAN("SidecarCapture");
+
+    // An earlier save's snapshot is of no use to this one
+    SidecarDiscard();
+
+    SidecarSnapshot* snap = (SidecarSnapshot*)MemAlloc(MEM_SIDECAR, sizeof(SidecarSnapshot));
+    if (!snap) {
+        LogMsg("  Sidecar: capture failed (out of memory)");
+        return -1;
+    }
+    snap->saveId = saveId;
+
+    int archetypes = WalkSocketEntities(entities, socketsStruct, connectionStruct,
+                                        CaptureEntity, snap);
+    if (archetypes < 0 || snap->outOfMemory) {
+        LogMsg("  Sidecar: capture failed (%s)",
+               archetypes < 0 ? "layout validation failed" : "out of memory");
+        SnapshotFree(snap);
+        return -1;
+    }
+    if (!snap->data) CaptureReserve(*snap, 0);  // no socket entities: empty payload
+
+    int captured = snap->entities;
+    SnapshotFree(g_pending.exchange(snap, std::memory_order_acq_rel));
+    return captured;
+}
+
+SidecarSnapshot* SidecarTake(uint32_t saveId) {
+    SidecarSnapshot* snap = g_pending.exchange(nullptr, std::memory_order_acq_rel);
+    if (!snap || snap->saveId == saveId) return snap;
+
+    // Another save's: put it back, unless a newer one has been captured
+    SidecarSnapshot* expected = nullptr;
+    if (!g_pending.compare_exchange_strong(expected, snap, std::memory_order_acq_rel))
+        SnapshotFree(snap);
+    return nullptr;
+}
+
+void SidecarDiscard() {
+    SnapshotFree(g_pending.exchange(nullptr, std::memory_order_acq_rel));
+}
+
+bool SidecarWrite(SidecarSnapshot* snap, const char* path,
+                  int64_t saveBytes, uint32_t saveSample)
+{
+    TRACE_SPAN("SidecarWrite");
+
+    if (!snap) return false;
+
+    SidecarHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic      = SIDECAR_MAGIC;
+    h.version    = SIDECAR_VERSION;
+    h.headerSize = (uint16_t)sizeof(SidecarHeader);
+    h.socketSize = (uint32_t)sizeof(SidecarSocket);
+    h.entities   = snap->entities;
+    h.sockets    = snap->sockets;
+    h.saveBytes  = saveBytes;
+    h.saveSample = saveSample;
+    h.payloadCrc = Crc32(0, snap->data, snap->size);
+    h.headerCrc  = HeaderCrc(h);
+
+    // Write to a temporary name and rename, so a crash mid-write never
+    // leaves a truncated sidecar under the real name
+    char tmp[1024];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    FILE* f = fopen(tmp, "wb");
+    bool ok = f != nullptr;
+    if (ok) {
+        ok = fwrite(&h, sizeof(h), 1, f) == 1 &&
+             (snap->size == 0 || fwrite(snap->data, snap->size, 1, f) == 1);
+        ok = (fclose(f) == 0) && ok;
+    }
+    if (ok) {
+        remove(path);
+        ok = rename(tmp, path) == 0;
+    }
+    if (!ok) {
+        remove(tmp);
+        LogMsg("  Sidecar: could not write %s", path);
+    } else {
+        LogMsg("  Sidecar: %d entities, %lld sockets -> %s (%.2f MB)", h.entities,
+               (long long)h.sockets, path,
+               (double)(sizeof(h) + snap->size) / (1024.0 * 1024.0));
+    }
+
+    SnapshotFree(snap);
+    return ok;
+}
+
+// ===================================================================
+// Open / close
+// ===================================================================
+
+void SidecarClose(Sidecar& sc) {
+    PlatUnmapFile(sc.map, sc.mapSize);
+    memset(&sc, 0, sizeof(sc));
+}
+
+// Walk the records front to back.  With recordOf, index them by entity
+// slot (payload offset + 1, 0 = none); without, only check that every
+// record is in bounds and the counts add up.
+static bool ScanRecords(const Sidecar& sc, uint32_t* recordOf, int32_t numSlots) {
+    const uint8_t* base = (const uint8_t*)sc.map;
+    size_t pos = sizeof(SidecarHeader);
+    int64_t sockets = 0;
+
+    for (int32_t i = 0; i < sc.header->entities; ++i) {
+        if (sc.mapSize - pos < sizeof(SidecarEntity)) return false;
+        SidecarEntity e;
+        memcpy(&e, base + pos, sizeof(e));
+        if (e.numSockets <= 0 || e.numSockets > MAX_SOCKETS_PER_ENTITY) return false;
+
+        size_t bytes = sizeof(SidecarEntity) + (size_t)e.numSockets * sizeof(SidecarSocket);
+        if (sc.mapSize - pos < bytes) return false;
+        if (recordOf && e.handle.Index >= 0 && e.handle.Index < numSlots)
+            recordOf[e.handle.Index] = (uint32_t)pos + 1;
+
+        sockets += e.numSockets;
+        pos += bytes;
+    }
+    return pos == sc.mapSize && sockets == sc.header->sockets;
+}
+
+bool SidecarOpen(const char* path, int64_t saveBytes, uint32_t saveSample, Sidecar& out) {
+    TRACE_SPAN("SidecarOpen");
+
+    memset(&out, 0, sizeof(out));
+    out.map = PlatMapFile(path, false, out.mapSize);
+    if (!out.map) {
+        LogMsg("  Sidecar: %s not found", path);
+        return false;
+    }
+
+    // Cheap rejection first: header only
+    const char* why = nullptr;
+    const SidecarHeader* h = (const SidecarHeader*)out.map;
+    if (out.mapSize < sizeof(SidecarHeader) || out.mapSize > 0xFFFFFFFFull ||
+        h->magic != SIDECAR_MAGIC)
+        why = "not a sidecar";
+    else if (h->version != SIDECAR_VERSION || h->headerSize != sizeof(SidecarHeader) ||
+             h->socketSize != sizeof(SidecarSocket))
+        why = "unsupported version";
+    else if (HeaderCrc(*h) != h->headerCrc)
+        why = "header checksum mismatch";
+    else if (h->saveBytes != saveBytes || h->saveSample != saveSample)
+        why = "written for a different save";
+    else if (h->entities < 0 || h->sockets < 0)
+        why = "bad counts";
+
+    if (!why) {
+        const uint8_t* payload = (const uint8_t*)out.map + sizeof(SidecarHeader);
+        if (Crc32(0, payload, out.mapSize - sizeof(SidecarHeader)) != h->payloadCrc)
+            why = "payload checksum mismatch";
+    }
+
+    if (!why) {
+        out.header = h;
+        if (!ScanRecords(out, nullptr, 0)) why = "malformed records";
+    }
+
+    if (why) {
+        LogMsg("  Sidecar: %s rejected (%s)", path, why);
+        SidecarClose(out);
+        return false;
+    }
+
+    LogMsg("  Sidecar: %s accepted (%d entities, %lld sockets)", path, h->entities,
+           (long long)h->sockets);
+    return true;
+}
+
+// ===================================================================
+// Apply
+// ===================================================================
+
+struct ApplyCtx {
+    const Sidecar*     sc;
+    const uint32_t*    recordOf;
+    int32_t            numSlots;
+    SidecarApplyStats* stats;
+};
+
+static void ApplyEntity(void* p, FMassEntityHandle h, uintptr_t sockFrag, uintptr_t) {
+    ApplyCtx& ctx = *(ApplyCtx*)p;
+    if (h.Index < 0 || h.Index >= ctx.numSlots || !ctx.recordOf[h.Index]) return;
+
+    const uint8_t* rec = (const uint8_t*)ctx.sc->map + (ctx.recordOf[h.Index] - 1);
+    SidecarEntity e;
+    memcpy(&e, rec, sizeof(e));
+    if (!SameEntity(e.handle, h)) return;
+    ctx.stats->entities++;
+
+    uintptr_t sockets;
+    int32_t numSockets;
+    if (!ReadSocketArray(sockFrag, sockets, numSockets) || numSockets != e.numSockets) {
+        ctx.stats->shapeMismatch++;
+        return;
+    }
+
+    bool changed = false;
+    const uint8_t* src = rec + sizeof(SidecarEntity);
+    for (int32_t k = 0; k < numSockets; ++k) {
+        SidecarSocket s;
+        memcpy(&s, src + (size_t)k * sizeof(SidecarSocket), sizeof(s));
+        uintptr_t sock = sockets + (uintptr_t)k * SocketOff::Size;
+
+        if (!SameEntity(ReadAt<FMassEntityHandle>(sock, SocketOff::ConnectedEntity), s.connected)) {
+            WriteAt<FMassEntityHandle>(sock, SocketOff::ConnectedEntity, s.connected);
+            changed = true;
+        }
+        for (int i = 0; i < 3; ++i) {
+            size_t off = SocketOff::Location + (size_t)i * sizeof(double);
+            if (ReadAt<double>(sock, off) != s.location[i]) {
+                WriteAt<double>(sock, off, s.location[i]);
+                changed = true;
+            }
+        }
+    }
+    if (changed) ctx.stats->restored++;
+}
+
+int SidecarApply(const Sidecar& sc, const EntityArray& entities,
+                 uintptr_t socketsStruct, uintptr_t connectionStruct,
+                 SidecarApplyStats& stats)
+{
+    TRACE_SPAN("SidecarApply");
+
+    memset(&stats, 0, sizeof(stats));
+    if (!sc.header || entities.num <= 0) return -1;
+
+    const size_t indexBytes = (size_t)entities.num * sizeof(uint32_t);
+    uint32_t* recordOf = (uint32_t*)MemAlloc(MEM_SIDECAR, indexBytes);
+    if (!recordOf) return -1;
+    ScanRecords(sc, recordOf, entities.num);
+
+    ApplyCtx ctx = { &sc, recordOf, entities.num, &stats };
+    int archetypes = WalkSocketEntities(entities, socketsStruct, connectionStruct,
+                                        ApplyEntity, &ctx);
+    MemFree(MEM_SIDECAR, recordOf, indexBytes);
+    return archetypes;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include "sockets.h"
+#include "ue_types.h"
+#include <cstddef>
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Socket sidecar — a binary snapshot of every socket entity's socket
+// state, written next to a save and applied straight back on load, so
+// entities it covers need no rebuild signal.
+//
+//   SidecarHeader                      64 bytes
+//   { SidecarEntity, SidecarSocket[numSockets] } per socket entity
+//
+// Entities are keyed by FMassEntityHandle, which the save restores as is
+// (saved connection data refers to entities the same way).  The header
+// names the save it belongs to by size and a CRC of its first and last
+// SIDECAR_SAMPLE_BYTES, so a stale or foreign sidecar is rejected from
+// the header alone; the payload CRC is only checked once that matches.
+// No OS calls beyond stdio and the platform layer, so the host simulator
+// runs exactly this code.
+// ---------------------------------------------------------------------------
+
+constexpr uint32_t SIDECAR_MAGIC        = 0x53465353;   // "SSFS"
+constexpr uint16_t SIDECAR_VERSION      = 1;
+constexpr size_t   SIDECAR_SAMPLE_BYTES = 64 * 1024;
+
+struct SidecarHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;        // sizeof(SidecarHeader)
+    uint32_t socketSize;        // sizeof(SidecarSocket)
+    int32_t  entities;
+    int64_t  sockets;
+    int64_t  saveBytes;         // size of the save data this belongs to
+    uint32_t saveSample;        // SidecarSaveSample of that data
+    uint32_t payloadCrc;        // CRC-32 of everything after the header
+    uint32_t headerCrc;         // CRC-32 of the header with this field zero
+    uint8_t  reserved[20];
+};
+static_assert(sizeof(SidecarHeader) == 64, "sidecar header layout");
+
+struct SidecarEntity {
+    FMassEntityHandle handle;
+    int32_t           numSockets;
+    int32_t           reserved;
+};
+
+struct SidecarSocket {
+    FMassEntityHandle connected;
+    double            location[3];
+};
+
+// Identity of a save's serialized data: CRC-32 of its head and tail
+uint32_t SidecarSaveSample(const uint8_t* data, int64_t size);
+
+// ---- Save side ----
+
+// A snapshot taken for one save, identified by a caller-chosen nonzero
+// save id.  At most one is pending; the thread that takes it owns it
+// until SidecarWrite frees it.
+struct SidecarSnapshot;
+
+// Snapshot every socket entity into memory (game thread, before the save
+// runs) and make it the pending one, freeing any snapshot of an earlier
+// save that was never taken.  Returns the number of entities captured,
+// or -1.
+int  SidecarCapture(uint32_t saveId, const EntityArray& entities,
+                    uintptr_t socketsStruct, uintptr_t connectionStruct);
+
+// Take the pending snapshot if it was captured for 'saveId' (any
+// thread), or return null and leave it pending.
+SidecarSnapshot* SidecarTake(uint32_t saveId);
+
+// Write a taken snapshot for the save whose data is given, then free it.
+// Returns false if there is no snapshot or the file cannot be written.
+bool SidecarWrite(SidecarSnapshot* snapshot, const char* path,
+                  int64_t saveBytes, uint32_t saveSample);
+
+// Free the pending snapshot, if any
+void SidecarDiscard();
+
+// ---- Load side ----
+
+struct Sidecar {
+    void*                map;
+    size_t               mapSize;
+    const SidecarHeader* header;
+};
+
+struct SidecarApplyStats {
+    int entities;           // socket entities found in the sidecar
+    int restored;           // of which had sockets rewritten
+    int shapeMismatch;      // socket count differs from the sidecar (left to the rebuild)
+};
+
+// Map and validate the sidecar for the save identified by saveBytes /
+// saveSample.  Returns false (and logs why) if the file is missing,
+// stale, foreign or damaged.
+bool SidecarOpen(const char* path, int64_t saveBytes, uint32_t saveSample, Sidecar& out);
+void SidecarClose(Sidecar& sc);
+
+// Index the records by entity slot in one pass over the file, then write
+// the saved socket state of every live socket entity the sidecar holds.
+// Entities whose Sockets array has a different length are left alone
+// for the rebuild.  Returns the number of socket archetypes, or -1.
+int SidecarApply(const Sidecar& sc, const EntityArray& entities,
+                 uintptr_t socketsStruct, uintptr_t connectionStruct,
+                 SidecarApplyStats& stats);
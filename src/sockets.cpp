@@ -0,0 +1,266 @@
+#include "sockets.h"
+#include "log.h"
+#include "trace.h"
+#include <cstring>
+
+// Sanity limits — anything beyond these means the layout guess is wrong
+static constexpr int     MAX_FRAGMENT_CONFIGS   = 256;
+static constexpr int32_t MAX_ENTITIES_PER_CHUNK = 64 * 1024;
+static constexpr int32_t MAX_CHUNKS             = 1024 * 1024;
+static constexpr int32_t MAX_CHUNK_OFFSET       = 1024 * 1024;
+static constexpr int32_t MAX_FRAGMENT_SIZE      = 0x1000;
+
+// ===================================================================
+// Unique archetype set  (open addressing, game thread only)
+// ===================================================================
+
+static constexpr int ARCHETYPE_SET_SIZE = 4096;    // power of two
+static uintptr_t g_archetypes[ARCHETYPE_SET_SIZE];
+static int       g_archetypeCount = 0;
+
+static bool AddArchetype(uintptr_t archetype) {
+    size_t h = (size_t)((archetype >> 4) * 0x9E3779B97F4A7C15ULL) & (ARCHETYPE_SET_SIZE - 1);
+    for (int probe = 0; probe < ARCHETYPE_SET_SIZE; ++probe) {
+        uintptr_t cur = g_archetypes[h];
+        if (cur == archetype) return true;
+        if (cur == 0) {
+            if (g_archetypeCount >= ARCHETYPE_SET_SIZE / 2) return false;
+            g_archetypes[h] = archetype;
+            g_archetypeCount++;
+            return true;
+        }
+        h = (h + 1) & (ARCHETYPE_SET_SIZE - 1);
+    }
+    return false;
+}
+
+// ===================================================================
+// Archetype layout helpers
+// ===================================================================
+
+// FragmentConfigs uses a TInlineAllocator — storage is inline unless the
+// archetype has more fragments than fit and it spilled to the heap.
+static bool FindFragmentOffsets(uintptr_t archetype,
+                                uintptr_t socketsStruct, uintptr_t connectionStruct,
+                                int32_t& sockOff, int32_t& connOff)
+{
+    uintptr_t heap = ReadAt<uintptr_t>(archetype, MassArchetypeOff::FragmentConfigsHeap);
+    int32_t   num  = ReadAt<int32_t>(archetype, MassArchetypeOff::FragmentConfigsNum);
+
+    if (num <= 0 || num > MAX_FRAGMENT_CONFIGS) return false;
+    if (!heap && num > MassArchetypeOff::FragmentConfigInline) return false;
+
+    uintptr_t configs = heap ? heap : archetype + MassArchetypeOff::FragmentConfigs;
+
+    sockOff = -1;
+    connOff = -1;
+    for (int32_t i = 0; i < num; ++i) {
+        uintptr_t cfg  = configs + (uintptr_t)i * MassArchetypeOff::FragmentConfigSize;
+        uintptr_t type = ReadAt<uintptr_t>(cfg, FragmentConfigOff::FragmentType);
+        int32_t   off  = ReadAt<int32_t>(cfg, FragmentConfigOff::ArrayOffset);
+
+        if (type < 0x10000 || off < 0 || off > MAX_CHUNK_OFFSET) return false;
+
+        if (type == socketsStruct)    sockOff = off;
+        if (type == connectionStruct) connOff = off;
+    }
+    return true;
+}
+
+static int32_t StructSize(uintptr_t scriptStruct) {
+    return scriptStruct ? ReadAt<int32_t>(scriptStruct, UStructOff::PropertiesSize) : 0;
+}
+
+// ===================================================================
+// Per-entity check
+//
+// Every saved connection must name a socket that exists and whose live
+// ConnectedEntity matches the saved target.  A junction that lost its
+// socket state after load has an empty or shorter Sockets array, or
+// unconnected sockets where the save says there should be a link.
+// Sockets loaded without a location (compact saves) need the rebuild too.
+// ===================================================================
+
+// 'arms' receives the larger of the live socket count and the saved
+// connection count, so a junction whose Sockets array was wiped is still
+// recognised as a junction.
+static bool SocketsConsistent(uintptr_t sockFrag, uintptr_t connFrag, int32_t& arms) {
+    uintptr_t sockets;
+    int32_t numSockets;
+    ReadSocketArray(sockFrag, sockets, numSockets);
+    arms = numSockets;
+
+    // Sockets from a compact save still need their locations rebuilt
+    for (int32_t k = 0; k < numSockets; ++k)
+        if (!SocketPlaced(sockets + (uintptr_t)k * SocketOff::Size)) return false;
+
+    // No saved connection data — nothing to compare against
+    if (!connFrag) return true;
+
+    uintptr_t conns  = ReadAt<uintptr_t>(connFrag, ConnDataOff::Connections + TArrayOff::Data);
+    int32_t numConns = ReadAt<int32_t>(connFrag, ConnDataOff::Connections + TArrayOff::Num);
+    if (numConns > arms) arms = numConns;
+
+    if (numConns <= 0) return true;
+    if (numConns > MAX_SOCKETS_PER_ENTITY) return false;
+    if (numSockets == 0 || !conns) return false;
+
+    for (int32_t c = 0; c < numConns; ++c) {
+        uintptr_t conn = conns + (uintptr_t)c * ConnOff::Size;
+        int32_t socketIdx = ReadAt<int32_t>(conn, ConnOff::SocketIndex);
+        FMassEntityHandle target = ReadAt<FMassEntityHandle>(conn, ConnOff::Target);
+
+        if (socketIdx < 0 || socketIdx >= numSockets) return false;
+
+        uintptr_t sock = sockets + (uintptr_t)socketIdx * SocketOff::Size;
+        FMassEntityHandle linked = ReadAt<FMassEntityHandle>(sock, SocketOff::ConnectedEntity);
+
+        if (!SameEntity(linked, target)) return false;
+    }
+    return true;
+}
+
+// ===================================================================
+// Socket entity walk
+// ===================================================================
+
+int WalkSocketEntities(const EntityArray& entities,
+                       uintptr_t socketsStruct, uintptr_t connectionStruct,
+                       SocketEntityFn fn, void* ctx)
+{
+    int32_t sockSize = StructSize(socketsStruct);
+    int32_t connSize = StructSize(connectionStruct);
+    if (sockSize <= 0 || sockSize > MAX_FRAGMENT_SIZE ||
+        (connectionStruct && (connSize <= 0 || connSize > MAX_FRAGMENT_SIZE))) {
+        LogMsg("  Verifier: implausible fragment sizes (sockets=%d, connections=%d)",
+               sockSize, connSize);
+        return -1;
+    }
+
+    // ---- Collect the distinct archetypes of all live entities ----
+    memset(g_archetypes, 0, sizeof(g_archetypes));
+    g_archetypeCount = 0;
+
+    {
+        TRACE_SPAN("VerifySockets: slots");
+
+        for (int32_t i = 0; i < entities.num; ++i) {
+            uintptr_t slot = entities.data + (uintptr_t)i * entities.elemSize;
+            if (ReadAt<int32_t>(slot, EntitySlotOff::SerialNumber) <= 0) continue;
+
+            uintptr_t archetype = ReadAt<uintptr_t>(slot, EntitySlotOff::Archetype);
+            if (!archetype) continue;
+
+            if (!AddArchetype(archetype)) {
+                LogMsg("  Verifier: more than %d archetypes", ARCHETYPE_SET_SIZE / 2);
+                return -1;
+            }
+        }
+    }
+
+    // ---- Walk socket-bearing archetypes chunk by chunk ----
+    TRACE_SPAN("VerifySockets: chunks");
+    int archetypes = 0;
+
+    for (int a = 0; a < ARCHETYPE_SET_SIZE; ++a) {
+        uintptr_t archetype = g_archetypes[a];
+        if (!archetype) continue;
+
+        int32_t sockOff, connOff;
+        if (!FindFragmentOffsets(archetype, socketsStruct, connectionStruct, sockOff, connOff)) {
+            LogMsg("  Verifier: archetype 0x%llX has an unexpected FragmentConfigs layout",
+                   (unsigned long long)archetype);
+            return -1;
+        }
+        if (sockOff < 0) continue;
+        archetypes++;
+
+        int32_t perChunk   = ReadAt<int32_t>(archetype, MassArchetypeOff::NumEntitiesPerChunk);
+        int32_t entListOff = ReadAt<int32_t>(archetype, MassArchetypeOff::EntityListOffset);
+        uintptr_t chunks   = ReadAt<uintptr_t>(archetype, MassArchetypeOff::Chunks + TArrayOff::Data);
+        int32_t numChunks  = ReadAt<int32_t>(archetype, MassArchetypeOff::Chunks + TArrayOff::Num);
+
+        if (perChunk <= 0 || perChunk > MAX_ENTITIES_PER_CHUNK ||
+            entListOff < 0 || entListOff > MAX_CHUNK_OFFSET ||
+            numChunks < 0 || numChunks > MAX_CHUNKS || (numChunks > 0 && !chunks)) {
+            LogMsg("  Verifier: archetype 0x%llX failed chunk validation "
+                   "(perChunk=%d, entityList=0x%X, chunks=%d)",
+                   (unsigned long long)archetype, perChunk, entListOff, numChunks);
+            return -1;
+        }
+
+        for (int32_t c = 0; c < numChunks; ++c) {
+            uintptr_t chunk = chunks + (uintptr_t)c * MassChunkOff::Size;
+            uintptr_t raw   = ReadAt<uintptr_t>(chunk, MassChunkOff::RawMemory);
+            int32_t   n     = ReadAt<int32_t>(chunk, MassChunkOff::NumInstances);
+
+            if (n <= 0) continue;
+            if (!raw || n > perChunk) return -1;
+
+            for (int32_t s = 0; s < n; ++s) {
+                FMassEntityHandle h = ReadAt<FMassEntityHandle>(
+                    raw + entListOff, (size_t)s * sizeof(FMassEntityHandle));
+
+                // Skip handles that no longer match their entity slot
+                if (h.Index < 0 || h.Index >= entities.num) continue;
+                uintptr_t slot = entities.data + (uintptr_t)h.Index * entities.elemSize;
+                if (ReadAt<int32_t>(slot, EntitySlotOff::SerialNumber) != h.SerialNumber) continue;
+
+                uintptr_t sockFrag = raw + sockOff + (uintptr_t)s * sockSize;
+                uintptr_t connFrag = (connOff >= 0) ? raw + connOff + (uintptr_t)s * connSize : 0;
+                fn(ctx, h, sockFrag, connFrag);
+            }
+        }
+    }
+
+    return archetypes;
+}
+
+// ===================================================================
+// VerifySockets
+// ===================================================================
+
+bool VerifySocketEntity(uintptr_t sockFrag, uintptr_t connFrag, SocketVerifyStats& stats) {
+    int32_t arms = 0;
+    bool ok = SocketsConsistent(sockFrag, connFrag, arms);
+    bool junction = arms >= JUNCTION_MIN_ARMS;
+
+    stats.entities++;
+    if (junction) stats.junctions++;
+    if (ok) return true;
+
+    stats.broken++;
+    if (junction) stats.brokenJunctions++;
+    return false;
+}
+
+struct VerifyCtx {
+    SocketVerifyStats* stats;
+    FMassEntityHandle* outHandles;
+    int                maxHandles;
+    int                count;
+};
+
+static void VerifyEntity(void* p, FMassEntityHandle h, uintptr_t sockFrag, uintptr_t connFrag) {
+    VerifyCtx& ctx = *(VerifyCtx*)p;
+    if (VerifySocketEntity(sockFrag, connFrag, *ctx.stats)) return;
+    if (ctx.count < ctx.maxHandles) ctx.outHandles[ctx.count++] = h;
+}
+
+int VerifySockets(const EntityArray& entities,
+                  uintptr_t socketsStruct, uintptr_t connectionStruct,
+                  SocketVerifyStats& stats,
+                  FMassEntityHandle* outHandles, int maxHandles)
+{
+    TRACE_SPAN("VerifySockets");
+
+    memset(&stats, 0, sizeof(stats));
+    VerifyCtx ctx = { &stats, outHandles, maxHandles, 0 };
+
+    int archetypes = WalkSocketEntities(entities, socketsStruct, connectionStruct,
+                                        VerifyEntity, &ctx);
+    if (archetypes < 0) return -1;
+
+    stats.archetypes = archetypes;
+    return ctx.count;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include "ue_types.h"
+
+// ---------------------------------------------------------------------------
+// Socket integrity verifier — walks every Mass archetype that carries
+// FCrLogisticsSocketsFragment and compares each entity's live socket links
+// against its saved FCrCustomConnectionData.  Only entities whose links are
+// missing or inconsistent are reported for a rebuild signal.
+// ---------------------------------------------------------------------------
+
+// Repair rules, shared with the offline save tool (tools/ssf_savefix):
+// an entity with at least JUNCTION_MIN_ARMS sockets or saved connections
+// is a junction, and a saved connection is intact when the socket it
+// names links to the same entity it recorded.
+constexpr int32_t JUNCTION_MIN_ARMS = 3;
+
+// Sanity limit on an entity's sockets and saved connections — anything
+// beyond it means the layout guess is wrong
+constexpr int32_t MAX_SOCKETS_PER_ENTITY = 64;
+
+inline bool SameEntity(const FMassEntityHandle& a, const FMassEntityHandle& b) {
+    return a.Index == b.Index && a.SerialNumber == b.SerialNumber;
+}
+
+// Sockets loaded from a compact save (see compact.h) have no location
+// until the rebuild signal restores it from the entity's params.
+inline bool SocketPlaced(uintptr_t sock) {
+    return ReadAt<double>(sock, SocketOff::Location) != 0.0 ||
+           ReadAt<double>(sock, SocketOff::Location + 8) != 0.0 ||
+           ReadAt<double>(sock, SocketOff::Location + 16) != 0.0;
+}
+
+// The entity's Sockets array.  Returns false, with 'num' 0, if it is
+// empty or fails the sanity limit.
+inline bool ReadSocketArray(uintptr_t sockFrag, uintptr_t& data, int32_t& num) {
+    data = ReadAt<uintptr_t>(sockFrag, SocketsFragOff::Sockets + TArrayOff::Data);
+    num  = ReadAt<int32_t>(sockFrag, SocketsFragOff::Sockets + TArrayOff::Num);
+    if (data && num > 0 && num <= MAX_SOCKETS_PER_ENTITY) return true;
+    num = 0;
+    return false;
+}
+
+struct EntityArray {
+    uintptr_t data;         // first entity slot
+    int32_t   num;          // number of slots
+    int32_t   elemSize;     // bytes per slot
+};
+
+struct SocketVerifyStats {
+    int archetypes;         // archetypes carrying the sockets fragment
+    int entities;           // socket-bearing entities checked
+    int junctions;          // of which 3-way / 5-way (>= 3 sockets)
+    int broken;             // entities with missing/inconsistent links
+    int brokenJunctions;    // of which junctions
+};
+
+// Called for every live entity of an archetype that carries the sockets
+// fragment; connFrag is 0 if the archetype has no saved connection data.
+typedef void (*SocketEntityFn)(void* ctx, FMassEntityHandle h,
+                               uintptr_t sockFrag, uintptr_t connFrag);
+
+// Visit every socket-bearing entity, archetype by archetype and chunk by
+// chunk.  Returns the number of socket archetypes, or -1 if an archetype
+// layout failed validation.
+int WalkSocketEntities(const EntityArray& entities,
+                       uintptr_t socketsStruct, uintptr_t connectionStruct,
+                       SocketEntityFn fn, void* ctx);
+
+// Check one entity's links against its saved connections and count it in
+// 'stats' (all but 'archetypes').  Returns true if they are consistent.
+bool VerifySocketEntity(uintptr_t sockFrag, uintptr_t connFrag, SocketVerifyStats& stats);
+
+// Returns the number of broken entity handles written to outHandles, or -1
+// if an archetype layout failed validation (the caller should then fall
+// back to signalling every entity).
+int VerifySockets(const EntityArray& entities,
+                  uintptr_t socketsStruct, uintptr_t connectionStruct,
+                  SocketVerifyStats& stats,
+                  FMassEntityHandle* outHandles, int maxHandles);
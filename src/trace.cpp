@@ -0,0 +1,158 @@
+#include "trace.h"
+#include "ini.h"
+#include "log.h"
+#include "mem.h"
+#include <windows.h>
+#include <atomic>
+#include <cstdio>
+
+extern char g_modDir[];
+
+bool g_traceEnabled = false;
+
+// ===================================================================
+// Event ring  (fixed capacity, allocated once in TraceInit)
+//
+// Event n goes to slot n % MAX_TRACE_EVENTS, so the buffer holds the
+// most recent spans.  A slot's seq is cleared while its payload is
+// written and then set to n + 1 with a release store; the exporter
+// reads seq with acquire, copies the payload, and keeps the copy only if
+// seq is unchanged and still n + 1.
+// ===================================================================
+
+struct TraceEvent {
+    std::atomic<uint32_t> seq;      // 0 = being written
+    const char*           name;
+    int64_t               start;
+    int64_t               end;
+    uint32_t              tid;
+};
+
+static constexpr uint32_t MAX_TRACE_EVENTS = 16384;
+
+static TraceEvent*           g_events = nullptr;
+static std::atomic<uint32_t> g_eventCount{0};
+static std::atomic<bool>     g_exportRequested{false};
+static int64_t               g_qpcFreq  = 0;
+static int64_t               g_qpcStart = 0;
+
+static void TraceExportTask();
+
+int64_t TraceNow() {
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return t.QuadPart;
+}
+
+void TraceRecord(const char* name, int64_t start, int64_t end) {
+    uint32_t idx = g_eventCount.fetch_add(1, std::memory_order_relaxed);
+    TraceEvent& e = g_events[idx % MAX_TRACE_EVENTS];
+
+    e.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.name  = name;
+    e.start = start;
+    e.end   = end;
+    e.tid   = GetCurrentThreadId();
+    e.seq.store(idx + 1, std::memory_order_release);
+}
+
+// ===================================================================
+// TraceInit — Trace=1 in socket_save_fix.ini turns tracing on
+// ===================================================================
+
+void TraceInit() {
+    char path[MAX_PATH];
+    snprintf(path, MAX_PATH, "%s\\socket_save_fix.ini", g_modDir);
+
+    if (!IniReadInt(path, "Trace", 0)) return;
+
+    g_events = (TraceEvent*)MemAlloc(MEM_TRACE, MAX_TRACE_EVENTS * sizeof(TraceEvent));
+    if (!g_events) {
+        LogMsg("WARNING: Trace buffer allocation failed — tracing disabled");
+        return;
+    }
+
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    g_qpcFreq  = freq.QuadPart;
+    g_qpcStart = TraceNow();
+
+    LogAddTask(TraceExportTask);
+    g_traceEnabled = true;
+    LogMsg("Tracing enabled (%u event ring)", MAX_TRACE_EVENTS);
+}
+
+// ===================================================================
+// TraceExport — Chrome trace_event JSON ("X" complete events, µs)
+// ===================================================================
+
+static void WriteJsonString(FILE* f, const char* s) {
+    fputc('"', f);
+    for (; *s; ++s) {
+        char c = *s;
+        if (c == '"' || c == '\\')  { fputc('\\', f); fputc(c, f); }
+        else if ((unsigned char)c < 0x20) fputc(' ', f);
+        else fputc(c, f);
+    }
+    fputc('"', f);
+}
+
+// Runs on the log writer thread
+static void WriteTraceFile() {
+    char path[MAX_PATH];
+    snprintf(path, MAX_PATH, "%s\\socket_save_fix.trace.json", g_modDir);
+
+    FILE* f = fopen(path, "w");
+    if (!f) {
+        LogMsg("WARNING: Cannot write trace file %s", path);
+        return;
+    }
+
+    uint32_t count = g_eventCount.load(std::memory_order_acquire);
+    uint32_t oldest = count > MAX_TRACE_EVENTS ? count - MAX_TRACE_EVENTS : 0;
+    uint32_t written = 0;
+
+    DWORD pid = GetCurrentProcessId();
+    double usPerTick = 1e6 / (double)g_qpcFreq;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (uint32_t i = oldest; i != count; ++i) {
+        TraceEvent& slot = g_events[i % MAX_TRACE_EVENTS];
+        uint32_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != i + 1) continue;  // still being written, or already reused
+
+        TraceEvent e;
+        e.name  = slot.name;
+        e.start = slot.start;
+        e.end   = slot.end;
+        e.tid   = slot.tid;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq) continue;
+
+        fprintf(f, "%s{\"name\":", first ? "" : ",\n");
+        first = false;
+        WriteJsonString(f, e.name);
+        fprintf(f, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%lu,\"tid\":%u}",
+                (double)(e.start - g_qpcStart) * usPerTick,
+                (double)(e.end - e.start) * usPerTick,
+                pid, e.tid);
+        written++;
+    }
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    LogMsg("Trace: %u spans written to %s%s", written, path,
+           oldest ? " (ring wrapped — oldest spans overwritten)" : "");
+}
+
+static void TraceExportTask() {
+    if (g_exportRequested.exchange(false, std::memory_order_acquire))
+        WriteTraceFile();
+}
+
+void TraceExport() {
+    if (g_traceEnabled)
+        g_exportRequested.store(true, std::memory_order_release);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Span tracing — RAII spans timestamped with QueryPerformanceCounter and
+// recorded into a preallocated ring (the most recent 16K spans), exported as Chrome trace_event JSON
+// (socket_save_fix.trace.json next to the log; open in chrome://tracing or
+// ui.perfetto.dev).  Enabled with Trace=1 in socket_save_fix.ini.
+//
+// When tracing is disabled a span costs one test of g_traceEnabled.
+// Span names must be string literals or otherwise outlive the process.
+// ---------------------------------------------------------------------------
+
+extern bool g_traceEnabled;
+
+// Read Trace= from the INI and allocate the event buffer.  Call once,
+// after g_modDir is set and before any spans are opened.
+void TraceInit();
+
+// Ask the log writer thread to write the spans in the ring to the trace
+// file (overwrites it).  Returns at once; the file is written on the
+// writer's next pass.
+void TraceExport();
+
+int64_t TraceNow();
+void    TraceRecord(const char* name, int64_t start, int64_t end);
+
+struct TraceSpan {
+    const char* name;
+    int64_t     start;
+
+    explicit TraceSpan(const char* n) : name(n), start(g_traceEnabled ? TraceNow() : 0) {}
+    ~TraceSpan() { if (start) TraceRecord(name, start, TraceNow()); }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b)  TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(name)    TraceSpan TRACE_CONCAT(traceSpan_, __LINE__)(name)
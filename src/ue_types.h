@@ -18,14 +18,21 @@ inline void WriteAt(uintptr_t base, size_t off, T val) {
 
 // ---------------------------------------------------------------------------
 // UObjectBase  (total size 0x28)
+//   +0x08  EObjectFlags ObjectFlags   (int32)
+//   +0x0C  int32    InternalIndex     (slot in GUObjectArray)
 //   +0x10  UClass*  ClassPrivate
 //   +0x18  FName    NamePrivate   (8 bytes)
+//   +0x20  UObject* OuterPrivate
 // ---------------------------------------------------------------------------
 namespace UObjOff {
+    constexpr size_t ObjectFlags   = 0x08;
+    constexpr size_t InternalIndex = 0x0C;
     constexpr size_t ClassPrivate  = 0x10;
     constexpr size_t NamePrivate   = 0x18;
     constexpr size_t OuterPrivate  = 0x20;
 }
+constexpr uint32_t RF_BeginDestroyed  = 0x00008000;
+constexpr uint32_t RF_FinishDestroyed = 0x00010000;
 
 // ---------------------------------------------------------------------------
 // UStruct  (total size 0xB0)
@@ -46,6 +53,38 @@ namespace UStructOff {
     constexpr size_t PropertiesSize  = 0x58;
 }
 
+// ---------------------------------------------------------------------------
+// FField  (UStruct::ChildProperties is a singly linked list of these)
+//   +0x08  FFieldClass*    ClassPrivate    (FFieldClass +0x00: FName Name,
+//                                           e.g. "NameProperty")
+//   +0x20  FField*         Next
+//   +0x28  FName           NamePrivate
+//
+// FProperty : FField
+//   +0x38  int32           ArrayDim
+//   +0x3C  int32           ElementSize
+//   +0x40  EPropertyFlags  PropertyFlags   (uint64)
+//   +0x4C  int32           Offset_Internal (offset in the owning struct)
+//
+// CPF_SkipSerialization makes tagged serialization leave the property
+// out; on load it keeps its default value.
+// ---------------------------------------------------------------------------
+namespace FFieldOff {
+    constexpr size_t ClassPrivate = 0x08;
+    constexpr size_t Next         = 0x20;
+    constexpr size_t NamePrivate  = 0x28;
+}
+namespace FFieldClassOff {
+    constexpr size_t Name = 0x00;
+}
+namespace FPropertyOff {
+    constexpr size_t ArrayDim       = 0x38;
+    constexpr size_t ElementSize    = 0x3C;
+    constexpr size_t PropertyFlags  = 0x40;
+    constexpr size_t OffsetInternal = 0x4C;
+}
+constexpr uint64_t CPF_SkipSerialization = 0x0080000000000000ULL;
+
 // ---------------------------------------------------------------------------
 // UScriptStruct  (total size 0xC0)
 //   +0xB0  EStructFlags   StructFlags
@@ -59,10 +98,12 @@ namespace UScriptStructOff {
 // ---------------------------------------------------------------------------
 // FUObjectItem  (0x18 per item)
 //   +0x00  UObjectBase*  Object
+//   +0x10  int32         SerialNumber  (0 until a weak pointer needs one)
 // ---------------------------------------------------------------------------
 namespace ItemOff {
-    constexpr size_t Object = 0x00;
-    constexpr size_t Size   = 0x18;
+    constexpr size_t Object       = 0x00;
+    constexpr size_t SerialNumber = 0x10;
+    constexpr size_t Size         = 0x18;
 }
 
 // ---------------------------------------------------------------------------
@@ -122,3 +163,100 @@ using FNameToStringFn = void (*)(const void* namePtr, FString* out);
 //   void (UMassSignalSubsystem* this, FName signalName, FMassEntityHandle handle)
 // ---------------------------------------------------------------------------
 using SignalEntityFn = void (*)(void* signalSubsystem, FName signalName, FMassEntityHandle handle);
+
+// ---------------------------------------------------------------------------
+// Mass entity slot  (UMassEntitySubsystem entity array, located heuristically
+// by FindEntityArray — element size is 16..32 bytes depending on build)
+//   +0x00  int32                SerialNumber   (0 = free slot)
+//   +0x08  FMassArchetypeData*  Archetype
+// ---------------------------------------------------------------------------
+namespace EntitySlotOff {
+    constexpr size_t SerialNumber = 0x00;
+    constexpr size_t Archetype    = 0x08;
+}
+
+// ---------------------------------------------------------------------------
+// FMassArchetypeData  (native, not reflected — offsets from the current
+// game build and validated at runtime before use)
+//   +0xD8   TArray<FMassArchetypeFragmentConfig, TInlineAllocator<16>> FragmentConfigs
+//             inline storage 16 * 0x10, then secondary heap ptr, Num, Max
+//   +0x1E8  TArray<FMassArchetypeChunk>  Chunks
+//   +0x2D0  int32  NumEntitiesPerChunk
+//   +0x2D8  int32  EntityListOffsetWithinChunk
+//
+// FMassArchetypeFragmentConfig  (0x10)
+//   +0x00  UScriptStruct*  FragmentType
+//   +0x08  int32           ArrayOffsetWithinChunk
+//
+// FMassArchetypeChunk  (0x30)
+//   +0x00  uint8*  RawMemory
+//   +0x0C  int32   NumInstances
+// ---------------------------------------------------------------------------
+namespace MassArchetypeOff {
+    constexpr size_t FragmentConfigs        = 0xD8;
+    constexpr int    FragmentConfigInline   = 16;
+    constexpr size_t FragmentConfigSize     = 0x10;
+    constexpr size_t FragmentConfigsHeap    = FragmentConfigs + FragmentConfigInline * FragmentConfigSize;
+    constexpr size_t FragmentConfigsNum     = FragmentConfigsHeap + 0x08;
+    constexpr size_t Chunks                 = 0x1E8;
+    constexpr size_t NumEntitiesPerChunk    = 0x2D0;
+    constexpr size_t EntityListOffset       = 0x2D8;
+}
+namespace FragmentConfigOff {
+    constexpr size_t FragmentType = 0x00;
+    constexpr size_t ArrayOffset  = 0x08;
+}
+namespace MassChunkOff {
+    constexpr size_t RawMemory    = 0x00;
+    constexpr size_t NumInstances = 0x0C;
+    constexpr size_t Size         = 0x30;
+}
+
+// ---------------------------------------------------------------------------
+// TArray  (16 bytes)
+//   +0x00  T*     Data
+//   +0x08  int32  Num
+//   +0x0C  int32  Max
+// ---------------------------------------------------------------------------
+namespace TArrayOff {
+    constexpr size_t Data = 0x00;
+    constexpr size_t Num  = 0x08;
+    constexpr size_t Max  = 0x0C;
+}
+
+// ---------------------------------------------------------------------------
+// FCrLogisticsSocketsFragment  (runtime socket state, rebuilt by
+// UCrLogisticsSocketsSignalProcessor)
+//   +0x00  TArray<FCrLogisticsSocket>  Sockets
+//
+// FCrLogisticsSocket  (0x28)
+//   +0x00  FMassEntityHandle  ConnectedEntity   ({0,0} = unconnected)
+//   +0x08  FVector            Location          (3 x double, world space)
+// ---------------------------------------------------------------------------
+namespace SocketsFragOff {
+    constexpr size_t Sockets = 0x00;
+}
+namespace SocketOff {
+    constexpr size_t ConnectedEntity = 0x00;
+    constexpr size_t Location        = 0x08;
+    constexpr size_t Size            = 0x28;
+}
+
+// ---------------------------------------------------------------------------
+// FCrCustomConnectionData  (saved connection list)
+//   +0x00  TArray<FCrCustomConnection>  Connections
+//
+// FCrCustomConnection  (0x10)
+//   +0x00  int32              SocketIndex
+//   +0x04  FMassEntityHandle  Target
+//   +0x0C  int32              TargetSocketIndex
+// ---------------------------------------------------------------------------
+namespace ConnDataOff {
+    constexpr size_t Connections = 0x00;
+}
+namespace ConnOff {
+    constexpr size_t SocketIndex       = 0x00;
+    constexpr size_t Target            = 0x04;
+    constexpr size_t TargetSocketIndex = 0x0C;
+    constexpr size_t Size              = 0x10;
+}
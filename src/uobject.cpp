@@ -0,0 +1,81 @@
+#include "uobject.h"
+#include "probe.h"
+#include <atomic>
+#include <cstring>
+
+// ===================================================================
+// FName -> string  (reuses one FString per thread)
+// ===================================================================
+
+// The patch thread resolves names while the detours may be running on
+// the game thread, so each thread fills its own FString
+static thread_local FString t_fstr   = { nullptr, 0, 0 };
+static std::atomic<size_t>  g_fstrBytes{0};     // capacity over all threads
+
+const wchar_t* NameToString(FNameToStringFn fn, uintptr_t namePtr) {
+    int32_t max = t_fstr.Max;
+    t_fstr.Num = 0;
+    fn((const void*)namePtr, &t_fstr);
+    if (t_fstr.Max != max)
+        g_fstrBytes.fetch_add((size_t)(t_fstr.Max - max) * sizeof(wchar_t),
+                              std::memory_order_relaxed);
+    return t_fstr.Data;
+}
+
+size_t NameBufferBytes() {
+    return g_fstrBytes.load(std::memory_order_relaxed);
+}
+
+bool NameEqualsA(FNameToStringFn fn, uintptr_t namePtr, const char* target) {
+    const wchar_t* ws = NameToString(fn, namePtr);
+    if (!ws) return false;
+    size_t tlen = strlen(target);
+    for (size_t i = 0; i < tlen; ++i) {
+        if (ws[i] != (wchar_t)(unsigned char)target[i]) return false;
+    }
+    return ws[tlen] == L'\0';
+}
+
+void WideToNarrow(const wchar_t* ws, char* out, size_t maxLen) {
+    if (!ws) { out[0] = '\0'; return; }
+    size_t i = 0;
+    for (; ws[i] && i + 1 < maxLen; ++i)
+        out[i] = (char)(ws[i] < 128 ? ws[i] : '?');
+    out[i] = '\0';
+}
+
+// ===================================================================
+// Object iteration
+// ===================================================================
+
+bool ObjectArrayReadable(uintptr_t objArrayBase) {
+    uintptr_t objects = 0;
+    int32_t numElements = 0, numChunks = 0;
+    if (!TryRead(objArrayBase, TObjOff::Objects, objects) ||
+        !TryRead(objArrayBase, TObjOff::NumElements, numElements) ||
+        !TryRead(objArrayBase, TObjOff::NumChunks, numChunks))
+        return false;
+
+    if (numElements <= 0 || numChunks <= 0 ||
+        (int64_t)numElements > (int64_t)numChunks * TObjOff::ChunkSize)
+        return false;
+    return ProbeReadable(objects, (size_t)numChunks * sizeof(uintptr_t));
+}
+
+uintptr_t GetObjectItem(uintptr_t objArrayBase, int32_t index) {
+    auto** chunks = ReadAt<uintptr_t**>(objArrayBase, TObjOff::Objects);
+    if (!chunks) return 0;
+
+    int chunkIdx = index / TObjOff::ChunkSize;
+    int itemIdx  = index % TObjOff::ChunkSize;
+
+    uintptr_t chunk = (uintptr_t)chunks[chunkIdx];
+    if (!chunk) return 0;
+
+    return chunk + (uintptr_t)itemIdx * ItemOff::Size;
+}
+
+uintptr_t GetObject(uintptr_t objArrayBase, int32_t index) {
+    uintptr_t item = GetObjectItem(objArrayBase, index);
+    return item ? ReadAt<uintptr_t>(item, ItemOff::Object) : 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "ue_types.h"
+#include <cstddef>
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// UObject helpers shared by the patch modules — FName resolution through
+// FName::ToString and indexed access into the chunked GUObjectArray.
+// ---------------------------------------------------------------------------
+
+// Resolve an FName to its wide string.  The result lives in the calling
+// thread's FString and is overwritten by that thread's next call.
+const wchar_t* NameToString(FNameToStringFn fn, uintptr_t namePtr);
+
+// Compare an FName against an ASCII string.
+bool NameEqualsA(FNameToStringFn fn, uintptr_t namePtr, const char* target);
+
+void WideToNarrow(const wchar_t* ws, char* out, size_t maxLen);
+
+// Capacity of those FStrings, summed over threads.  FName::ToString grows
+// them with the engine's allocator, so the mod cannot free them; they are
+// only reported.
+size_t NameBufferBytes();
+
+// Whether a populated object array's chunk table can be read: the header
+// and every chunk pointer (not the chunks).  Probed, so a wrong
+// objArrayBase never faults.
+bool ObjectArrayReadable(uintptr_t objArrayBase);
+
+// FUObjectItem at 'index' of TUObjectArray (objArrayBase = GUObjectArray +
+// ObjObjects), or 0 if its chunk is not allocated.
+uintptr_t GetObjectItem(uintptr_t objArrayBase, int32_t index);
+
+// UObject* at 'index' of TUObjectArray.
+uintptr_t GetObject(uintptr_t objArrayBase, int32_t index);
@@ -0,0 +1,173 @@
+#include "worlds.h"
+#include "log.h"
+#include "trace.h"
+#include "uobject.h"
+#include <cstring>
+
+static constexpr int       MAX_OUTER_HOPS = 16;
+static constexpr int       TABLE_SIZE     = 16;         // power of two
+static constexpr uintptr_t TOMBSTONE      = 1;          // entry of a torn-down world
+
+struct WorldEntry {
+    uintptr_t world;            // 0 = empty, TOMBSTONE = removed
+    uintptr_t signalSubsystem;
+    uintptr_t entitySubsystem;
+    int32_t   worldIndex;       // GUObjectArray slots the entry is checked against
+    int32_t   signalIndex;
+    int32_t   entityIndex;
+};
+
+static WorldEntry      g_table[TABLE_SIZE] = {};
+static WorldCacheStats g_stats = {};
+
+// Class pointers, learned by name on first match
+static uintptr_t g_worldClass  = 0;
+static uintptr_t g_signalClass = 0;
+static uintptr_t g_entityClass = 0;
+
+void WorldCacheReset() {
+    memset(g_table, 0, sizeof(g_table));
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_worldClass = g_signalClass = g_entityClass = 0;
+}
+
+void WorldCacheGetStats(WorldCacheStats& out) {
+    out = g_stats;
+}
+
+// ===================================================================
+// Object checks
+// ===================================================================
+
+static bool IsClass(FNameToStringFn fn, uintptr_t cls, uintptr_t& known, const char* name) {
+    if (known) return cls == known;
+    if (!cls || !NameEqualsA(fn, cls + UObjOff::NamePrivate, name)) return false;
+    known = cls;
+    return true;
+}
+
+// Whether 'obj' still occupies slot 'index' — reads the object array only,
+// so it is safe on a pointer to an object that is gone
+static bool InSlot(uintptr_t objArrayBase, uintptr_t obj, int32_t index) {
+    int32_t numElements = ReadAt<int32_t>(objArrayBase, TObjOff::NumElements);
+    return index >= 0 && index < numElements && GetObject(objArrayBase, index) == obj;
+}
+
+static bool WorldAlive(uintptr_t objArrayBase, uintptr_t world, int32_t index) {
+    return InSlot(objArrayBase, world, index) &&
+           (ReadAt<uint32_t>(world, UObjOff::ObjectFlags) &
+            (RF_BeginDestroyed | RF_FinishDestroyed)) == 0;
+}
+
+static uintptr_t OwningWorld(FNameToStringFn fn, uintptr_t obj) {
+    for (int hop = 0; obj && hop < MAX_OUTER_HOPS; ++hop) {
+        if (IsClass(fn, ReadAt<uintptr_t>(obj, UObjOff::ClassPrivate), g_worldClass, "World"))
+            return obj;
+        obj = ReadAt<uintptr_t>(obj, UObjOff::OuterPrivate);
+    }
+    return 0;
+}
+
+// ===================================================================
+// Table: open addressing, linear probing
+// ===================================================================
+
+static int Home(uintptr_t world) {
+    return (int)(((world >> 4) * 0x9E3779B97F4A7C15ULL) >> 60) & (TABLE_SIZE - 1);
+}
+
+static WorldEntry* Lookup(uintptr_t world) {
+    for (int i = 0, slot = Home(world); i < TABLE_SIZE; ++i, slot = (slot + 1) & (TABLE_SIZE - 1)) {
+        WorldEntry& e = g_table[slot];
+        if (e.world == world) return &e;
+        if (e.world == 0) return nullptr;
+    }
+    return nullptr;
+}
+
+static void Insert(const WorldEntry& entry) {
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0, slot = Home(entry.world); i < TABLE_SIZE;
+             ++i, slot = (slot + 1) & (TABLE_SIZE - 1)) {
+            WorldEntry& e = g_table[slot];
+            if (e.world != 0 && e.world != TOMBSTONE) continue;
+            e = entry;
+            g_stats.worlds++;
+            return;
+        }
+
+        // Every slot holds a live world; start over rather than guess which
+        // one is stale
+        memset(g_table, 0, sizeof(g_table));
+        g_stats.worlds = 0;
+    }
+}
+
+static void Evict(WorldEntry& e) {
+    LogMsg("  World 0x%llX torn down — cached subsystems dropped", (unsigned long long)e.world);
+    memset(&e, 0, sizeof(e));
+    e.world = TOMBSTONE;
+    g_stats.worlds--;
+    g_stats.evictions++;
+}
+
+// ===================================================================
+// Resolve
+// ===================================================================
+
+// One object array pass for both subsystems of 'world'
+static void ScanWorld(uintptr_t objArrayBase, FNameToStringFn fn, WorldEntry& e) {
+    g_stats.scans++;
+
+    int32_t numElements = ReadAt<int32_t>(objArrayBase, TObjOff::NumElements);
+    for (int32_t i = 0; i < numElements && !(e.signalSubsystem && e.entitySubsystem); ++i) {
+        uintptr_t obj = GetObject(objArrayBase, i);
+        if (!obj || ReadAt<uintptr_t>(obj, UObjOff::OuterPrivate) != e.world) continue;
+
+        uintptr_t cls = ReadAt<uintptr_t>(obj, UObjOff::ClassPrivate);
+        if (!e.signalSubsystem && IsClass(fn, cls, g_signalClass, "MassSignalSubsystem")) {
+            e.signalSubsystem = obj;
+            e.signalIndex = i;
+        } else if (!e.entitySubsystem && IsClass(fn, cls, g_entityClass, "MassEntitySubsystem")) {
+            e.entitySubsystem = obj;
+            e.entityIndex = i;
+        }
+    }
+}
+
+bool ResolveWorldSubsystems(uintptr_t objArrayBase, FNameToStringFn fn,
+                            uintptr_t obj, WorldSubsystems& out)
+{
+    TRACE_SPAN("ResolveWorldSubsystems");
+    memset(&out, 0, sizeof(out));
+
+    uintptr_t world = OwningWorld(fn, obj);
+    if (!world) return false;
+
+    if (WorldEntry* e = Lookup(world)) {
+        if (WorldAlive(objArrayBase, e->world, e->worldIndex) &&
+            InSlot(objArrayBase, e->signalSubsystem, e->signalIndex) &&
+            InSlot(objArrayBase, e->entitySubsystem, e->entityIndex)) {
+            g_stats.hits++;
+            out = { e->world, e->signalSubsystem, e->entitySubsystem };
+            return true;
+        }
+        Evict(*e);
+    }
+
+    WorldEntry e = {};
+    e.world      = world;
+    e.worldIndex = ReadAt<int32_t>(world, UObjOff::InternalIndex);
+    if (!WorldAlive(objArrayBase, world, e.worldIndex)) return false;
+
+    ScanWorld(objArrayBase, fn, e);
+    out = { world, e.signalSubsystem, e.entitySubsystem };
+
+    LogMsg("  World 0x%llX: UMassSignalSubsystem 0x%llX, UMassEntitySubsystem 0x%llX",
+           (unsigned long long)world, (unsigned long long)e.signalSubsystem,
+           (unsigned long long)e.entitySubsystem);
+
+    // A world still being set up gets scanned again next time
+    if (e.signalSubsystem && e.entitySubsystem) Insert(e);
+    return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "ue_types.h"
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Per-world subsystems — the UMassSignalSubsystem and UMassEntitySubsystem
+// of the world an object belongs to, rather than the first of each in the
+// object array (which, with a main-menu or transition world still alive,
+// can belong to another world).
+//
+// The world is found by walking the object's outer chain to a UWorld.
+// Its subsystems are found with one object array pass the first time and
+// kept in a small hash table keyed on the world.  An entry is checked
+// against the object array on every lookup — the world and both
+// subsystems must still sit in their slots, and the world must not be
+// marked for destruction — so a torn-down world drops out on its next
+// lookup, and a new world at the same address is scanned again.
+// ---------------------------------------------------------------------------
+
+struct WorldSubsystems {
+    uintptr_t world;
+    uintptr_t signalSubsystem;      // UMassSignalSubsystem
+    uintptr_t entitySubsystem;      // UMassEntitySubsystem
+};
+
+struct WorldCacheStats {
+    int32_t worlds;                 // entries held
+    int32_t hits;
+    int32_t scans;                  // object array passes
+    int32_t evictions;              // entries dropped for a torn-down world
+};
+
+// Subsystems of the world that owns 'obj' (e.g. the save subsystem passed
+// to OnPostSaveLoaded).  Returns false if no UWorld is found on its outer
+// chain or the world is being destroyed; a subsystem the world does not
+// have (yet) is left 0 and not cached.
+bool ResolveWorldSubsystems(uintptr_t objArrayBase, FNameToStringFn fn,
+                            uintptr_t obj, WorldSubsystems& out);
+
+// Forget every world and cached class (the object array was rebuilt).
+void WorldCacheReset();
+
+void WorldCacheGetStats(WorldCacheStats& out);
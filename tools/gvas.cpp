@@ -0,0 +1,271 @@
+#include "gvas.h"
+#include <cstdio>
+#include <cstring>
+
+// UE5 object versions that change the property tag layout
+static constexpr int32_t VER_UE5_PROPERTY_TAG_EXTENSION          = 1011;
+static constexpr int32_t VER_UE5_PROPERTY_TAG_COMPLETE_TYPE_NAME = 1012;
+
+// EPropertyTagFlags (UE 5.4+)
+static constexpr uint8_t TAG_HAS_ARRAY_INDEX    = 0x01;
+static constexpr uint8_t TAG_HAS_PROPERTY_GUID  = 0x02;
+static constexpr uint8_t TAG_HAS_EXTENSIONS     = 0x04;
+static constexpr uint8_t TAG_BINARY_OR_NATIVE   = 0x08;
+static constexpr uint8_t TAG_BOOL_TRUE          = 0x10;
+
+// EPropertyTagExtension
+static constexpr uint8_t EXT_OVERRIDABLE_INFO   = 0x02;
+
+static constexpr int32_t MAX_STRING_LEN   = 64 * 1024;
+static constexpr int     MAX_TYPE_NODES   = 64;
+static constexpr int32_t MAX_TYPE_PARAMS  = 16;
+static constexpr int32_t MAX_CUSTOM_VERSIONS = 4096;
+
+// ===================================================================
+// Primitive reads
+// ===================================================================
+
+static bool Need(GvasReader& r, size_t n) {
+    if (!r.ok || n > r.end - r.pos) {
+        r.ok = false;
+        return false;
+    }
+    return true;
+}
+
+template<typename T>
+static T Read(GvasReader& r) {
+    T v = {};
+    if (Need(r, sizeof(T))) {
+        memcpy(&v, r.data + r.pos, sizeof(T));
+        r.pos += sizeof(T);
+    }
+    return v;
+}
+
+static void Skip(GvasReader& r, size_t n) {
+    if (Need(r, n)) r.pos += n;
+}
+
+// FString: int32 length including the terminator, negative for UTF-16.
+// Non-ASCII characters come out as '?', which is fine for type and
+// property names.  'out' may be null to skip.
+static void ReadString(GvasReader& r, char* out, size_t outSize) {
+    if (out) out[0] = '\0';
+    int32_t len = Read<int32_t>(r);
+    if (!r.ok || len == 0) return;
+    if (len < -MAX_STRING_LEN || len > MAX_STRING_LEN) {
+        r.ok = false;
+        return;
+    }
+
+    bool wide = len < 0;
+    size_t chars = (size_t)(wide ? -len : len);
+    size_t bytes = chars * (wide ? 2 : 1);
+    if (!Need(r, bytes)) return;
+
+    const uint8_t* src = r.data + r.pos;
+    r.pos += bytes;
+    if (!out) return;
+
+    size_t n = 0;
+    for (size_t i = 0; i + 1 < chars && n + 1 < outSize; ++i) {
+        uint32_t c = wide ? (uint32_t)(src[i * 2] | (src[i * 2 + 1] << 8)) : src[i];
+        out[n++] = (c >= 0x20 && c < 0x7F) ? (char)c : '?';
+    }
+    out[n] = '\0';
+}
+
+static void CopyName(char* dst, const char* src) {
+    snprintf(dst, GVAS_NAME_MAX, "%s", src);
+}
+
+// ===================================================================
+// Header
+// ===================================================================
+
+bool GvasReadHeader(const uint8_t* data, size_t size, GvasHeader& h) {
+    memset(&h, 0, sizeof(h));
+    GvasReader r = { data, 0, size, 0, true };
+
+    if (Read<uint32_t>(r) != 0x53415647) return false;     // "GVAS"
+
+    h.saveVersion = Read<int32_t>(r);
+    h.ue4Version  = Read<int32_t>(r);
+    if (h.saveVersion >= 3) h.ue5Version = Read<int32_t>(r);
+
+    h.engineMajor = Read<uint16_t>(r);
+    h.engineMinor = Read<uint16_t>(r);
+    h.enginePatch = Read<uint16_t>(r);
+    h.changelist  = Read<uint32_t>(r);
+    ReadString(r, h.branch, sizeof(h.branch));
+
+    if (h.saveVersion >= 2) {
+        Read<int32_t>(r);                                   // custom version format
+        int32_t count = Read<int32_t>(r);
+        if (count < 0 || count > MAX_CUSTOM_VERSIONS) return false;
+        Skip(r, (size_t)count * 20);                        // FGuid + int32
+    }
+
+    ReadString(r, h.saveClass, sizeof(h.saveClass));
+    h.bodyOffset = r.pos;
+    return r.ok;
+}
+
+GvasReader GvasStream(const uint8_t* data, size_t begin, size_t end, const GvasHeader& h) {
+    GvasReader r = { data, begin, end, h.ue5Version, true };
+    return r;
+}
+
+// ===================================================================
+// Property tags
+// ===================================================================
+
+// UE 5.4+ writes the full type as a pre-order tree of (FName, param count):
+// StructProperty(Vector(/Script/CoreUObject)), ArrayProperty(IntProperty),
+// ArrayProperty(StructProperty(CrLogisticsSocket(/Script/Chimera))), ...
+// Only the first parameter chain matters here.
+static void ReadTypeName(GvasReader& r, GvasTag& tag) {
+    char    names[3][GVAS_NAME_MAX] = {};
+    int32_t remaining = 1;          // nodes still to read
+    int     nodes = 0;
+    bool    chain = true;           // still on the first-parameter chain
+
+    while (remaining > 0 && r.ok) {
+        if (++nodes > MAX_TYPE_NODES) {
+            r.ok = false;
+            return;
+        }
+        char name[GVAS_NAME_MAX];
+        ReadString(r, name, sizeof(name));
+        int32_t params = Read<int32_t>(r);
+        if (params < 0 || params > MAX_TYPE_PARAMS) {
+            r.ok = false;
+            return;
+        }
+
+        if (chain && nodes <= 3) CopyName(names[nodes - 1], name);
+        if (params == 0) chain = false;
+        remaining += params - 1;
+    }
+
+    CopyName(tag.type, names[0]);
+    if (strcmp(names[0], "StructProperty") == 0) {
+        CopyName(tag.structName, names[1]);
+    } else if (strcmp(names[0], "ArrayProperty") == 0 || strcmp(names[0], "SetProperty") == 0 ||
+               strcmp(names[0], "MapProperty") == 0) {
+        CopyName(tag.innerType, names[1]);
+        if (strcmp(names[1], "StructProperty") == 0) CopyName(tag.structName, names[2]);
+    }
+}
+
+static void ReadExtensions(GvasReader& r) {
+    uint8_t ext = Read<uint8_t>(r);
+    if (ext & EXT_OVERRIDABLE_INFO) Skip(r, 1);
+}
+
+// Every UE5 save is past VER_UE4_PROPERTY_GUID_IN_PROPERTY_TAG, so the
+// property guid flag is always there
+static void ReadClassicTag(GvasReader& r, GvasTag& tag) {
+    ReadString(r, tag.type, sizeof(tag.type));
+    tag.size = Read<int32_t>(r);
+    Read<int32_t>(r);                                       // array index
+
+    if (strcmp(tag.type, "StructProperty") == 0) {
+        ReadString(r, tag.structName, sizeof(tag.structName));
+        Skip(r, 16);                                        // struct guid
+    } else if (strcmp(tag.type, "BoolProperty") == 0) {
+        tag.boolValue = Read<uint8_t>(r) != 0;
+    } else if (strcmp(tag.type, "ByteProperty") == 0 || strcmp(tag.type, "EnumProperty") == 0) {
+        ReadString(r, nullptr, 0);                          // enum name
+    } else if (strcmp(tag.type, "ArrayProperty") == 0 || strcmp(tag.type, "SetProperty") == 0) {
+        ReadString(r, tag.innerType, sizeof(tag.innerType));
+    } else if (strcmp(tag.type, "MapProperty") == 0) {
+        ReadString(r, tag.innerType, sizeof(tag.innerType));
+        ReadString(r, nullptr, 0);                          // value type
+    }
+
+    if (Read<uint8_t>(r)) Skip(r, 16);
+}
+
+bool GvasReadTag(GvasReader& r, GvasTag& tag) {
+    memset(&tag, 0, sizeof(tag));
+
+    ReadString(r, tag.name, sizeof(tag.name));
+    if (!r.ok) return false;
+    if (strcmp(tag.name, "None") == 0) return false;
+    if (tag.name[0] == '\0') {
+        r.ok = false;
+        return false;
+    }
+
+    if (r.ue5Version >= VER_UE5_PROPERTY_TAG_COMPLETE_TYPE_NAME) {
+        ReadTypeName(r, tag);
+        tag.size = Read<int32_t>(r);
+        uint8_t flags = Read<uint8_t>(r);
+        if (flags & TAG_HAS_ARRAY_INDEX)   Skip(r, 4);
+        if (flags & TAG_HAS_PROPERTY_GUID) Skip(r, 16);
+        if (flags & TAG_HAS_EXTENSIONS)    ReadExtensions(r);
+        tag.boolValue    = (flags & TAG_BOOL_TRUE) != 0;
+        tag.nativeStruct = (flags & TAG_BINARY_OR_NATIVE) != 0;
+    } else {
+        ReadClassicTag(r, tag);
+        if (r.ue5Version >= VER_UE5_PROPERTY_TAG_EXTENSION) ReadExtensions(r);
+    }
+
+    if (!r.ok || tag.size < 0 || (uint64_t)tag.size > r.end - r.pos) {
+        r.ok = false;
+        return false;
+    }
+    tag.valueOffset = r.pos;
+    return true;
+}
+
+void GvasSkipValue(GvasReader& r, const GvasTag& tag) {
+    r.pos = tag.valueOffset + (size_t)tag.size;
+}
+
+// ===================================================================
+// Structs and arrays
+// ===================================================================
+
+bool GvasOpenStructArray(const GvasReader& r, const GvasTag& tag, GvasStructArray& out) {
+    memset(&out, 0, sizeof(out));
+    if (strcmp(tag.type, "ArrayProperty") != 0 || strcmp(tag.innerType, "StructProperty") != 0)
+        return false;
+
+    GvasReader a = r;
+    a.pos = tag.valueOffset;
+    a.end = tag.valueOffset + (size_t)tag.size;
+
+    out.count = Read<int32_t>(a);
+    if (!a.ok || out.count < 0) return false;
+
+    if (a.ue5Version >= VER_UE5_PROPERTY_TAG_COMPLETE_TYPE_NAME) {
+        CopyName(out.structName, tag.structName);
+    } else {
+        GvasTag inner;
+        if (!GvasReadTag(a, inner) || strcmp(inner.type, "StructProperty") != 0) return false;
+        CopyName(out.structName, inner.structName);
+    }
+
+    out.first = a.pos;
+    out.end   = a.end;
+    return true;
+}
+
+bool GvasSkipTaggedStruct(GvasReader& r) {
+    GvasTag tag;
+    while (GvasReadTag(r, tag)) GvasSkipValue(r, tag);
+    return r.ok;
+}
+
+bool GvasFindProperty(GvasReader& r, size_t begin, size_t end, const char* name, GvasTag& tag) {
+    r.pos = begin;
+    r.end = end;
+    while (GvasReadTag(r, tag)) {
+        if (strcmp(tag.name, name) == 0) return true;
+        GvasSkipValue(r, tag);
+    }
+    return false;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// ---------------------------------------------------------------------------
+// Streaming reader for UE save-game files (GVAS) — the header, then the
+// tagged property stream, read tag by tag straight out of a mapped file.
+// Nothing is copied or built up: callers walk tags, skip the values they
+// do not care about and keep file offsets for the ones they do.
+//
+// Both property tag layouts are handled: the classic one (type name plus
+// per-type extras, UE4 through 5.3) and the complete type name tree of
+// UE 5.4+.  Compressed saves are not.
+// ---------------------------------------------------------------------------
+
+constexpr int GVAS_NAME_MAX = 128;
+
+struct GvasHeader {
+    int32_t  saveVersion;
+    int32_t  ue4Version;
+    int32_t  ue5Version;
+    uint16_t engineMajor, engineMinor, enginePatch;
+    uint32_t changelist;
+    char     branch[GVAS_NAME_MAX];
+    char     saveClass[GVAS_NAME_MAX];
+    size_t   bodyOffset;            // first property tag
+};
+
+// Bounds-checked cursor over [data, data + end).  Any read past 'end'
+// clears 'ok' and returns zeros; callers check 'ok' once per step.
+struct GvasReader {
+    const uint8_t* data;
+    size_t         pos;
+    size_t         end;
+    int32_t        ue5Version;      // selects the tag layout
+    bool           ok;
+};
+
+struct GvasTag {
+    char    name[GVAS_NAME_MAX];
+    char    type[GVAS_NAME_MAX];        // IntProperty, StructProperty, ...
+    char    structName[GVAS_NAME_MAX];  // StructProperty, or an array / set of them
+    char    innerType[GVAS_NAME_MAX];   // ArrayProperty / SetProperty / MapProperty key
+    int64_t size;                       // value bytes
+    size_t  valueOffset;                // file offset of the value
+    bool    boolValue;                  // BoolProperty keeps its value in the tag
+    bool    nativeStruct;               // UE 5.4+: struct value is binary, not tagged
+};
+
+bool GvasReadHeader(const uint8_t* data, size_t size, GvasHeader& h);
+
+// Reader positioned on a tagged property stream in [begin, end)
+GvasReader GvasStream(const uint8_t* data, size_t begin, size_t end, const GvasHeader& h);
+
+// Read the tag at r.pos and leave r.pos on its value.  Returns false at
+// the "None" terminator (r.ok stays true) or on malformed input (r.ok
+// false).
+bool GvasReadTag(GvasReader& r, GvasTag& tag);
+
+// Move past the value of 'tag'
+void GvasSkipValue(GvasReader& r, const GvasTag& tag);
+
+// Struct elements of an ArrayProperty of StructProperty.  Classic saves
+// put one more tag in front of the elements; 'first' is the offset of
+// element 0 and the elements end at 'end'.
+struct GvasStructArray {
+    int32_t count;
+    size_t  first;
+    size_t  end;
+    char    structName[GVAS_NAME_MAX];
+};
+
+bool GvasOpenStructArray(const GvasReader& r, const GvasTag& tag, GvasStructArray& out);
+
+// Walk the tagged struct at r.pos through its "None" terminator.  Returns
+// false if the bytes there are not a well-formed tag stream (native
+// structs are not); r.pos is then unspecified.
+bool GvasSkipTaggedStruct(GvasReader& r);
+
+// First tag named 'name' in the tagged struct [begin, end).  r is
+// narrowed to that range and left on the value.
+bool GvasFindProperty(GvasReader& r, size_t begin, size_t end, const char* name, GvasTag& tag);
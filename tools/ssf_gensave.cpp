@@ -0,0 +1,521 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// ssf_gensave — write a synthetic StarRupture save (GVAS) with known
+// breaks, for exercising ssf_savefix and measuring save sizes.
+//
+// Every entity gets a handle, a location and a flag; 70% also get a
+// sockets fragment and a connection list with 1, 2, 3 or 5 arms.  A
+// quarter of those have links zeroed the way a broken load leaves them,
+// and a few junctions have their sockets array cut short, which the
+// repair cannot fix.  What ssf_savefix should find is printed as the
+// "truth" line.
+//
+//   ssf_gensave [--ue5 VER] [--layout direct|wrapped|blob|parallel]
+//               [--entities N] [--seed S] [--compact] [--compressed] OUT
+//
+// --ue5 selects the tag layout: 1012 and up write UE 5.4 type name trees,
+// older versions the classic per-type extras (1011 with the extension
+// byte).  Layouts place the two fragments of an entity:
+//   direct    as struct properties of the entity
+//   wrapped   as InstancedStruct "Value"s in a fragment array
+//   blob      inside a ByteProperty array (opaque to a tag reader)
+//   parallel  in two save-wide arrays, not inside the entity
+// --compact leaves socket locations out, as CompactSockets=1 saves do.
+// --compressed frames the output as a compressed save (stored, not
+// actually compressed), which ssf_savefix must refuse.
+// ---------------------------------------------------------------------------
+
+static constexpr int32_t VER_UE5_PROPERTY_TAG_EXTENSION          = 1011;
+static constexpr int32_t VER_UE5_PROPERTY_TAG_COMPLETE_TYPE_NAME = 1012;
+
+static constexpr uint8_t TAG_BINARY_OR_NATIVE   = 0x08;
+static constexpr uint8_t TAG_BOOL_TRUE          = 0x10;
+
+static constexpr uint32_t GVAS_MAGIC            = 0x53415647;     // "GVAS"
+static constexpr uint64_t PACKAGE_FILE_TAG      = 0x9E2A83C1;     // compressed chunk
+static constexpr uint64_t COMPRESSION_CHUNK     = 128 * 1024;
+
+static const char* const PACKAGE = "/Script/Chimera";
+
+enum Layout { LAYOUT_DIRECT, LAYOUT_WRAPPED, LAYOUT_BLOB, LAYOUT_PARALLEL };
+static const char* const LAYOUT_NAMES[] = { "direct", "wrapped", "blob", "parallel" };
+
+static int32_t g_ue5 = VER_UE5_PROPERTY_TAG_COMPLETE_TYPE_NAME;
+static bool    g_typeTrees = true;
+static bool    g_compact = false;
+
+// ===================================================================
+// Deterministic RNG  (xorshift32, as the simulator's)
+// ===================================================================
+
+static uint32_t g_rng = 1;
+
+static uint32_t Rand() {
+    uint32_t x = g_rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return g_rng = x;
+}
+
+static bool Chance(int pct) {
+    return (int)(Rand() % 100) < pct;
+}
+
+// ===================================================================
+// Output buffer
+//
+// Tag sizes come before their values, so everything is built in memory
+// and each size patched once its value is complete.
+// ===================================================================
+
+struct Buffer {
+    uint8_t* data;
+    size_t   size;
+    size_t   cap;
+    bool     ok;
+};
+
+static void Put(Buffer& b, const void* p, size_t n) {
+    if (!b.ok) return;
+    if (b.size + n > b.cap) {
+        size_t cap = b.cap ? b.cap : 1 << 20;
+        while (cap < b.size + n) cap *= 2;
+        uint8_t* grown = (uint8_t*)realloc(b.data, cap);
+        if (!grown) {
+            b.ok = false;
+            return;
+        }
+        b.data = grown;
+        b.cap = cap;
+    }
+    memcpy(b.data + b.size, p, n);
+    b.size += n;
+}
+
+template<typename T>
+static void Put(Buffer& b, T v) {
+    Put(b, &v, sizeof(T));
+}
+
+template<typename T>
+static void PatchAt(Buffer& b, size_t at, T v) {
+    if (b.ok) memcpy(b.data + at, &v, sizeof(T));
+}
+
+static void PutZeros(Buffer& b, size_t n) {
+    static const uint8_t zeros[16] = {};
+    for (; n > sizeof(zeros); n -= sizeof(zeros)) Put(b, zeros, sizeof(zeros));
+    Put(b, zeros, n);
+}
+
+// FString, ASCII, with its terminator
+static void PutString(Buffer& b, const char* s) {
+    int32_t len = (int32_t)strlen(s) + 1;
+    Put(b, len);
+    Put(b, s, (size_t)len);
+}
+
+// ===================================================================
+// Property tags
+// ===================================================================
+
+struct Mark {
+    size_t sizeAt;              // int32 value size in the tag
+    size_t valueAt;             // first value byte
+};
+
+struct ArrayMark {
+    Mark   tag;
+    size_t countAt;
+    Mark   inner;               // classic layout: the element type tag
+    int32_t count;
+};
+
+// UE 5.4+ type name node: name, then the number of parameter nodes
+static void PutTypeNode(Buffer& b, const char* name, int32_t params) {
+    PutString(b, name);
+    Put(b, params);
+}
+
+static Mark BeginTag(Buffer& b, const char* name, const char* type, const char* structName,
+                     const char* inner, bool native, bool boolValue) {
+    Mark m;
+    PutString(b, name);
+    if (g_typeTrees) {
+        if (strcmp(type, "StructProperty") == 0) {
+            PutTypeNode(b, type, 1);
+            PutTypeNode(b, structName, 1);
+            PutTypeNode(b, PACKAGE, 0);
+        } else if (inner && strcmp(inner, "StructProperty") == 0) {
+            PutTypeNode(b, type, 1);
+            PutTypeNode(b, inner, 1);
+            PutTypeNode(b, structName, 1);
+            PutTypeNode(b, PACKAGE, 0);
+        } else if (inner) {
+            PutTypeNode(b, type, 1);
+            PutTypeNode(b, inner, 0);
+        } else {
+            PutTypeNode(b, type, 0);
+        }
+        m.sizeAt = b.size;
+        Put<int32_t>(b, 0);
+        Put<uint8_t>(b, (native ? TAG_BINARY_OR_NATIVE : 0) | (boolValue ? TAG_BOOL_TRUE : 0));
+    } else {
+        PutString(b, type);
+        m.sizeAt = b.size;
+        Put<int32_t>(b, 0);
+        Put<int32_t>(b, 0);                     // array index
+        if (strcmp(type, "StructProperty") == 0) {
+            PutString(b, structName);
+            PutZeros(b, 16);                    // struct guid
+        } else if (strcmp(type, "BoolProperty") == 0) {
+            Put<uint8_t>(b, boolValue ? 1 : 0);
+        } else if (inner) {
+            PutString(b, inner);
+        }
+        Put<uint8_t>(b, 0);                     // no property guid
+        if (g_ue5 >= VER_UE5_PROPERTY_TAG_EXTENSION) Put<uint8_t>(b, 0);
+    }
+    m.valueAt = b.size;
+    return m;
+}
+
+static void EndTag(Buffer& b, const Mark& m) {
+    PatchAt<int32_t>(b, m.sizeAt, (int32_t)(b.size - m.valueAt));
+}
+
+static void PutNone(Buffer& b) {
+    PutString(b, "None");
+}
+
+static void PutInt(Buffer& b, const char* name, int32_t v) {
+    Mark m = BeginTag(b, name, "IntProperty", nullptr, nullptr, false, false);
+    Put(b, v);
+    EndTag(b, m);
+}
+
+static void PutBool(Buffer& b, const char* name, bool v) {
+    Mark m = BeginTag(b, name, "BoolProperty", nullptr, nullptr, false, v);
+    EndTag(b, m);
+}
+
+static Mark BeginStruct(Buffer& b, const char* name, const char* structName) {
+    return BeginTag(b, name, "StructProperty", structName, nullptr, false, false);
+}
+
+static void PutHandle(Buffer& b, const char* name, int32_t index, int32_t serial) {
+    Mark m = BeginStruct(b, name, "MassEntityHandle");
+    PutInt(b, "Index", index);
+    PutInt(b, "SerialNumber", serial);
+    PutNone(b);
+    EndTag(b, m);
+}
+
+static void PutVector(Buffer& b, const char* name) {
+    Mark m = BeginTag(b, name, "StructProperty", "Vector", nullptr, true, false);
+    Put<double>(b, (double)(Rand() % 100000000) * 0.1);
+    Put<double>(b, (double)(Rand() % 100000000) * 0.1);
+    Put<double>(b, 0.0);
+    EndTag(b, m);
+}
+
+// ArrayProperty of StructProperty: the count, then (classic only) one
+// more tag describing the elements, then the elements
+static ArrayMark BeginStructArray(Buffer& b, const char* name, const char* structName) {
+    ArrayMark a = {};
+    a.tag = BeginTag(b, name, "ArrayProperty", structName, "StructProperty", false, false);
+    a.countAt = b.size;
+    Put<int32_t>(b, 0);
+    if (!g_typeTrees) a.inner = BeginStruct(b, name, structName);
+    return a;
+}
+
+static void EndStructArray(Buffer& b, const ArrayMark& a) {
+    PatchAt<int32_t>(b, a.countAt, a.count);
+    if (!g_typeTrees) EndTag(b, a.inner);
+    EndTag(b, a.tag);
+}
+
+// ===================================================================
+// Entities
+// ===================================================================
+
+struct Truth {
+    int64_t entities;           // with both fragments
+    int64_t junctions;
+    int64_t repairable;         // broken junctions
+    int64_t links;              // links those need rewritten
+    int64_t unrepairable;
+    int64_t brokenOther;        // broken, not junctions
+};
+
+struct Link {
+    int32_t index;
+    int32_t serial;
+};
+
+static constexpr int MAX_ARMS = 5;
+static const int ARM_CHOICES[] = { 1, 2, 2, 3, 5 };
+
+static void PutSocketsFragment(Buffer& b, const Link* links, int count) {
+    ArrayMark a = BeginStructArray(b, "Sockets", "CrLogisticsSocket");
+    for (int k = 0; k < count; ++k, ++a.count) {
+        PutHandle(b, "ConnectedEntity", links[k].index, links[k].serial);
+        if (!g_compact) PutVector(b, "Location");
+        PutNone(b);
+    }
+    EndStructArray(b, a);
+    PutNone(b);
+}
+
+static void PutConnectionData(Buffer& b, const Link* targets, int arms) {
+    ArrayMark a = BeginStructArray(b, "Connections", "CrCustomConnection");
+    for (int k = 0; k < arms; ++k, ++a.count) {
+        PutInt(b, "SocketIndex", k);
+        PutHandle(b, "Target", targets[k].index, targets[k].serial);
+        PutInt(b, "TargetSocketIndex", 0);
+        PutNone(b);
+    }
+    EndStructArray(b, a);
+    PutNone(b);
+}
+
+// Both fragments as struct properties named as the direct layout has them
+static void PutFragmentProperties(Buffer& b, const Link* links, int sockets,
+                                  const Link* targets, int arms) {
+    Mark m = BeginStruct(b, "Sockets", "CrLogisticsSocketsFragment");
+    PutSocketsFragment(b, links, sockets);
+    EndTag(b, m);
+    m = BeginStruct(b, "Conn", "CrCustomConnectionData");
+    PutConnectionData(b, targets, arms);
+    EndTag(b, m);
+}
+
+// Writes one entity into 'b'; for the parallel layout its fragments go to
+// the save-wide arrays instead
+static void PutEntity(Buffer& b, int32_t i, int32_t n, Layout layout, Truth& truth,
+                      Buffer& allSockets, Buffer& allConns, int32_t& parallel) {
+    PutHandle(b, "Handle", i + 1, 1);
+    PutVector(b, "Location");
+    PutBool(b, "bActive", true);
+
+    if (!Chance(70)) {
+        PutNone(b);
+        return;
+    }
+
+    int arms = ARM_CHOICES[Rand() % 5];
+    Link targets[MAX_ARMS];
+    Link links[MAX_ARMS];
+    for (int k = 0; k < arms; ++k) {
+        targets[k].index  = 1 + (int32_t)(Rand() % (uint32_t)(n > 1 ? n - 1 : 1));
+        targets[k].serial = 1 + (int32_t)(Rand() % 4);
+        links[k] = targets[k];
+    }
+
+    int sockets = arms, broken = 0;
+    bool truncated = false;
+    int kind = (int)(Rand() % 100);
+    if (kind < 25) {
+        for (int k = 0; k < arms; ++k)
+            if (Chance(60)) {
+                links[k] = {};
+                broken++;
+            }
+    } else if (kind < 30 && arms >= 3) {
+        sockets = 1;
+        truncated = true;
+    }
+
+    truth.entities++;
+    if (arms >= 3) {
+        truth.junctions++;
+        if (truncated) {
+            truth.unrepairable++;
+        } else if (broken) {
+            truth.repairable++;
+            truth.links += broken;
+        }
+    } else if (broken) {
+        truth.brokenOther++;
+    }
+
+    switch (layout) {
+    case LAYOUT_DIRECT:
+        PutFragmentProperties(b, links, sockets, targets, arms);
+        break;
+
+    case LAYOUT_WRAPPED: {
+        ArrayMark a = BeginStructArray(b, "Fragments", "InstancedStruct");
+        Mark m = BeginStruct(b, "Value", "CrLogisticsSocketsFragment");
+        PutSocketsFragment(b, links, sockets);
+        EndTag(b, m);
+        PutNone(b);
+        m = BeginStruct(b, "Value", "CrCustomConnectionData");
+        PutConnectionData(b, targets, arms);
+        EndTag(b, m);
+        PutNone(b);
+        a.count = 2;
+        EndStructArray(b, a);
+        break;
+    }
+
+    case LAYOUT_BLOB: {
+        Mark m = BeginTag(b, "Data", "ArrayProperty", nullptr, "ByteProperty", false, false);
+        size_t countAt = b.size;
+        Put<int32_t>(b, 0);
+        PutFragmentProperties(b, links, sockets, targets, arms);
+        PutNone(b);
+        PatchAt<int32_t>(b, countAt, (int32_t)(b.size - countAt - sizeof(int32_t)));
+        EndTag(b, m);
+        break;
+    }
+
+    case LAYOUT_PARALLEL:
+        PutSocketsFragment(allSockets, links, sockets);
+        PutConnectionData(allConns, targets, arms);
+        parallel++;
+        break;
+    }
+    PutNone(b);
+}
+
+// ===================================================================
+// Save
+// ===================================================================
+
+static void PutHeader(Buffer& b) {
+    Put(b, GVAS_MAGIC);
+    Put<int32_t>(b, 3);                         // save game file version
+    Put<int32_t>(b, 522);                       // UE4 package version
+    Put<int32_t>(b, g_ue5);
+    Put<uint16_t>(b, 5);
+    Put<uint16_t>(b, g_typeTrees ? 4 : 3);
+    Put<uint16_t>(b, 2);
+    Put<uint32_t>(b, 12345);                    // changelist
+    PutString(b, g_typeTrees ? "++UE5+Release-5.4" : "++UE5+Release-5.3");
+
+    Put<int32_t>(b, 3);                         // custom version format
+    Put<int32_t>(b, 2);
+    for (uint8_t v = 1; v <= 2; ++v) {
+        uint8_t key[16];
+        memset(key, v, sizeof(key));
+        Put(b, key, sizeof(key));
+        Put<int32_t>(b, v);
+    }
+    PutString(b, "/Script/Chimera.CrSaveGame");
+}
+
+static bool Generate(Buffer& b, int32_t n, Layout layout, Truth& truth) {
+    Buffer allSockets = { nullptr, 0, 0, true };
+    Buffer allConns   = { nullptr, 0, 0, true };
+    int32_t parallel = 0;
+
+    PutHeader(b);
+    PutInt(b, "Version", 7);
+    ArrayMark entities = BeginStructArray(b, "Entities", "CrSavedEntity");
+    for (int32_t i = 0; i < n; ++i, ++entities.count)
+        PutEntity(b, i, n, layout, truth, allSockets, allConns, parallel);
+    EndStructArray(b, entities);
+
+    if (layout == LAYOUT_PARALLEL) {
+        ArrayMark a = BeginStructArray(b, "AllSockets", "CrLogisticsSocketsFragment");
+        Put(b, allSockets.data, allSockets.size);
+        a.count = parallel;
+        EndStructArray(b, a);
+        a = BeginStructArray(b, "AllConns", "CrCustomConnectionData");
+        Put(b, allConns.data, allConns.size);
+        a.count = parallel;
+        EndStructArray(b, a);
+    }
+    PutNone(b);
+    Put<int32_t>(b, 0);
+
+    bool ok = b.ok && allSockets.ok && allConns.ok;
+    free(allSockets.data);
+    free(allConns.data);
+    return ok;
+}
+
+// One stored chunk behind the compressed chunk header: tag, chunk size,
+// then compressed and uncompressed sizes for the summary and the block
+static bool WriteCompressed(FILE* f, const Buffer& b) {
+    uint64_t words[6] = { PACKAGE_FILE_TAG, COMPRESSION_CHUNK,
+                          b.size, b.size, b.size, b.size };
+    return fwrite(words, sizeof(words), 1, f) == 1;
+}
+
+static void Usage() {
+    fprintf(stderr, "usage: ssf_gensave [--ue5 VER] [--layout direct|wrapped|blob|parallel] "
+                    "[--entities N] [--seed S] [--compact] [--compressed] OUT\n");
+}
+
+int main(int argc, char** argv) {
+    const char* out = nullptr;
+    int32_t n = 100000;
+    Layout layout = LAYOUT_DIRECT;
+    bool compressed = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if      (strcmp(a, "--compact") == 0)                 g_compact = true;
+        else if (strcmp(a, "--compressed") == 0)              compressed = true;
+        else if (strcmp(a, "--ue5") == 0 && i + 1 < argc)     g_ue5 = atoi(argv[++i]);
+        else if (strcmp(a, "--entities") == 0 && i + 1 < argc) n = atoi(argv[++i]);
+        else if (strcmp(a, "--seed") == 0 && i + 1 < argc)    g_rng = (uint32_t)strtoul(argv[++i], nullptr, 0);
+        else if (strcmp(a, "--layout") == 0 && i + 1 < argc) {
+            const char* name = argv[++i];
+            int l = 0;
+            while (l < 4 && strcmp(name, LAYOUT_NAMES[l]) != 0) ++l;
+            if (l == 4) {
+                Usage();
+                return 2;
+            }
+            layout = (Layout)l;
+        }
+        else if (a[0] != '-' && !out)                         out = a;
+        else {
+            Usage();
+            return 2;
+        }
+    }
+    if (!out || n < 1 || g_ue5 < 1000) {
+        Usage();
+        return 2;
+    }
+    if (g_rng == 0) g_rng = 1;
+    g_typeTrees = g_ue5 >= VER_UE5_PROPERTY_TAG_COMPLETE_TYPE_NAME;
+
+    Buffer b = { nullptr, 0, 0, true };
+    Truth truth = {};
+    if (!Generate(b, n, layout, truth)) {
+        fprintf(stderr, "out of memory\n");
+        free(b.data);
+        return 1;
+    }
+
+    FILE* f = fopen(out, "wb");
+    bool ok = f != nullptr;
+    if (ok && compressed) ok = WriteCompressed(f, b);
+    if (ok) ok = fwrite(b.data, 1, b.size, f) == b.size;
+    if (f && fclose(f) != 0) ok = false;
+    free(b.data);
+    if (!ok) {
+        fprintf(stderr, "%s: write failed\n", out);
+        return 1;
+    }
+
+    printf("%s: %d entities, %s layout, %s tags%s, %.1f MB\n", out, n, LAYOUT_NAMES[layout],
+           g_typeTrees ? "UE 5.4" : "classic", g_compact ? ", compact" : "",
+           (double)b.size / (1024.0 * 1024.0));
+    printf("truth: entities %lld junctions %lld repairable %lld links %lld "
+           "unrepairable %lld broken-other %lld\n",
+           (long long)truth.entities, (long long)truth.junctions, (long long)truth.repairable,
+           (long long)truth.links, (long long)truth.unrepairable, (long long)truth.brokenOther);
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include "metrics.h"
+#include "platform.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// ---------------------------------------------------------------------------
+// ssf_metrics — print the live metrics block of a running game with the
+// mod loaded (see src/metrics.h).
+//
+//   ssf_metrics [--watch MS] PID | NAME
+//
+// A number is taken as the game's process id; anything else as the block
+// name (on Linux a path, for blocks the simulator writes to a file).
+// --watch prints again every MS milliseconds whenever the block changed,
+// until the writer unloads or the block goes away.
+// ---------------------------------------------------------------------------
+
+static const char* const SYMBOL_SOURCES[] = { "unresolved", "ini", "aob" };
+static const char* const INIT_STATES[]    = { "running", "done", "failed", "unloaded" };
+
+static void Usage() {
+    fprintf(stderr, "usage: ssf_metrics [--watch MS] PID | NAME\n");
+}
+
+static const char* Label(const char* const* names, size_t count, uint32_t value) {
+    return value < count ? names[value] : "?";
+}
+
+static void Print(const MetricsBlock& b) {
+    const MetricsData& m = b.data;
+
+    printf("pid %u, update %llu\n", b.pid, (unsigned long long)(b.seq / 2));
+    printf("  init      %s in %.1f ms, symbols from %s, %llu errors\n",
+           Label(INIT_STATES, 4, m.init), m.setupMicros / 1000.0,
+           Label(SYMBOL_SOURCES, 3, m.symbols), (unsigned long long)m.errors);
+
+    if (m.loads == 0) {
+        printf("  loads     none\n");
+    } else if (m.lastLoadSignalled < 0) {
+        printf("  loads     %llu, last failed after %.1f ms\n",
+               (unsigned long long)m.loads, m.lastLoadMicros / 1000.0);
+    } else {
+        printf("  loads     %llu, last: %lld entity slots, %lld signalled in %.1f ms "
+               "(%.1f ms total)\n",
+               (unsigned long long)m.loads, (long long)m.lastLoadEntities,
+               (long long)m.lastLoadSignalled, m.lastSignalMicros / 1000.0,
+               m.lastLoadMicros / 1000.0);
+    }
+
+    if (m.saves == 0) printf("  saves     none\n");
+    else              printf("  saves     %llu, last %.1f ms\n",
+                             (unsigned long long)m.saves, m.lastSaveMicros / 1000.0);
+
+    uint32_t n = m.hookCount < METRICS_MAX_HOOKS ? m.hookCount : METRICS_MAX_HOOKS;
+    for (uint32_t i = 0; i < n; ++i) {
+        char name[sizeof(m.hooks[i].name) + 1];
+        memcpy(name, m.hooks[i].name, sizeof(m.hooks[i].name));
+        name[sizeof(m.hooks[i].name)] = '\0';
+        printf("  hook      %-20s %llu calls\n", name, (unsigned long long)m.hooks[i].calls);
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    const char* target = nullptr;
+    int watchMs = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if (strcmp(a, "--watch") == 0 && i + 1 < argc) {
+            watchMs = atoi(argv[++i]);
+            if (watchMs <= 0) {
+                Usage();
+                return 2;
+            }
+        }
+        else if (a[0] != '-' && !target) target = a;
+        else {
+            Usage();
+            return 2;
+        }
+    }
+    if (!target) {
+        Usage();
+        return 2;
+    }
+
+    char name[512];
+    if (strspn(target, "0123456789") == strlen(target))
+        MetricsName((uint32_t)strtoul(target, nullptr, 10), name, sizeof(name));
+    else
+        snprintf(name, sizeof(name), "%s", target);
+
+    void* handle = nullptr;
+    const MetricsBlock* shared = MetricsAttach(name, handle);
+    if (!shared) {
+        fprintf(stderr, "%s: no metrics block (game not running, or LiveMetrics=0)\n", name);
+        return 1;
+    }
+
+    MetricsBlock b;
+    if (!MetricsSnapshot(shared, b)) {
+        fprintf(stderr, "%s: block not readable (other version, or never initialised)\n", name);
+        MetricsDetach(shared, handle);
+        return 1;
+    }
+    Print(b);
+
+    uint64_t lastSeq = b.seq;
+    while (watchMs > 0 && b.data.init != METRICS_INIT_UNLOADED) {
+        PlatSleep((uint32_t)watchMs);
+        if (!MetricsSnapshot(shared, b)) continue;
+        if (b.seq == lastSeq) continue;
+        lastSeq = b.seq;
+        Print(b);
+    }
+
+    MetricsDetach(shared, handle);
+    return 0;
+}
@@ -0,0 +1,653 @@
+#include "gvas.h"
+#include "platform.h"
+#include "sockets.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+// ---------------------------------------------------------------------------
+// ssf_savefix — repair 3-way / 5-way junctions that are already broken in
+// a StarRupture save, offline, with the rules the mod uses at load time.
+//
+// The save is memory-mapped and its property stream walked tag by tag.
+// Every FCrLogisticsSocketsFragment is paired with the
+// FCrCustomConnectionData of the same entity (the two fragments sharing
+// the nearest enclosing struct), and the pairs are checked in batches by
+// a pool of worker threads while the scan goes on.  A junction is
+// repaired by pointing each socket named in its saved connection list
+// back at the saved target — the same comparison VerifySockets makes in
+// game — and every fix rewrites a fixed-size handle, so the file never
+// changes size.  Memory use is two record batches plus whatever pages the
+// OS keeps cached, whatever the save size.
+//
+//   ssf_savefix [--in-place | -o OUT] [--threads N] [-v] SAVE
+//
+// Without --in-place or -o nothing is written; the report says what
+// would be repaired.  --in-place checks the whole file first, so a save
+// the reader cannot follow is left untouched.
+// ---------------------------------------------------------------------------
+
+// Reflected names as they appear in the save
+static const char* const SOCKETS_STRUCT     = "CrLogisticsSocketsFragment";
+static const char* const CONNECTIONS_STRUCT = "CrCustomConnectionData";
+
+static constexpr int     MAX_DEPTH              = 32;
+static constexpr int     BATCH_RECORDS          = 16 * 1024;
+static constexpr int     MAX_THREADS            = 64;
+static constexpr size_t  COPY_BUFFER            = 1 << 20;
+
+// ===================================================================
+// Records and batches
+// ===================================================================
+
+struct Fragment {
+    size_t begin;               // struct value, 0 = none
+    size_t end;
+};
+
+struct EntityRecord {
+    Fragment sockets;
+    Fragment conns;
+};
+
+struct RepairStats {
+    int64_t entities;           // sockets + connection data pairs
+    int64_t junctions;
+    int64_t threeWay;
+    int64_t fiveWay;
+    int64_t intact;
+    int64_t repaired;
+    int64_t unrepairable;
+    int64_t brokenOther;        // not junctions, left alone
+    int64_t linksRewritten;
+    int64_t malformed;          // fragment layout not understood
+};
+
+struct ScanStats {
+    int64_t socketsOnly;        // no connection data to compare against
+    int64_t connsOnly;          // saved before the fix: no sockets fragment
+    int64_t ambiguous;          // fragments in lists, not one per entity
+    int64_t opaque;             // struct values that are not tagged streams
+};
+
+struct Batch {
+    EntityRecord recs[BATCH_RECORDS];
+    int          count;
+};
+
+static uint8_t*   g_data       = nullptr;
+static bool       g_write      = false;
+static int        g_threads    = 1;
+static bool       g_verbose    = false;
+static GvasHeader g_header;
+
+static Batch       g_batches[2];
+static int         g_current   = 0;
+static RepairStats g_workerStats[MAX_THREADS];
+static std::atomic<int> g_nextRecord{0};
+
+// Worker pool: started once, woken per batch
+static std::thread             g_workers[MAX_THREADS];
+static std::mutex              g_poolLock;
+static std::condition_variable g_poolWake;      // a batch was posted, or stop
+static std::condition_variable g_poolIdle;      // the last worker finished a batch
+static const Batch*            g_poolBatch = nullptr;
+static uint64_t                g_poolGeneration = 0;
+static int                     g_poolBusy = 0;
+static bool                    g_poolStop = false;
+
+static ScanStats   g_scan;
+
+// ===================================================================
+// Per-entity check and repair  (worker threads)
+// ===================================================================
+
+// File offsets of the two int32s of a saved FMassEntityHandle
+struct HandleField {
+    size_t index;
+    size_t serial;
+};
+
+static FMassEntityHandle LoadHandle(const HandleField& f) {
+    FMassEntityHandle h;
+    memcpy(&h.Index, g_data + f.index, 4);
+    memcpy(&h.SerialNumber, g_data + f.serial, 4);
+    return h;
+}
+
+static void StoreHandle(const HandleField& f, const FMassEntityHandle& h) {
+    memcpy(g_data + f.index, &h.Index, 4);
+    memcpy(g_data + f.serial, &h.SerialNumber, 4);
+}
+
+// Handles are plain tagged structs (Index, SerialNumber); a binary
+// 8-byte value is taken as the raw pair
+static bool ParseHandle(GvasReader& r, const GvasTag& tag, HandleField& out) {
+    if (strcmp(tag.type, "StructProperty") != 0) return false;
+    if (tag.size == 8) {
+        out.index  = tag.valueOffset;
+        out.serial = tag.valueOffset + 4;
+        return true;
+    }
+
+    size_t begin = tag.valueOffset, end = tag.valueOffset + (size_t)tag.size;
+    GvasReader h = r;
+    GvasTag t;
+    if (!GvasFindProperty(h, begin, end, "Index", t) || t.size != 4) return false;
+    out.index = t.valueOffset;
+    if (!GvasFindProperty(h, begin, end, "SerialNumber", t) || t.size != 4) return false;
+    out.serial = t.valueOffset;
+    return true;
+}
+
+// Walk one tagged struct element at r.pos, picking out an int32 and a
+// handle by name; r is left on the next element
+static bool ParseElement(GvasReader& r, const char* intName, int32_t* intOut,
+                         const char* handleName, HandleField& handleOut)
+{
+    bool haveInt = !intName, haveHandle = false;
+    GvasTag tag;
+    while (GvasReadTag(r, tag)) {
+        if (intName && strcmp(tag.name, intName) == 0 && tag.size == 4) {
+            memcpy(intOut, g_data + tag.valueOffset, 4);
+            haveInt = true;
+        } else if (strcmp(tag.name, handleName) == 0) {
+            haveHandle = ParseHandle(r, tag, handleOut);
+        }
+        GvasSkipValue(r, tag);
+    }
+    return r.ok && haveInt && haveHandle;
+}
+
+// Fixed-size views of the two fragments of one entity
+struct SocketList {
+    HandleField linked[MAX_SOCKETS_PER_ENTITY];
+    int32_t     num;
+};
+
+struct ConnectionList {
+    int32_t     socket[MAX_SOCKETS_PER_ENTITY];
+    HandleField target[MAX_SOCKETS_PER_ENTITY];
+    int32_t     num;
+};
+
+static bool ParseSockets(const Fragment& f, SocketList& out) {
+    GvasReader r = GvasStream(g_data, f.begin, f.end, g_header);
+    GvasTag tag;
+    GvasStructArray arr;
+    out.num = 0;
+
+    if (!GvasFindProperty(r, f.begin, f.end, "Sockets", tag)) return r.ok;   // empty
+    if (!GvasOpenStructArray(r, tag, arr) || arr.count > MAX_SOCKETS_PER_ENTITY) return false;
+
+    r.pos = arr.first;
+    r.end = arr.end;
+    for (int32_t i = 0; i < arr.count; ++i)
+        if (!ParseElement(r, nullptr, nullptr, "ConnectedEntity", out.linked[i])) return false;
+    out.num = arr.count;
+    return true;
+}
+
+static bool ParseConnections(const Fragment& f, ConnectionList& out) {
+    GvasReader r = GvasStream(g_data, f.begin, f.end, g_header);
+    GvasTag tag;
+    GvasStructArray arr;
+    out.num = 0;
+
+    if (!GvasFindProperty(r, f.begin, f.end, "Connections", tag)) return r.ok;
+    if (!GvasOpenStructArray(r, tag, arr) || arr.count > MAX_SOCKETS_PER_ENTITY) return false;
+
+    r.pos = arr.first;
+    r.end = arr.end;
+    for (int32_t i = 0; i < arr.count; ++i)
+        if (!ParseElement(r, "SocketIndex", &out.socket[i], "Target", out.target[i])) return false;
+    out.num = arr.count;
+    return true;
+}
+
+// A junction is repaired only when every broken link can be fixed: each
+// connection names an existing socket, and no socket is claimed by two
+// connections with different targets.  Anything else is left for the
+// in-game rebuild.
+static void CheckEntity(const EntityRecord& rec, RepairStats& st) {
+    SocketList sockets;
+    ConnectionList conns;
+    if (!ParseSockets(rec.sockets, sockets) || !ParseConnections(rec.conns, conns)) {
+        st.malformed++;
+        return;
+    }
+    st.entities++;
+
+    int32_t arms = sockets.num > conns.num ? sockets.num : conns.num;
+    bool junction = arms >= JUNCTION_MIN_ARMS;
+    if (junction) {
+        st.junctions++;
+        if (arms == 3) st.threeWay++;
+        if (arms == 5) st.fiveWay++;
+    }
+
+    int broken = 0;
+    bool fixable = true;
+    int32_t claimedBy[MAX_SOCKETS_PER_ENTITY];
+    memset(claimedBy, 0xFF, sizeof(claimedBy));
+    for (int32_t c = 0; c < conns.num; ++c) {
+        int32_t s = conns.socket[c];
+        if (s < 0 || s >= sockets.num) {
+            broken++;
+            fixable = false;
+            continue;
+        }
+        FMassEntityHandle target = LoadHandle(conns.target[c]);
+        if (!SameEntity(LoadHandle(sockets.linked[s]), target)) broken++;
+        if (claimedBy[s] >= 0 && !SameEntity(LoadHandle(conns.target[claimedBy[s]]), target))
+            fixable = false;
+        claimedBy[s] = c;
+    }
+
+    if (broken == 0) {
+        if (junction) st.intact++;
+        return;
+    }
+    if (!junction) {
+        st.brokenOther++;
+        return;
+    }
+    if (!fixable) {
+        st.unrepairable++;
+        return;
+    }
+
+    st.repaired++;
+    for (int32_t c = 0; c < conns.num; ++c) {
+        const HandleField& linked = sockets.linked[conns.socket[c]];
+        FMassEntityHandle target = LoadHandle(conns.target[c]);
+        if (SameEntity(LoadHandle(linked), target)) continue;
+        if (g_write) StoreHandle(linked, target);
+        st.linksRewritten++;
+    }
+}
+
+static void Worker(RepairStats* st) {
+    uint64_t seen = 0;
+    for (;;) {
+        const Batch* batch;
+        {
+            std::unique_lock<std::mutex> lock(g_poolLock);
+            g_poolWake.wait(lock, [&] { return g_poolStop || g_poolGeneration != seen; });
+            if (g_poolStop) return;
+            seen  = g_poolGeneration;
+            batch = g_poolBatch;
+        }
+
+        for (;;) {
+            int i = g_nextRecord.fetch_add(1, std::memory_order_relaxed);
+            if (i >= batch->count) break;
+            CheckEntity(batch->recs[i], *st);
+        }
+
+        std::lock_guard<std::mutex> lock(g_poolLock);
+        if (--g_poolBusy == 0) g_poolIdle.notify_one();
+    }
+}
+
+static void StartWorkers() {
+    g_poolStop = false;
+    for (int t = 0; t < g_threads; ++t)
+        g_workers[t] = std::thread(Worker, &g_workerStats[t]);
+}
+
+static void StopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(g_poolLock);
+        g_poolStop = true;
+    }
+    g_poolWake.notify_all();
+    for (int t = 0; t < g_threads; ++t) g_workers[t].join();
+}
+
+// Wait until every worker is done with the posted batch
+static void WaitWorkers() {
+    std::unique_lock<std::mutex> lock(g_poolLock);
+    g_poolIdle.wait(lock, [] { return g_poolBusy == 0; });
+}
+
+// Hand the current batch to the pool and start filling the other one.
+// The previous batch must be done first: its slots are reused.
+static void Dispatch() {
+    WaitWorkers();
+    Batch& b = g_batches[g_current];
+    if (b.count == 0) return;
+
+    {
+        std::lock_guard<std::mutex> lock(g_poolLock);
+        g_nextRecord.store(0, std::memory_order_relaxed);
+        g_poolBatch = &b;
+        g_poolBusy  = g_threads;
+        g_poolGeneration++;
+    }
+    g_poolWake.notify_all();
+
+    g_current ^= 1;
+    g_batches[g_current].count = 0;
+}
+
+static void Emit(const Fragment& sockets, const Fragment& conns) {
+    Batch& b = g_batches[g_current];
+    b.recs[b.count].sockets = sockets;
+    b.recs[b.count].conns   = conns;
+    if (++b.count == BATCH_RECORDS) Dispatch();
+}
+
+// ===================================================================
+// Scan  (main thread)
+//
+// Fragments are paired in the nearest struct that holds exactly one of
+// each.  A struct holding only one of the two passes it up to its parent,
+// so entities that keep each fragment in its own wrapper struct still
+// pair.  A struct that collects a second fragment of the same kind is a
+// list, not an entity — nothing pairs there.
+// ===================================================================
+
+struct Scope {
+    Fragment sockets;
+    Fragment conns;
+    bool     displaced;
+};
+
+static void Drop(const Scope& s) {
+    if (s.displaced) {
+        g_scan.ambiguous += (s.sockets.begin != 0) + (s.conns.begin != 0);
+    } else if (!s.sockets.begin != !s.conns.begin) {
+        if (s.sockets.begin) g_scan.socketsOnly++;
+        else                 g_scan.connsOnly++;
+    }
+}
+
+static void Offer(Scope& s, bool isSockets, const Fragment& f) {
+    Fragment& slot = isSockets ? s.sockets : s.conns;
+    if (slot.begin) {
+        g_scan.ambiguous++;
+        s.displaced = true;
+    }
+    slot = f;
+}
+
+static void Close(const Scope& child, Scope& parent) {
+    if (child.displaced) {
+        Drop(child);
+    } else if (child.sockets.begin && child.conns.begin) {
+        Emit(child.sockets, child.conns);
+    } else {
+        if (child.sockets.begin) Offer(parent, true, child.sockets);
+        if (child.conns.begin)   Offer(parent, false, child.conns);
+    }
+}
+
+static bool ScanStruct(GvasReader& r, int depth, Scope& scope);
+
+// A struct value that is its own tag stream: scan it as a child scope.
+// Binary structs (vectors, guids, ...) do not parse and are skipped.
+static void ScanNested(GvasReader& r, size_t begin, size_t end, int depth, Scope& scope) {
+    GvasReader n = r;
+    n.pos = begin;
+    n.end = end;
+    Scope child = {};
+    if (ScanStruct(n, depth + 1, child)) Close(child, scope);
+    else                                 g_scan.opaque++;
+}
+
+static void ScanArray(GvasReader& r, const GvasTag& tag, int depth, Scope& scope) {
+    if (strcmp(tag.innerType, "StructProperty") == 0) {
+        GvasStructArray arr;
+        if (!GvasOpenStructArray(r, tag, arr)) {
+            g_scan.opaque++;
+            return;
+        }
+
+        bool isSockets = strcmp(arr.structName, SOCKETS_STRUCT) == 0;
+        bool isConns   = strcmp(arr.structName, CONNECTIONS_STRUCT) == 0;
+
+        GvasReader e = r;
+        e.pos = arr.first;
+        e.end = arr.end;
+        for (int32_t i = 0; i < arr.count; ++i) {
+            size_t begin = e.pos;
+            Scope child = {};
+            if (isSockets || isConns) {
+                if (!GvasSkipTaggedStruct(e)) break;
+                Offer(child, isSockets, Fragment{ begin, e.pos });
+            } else if (!ScanStruct(e, depth + 1, child)) {
+                break;
+            }
+            Close(child, scope);
+        }
+        if (!e.ok) g_scan.opaque++;
+        return;
+    }
+
+    // Byte arrays often hold a nested object written with tagged
+    // properties; scan them if they parse as one
+    if (strcmp(tag.innerType, "ByteProperty") == 0 && tag.size > 4) {
+        int32_t count;
+        memcpy(&count, g_data + tag.valueOffset, 4);
+        if ((int64_t)count + 4 == tag.size) {
+            GvasReader n = r;
+            n.pos = tag.valueOffset + 4;
+            n.end = tag.valueOffset + (size_t)tag.size;
+            Scope child = {};
+            if (ScanStruct(n, depth + 1, child)) Close(child, scope);
+        }
+    }
+}
+
+// Walk tags from r.pos through "None".  Maps and sets are not entered.
+static bool ScanStruct(GvasReader& r, int depth, Scope& scope) {
+    if (depth > MAX_DEPTH) return false;
+
+    GvasTag tag;
+    while (GvasReadTag(r, tag)) {
+        size_t end = tag.valueOffset + (size_t)tag.size;
+
+        if (strcmp(tag.type, "StructProperty") == 0 && !tag.nativeStruct) {
+            if (strcmp(tag.structName, SOCKETS_STRUCT) == 0)
+                Offer(scope, true, Fragment{ tag.valueOffset, end });
+            else if (strcmp(tag.structName, CONNECTIONS_STRUCT) == 0)
+                Offer(scope, false, Fragment{ tag.valueOffset, end });
+            else if (tag.size > 0)
+                ScanNested(r, tag.valueOffset, end, depth, scope);
+        } else if (strcmp(tag.type, "ArrayProperty") == 0) {
+            ScanArray(r, tag, depth, scope);
+        }
+
+        GvasSkipValue(r, tag);
+    }
+    return r.ok;
+}
+
+// One full pass; returns false if the property stream could not be
+// followed to its end
+static bool RunPass(size_t fileSize, RepairStats& total, size_t& failedAt) {
+    memset(&g_scan, 0, sizeof(g_scan));
+    memset(g_workerStats, 0, sizeof(g_workerStats));
+    g_batches[0].count = g_batches[1].count = 0;
+    g_current = 0;
+
+    GvasReader r = GvasStream(g_data, g_header.bodyOffset, fileSize, g_header);
+    Scope root = {};
+    bool ok = ScanStruct(r, 0, root);
+    if (ok && root.sockets.begin && root.conns.begin && !root.displaced)
+        Emit(root.sockets, root.conns);
+    else
+        Drop(root);
+    failedAt = r.pos;
+
+    Dispatch();
+    WaitWorkers();
+
+    memset(&total, 0, sizeof(total));
+    for (int t = 0; t < g_threads; ++t) {
+        const RepairStats& s = g_workerStats[t];
+        total.entities       += s.entities;
+        total.junctions      += s.junctions;
+        total.threeWay       += s.threeWay;
+        total.fiveWay        += s.fiveWay;
+        total.intact         += s.intact;
+        total.repaired       += s.repaired;
+        total.unrepairable   += s.unrepairable;
+        total.brokenOther    += s.brokenOther;
+        total.linksRewritten += s.linksRewritten;
+        total.malformed      += s.malformed;
+    }
+    return ok;
+}
+
+// ===================================================================
+// Files
+// ===================================================================
+
+static bool CopyFile(const char* from, const char* to) {
+    FILE* in = fopen(from, "rb");
+    if (!in) return false;
+    FILE* out = fopen(to, "wb");
+    if (!out) {
+        fclose(in);
+        return false;
+    }
+
+    char* buf = (char*)malloc(COPY_BUFFER);
+    bool ok = buf != nullptr;
+    size_t n;
+    while (ok && (n = fread(buf, 1, COPY_BUFFER, in)) > 0)
+        ok = fwrite(buf, 1, n, out) == n;
+    ok = ok && !ferror(in);
+
+    free(buf);
+    fclose(in);
+    if (fclose(out) != 0) ok = false;
+    return ok;
+}
+
+static void Report(const RepairStats& s, size_t size, double seconds) {
+    const char* verb = g_write ? "repaired" : "would repair";
+    double mb = (double)size / (1024.0 * 1024.0);
+
+    printf("scanned %.1f MB in %.2f s (%.0f MB/s), %d worker threads\n",
+           mb, seconds, seconds > 0 ? mb / seconds : 0.0, g_threads);
+    printf("  socket entities          %lld\n", (long long)s.entities);
+    printf("  junctions                %lld  (3-way %lld, 5-way %lld)\n",
+           (long long)s.junctions, (long long)s.threeWay, (long long)s.fiveWay);
+    printf("    intact                 %lld\n", (long long)s.intact);
+    printf("    %-22s %lld  (%lld links)\n", verb, (long long)s.repaired, (long long)s.linksRewritten);
+    printf("    unrepairable           %lld\n", (long long)s.unrepairable);
+    printf("  broken, not junctions    %lld  (left alone)\n", (long long)s.brokenOther);
+    printf("  no connection data       %lld\n", (long long)g_scan.socketsOnly);
+    printf("  no sockets fragment      %lld  (saved without the mod; rebuilt in game)\n",
+           (long long)g_scan.connsOnly);
+    if (g_scan.ambiguous || s.malformed || g_verbose)
+        printf("  in lists / malformed     %lld / %lld  (not paired, left alone)\n",
+               (long long)g_scan.ambiguous, (long long)s.malformed);
+    if (g_verbose)
+        printf("  opaque struct values     %lld\n", (long long)g_scan.opaque);
+}
+
+// ===================================================================
+// main
+// ===================================================================
+
+static void Usage() {
+    fprintf(stderr, "usage: ssf_savefix [--in-place | -o OUT] [--threads N] [-v] SAVE\n");
+}
+
+int main(int argc, char** argv) {
+    const char* in = nullptr;
+    const char* out = nullptr;
+    bool inPlace = false;
+
+    int hw = (int)std::thread::hardware_concurrency();
+    g_threads = hw > 0 ? (hw < MAX_THREADS ? hw : MAX_THREADS) : 1;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        if      (strcmp(a, "--in-place") == 0)            inPlace = true;
+        else if (strcmp(a, "-v") == 0)                    g_verbose = true;
+        else if (strcmp(a, "-o") == 0 && i + 1 < argc)    out = argv[++i];
+        else if (strcmp(a, "--threads") == 0 && i + 1 < argc) {
+            g_threads = atoi(argv[++i]);
+            if (g_threads < 1 || g_threads > MAX_THREADS) {
+                Usage();
+                return 2;
+            }
+        }
+        else if (a[0] != '-' && !in)                      in = a;
+        else {
+            Usage();
+            return 2;
+        }
+    }
+    if (!in || (inPlace && out)) {
+        Usage();
+        return 2;
+    }
+
+    if (out && !CopyFile(in, out)) {
+        fprintf(stderr, "%s: could not copy to %s\n", in, out);
+        return 1;
+    }
+    const char* target = out ? out : in;
+    bool writable = inPlace || out;
+
+    size_t size = 0;
+    g_data = (uint8_t*)PlatMapFile(target, writable, size);
+    if (!g_data) {
+        fprintf(stderr, "%s: cannot map file\n", target);
+        return 1;
+    }
+
+    if (!GvasReadHeader(g_data, size, g_header)) {
+        fprintf(stderr, "%s: not an uncompressed UE save (GVAS)\n", in);
+        PlatUnmapFile(g_data, size);
+        if (out) remove(out);
+        return 1;
+    }
+    printf("%s: %s, UE %u.%u.%u, save version %d, package version %d/%d\n",
+           in, g_header.saveClass, g_header.engineMajor, g_header.engineMinor,
+           g_header.enginePatch, g_header.saveVersion, g_header.ue4Version, g_header.ue5Version);
+
+    RepairStats stats;
+    size_t failedAt = 0;
+    int64_t t0 = PlatTicks();
+
+    // Before writing anything, make sure the whole stream can be followed
+    StartWorkers();
+    g_write = false;
+    bool ok = RunPass(size, stats, failedAt);
+    if (ok && writable) {
+        g_write = true;
+        ok = RunPass(size, stats, failedAt);
+    }
+    StopWorkers();
+    double seconds = (double)(PlatTicks() - t0) / (double)PlatTicksPerSecond();
+
+    if (!ok) {
+        fprintf(stderr, "%s: malformed property stream at offset 0x%zX; nothing written\n",
+                in, failedAt);
+        PlatUnmapFile(g_data, size);
+        if (out) remove(out);
+        return 1;
+    }
+
+    if (writable && stats.linksRewritten > 0 && !PlatFlushMapping(g_data, size)) {
+        fprintf(stderr, "%s: writing the repaired save failed\n", target);
+        PlatUnmapFile(g_data, size);
+        return 1;
+    }
+    PlatUnmapFile(g_data, size);
+
+    Report(stats, size, seconds);
+    if (out) printf("written to %s\n", out);
+    return 0;
+}